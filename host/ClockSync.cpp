@@ -0,0 +1,150 @@
+#include "ClockSync.h"
+
+#include <math.h>
+
+#include "Telemetry.h"
+
+namespace {
+
+const size_t CLOCK_MAP_SIZE = 28;
+const int64_t RTT_SLACK_US = 200;  // exchanges within 2 x best + slack are fitted
+
+}  // namespace
+
+int64_t mapToHostUs(const ClockMap& map, uint64_t deviceUs) {
+  double elapsed = (double)(int64_t)(deviceUs - map.deviceUs);
+  return map.hostUs + llround(elapsed * (1.0 + map.driftPpm * 1e-6));
+}
+
+// Within about 35 minutes of the reference point
+uint64_t unwrapDeviceUs(const ClockMap& map, uint32_t deviceLowUs) {
+  return map.deviceUs + (int64_t)(int32_t)(deviceLowUs - (uint32_t)map.deviceUs);
+}
+
+size_t encodeClockMap(const ClockMap& map, uint8_t* payload, size_t capacity) {
+  PayloadWriter out(payload, capacity);
+  out.putU64(map.deviceUs);
+  out.putU64((uint64_t)map.hostUs);
+  out.putF32(map.driftPpm);
+  out.putU32(map.errorUs);
+  out.putU32(map.rttUs);
+  return out.overflow() ? 0 : out.length();
+}
+
+bool decodeClockMap(const uint8_t* payload, size_t length, ClockMap& map) {
+  if (length != CLOCK_MAP_SIZE) {
+    return false;
+  }
+  PayloadReader in(payload, length);
+  map.deviceUs = in.getU64();
+  map.hostUs = (int64_t)in.getU64();
+  map.driftPpm = in.getF32();
+  map.errorUs = in.getU32();
+  map.rttUs = in.getU32();
+  return !in.underflow();
+}
+
+void ClockSync::reset() {
+  _count = 0;
+  _next = 0;
+  _lastDeviceUs = 0;
+  _anchorUs = 0;
+  _offsetUs = 0.0;
+  _slope = 0.0;
+  _bestRttUs = 0;
+  _errorUs = 0;
+  _exchanges = 0;
+}
+
+bool ClockSync::add(int64_t hostSendUs, uint64_t deviceUs, int64_t hostReceiveUs) {
+  int64_t rtt = hostReceiveUs - hostSendUs;
+  if (rtt < 0) {
+    return false;
+  }
+  if (_count > 0 && deviceUs < _lastDeviceUs) {
+    reset();
+    _restarts++;
+  }
+  _lastDeviceUs = deviceUs;
+
+  Exchange& e = _window[_next];
+  e.deviceUs = deviceUs;
+  e.hostUs = hostSendUs + rtt / 2;
+  e.rttUs = rtt;
+  _next = (_next + 1) % CLOCK_SYNC_WINDOW;
+  if (_count < CLOCK_SYNC_WINDOW) {
+    _count++;
+  }
+  _exchanges++;
+  _anchorUs = deviceUs;
+  fit();
+  return true;
+}
+
+// Only exchanges close to the best round trip count: a long one was held up
+// somewhere (console busy in a sweep step, queue backed up, USB latency), and
+// the midpoint of a long round trip says little about the device time
+void ClockSync::fit() {
+  _bestRttUs = _window[0].rttUs;
+  for (size_t i = 1; i < _count; i++) {
+    if (_window[i].rttUs < _bestRttUs) _bestRttUs = _window[i].rttUs;
+  }
+  int64_t limit = 2 * _bestRttUs + RTT_SLACK_US;
+
+  // x: device time from the anchor, y: host minus device, both in us
+  double sumX = 0.0, sumY = 0.0;
+  double minX = 0.0, maxX = 0.0;
+  size_t n = 0;
+  for (size_t i = 0; i < _count; i++) {
+    const Exchange& e = _window[i];
+    if (e.rttUs > limit) continue;
+    double x = (double)(int64_t)(e.deviceUs - _anchorUs);
+    double y = (double)(e.hostUs - (int64_t)e.deviceUs);
+    if (n == 0 || x < minX) minX = x;
+    if (n == 0 || x > maxX) maxX = x;
+    sumX += x;
+    sumY += y;
+    n++;
+  }
+  double meanX = sumX / n;
+  double meanY = sumY / n;
+
+  if (n >= 2 && maxX - minX >= (double)CLOCK_SYNC_MIN_SPAN_US) {
+    double sxy = 0.0, sxx = 0.0;
+    for (size_t i = 0; i < _count; i++) {
+      const Exchange& e = _window[i];
+      if (e.rttUs > limit) continue;
+      double dx = (double)(int64_t)(e.deviceUs - _anchorUs) - meanX;
+      sxy += dx * ((double)(e.hostUs - (int64_t)e.deviceUs) - meanY);
+      sxx += dx * dx;
+    }
+    _slope = sxy / sxx;
+  }
+  // Too short for a rate: the last known drift stays (0 at first)
+  _offsetUs = meanY - _slope * meanX;
+
+  double squares = 0.0;
+  for (size_t i = 0; i < _count; i++) {
+    const Exchange& e = _window[i];
+    if (e.rttUs > limit) continue;
+    double x = (double)(int64_t)(e.deviceUs - _anchorUs);
+    double r = (double)(e.hostUs - (int64_t)e.deviceUs) - (_offsetUs + _slope * x);
+    squares += r * r;
+  }
+  _errorUs = _bestRttUs / 2 + llround(sqrt(squares / n));
+}
+
+int64_t ClockSync::toHostUs(uint64_t deviceUs) const {
+  double x = (double)(int64_t)(deviceUs - _anchorUs);
+  return (int64_t)deviceUs + llround(_offsetUs + _slope * x);
+}
+
+ClockMap ClockSync::map(int64_t hostOffsetUs) const {
+  ClockMap m;
+  m.deviceUs = _anchorUs;
+  m.hostUs = toHostUs(_anchorUs) + hostOffsetUs;
+  m.driftPpm = (float)driftPpm();
+  m.errorUs = (uint32_t)_errorUs;
+  m.rttUs = (uint32_t)_bestRttUs;
+  return m;
+}
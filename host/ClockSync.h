@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Device-to-host time mapping from `sync` exchanges (Linux/POSIX host).
+// The host notes when it sent `sync <token>` and when the TIME_SYNC reply
+// arrived; the device stamped esp_timer in between. Each exchange puts the
+// device time at the midpoint of the round trip, give or take half of it.
+// The fit keeps the exchanges with the shortest round trips in a sliding
+// window and solves offset and drift (rate difference) by least squares.
+
+const size_t CLOCK_SYNC_WINDOW = 64;
+const int64_t CLOCK_SYNC_MIN_SPAN_US = 2000000;  // shorter windows fit the offset only
+
+// Published by the hub as a TELEMETRY_CLOCK_MAP frame:
+//   host = hostUs + (device - deviceUs) * (1 + driftPpm / 1e6)
+struct ClockMap {
+  uint64_t deviceUs;  // esp_timer at the reference point
+  int64_t hostUs;     // host clock at the same instant (Unix us from the hub)
+  float driftPpm;     // host minus device rate
+  uint32_t errorUs;   // half the best round trip plus the fit residual
+  uint32_t rttUs;     // best round trip in the window
+};
+
+int64_t mapToHostUs(const ClockMap& map, uint64_t deviceUs);
+// Extends a 32-bit event time (low bits of esp_timer) to the map's epoch
+uint64_t unwrapDeviceUs(const ClockMap& map, uint32_t deviceLowUs);
+
+size_t encodeClockMap(const ClockMap& map, uint8_t* payload, size_t capacity);
+bool decodeClockMap(const uint8_t* payload, size_t length, ClockMap& map);
+
+class ClockSync {
+ public:
+  ClockSync() : _restarts(0) { reset(); }
+
+  // Drops the window; the restart count stays
+  void reset();
+
+  // One exchange, host times on one monotonic clock; false if the round trip
+  // is negative. A device time before the last one (reboot) restarts the fit.
+  bool add(int64_t hostSendUs, uint64_t deviceUs, int64_t hostReceiveUs);
+
+  bool valid() const { return _count > 0; }
+  int64_t toHostUs(uint64_t deviceUs) const;
+  // Map anchored at the newest exchange; hostOffsetUs moves it to another
+  // host clock (e.g. CLOCK_REALTIME - CLOCK_MONOTONIC)
+  ClockMap map(int64_t hostOffsetUs) const;
+
+  double driftPpm() const { return _slope * 1e6; }
+  int64_t bestRttUs() const { return _bestRttUs; }
+  int64_t errorUs() const { return _errorUs; }
+  size_t samples() const { return _count; }
+  uint32_t exchanges() const { return _exchanges; }
+  uint32_t restarts() const { return _restarts; }
+
+ private:
+  struct Exchange {
+    uint64_t deviceUs;
+    int64_t hostUs;  // midpoint of the round trip
+    int64_t rttUs;
+  };
+
+  void fit();
+
+  Exchange _window[CLOCK_SYNC_WINDOW];
+  size_t _count;
+  size_t _next;
+  uint64_t _lastDeviceUs;
+  // host = device + _offsetUs + _slope * (device - _anchorUs)
+  uint64_t _anchorUs;
+  double _offsetUs;
+  double _slope;
+  int64_t _bestRttUs;
+  int64_t _errorUs;
+  uint32_t _exchanges;
+  uint32_t _restarts;
+};
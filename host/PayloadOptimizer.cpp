@@ -0,0 +1,262 @@
+#include "PayloadOptimizer.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace {
+
+struct Row {
+  float thrustKg;
+  float powerW;
+};
+
+// Score first, then grid position: the same set wins however work is split
+bool better(const DesignResult& a, const DesignResult& b) {
+  return a.score > b.score || (a.score == b.score && a.order < b.order);
+}
+
+// Grid pairs for one motor count, flattened T/W-major
+struct GridArrays {
+  std::vector<float> twRatio;
+  std::vector<float> airframeKg;
+};
+
+struct BatchOutput {
+  std::vector<float> payloadKg;
+  std::vector<float> hoverPowerW;
+  std::vector<float> hoverGPerW;
+};
+
+// One curve and motor count against every grid pair. Straight-line float
+// code over separate arrays, so the compiler can keep it in vector registers.
+// Payload is computed as payloadCapacityKg() does: (T * n) / ratio - weight.
+void evaluateBatch(const ThrustCurve& curve, int motors, float requiredPayloadKg,
+                   const float* __restrict twRatio, const float* __restrict airframeKg, size_t count,
+                   float* __restrict payloadKg, float* __restrict hoverPowerW,
+                   float* __restrict hoverGPerW) {
+  const float totalThrust = curve.maxThrustKg * motors;
+  const float invMotors = 1.0f / motors;
+  const float* power = curve.powerW;
+  for (size_t i = 0; i < count; i++) {
+    payloadKg[i] = totalThrust / twRatio[i] - airframeKg[i];
+
+    float hoverKg = airframeKg[i] + requiredPayloadKg;
+    float x = hoverKg * invMotors * curve.invStepKg;
+    int k = (int)x;
+    k = k < CURVE_POINTS - 2 ? k : CURVE_POINTS - 2;
+    k = k > 0 ? k : 0;
+    float t = x - (float)k;
+    float perMotorW = power[k] + (power[k + 1] - power[k]) * t;
+    hoverPowerW[i] = perMotorW * motors;
+    hoverGPerW[i] = hoverKg * 1000.0f / hoverPowerW[i];
+  }
+}
+
+class TopList {
+ public:
+  explicit TopList(size_t size) : _size(size) {}
+
+  void offer(const DesignResult& result) {
+    if (_size == 0) {
+      return;
+    }
+    if (_heap.size() < _size) {
+      _heap.push_back(result);
+      std::push_heap(_heap.begin(), _heap.end(), better);
+    } else if (better(result, _heap.front())) {
+      std::pop_heap(_heap.begin(), _heap.end(), better);
+      _heap.back() = result;
+      std::push_heap(_heap.begin(), _heap.end(), better);
+    }
+  }
+
+  // Once full, anything scoring below the worst kept design cannot enter;
+  // a zero-size list keeps nothing and never has a worst design
+  bool full() const { return _size > 0 && _heap.size() >= _size; }
+  float worst() const { return _heap.front().score; }
+
+  std::vector<DesignResult>& items() { return _heap; }
+
+ private:
+  size_t _size;
+  std::vector<DesignResult> _heap;  // heap on better(): worst at the front
+};
+
+}  // namespace
+
+bool buildThrustCurve(uint32_t runId, const float* thrustKg, const float* powerW, size_t count,
+                      ThrustCurve& out) {
+  std::vector<Row> rows;
+  rows.reserve(count);
+  bool hasPower = true;
+  for (size_t i = 0; i < count; i++) {
+    if (!(thrustKg[i] > 0.0f)) {
+      continue;
+    }
+    Row row = {thrustKg[i], powerW != nullptr ? powerW[i] : NAN};
+    if (!isfinite(row.powerW)) {
+      hasPower = false;
+    }
+    rows.push_back(row);
+  }
+  if (rows.size() < 2) {
+    return false;
+  }
+  std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.thrustKg < b.thrustKg; });
+
+  out.runId = runId;
+  out.maxThrustKg = rows.back().thrustKg;
+  out.invStepKg = (CURVE_POINTS - 1) / out.maxThrustKg;
+  out.hasPower = hasPower;
+
+  // Below the lightest measured point the power stays at its value (idle draw)
+  size_t j = 0;
+  for (int k = 0; k < CURVE_POINTS; k++) {
+    float target = out.maxThrustKg * k / (CURVE_POINTS - 1);
+    if (!hasPower) {
+      out.powerW[k] = NAN;
+      continue;
+    }
+    while (j + 1 < rows.size() && rows[j + 1].thrustKg < target) {
+      j++;
+    }
+    const Row& a = rows[j];
+    const Row& b = rows[j + 1 < rows.size() ? j + 1 : j];
+    if (target <= a.thrustKg || b.thrustKg <= a.thrustKg) {
+      out.powerW[k] = target <= a.thrustKg ? a.powerW : b.powerW;
+    } else {
+      float t = (target - a.thrustKg) / (b.thrustKg - a.thrustKg);
+      out.powerW[k] = a.powerW + (b.powerW - a.powerW) * (t < 1.0f ? t : 1.0f);
+    }
+  }
+  return true;
+}
+
+float curvePowerW(const ThrustCurve& curve, float thrustKg) {
+  float x = thrustKg * curve.invStepKg;
+  int k = (int)x;
+  k = k < CURVE_POINTS - 2 ? k : CURVE_POINTS - 2;
+  k = k > 0 ? k : 0;
+  float t = x - (float)k;
+  return curve.powerW[k] + (curve.powerW[k + 1] - curve.powerW[k]) * t;
+}
+
+DesignResult evaluateDesign(const ThrustCurve& curve, int motors, float twRatio, float airframeKg,
+                            float requiredPayloadKg) {
+  DesignResult r;
+  r.curve = 0;
+  r.motors = motors;
+  r.twRatio = twRatio;
+  r.airframeKg = airframeKg;
+  r.payloadKg = curve.maxThrustKg * motors / twRatio - airframeKg;
+  float hoverKg = airframeKg + requiredPayloadKg;
+  r.hoverPowerW = curvePowerW(curve, hoverKg * (1.0f / motors)) * motors;
+  r.hoverGPerW = hoverKg * 1000.0f / r.hoverPowerW;
+  r.score = 0.0f;
+  r.order = 0;
+  return r;
+}
+
+std::vector<DesignResult> rankDesigns(const std::vector<ThrustCurve>& curves, const DesignGrid& grid,
+                                      DesignObjective objective, size_t top, int threads,
+                                      OptimizerStats& stats) {
+  auto start = std::chrono::steady_clock::now();
+
+  GridArrays pairs;
+  for (float ratio : grid.twRatios) {
+    for (float airframe : grid.airframeKg) {
+      pairs.twRatio.push_back(ratio);
+      pairs.airframeKg.push_back(airframe);
+    }
+  }
+  const size_t pairCount = pairs.twRatio.size();
+  const size_t units = curves.size() * grid.motors.size();
+  if (threads < 1) {
+    threads = 1;
+  }
+  if ((size_t)threads > units && units > 0) {
+    threads = (int)units;
+  }
+
+  std::atomic<size_t> nextUnit(0);
+  std::vector<TopList> tops(threads, TopList(top));
+  std::vector<uint64_t> evaluated(threads, 0);
+  std::vector<uint64_t> feasible(threads, 0);
+
+  auto worker = [&](int id) {
+    BatchOutput out;
+    out.payloadKg.resize(pairCount);
+    out.hoverPowerW.resize(pairCount);
+    out.hoverGPerW.resize(pairCount);
+    TopList& best = tops[id];
+    uint64_t done = 0;
+    uint64_t fits = 0;
+
+    for (size_t unit = nextUnit++; unit < units; unit = nextUnit++) {
+      size_t c = unit / grid.motors.size();
+      size_t m = unit % grid.motors.size();
+      const ThrustCurve& curve = curves[c];
+      if (objective == OBJ_HOVER_EFFICIENCY && !curve.hasPower) {
+        continue;
+      }
+      int motors = grid.motors[m];
+      evaluateBatch(curve, motors, grid.payloadKg, pairs.twRatio.data(), pairs.airframeKg.data(), pairCount,
+                    out.payloadKg.data(), out.hoverPowerW.data(), out.hoverGPerW.data());
+      done += pairCount;
+
+      const float* score = objective == OBJ_PAYLOAD ? out.payloadKg.data() : out.hoverGPerW.data();
+      for (size_t i = 0; i < pairCount; i++) {
+        if (!(out.payloadKg[i] >= grid.payloadKg)) {
+          continue;
+        }
+        fits++;
+        if (best.full() && score[i] < best.worst()) {
+          continue;
+        }
+        DesignResult r;
+        r.curve = (uint32_t)c;
+        r.motors = motors;
+        r.twRatio = pairs.twRatio[i];
+        r.airframeKg = pairs.airframeKg[i];
+        r.payloadKg = out.payloadKg[i];
+        r.hoverPowerW = curve.hasPower ? out.hoverPowerW[i] : 0.0f;
+        r.hoverGPerW = curve.hasPower ? out.hoverGPerW[i] : 0.0f;
+        r.score = score[i];
+        r.order = (uint64_t)unit * pairCount + i;
+        best.offer(r);
+      }
+    }
+    evaluated[id] = done;
+    feasible[id] = fits;
+  };
+
+  std::vector<std::thread> pool;
+  for (int id = 1; id < threads; id++) {
+    pool.emplace_back(worker, id);
+  }
+  worker(0);
+  for (std::thread& t : pool) {
+    t.join();
+  }
+
+  TopList merged(top);
+  stats.evaluated = 0;
+  stats.feasible = 0;
+  for (int id = 0; id < threads; id++) {
+    for (const DesignResult& r : tops[id].items()) {
+      merged.offer(r);
+    }
+    stats.evaluated += evaluated[id];
+    stats.feasible += feasible[id];
+  }
+  std::vector<DesignResult> ranked = merged.items();
+  std::sort(ranked.begin(), ranked.end(), better);
+
+  stats.threads = threads;
+  stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  return ranked;
+}
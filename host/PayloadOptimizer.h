@@ -0,0 +1,71 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+// Design search over measured thrust curves: for every curve (one motor,
+// prop and battery) and every frame of a grid (motor count, thrust-to-weight
+// ratio, airframe weight) the payload the frame can lift and its hover
+// efficiency. Grid pairs are kept as structure-of-arrays so the inner loop
+// runs over plain float arrays; curves are split across threads.
+
+const int CURVE_POINTS = 64;
+
+// Electrical power per motor on an even thrust grid, 0 .. maxThrustKg
+struct ThrustCurve {
+  uint32_t runId;
+  float maxThrustKg;
+  float invStepKg;  // (CURVE_POINTS - 1) / maxThrustKg
+  bool hasPower;
+  float powerW[CURVE_POINTS];
+};
+
+// Resamples one sweep (both phases, any order); rows without thrust are
+// skipped. False when fewer than two rows have thrust.
+bool buildThrustCurve(uint32_t runId, const float* thrustKg, const float* powerW, size_t count,
+                      ThrustCurve& out);
+
+// Power per motor at a thrust within the curve, interpolated
+float curvePowerW(const ThrustCurve& curve, float thrustKg);
+
+struct DesignGrid {
+  std::vector<int> motors;
+  std::vector<float> twRatios;
+  std::vector<float> airframeKg;
+  float payloadKg;  // must fit; hover efficiency is figured with it on board
+};
+
+enum DesignObjective {
+  OBJ_PAYLOAD,          // largest payload capacity
+  OBJ_HOVER_EFFICIENCY  // most grams per watt in hover (curves with power only)
+};
+
+struct DesignResult {
+  uint32_t curve;       // index into the curve list
+  int motors;
+  float twRatio;
+  float airframeKg;
+  float payloadKg;      // capacity at twRatio, as payloadCapacityKg()
+  float hoverPowerW;    // all motors, airframe plus required payload
+  float hoverGPerW;     // 0 without power data
+  float score;
+  uint64_t order;       // position in the grid, breaks ties
+};
+
+struct OptimizerStats {
+  uint64_t evaluated;
+  uint64_t feasible;
+  int threads;
+  double seconds;
+};
+
+// Best `top` designs, best first; identical for any thread count
+std::vector<DesignResult> rankDesigns(const std::vector<ThrustCurve>& curves, const DesignGrid& grid,
+                                      DesignObjective objective, size_t top, int threads,
+                                      OptimizerStats& stats);
+
+// One design the slow way, for checking the batched path
+DesignResult evaluateDesign(const ThrustCurve& curve, int motors, float twRatio, float airframeKg,
+                            float requiredPayloadKg);
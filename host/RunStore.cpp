@@ -0,0 +1,345 @@
+#include "RunStore.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char FILE_MAGIC[4] = {'T', 'S', 'R', 'S'};
+const size_t HEADER_SIZE = 16;
+
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t elementSize;
+  uint32_t reserved;
+};
+static_assert(sizeof(FileHeader) == HEADER_SIZE, "FileHeader is on disk");
+
+const char* const COLUMN_FILES[COL_COUNT] = {
+  "pwm.col", "phase.col", "thrust.col", "voltage.col", "current.col", "power.col", "efficiency.col"
+};
+const uint32_t COLUMN_SIZES[COL_COUNT] = {2, 1, 4, 4, 4, 4, 4};
+
+off_t fileSize(int fd) {
+  struct stat st;
+  return fstat(fd, &st) == 0 ? st.st_size : -1;
+}
+
+bool writeAll(int fd, const void* data, size_t length) {
+  const uint8_t* bytes = (const uint8_t*)data;
+  while (length > 0) {
+    ssize_t n = write(fd, bytes, length);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += n;
+    length -= (size_t)n;
+  }
+  return true;
+}
+
+void copyName(char* out, size_t capacity, const char* text) {
+  strncpy(out, text != nullptr ? text : "", capacity - 1);
+  out[capacity - 1] = '\0';
+}
+
+}  // namespace
+
+RunFilter anyRun() {
+  RunFilter filter;
+  filter.motor = nullptr;
+  filter.prop = nullptr;
+  filter.propDiameterIn = 0.0f;
+  filter.fromDate = 0;
+  filter.toDate = 0;
+  return filter;
+}
+
+bool runMatches(const RunMeta& meta, const RunFilter& filter) {
+  if (filter.motor != nullptr && strncmp(meta.motor, filter.motor, sizeof(meta.motor)) != 0) return false;
+  if (filter.prop != nullptr && strncmp(meta.prop, filter.prop, sizeof(meta.prop)) != 0) return false;
+  if (filter.propDiameterIn > 0.0f && fabsf(meta.propDiameterIn - filter.propDiameterIn) > 0.05f) return false;
+  if (filter.fromDate != 0 && meta.dateUnix < filter.fromDate) return false;
+  if (filter.toDate != 0 && meta.dateUnix > filter.toDate) return false;
+  return true;
+}
+
+RunStore::RunStore() : _writable(false), _rows(0), _runCount(0), _mappedMask(0) {
+  _directory[0] = '\0';
+  _index = {-1, nullptr, 0};
+  for (Mapping& column : _columns) {
+    column = {-1, nullptr, 0};
+  }
+}
+
+RunStore::~RunStore() {
+  close();
+}
+
+bool RunStore::openFile(Mapping& file, const char* name, uint32_t elementSize) {
+  char path[320];
+  snprintf(path, sizeof(path), "%s/%s", _directory, name);
+  file.fd = ::open(path, _writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+  if (file.fd < 0) {
+    return false;
+  }
+
+  FileHeader header;
+  if (fileSize(file.fd) == 0 && _writable) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = RUN_STORE_VERSION;
+    header.elementSize = elementSize;
+    return writeAll(file.fd, &header, sizeof(header));
+  }
+  if (pread(file.fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+      memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 ||
+      header.version != RUN_STORE_VERSION || header.elementSize != elementSize) {
+    errno = EINVAL;
+    return false;
+  }
+  return true;
+}
+
+bool RunStore::open(const char* directory, bool writable) {
+  close();
+  copyName(_directory, sizeof(_directory), directory);
+  _writable = writable;
+  if (writable) {
+    mkdir(directory, 0755);
+  }
+
+  if (!openFile(_index, "runs.idx", sizeof(RunMeta))) {
+    close();
+    return false;
+  }
+  for (int c = 0; c < COL_COUNT; c++) {
+    if (!openFile(_columns[c], COLUMN_FILES[c], COLUMN_SIZES[c])) {
+      close();
+      return false;
+    }
+  }
+  if (!repair()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// Index records are only trusted up to the shortest column, and (when
+// writable) trailing column data without an index record is cut off
+bool RunStore::repair() {
+  off_t indexSize = fileSize(_index.fd);
+  _runCount = indexSize > (off_t)HEADER_SIZE ? (size_t)(indexSize - HEADER_SIZE) / sizeof(RunMeta) : 0;
+
+  uint64_t columnRows = UINT64_MAX;
+  for (int c = 0; c < COL_COUNT; c++) {
+    off_t size = fileSize(_columns[c].fd);
+    uint64_t rows = size > (off_t)HEADER_SIZE ? (uint64_t)(size - HEADER_SIZE) / COLUMN_SIZES[c] : 0;
+    if (rows < columnRows) columnRows = rows;
+  }
+
+  _rows = 0;
+  while (_runCount > 0) {
+    RunMeta last;
+    off_t at = (off_t)(HEADER_SIZE + (_runCount - 1) * sizeof(RunMeta));
+    if (pread(_index.fd, &last, sizeof(last), at) != (ssize_t)sizeof(last)) {
+      return false;
+    }
+    if (last.firstPoint + last.pointCount <= columnRows) {
+      _rows = last.firstPoint + last.pointCount;
+      break;
+    }
+    _runCount--;  // columns never made it to disk
+  }
+
+  if (_writable) {
+    if (ftruncate(_index.fd, (off_t)(HEADER_SIZE + _runCount * sizeof(RunMeta))) != 0) {
+      return false;
+    }
+    for (int c = 0; c < COL_COUNT; c++) {
+      if (ftruncate(_columns[c].fd, (off_t)(HEADER_SIZE + _rows * COLUMN_SIZES[c])) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void RunStore::close() {
+  unmap(_index);
+  if (_index.fd >= 0) {
+    ::close(_index.fd);
+    _index.fd = -1;
+  }
+  for (Mapping& column : _columns) {
+    unmap(column);
+    if (column.fd >= 0) {
+      ::close(column.fd);
+      column.fd = -1;
+    }
+  }
+  _rows = 0;
+  _runCount = 0;
+  _mappedMask = 0;
+}
+
+const void* RunStore::map(Mapping& file) {
+  if (file.data == nullptr) {
+    off_t size = fileSize(file.fd);
+    if (size <= (off_t)HEADER_SIZE) {
+      return nullptr;
+    }
+    void* data = mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED, file.fd, 0);
+    if (data == MAP_FAILED) {
+      return nullptr;
+    }
+    file.data = data;
+    file.length = (size_t)size;
+  }
+  return (const uint8_t*)file.data + HEADER_SIZE;
+}
+
+void RunStore::unmap(Mapping& file) {
+  if (file.data != nullptr) {
+    munmap(file.data, file.length);
+    file.data = nullptr;
+    file.length = 0;
+  }
+}
+
+bool RunStore::append(RunMeta& meta, const RunPoint* points, size_t count) {
+  if (!_writable || count == 0) {
+    errno = EINVAL;
+    return false;
+  }
+
+  meta.runId = _runCount > 0 ? runs()[_runCount - 1].runId + 1 : 1;
+  meta.firstPoint = _rows;
+  meta.pointCount = (uint32_t)count;
+  meta.maxThrustKg = 0.0f;
+  for (size_t i = 0; i < count; i++) {
+    if (points[i].thrustKg > meta.maxThrustKg) meta.maxThrustKg = points[i].thrustKg;
+  }
+
+  // Columns first, index record last (see repair())
+  uint8_t buffer[4096];
+  for (int c = 0; c < COL_COUNT; c++) {
+    size_t elementSize = COLUMN_SIZES[c];
+    if (lseek(_columns[c].fd, 0, SEEK_END) < 0) return false;
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+      const RunPoint& p = points[i];
+      switch (c) {
+        case COL_PWM: memcpy(buffer + used, &p.pwm, 2); break;
+        case COL_PHASE: buffer[used] = p.phase; break;
+        case COL_THRUST: memcpy(buffer + used, &p.thrustKg, 4); break;
+        case COL_VOLTAGE: memcpy(buffer + used, &p.voltageV, 4); break;
+        case COL_CURRENT: memcpy(buffer + used, &p.currentA, 4); break;
+        case COL_POWER: memcpy(buffer + used, &p.powerW, 4); break;
+        case COL_EFFICIENCY: memcpy(buffer + used, &p.efficiencyGPerW, 4); break;
+      }
+      used += elementSize;
+      if (used + elementSize > sizeof(buffer) || i + 1 == count) {
+        if (!writeAll(_columns[c].fd, buffer, used)) return false;
+        used = 0;
+      }
+    }
+    unmap(_columns[c]);
+  }
+
+  if (lseek(_index.fd, 0, SEEK_END) < 0 || !writeAll(_index.fd, &meta, sizeof(meta))) {
+    return false;
+  }
+  unmap(_index);
+  _runCount++;
+  _rows += count;
+  return true;
+}
+
+size_t RunStore::runCount() const {
+  return _runCount;
+}
+
+const RunMeta* RunStore::runs() {
+  return (const RunMeta*)map(_index);
+}
+
+const int16_t* RunStore::pwmColumn() {
+  _mappedMask |= 1u << COL_PWM;
+  return (const int16_t*)map(_columns[COL_PWM]);
+}
+
+const uint8_t* RunStore::phaseColumn() {
+  _mappedMask |= 1u << COL_PHASE;
+  return (const uint8_t*)map(_columns[COL_PHASE]);
+}
+
+const float* RunStore::floatColumn(RunColumn column) {
+  if (column < COL_THRUST || column >= COL_COUNT) {
+    return nullptr;
+  }
+  _mappedMask |= 1u << column;
+  return (const float*)map(_columns[column]);
+}
+
+float RunStore::thrustAtPwm(const RunMeta& meta, int pwm) {
+  const int16_t* pwmValues = pwmColumn();
+  const float* thrust = floatColumn(COL_THRUST);
+  if (pwmValues == nullptr || thrust == nullptr) {
+    return NAN;
+  }
+  float best = NAN;
+  uint64_t end = meta.firstPoint + meta.pointCount;
+  for (uint64_t row = meta.firstPoint; row < end; row++) {
+    if (pwmValues[row] == pwm && !(thrust[row] <= best)) {
+      best = thrust[row];
+    }
+  }
+  return best;
+}
+
+// Parses one sweep log; rows look like
+//   1250us\t| 64%\t| 0.313 kg\t| 50%[\t| 15.87 V\t| 7.42 A\t| 117.6 W\t| 2.66 g/W][\t| time us]
+// The trailing device time is not stored; without power columns it stops the
+// match at the missing " V".
+size_t parseSweepLog(FILE* f, RunPoint* points, size_t capacity) {
+  char line[256];
+  size_t count = 0;
+  uint8_t phase = 0;
+  while (fgets(line, sizeof(line), f) != nullptr && count < capacity) {
+    if (strstr(line, "Speeding up") != nullptr) {
+      phase = 0;
+      continue;
+    }
+    if (strstr(line, "Slowing down") != nullptr) {
+      phase = 1;
+      continue;
+    }
+    int pwm, throttle, progress;
+    float thrust, voltage, current, power, efficiency;
+    int fields = sscanf(line, "%dus | %d%% | %f kg | %d%% | %f V | %f A | %f W | %f g/W",
+                        &pwm, &throttle, &thrust, &progress, &voltage, &current, &power, &efficiency);
+    if (fields < 4) {
+      continue;
+    }
+    RunPoint& p = points[count++];
+    p.pwm = (int16_t)pwm;
+    p.phase = phase;
+    p.thrustKg = thrust;
+    bool hasPower = fields == 8;
+    p.voltageV = hasPower ? voltage : NAN;
+    p.currentA = hasPower ? current : NAN;
+    p.powerW = hasPower ? power : NAN;
+    p.efficiencyGPerW = hasPower ? efficiency : NAN;
+  }
+  return count;
+}
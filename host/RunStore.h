@@ -0,0 +1,115 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Append-only columnar store for sweep results (Linux/POSIX host).
+// A store is a directory:
+//   runs.idx        fixed-size RunMeta records, one per run (the index)
+//   pwm.col ...     one file per column, one element per sweep step
+// Each run owns rows [firstPoint, firstPoint + pointCount) in every column.
+// Columns are written first and the index record last, so a crash leaves
+// at most unindexed column tails, which open() trims. Readers mmap only the
+// columns a query touches.
+
+const uint32_t RUN_STORE_VERSION = 1;
+
+struct RunMeta {
+  uint32_t runId;
+  uint32_t pointCount;
+  uint64_t firstPoint;
+  int64_t dateUnix;
+  float propDiameterIn;
+  float droneWeightKg;
+  float maxThrustKg;
+  char motor[32];
+  char prop[24];     // e.g. "5x4.3x3"
+  char battery[24];  // e.g. "4S 1500mAh"
+  uint8_t reserved[12];
+};
+static_assert(sizeof(RunMeta) == 128, "RunMeta is an on-disk record");
+
+struct RunPoint {
+  int16_t pwm;
+  uint8_t phase;  // SweepPhase: 0 speeding up, 1 slowing down
+  float thrustKg;
+  float voltageV;  // NaN without a power monitor
+  float currentA;
+  float powerW;
+  float efficiencyGPerW;
+};
+
+enum RunColumn {
+  COL_PWM,         // int16
+  COL_PHASE,       // uint8
+  COL_THRUST,      // float, the rest too
+  COL_VOLTAGE,
+  COL_CURRENT,
+  COL_POWER,
+  COL_EFFICIENCY,
+  COL_COUNT
+};
+
+struct RunFilter {
+  const char* motor;     // nullptr = any; exact match otherwise
+  const char* prop;
+  float propDiameterIn;  // <= 0 = any
+  int64_t fromDate;      // inclusive, 0 = open
+  int64_t toDate;
+};
+
+RunFilter anyRun();
+bool runMatches(const RunMeta& meta, const RunFilter& filter);
+
+class RunStore {
+ public:
+  RunStore();
+  ~RunStore();
+  RunStore(const RunStore&) = delete;
+  RunStore& operator=(const RunStore&) = delete;
+
+  // Opens (and with writable, creates or repairs) the store; false with errno
+  bool open(const char* directory, bool writable);
+  void close();
+
+  // Fills meta.runId, firstPoint, pointCount and maxThrustKg
+  bool append(RunMeta& meta, const RunPoint* points, size_t count);
+
+  size_t runCount() const;
+  const RunMeta* runs();  // mapped index
+
+  // Mapped columns, indexed by row; nullptr if the column is empty
+  const int16_t* pwmColumn();
+  const uint8_t* phaseColumn();
+  const float* floatColumn(RunColumn column);
+
+  // Highest thrust recorded at exactly `pwm` in the run; NaN if never visited
+  float thrustAtPwm(const RunMeta& meta, int pwm);
+
+  uint32_t mappedColumns() const { return _mappedMask; }  // bit per RunColumn
+  uint64_t rowCount() const { return _rows; }
+
+ private:
+  struct Mapping {
+    int fd;
+    void* data;
+    size_t length;
+  };
+
+  bool openFile(Mapping& file, const char* name, uint32_t elementSize);
+  const void* map(Mapping& file);
+  void unmap(Mapping& file);
+  bool repair();
+
+  char _directory[256];
+  bool _writable;
+  Mapping _index;
+  Mapping _columns[COL_COUNT];
+  uint64_t _rows;
+  size_t _runCount;
+  uint32_t _mappedMask;
+};
+
+// Reads the algorithm-test table from a saved serial log; returns the row count
+size_t parseSweepLog(FILE* f, RunPoint* points, size_t capacity);
@@ -0,0 +1,489 @@
+#include "TelemetryHub.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const long long SERIAL_RETRY_MS = 1000;  // Reopen interval after the port goes away
+const size_t SERIAL_READ_CHUNK = 4096;
+
+long long monotonicMs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int64_t clockUs(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+speed_t speedFor(int baud) {
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+#ifdef B460800
+    case 460800: return B460800;
+#endif
+#ifdef B921600
+    case 921600: return B921600;
+#endif
+    default: return 0;
+  }
+}
+
+}  // namespace
+
+FanoutRing::FanoutRing(size_t capacity)
+    : _buffer(new uint8_t[capacity]), _capacity(capacity), _head(0) {}
+
+FanoutRing::~FanoutRing() {
+  delete[] _buffer;
+}
+
+void FanoutRing::append(const uint8_t* data, size_t length) {
+  // Only the newest `capacity` bytes can survive
+  if (length > _capacity) {
+    _head += length - _capacity;
+    data += length - _capacity;
+    length = _capacity;
+  }
+  size_t offset = _head % _capacity;
+  size_t first = _capacity - offset < length ? _capacity - offset : length;
+  memcpy(_buffer + offset, data, first);
+  memcpy(_buffer, data + first, length - first);
+  _head += length;
+}
+
+size_t FanoutRing::readable(uint64_t cursor, const uint8_t** data) const {
+  if (cursor >= _head || lost(cursor)) {
+    return 0;
+  }
+  size_t offset = cursor % _capacity;
+  uint64_t pending = _head - cursor;
+  size_t length = _capacity - offset;
+  if (pending < length) {
+    length = (size_t)pending;
+  }
+  *data = _buffer + offset;
+  return length;
+}
+
+void StreamSplitter::feed(const uint8_t* data, size_t length, RecordSink& sink) {
+  for (size_t i = 0; i < length; i++) {
+    uint8_t byte = data[i];
+
+    // The firmware prints ASCII only, so outside a frame anything but the
+    // first sync byte belongs to a text line
+    if (_decoder.idle() && byte != TELEMETRY_SYNC_1) {
+      _line[_lineLength++] = byte;
+      if (byte == '\n' || _lineLength == sizeof(_line)) {
+        sink.onRecord(_line, _lineLength, false);
+        _lineLength = 0;
+        if (byte == '\n') {
+          _lines++;
+        }
+      }
+      continue;
+    }
+
+    uint32_t crcErrors = _decoder.crcErrors();
+    if (_decoder.feed(byte)) {
+      uint8_t frame[TELEMETRY_MAX_FRAME];
+      size_t n = encodeTelemetryFrame(_decoder.type(), _decoder.payload(), _decoder.length(),
+                                      frame, sizeof(frame));
+      sink.onRecord(frame, n, true);
+      _frames++;
+    } else if (_decoder.crcErrors() != crcErrors) {
+      _badFrames++;
+    }
+  }
+}
+
+HubConfig defaultHubConfig() {
+  HubConfig config;
+  config.serialPath = "/dev/ttyUSB0";
+  config.baud = 9600;
+  config.unixPath = "/tmp/thrust_stand.sock";
+  config.tcpPort = 0;
+  config.ringBytes = HUB_DEFAULT_RING;
+  config.clientSendBuffer = 0;
+  config.syncPeriodMs = 1000;
+  return config;
+}
+
+TelemetryHub::TelemetryHub(const HubConfig& config)
+    : _config(config),
+      _ring(config.ringBytes),
+      _serialFd(-1),
+      _unixFd(-1),
+      _tcpFd(-1),
+      _serialRetryMs(0),
+      _nextSyncMs(0),
+      _syncToken(0),
+      _syncPending(false),
+      _syncSentUs(0),
+      _readUs(0) {
+  memset(&_stats, 0, sizeof(_stats));
+  for (Client& client : _clients) {
+    client.fd = -1;
+  }
+}
+
+TelemetryHub::~TelemetryHub() {
+  close();
+}
+
+bool TelemetryHub::open() {
+  if (_config.unixPath != nullptr) {
+    _unixFd = openUnixListener(_config.unixPath);
+    if (_unixFd < 0) return false;
+  }
+  if (_config.tcpPort > 0) {
+    _tcpFd = openTcpListener(_config.tcpPort);
+    if (_tcpFd < 0) return false;
+  }
+  return openSerial();
+}
+
+void TelemetryHub::close() {
+  for (Client& client : _clients) {
+    if (client.fd >= 0) {
+      ::close(client.fd);
+      client.fd = -1;
+    }
+  }
+  if (_unixFd >= 0) {
+    ::close(_unixFd);
+    unlink(_config.unixPath);
+    _unixFd = -1;
+  }
+  if (_tcpFd >= 0) {
+    ::close(_tcpFd);
+    _tcpFd = -1;
+  }
+  closeSerial();
+}
+
+bool TelemetryHub::openSerial() {
+  int fd = ::open(_config.serialPath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+  if (fd < 0) {
+    return false;
+  }
+
+  // Raw bytes both ways: no echo, no CR/LF translation, no line buffering
+  struct termios tio;
+  if (tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 1;  // with O_NONBLOCK: EAGAIN when empty, 0 only on hangup
+    tio.c_cc[VTIME] = 0;
+    if (_config.baud > 0) {
+      speed_t speed = speedFor(_config.baud);
+      if (speed == 0) {
+        ::close(fd);
+        errno = EINVAL;
+        return false;
+      }
+      cfsetispeed(&tio, speed);
+      cfsetospeed(&tio, speed);
+    }
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  _serialFd = fd;
+  return true;
+}
+
+void TelemetryHub::closeSerial() {
+  if (_serialFd >= 0) {
+    ::close(_serialFd);
+    _serialFd = -1;
+  }
+}
+
+int TelemetryHub::openUnixListener(const char* path) {
+  struct sockaddr_un addr;
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  unlink(path);  // stale socket from a previous run
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0 || !setNonBlocking(fd)) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int TelemetryHub::openTcpListener(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  int yes = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // local subscribers only
+  addr.sin_port = htons((uint16_t)port);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 8) < 0 || !setNonBlocking(fd)) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+size_t TelemetryHub::clientCount() const {
+  size_t count = 0;
+  for (const Client& client : _clients) {
+    if (client.fd >= 0) count++;
+  }
+  return count;
+}
+
+void TelemetryHub::pollOnce(int timeoutMs) {
+  struct pollfd fds[3 + HUB_MAX_CLIENTS];
+  Client* owners[3 + HUB_MAX_CLIENTS];
+  nfds_t count = 0;
+
+  if (_serialFd < 0) {
+    long long now = monotonicMs();
+    if (now >= _serialRetryMs) {
+      _serialRetryMs = now + SERIAL_RETRY_MS;
+      if (openSerial()) {
+        _stats.serialReopens++;
+      }
+    }
+    if (_serialFd < 0 && timeoutMs > SERIAL_RETRY_MS) {
+      timeoutMs = (int)SERIAL_RETRY_MS;
+    }
+  }
+
+  if (_serialFd >= 0 && _config.syncPeriodMs > 0) {
+    long long now = monotonicMs();
+    if (now >= _nextSyncMs) {
+      _nextSyncMs = now + _config.syncPeriodMs;
+      sendSync();
+    }
+    if (_nextSyncMs - now < timeoutMs) {
+      timeoutMs = (int)(_nextSyncMs - now);
+    }
+  }
+
+  int serialIndex = -1;
+  if (_serialFd >= 0) {
+    serialIndex = (int)count;
+    fds[count] = {_serialFd, POLLIN, 0};
+    owners[count++] = nullptr;
+  }
+  int listenIndex = (int)count;
+  const int listeners[2] = {_unixFd, _tcpFd};
+  for (int fd : listeners) {
+    if (fd >= 0) {
+      fds[count] = {fd, POLLIN, 0};
+      owners[count++] = nullptr;
+    }
+  }
+  int listenEnd = (int)count;
+  for (Client& client : _clients) {
+    if (client.fd >= 0) {
+      short events = POLLIN;
+      if (client.cursor < _ring.head()) events |= POLLOUT;
+      fds[count] = {client.fd, events, 0};
+      owners[count++] = &client;
+    }
+  }
+
+  if (poll(fds, count, timeoutMs) <= 0) {
+    return;
+  }
+
+  if (serialIndex >= 0 && fds[serialIndex].revents != 0) {
+    readSerial();
+  }
+  for (int i = listenIndex; i < listenEnd; i++) {
+    if (fds[i].revents & POLLIN) {
+      acceptClient(fds[i].fd);
+    }
+  }
+  for (nfds_t i = listenEnd; i < count; i++) {
+    Client& client = *owners[i];
+    if (client.fd >= 0 && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+      readClient(client);
+    }
+  }
+
+  // New data goes out right away; clients that cannot keep up fall behind
+  for (Client& client : _clients) {
+    if (client.fd >= 0) {
+      flushClient(client);
+    }
+  }
+}
+
+void TelemetryHub::onRecord(const uint8_t* data, size_t length, bool frame) {
+  _ring.append(data, length);
+  if (frame && data[2] == TELEMETRY_TIME_SYNC) {
+    syncReply(data + TELEMETRY_HEADER_SIZE, length - TELEMETRY_HEADER_SIZE - TELEMETRY_CRC_SIZE);
+  }
+}
+
+// A newer exchange replaces one still unanswered; its late reply is ignored
+void TelemetryHub::sendSync() {
+  char line[32];
+  int length = snprintf(line, sizeof(line), "sync %u\n", ++_syncToken);
+  _syncSentUs = clockUs(CLOCK_MONOTONIC);
+  if (write(_serialFd, line, (size_t)length) == length) {
+    _syncPending = true;
+    _stats.syncSent++;
+  }
+}
+
+// Fit on the monotonic clock, published in Unix time for other instruments
+void TelemetryHub::syncReply(const uint8_t* payload, size_t length) {
+  PayloadReader in(payload, length);
+  uint32_t token = in.getU32();
+  uint64_t deviceUs = in.getU64();
+  if (in.underflow() || !_syncPending || token != _syncToken) {
+    return;
+  }
+  _syncPending = false;
+  if (!_clock.add(_syncSentUs, deviceUs, _readUs)) {
+    return;
+  }
+  _stats.syncReplies++;
+
+  uint8_t mapPayload[32];
+  size_t n = encodeClockMap(_clock.map(clockUs(CLOCK_REALTIME) - clockUs(CLOCK_MONOTONIC)), mapPayload,
+                            sizeof(mapPayload));
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  size_t frameLength = encodeTelemetryFrame(TELEMETRY_CLOCK_MAP, mapPayload, n, frame, sizeof(frame));
+  _ring.append(frame, frameLength);
+}
+
+void TelemetryHub::readSerial() {
+  uint8_t buffer[SERIAL_READ_CHUNK];
+  while (true) {
+    ssize_t n = read(_serialFd, buffer, sizeof(buffer));
+    if (n > 0) {
+      _readUs = clockUs(CLOCK_MONOTONIC);
+      _stats.serialBytes += (uint64_t)n;
+      _splitter.feed(buffer, (size_t)n, *this);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      return;
+    }
+    // EOF or EIO: USB unplugged, board reset, PTY peer gone; retry later
+    closeSerial();
+    _serialRetryMs = monotonicMs() + SERIAL_RETRY_MS;
+    return;
+  }
+}
+
+void TelemetryHub::acceptClient(int listenFd) {
+  int fd = accept(listenFd, nullptr, nullptr);
+  if (fd < 0) return;
+
+  Client* slot = nullptr;
+  for (Client& client : _clients) {
+    if (client.fd < 0) {
+      slot = &client;
+      break;
+    }
+  }
+  if (slot == nullptr || !setNonBlocking(fd)) {
+    ::close(fd);
+    return;
+  }
+  if (_config.clientSendBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &_config.clientSendBuffer, sizeof(_config.clientSendBuffer));
+  }
+
+  // Live stream only: a new subscriber starts at the current head
+  slot->fd = fd;
+  slot->cursor = _ring.head();
+  slot->commandLength = 0;
+  _stats.clientsAccepted++;
+}
+
+void TelemetryHub::readClient(Client& client) {
+  char buffer[256];
+  ssize_t n = recv(client.fd, buffer, sizeof(buffer), 0);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    dropClient(client, false);
+    return;
+  }
+  for (ssize_t i = 0; i < n; i++) {
+    if (client.commandLength < sizeof(client.command)) {
+      client.command[client.commandLength++] = buffer[i];
+    }
+    // Whole lines only, so two subscribers cannot interleave a command
+    if (buffer[i] == '\n') {
+      if (_serialFd >= 0 && write(_serialFd, client.command, client.commandLength) > 0) {
+        _stats.commandsForwarded++;
+      }
+      client.commandLength = 0;
+    }
+  }
+}
+
+void TelemetryHub::flushClient(Client& client) {
+  while (true) {
+    if (_ring.lost(client.cursor)) {
+      dropClient(client, true);
+      return;
+    }
+    const uint8_t* data;
+    size_t length = _ring.readable(client.cursor, &data);
+    if (length == 0) {
+      return;
+    }
+    ssize_t sent = send(client.fd, data, length, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent > 0) {
+      client.cursor += (uint64_t)sent;
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+      return;
+    }
+    dropClient(client, false);
+    return;
+  }
+}
+
+void TelemetryHub::dropClient(Client& client, bool slow) {
+  ::close(client.fd);
+  client.fd = -1;
+  if (slow) {
+    _stats.clientsDropped++;
+  } else {
+    _stats.clientsClosed++;
+  }
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ClockSync.h"
+#include "Telemetry.h"
+
+// Host-side fan-out of the stand's serial output (Linux/POSIX).
+// One process owns the serial port (or a PTY stand-in), splits the stream
+// into text lines and CRC-checked binary frames once, and serves every
+// record to any number of local subscribers over a Unix socket and/or TCP.
+// Subscriber lines (console commands) are forwarded to the stand.
+// The hub also runs the clock exchange (`sync <token>`) and publishes the
+// device-to-host time fit as a CLOCK_MAP frame after every reply.
+
+const size_t HUB_MAX_CLIENTS = 16;
+const size_t HUB_MAX_LINE = 512;   // Longer text runs are passed on in pieces
+const size_t HUB_DEFAULT_RING = 1 << 20;
+
+// Byte ring shared by all subscribers. The writer never waits: each client
+// has its own cursor, and a client more than `capacity` bytes behind has
+// lost data and must be dropped.
+class FanoutRing {
+ public:
+  explicit FanoutRing(size_t capacity);
+  ~FanoutRing();
+  FanoutRing(const FanoutRing&) = delete;
+  FanoutRing& operator=(const FanoutRing&) = delete;
+
+  void append(const uint8_t* data, size_t length);
+
+  // Contiguous bytes readable from cursor (up to the wrap point)
+  size_t readable(uint64_t cursor, const uint8_t** data) const;
+  bool lost(uint64_t cursor) const { return _head - cursor > _capacity; }
+
+  uint64_t head() const { return _head; }
+  size_t capacity() const { return _capacity; }
+
+ private:
+  uint8_t* _buffer;
+  size_t _capacity;
+  uint64_t _head;  // total bytes ever written
+};
+
+// Receives complete records from the splitter
+class RecordSink {
+ public:
+  virtual ~RecordSink() {}
+  virtual void onRecord(const uint8_t* data, size_t length, bool frame) = 0;
+};
+
+// Splits the mixed serial stream: ASCII text lines pass through whole,
+// binary frames are passed on only with a valid CRC
+class StreamSplitter {
+ public:
+  StreamSplitter() : _lineLength(0), _lines(0), _frames(0), _badFrames(0) {}
+
+  void feed(const uint8_t* data, size_t length, RecordSink& sink);
+
+  uint32_t lines() const { return _lines; }
+  uint32_t frames() const { return _frames; }
+  uint32_t badFrames() const { return _badFrames; }
+
+ private:
+  TelemetryDecoder _decoder;
+  uint8_t _line[HUB_MAX_LINE];
+  size_t _lineLength;
+  uint32_t _lines;
+  uint32_t _frames;
+  uint32_t _badFrames;
+};
+
+struct HubConfig {
+  const char* serialPath;  // serial device or PTY slave
+  int baud;                // 0 = keep the current speed (PTY)
+  const char* unixPath;    // nullptr = no Unix socket
+  int tcpPort;             // 0 = no TCP listener (binds 127.0.0.1)
+  size_t ringBytes;        // also the lag at which a client is dropped
+  int clientSendBuffer;    // SO_SNDBUF per client, 0 = system default
+  int syncPeriodMs;        // clock exchange interval, 0 = off
+};
+
+HubConfig defaultHubConfig();
+
+struct HubStats {
+  uint64_t serialBytes;
+  uint32_t serialReopens;
+  uint32_t clientsAccepted;
+  uint32_t clientsDropped;  // too slow, fell off the ring
+  uint32_t clientsClosed;   // disconnected normally
+  uint32_t commandsForwarded;
+  uint32_t syncSent;
+  uint32_t syncReplies;  // matched and fitted
+};
+
+class TelemetryHub : private RecordSink {
+ public:
+  explicit TelemetryHub(const HubConfig& config);
+  ~TelemetryHub();
+
+  // Opens the listeners and the serial port; false (with errno) on failure
+  bool open();
+  void close();
+
+  // One event-loop pass; waits at most timeoutMs for activity
+  void pollOnce(int timeoutMs);
+
+  size_t clientCount() const;
+  const HubStats& stats() const { return _stats; }
+  const StreamSplitter& splitter() const { return _splitter; }
+  const ClockSync& clock() const { return _clock; }
+
+ private:
+  struct Client {
+    int fd;
+    uint64_t cursor;
+    char command[HUB_MAX_LINE];
+    size_t commandLength;
+  };
+
+  void onRecord(const uint8_t* data, size_t length, bool frame) override;
+
+  bool openSerial();
+  void closeSerial();
+  int openUnixListener(const char* path);
+  int openTcpListener(int port);
+  void acceptClient(int listenFd);
+  void readSerial();
+  void readClient(Client& client);
+  void flushClient(Client& client);
+  void dropClient(Client& client, bool slow);
+  void sendSync();
+  void syncReply(const uint8_t* payload, size_t length);
+
+  HubConfig _config;
+  FanoutRing _ring;
+  StreamSplitter _splitter;
+  int _serialFd;
+  int _unixFd;
+  int _tcpFd;
+  long long _serialRetryMs;
+  Client _clients[HUB_MAX_CLIENTS];
+  HubStats _stats;
+  ClockSync _clock;
+  long long _nextSyncMs;
+  uint32_t _syncToken;
+  bool _syncPending;
+  int64_t _syncSentUs;
+  int64_t _readUs;  // monotonic time of the serial read being split
+};
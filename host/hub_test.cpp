@@ -0,0 +1,364 @@
+// Telemetry hub checks - a PTY stands in for the ESP32, no hardware required
+// Build and run: make test-hub
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <pty.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ClockSync.h"
+#include "Telemetry.h"
+#include "TelemetryHub.h"
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+  printf("[%s] %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) {
+    failures++;
+  }
+}
+
+static int connectUnix(const char* path, int receiveBuffer) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (receiveBuffer > 0) {
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+  }
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  return fd;
+}
+
+// Appends whatever the socket has to out
+static size_t drainSocket(int fd, uint8_t* out, size_t used, size_t capacity) {
+  while (used < capacity) {
+    ssize_t n = recv(fd, out + used, capacity - used, 0);
+    if (n <= 0) break;
+    used += (size_t)n;
+  }
+  return used;
+}
+
+// Writes everything to the PTY master, letting the hub run while it is full
+static void standWrite(int master, TelemetryHub& hub, const uint8_t* data, size_t length) {
+  size_t done = 0;
+  while (done < length) {
+    ssize_t n = write(master, data + done, length - done);
+    if (n > 0) {
+      done += (size_t)n;
+    } else {
+      hub.pollOnce(1);
+    }
+  }
+}
+
+static size_t makeFrame(uint8_t type, uint32_t value, uint8_t* out) {
+  uint8_t payload[4];
+  PayloadWriter writer(payload, sizeof(payload));
+  writer.putU32(value);
+  return encodeTelemetryFrame(type, payload, writer.length(), out, TELEMETRY_MAX_FRAME);
+}
+
+class CountingSink : public RecordSink {
+ public:
+  int lines = 0;
+  int frames = 0;
+  void onRecord(const uint8_t*, size_t, bool frame) override { frame ? frames++ : lines++; }
+};
+
+static void testRingAndSplitter() {
+  FanoutRing ring(16);
+  const uint8_t data[24] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20};
+  ring.append(data, 10);
+  const uint8_t* chunk;
+  check(ring.readable(0, &chunk) == 10 && chunk[9] == 10, "ring: reader sees appended bytes");
+  ring.append(data + 10, 10);
+  check(ring.lost(0) && !ring.lost(4), "ring: cursor more than capacity behind is lost");
+  size_t first = ring.readable(4, &chunk);
+  check(first == 12 && chunk[0] == 5, "ring: read stops at the wrap point");
+  check(ring.readable(16, &chunk) == 4 && chunk[0] == 17, "ring: read continues after the wrap");
+
+  StreamSplitter splitter;
+  CountingSink sink;
+  uint8_t stream[256];
+  size_t n = 0;
+  const char* text = "1250us\t| 64%\t| 0.313 kg\r\n";
+  memcpy(stream, text, strlen(text));
+  n += strlen(text);
+  n += makeFrame(TELEMETRY_BURST_RESULT, 42, stream + n);
+  size_t bad = n;
+  n += makeFrame(TELEMETRY_BURST_RESULT, 43, stream + n);
+  stream[bad + 6] ^= 0xFF;  // corrupt the payload
+  stream[n++] = '\r';
+  stream[n++] = '\n';
+  splitter.feed(stream, n, sink);
+  check(sink.lines == 2 && sink.frames == 1, "splitter: text lines and good frames passed on");
+  check(splitter.badFrames() == 1, "splitter: corrupted frame dropped and counted");
+}
+
+static void testHubOverPty() {
+  int master = -1;
+  int slave = -1;
+  char slavePath[128];
+  if (openpty(&master, &slave, slavePath, nullptr, nullptr) < 0) {
+    check(false, "hub: openpty");
+    return;
+  }
+  close(slave);  // the hub opens it by path, like a real port
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+
+  char socketPath[64];
+  snprintf(socketPath, sizeof(socketPath), "/tmp/hub_test_%d.sock", (int)getpid());
+  HubConfig config = defaultHubConfig();
+  config.serialPath = slavePath;
+  config.baud = 0;
+  config.unixPath = socketPath;
+  config.ringBytes = 64 * 1024;
+  config.clientSendBuffer = 4096;
+  config.syncPeriodMs = 0;  // the stream and commands below are checked byte for byte
+  TelemetryHub hub(config);
+  check(hub.open(), "hub: opens PTY and Unix socket");
+
+  int fast = connectUnix(socketPath, 0);
+  int second = connectUnix(socketPath, 0);
+  int slow = connectUnix(socketPath, 4096);
+  for (int i = 0; i < 10 && hub.clientCount() < 3; i++) {
+    hub.pollOnce(10);
+  }
+  check(hub.clientCount() == 3, "hub: three subscribers connected");
+
+  // Text and frames reach every subscriber
+  uint8_t out[2][4096];
+  size_t got[2] = {0, 0};
+  uint8_t chunk[512];
+  size_t n = 0;
+  const char* line = "=== Step Capture Mode ===\r\n";
+  memcpy(chunk, line, strlen(line));
+  n += strlen(line);
+  n += makeFrame(TELEMETRY_BURST_HEADER, 7, chunk + n);
+  standWrite(master, hub, chunk, n);
+  for (int i = 0; i < 20 && (got[0] < n || got[1] < n); i++) {
+    hub.pollOnce(5);
+    got[0] = drainSocket(fast, out[0], got[0], sizeof(out[0]));
+    got[1] = drainSocket(second, out[1], got[1], sizeof(out[1]));
+  }
+  check(got[0] == n && memcmp(out[0], chunk, n) == 0, "hub: first client gets the exact stream");
+  check(got[1] == n && memcmp(out[1], chunk, n) == 0, "hub: second client gets the same stream");
+
+  // A subscriber line goes to the stand as a console command
+  const char* command = "stats\n";
+  send(second, command, strlen(command), 0);
+  char received[64] = {0};
+  size_t receivedLength = 0;
+  for (int i = 0; i < 20 && receivedLength < strlen(command); i++) {
+    hub.pollOnce(5);
+    ssize_t r = read(master, received + receivedLength, sizeof(received) - 1 - receivedLength);
+    if (r > 0) receivedLength += (size_t)r;
+  }
+  check(strcmp(received, command) == 0, "hub: client command forwarded to the stand");
+
+  // Flood: the client that never reads is dropped, the others keep up
+  const size_t FLOOD_BYTES = 2 * 1024 * 1024;
+  char row[64];
+  size_t sent = 0;
+  uint64_t fastBytes = 0;
+  bool fastIntact = true;
+  int rowIndex = 0;
+  int expectedRow = 0;
+  char pending[128];
+  size_t pendingLength = 0;
+  while (sent < FLOOD_BYTES) {
+    int length = snprintf(row, sizeof(row), "%06dus\t| 64%%\t| 0.313 kg\r\n", rowIndex++);
+    standWrite(master, hub, (const uint8_t*)row, (size_t)length);
+    sent += (size_t)length;
+    if ((rowIndex & 15) == 0) {
+      hub.pollOnce(0);
+      // The fast client checks every row arrives in order
+      uint8_t buffer[8192];
+      size_t got2 = drainSocket(fast, buffer, 0, sizeof(buffer));
+      fastBytes += got2;
+      for (size_t i = 0; i < got2; i++) {
+        pending[pendingLength++] = (char)buffer[i];
+        if (buffer[i] == '\n') {
+          if (atoi(pending) != expectedRow++) fastIntact = false;
+          pendingLength = 0;
+        }
+        if (pendingLength >= sizeof(pending)) pendingLength = 0;
+      }
+      drainSocket(second, buffer, 0, sizeof(buffer));
+    }
+  }
+  for (int i = 0; i < 50; i++) {
+    hub.pollOnce(2);
+    uint8_t buffer[8192];
+    fastBytes += drainSocket(fast, buffer, 0, sizeof(buffer));
+    drainSocket(second, buffer, 0, sizeof(buffer));
+  }
+  check(hub.stats().clientsDropped == 1 && hub.clientCount() == 2, "hub: slow client dropped");
+  check(fastBytes == sent && fastIntact && expectedRow > 0, "hub: fast client received every row in order");
+
+  // Stand disappears (USB unplugged): the hub survives and reopens
+  close(master);
+  for (int i = 0; i < 5; i++) {
+    hub.pollOnce(5);
+  }
+  check(hub.clientCount() == 2, "hub: subscribers stay connected while the port is gone");
+
+  close(fast);
+  close(second);
+  close(slow);
+  hub.close();
+}
+
+static int64_t realtimeUs() {
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// Device clock 80 ppm slow and 5 s into its uptime; round trips 0.3-3 ms,
+// every fifth held up 20 ms on one leg
+static void testClockSync() {
+  const double DEVICE_RATE = 1.0 - 80e-6;
+  ClockSync sync;
+  uint32_t seed = 12345;
+  int64_t worstUs = 0;
+  for (int i = 0; i < 120; i++) {
+    int64_t sendUs = 1000000000LL + i * 1000000LL;
+    seed = seed * 1103515245 + 12345;
+    int64_t upUs = 150 + (seed >> 16) % 1350;
+    int64_t downUs = 150 + (seed >> 8) % 1350;
+    if (i % 5 == 3) upUs += 20000;
+    int64_t stampUs = sendUs + upUs;
+    uint64_t deviceUs = 5000000 + (uint64_t)((stampUs - 1000000000LL) * DEVICE_RATE);
+    sync.add(sendUs, deviceUs, stampUs + downUs);
+    if (i >= 64) {
+      int64_t error = sync.toHostUs(deviceUs) - stampUs;
+      if (error < 0) error = -error;
+      if (error > worstUs) worstUs = error;
+    }
+  }
+  check(sync.samples() == CLOCK_SYNC_WINDOW && sync.exchanges() == 120, "clock: sliding window of exchanges");
+  check(fabs(sync.driftPpm() - 80.0) < 2.0, "clock: drift estimated within 2 ppm");
+  check(worstUs < 1000 && sync.errorUs() < 1500, "clock: device times mapped within 1 ms");
+  printf("       drift %.2f ppm (80 true), worst mapping error %lld us, reported bound %lld us\n",
+         sync.driftPpm(), (long long)worstUs, (long long)sync.errorUs());
+
+  ClockMap map = sync.map(0);
+  uint8_t payload[32];
+  ClockMap decoded;
+  size_t n = encodeClockMap(map, payload, sizeof(payload));
+  check(n > 0 && decodeClockMap(payload, n, decoded) &&
+        mapToHostUs(decoded, map.deviceUs + 1000000) - sync.toHostUs(map.deviceUs + 1000000) == 0,
+        "clock: published map gives the same host times");
+  check(unwrapDeviceUs(map, (uint32_t)(map.deviceUs - 5000)) == map.deviceUs - 5000 &&
+        unwrapDeviceUs(map, (uint32_t)(map.deviceUs + 7000)) == map.deviceUs + 7000,
+        "clock: 32-bit event times unwrapped around the reference");
+
+  check(sync.add(2000000000LL, 1000, 2000000500LL) && sync.restarts() == 1 && sync.samples() == 1,
+        "clock: device reboot restarts the fit");
+  check(!sync.add(10, 2000, 5), "clock: negative round trip rejected");
+}
+
+// The PTY answers `sync` like the firmware; subscribers get CLOCK_MAP frames
+static void testHubClockSync() {
+  int master = -1;
+  int slave = -1;
+  char slavePath[128];
+  if (openpty(&master, &slave, slavePath, nullptr, nullptr) < 0) {
+    check(false, "sync: openpty");
+    return;
+  }
+  close(slave);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL, 0) | O_NONBLOCK);
+
+  char socketPath[64];
+  snprintf(socketPath, sizeof(socketPath), "/tmp/hub_sync_%d.sock", (int)getpid());
+  HubConfig config = defaultHubConfig();
+  config.serialPath = slavePath;
+  config.baud = 0;
+  config.unixPath = socketPath;
+  config.syncPeriodMs = 20;
+  TelemetryHub hub(config);
+  check(hub.open(), "sync: hub opens");
+  int client = connectUnix(socketPath, 0);
+
+  // Device clock: its own epoch, 1 s of uptime at the start
+  const int64_t bootUs = realtimeUs() - 1000000;
+  char line[64];
+  size_t lineLength = 0;
+  TelemetryDecoder decoder;
+  ClockMap last;
+  int maps = 0;
+  int64_t start = realtimeUs();
+  while (realtimeUs() - start < 600000) {
+    hub.pollOnce(5);
+    char byte;
+    while (read(master, &byte, 1) == 1) {
+      if (lineLength < sizeof(line) - 1) line[lineLength++] = byte;
+      if (byte != '\n') continue;
+      line[lineLength] = '\0';
+      lineLength = 0;
+      unsigned token;
+      if (sscanf(line, "sync %u", &token) == 1) {
+        uint8_t payload[12];
+        PayloadWriter writer(payload, sizeof(payload));
+        writer.putU32(token);
+        writer.putU64((uint64_t)(realtimeUs() - bootUs));
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        size_t n = encodeTelemetryFrame(TELEMETRY_TIME_SYNC, payload, writer.length(), frame, sizeof(frame));
+        standWrite(master, hub, frame, n);
+      }
+    }
+    uint8_t buffer[4096];
+    size_t got = drainSocket(client, buffer, 0, sizeof(buffer));
+    for (size_t i = 0; i < got; i++) {
+      if (decoder.feed(buffer[i]) && decoder.type() == TELEMETRY_CLOCK_MAP &&
+          decodeClockMap(decoder.payload(), decoder.length(), last)) {
+        maps++;
+      }
+    }
+  }
+  const HubStats& stats = hub.stats();
+  check(stats.syncSent >= 10 && stats.syncReplies >= 10 && maps >= 10, "sync: exchanges answered and published");
+
+  // The map puts a device instant at the host time it happened
+  int64_t deviceNowUs = realtimeUs() - bootUs;
+  int64_t errorUs = mapToHostUs(last, (uint64_t)deviceNowUs) - (deviceNowUs + bootUs);
+  if (errorUs < 0) errorUs = -errorUs;
+  check(errorUs <= (int64_t)last.errorUs + 1000, "sync: device time mapped to Unix time within the bound");
+  printf("       %u exchanges, best round trip %u us, mapping error %lld us\n", stats.syncReplies, last.rttUs,
+         (long long)errorUs);
+
+  close(client);
+  close(master);
+  hub.close();
+}
+
+int main() {
+  printf("=== Telemetry Hub Checks ===\n\n");
+
+  testRingAndSplitter();
+  testHubOverPty();
+  testClockSync();
+  testHubClockSync();
+
+  printf("\n%s (%d failure%s)\n", failures == 0 ? "ALL PASSED" : "FAILED",
+         failures, failures == 1 ? "" : "s");
+  return failures == 0 ? 0 : 1;
+}
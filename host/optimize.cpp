@@ -0,0 +1,154 @@
+// Design optimizer - ranks motor/prop/battery and frame combinations over the run database
+// Build: make optimize
+//
+// Usage: optimize <db> [--rank payload|efficiency] [--motors 4,6,8] [--tw FROM:TO:STEP]
+//                 [--airframe FROM:TO:STEP] [--payload KG] [--top N] [--threads N]
+//                 [--motor NAME] [--prop NAME] [--prop-in INCHES]
+//
+// Every stored sweep (or those matching the filters) is a thrust curve; each is
+// tried on every frame of the grid: motor count x thrust-to-weight ratio x
+// airframe weight. --rank payload lists the largest payloads; --rank efficiency
+// lists the most grams per watt in hover with --payload on board.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include "PayloadOptimizer.h"
+#include "RunStore.h"
+
+static void usage() {
+  fprintf(stderr,
+          "usage: optimize <db> [--rank payload|efficiency] [--motors 4,6,8] [--tw FROM:TO:STEP]\n"
+          "                [--airframe FROM:TO:STEP] [--payload KG] [--top N] [--threads N]\n"
+          "                [--motor NAME] [--prop NAME] [--prop-in IN]\n");
+}
+
+static bool parseList(const char* text, std::vector<int>& out) {
+  out.clear();
+  const char* p = text;
+  while (*p != '\0') {
+    char* end;
+    long value = strtol(p, &end, 10);
+    if (end == p || value < 1 || value > 64) return false;
+    out.push_back((int)value);
+    p = *end == ',' ? end + 1 : end;
+    if (*end != ',' && *end != '\0') return false;
+  }
+  return !out.empty();
+}
+
+// Whole number of at least 1
+static bool parseCount(const char* text, size_t& out) {
+  char* end;
+  long value = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || value < 1) return false;
+  out = (size_t)value;
+  return true;
+}
+
+// FROM:TO:STEP, both ends included
+static bool parseRange(const char* text, float minimum, std::vector<float>& out) {
+  float from, to, step;
+  if (sscanf(text, "%f:%f:%f", &from, &to, &step) != 3 || step <= 0.0f || from < minimum || to < from) {
+    return false;
+  }
+  out.clear();
+  int count = (int)((to - from) / step + 1.5f);
+  for (int i = 0; i < count; i++) {
+    out.push_back(from + step * i);
+  }
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  DesignGrid grid;
+  grid.motors = {4, 6, 8};
+  parseRange("1.5:4.0:0.1", 1.0f, grid.twRatios);
+  parseRange("0.2:3.0:0.01", 0.0f, grid.airframeKg);
+  grid.payloadKg = 0.0f;
+  DesignObjective objective = OBJ_PAYLOAD;
+  size_t top = 20;
+  int threads = (int)std::thread::hardware_concurrency();
+  RunFilter filter = anyRun();
+
+  for (int i = 2; i < argc; i++) {
+    if (i + 1 >= argc) {
+      usage();
+      return 2;
+    }
+    const char* name = argv[i];
+    const char* value = argv[++i];
+    bool ok = true;
+    if (strcmp(name, "--rank") == 0) {
+      ok = strcmp(value, "payload") == 0 || strcmp(value, "efficiency") == 0;
+      objective = strcmp(value, "efficiency") == 0 ? OBJ_HOVER_EFFICIENCY : OBJ_PAYLOAD;
+    } else if (strcmp(name, "--motors") == 0) ok = parseList(value, grid.motors);
+    else if (strcmp(name, "--tw") == 0) ok = parseRange(value, 1.0f, grid.twRatios);
+    else if (strcmp(name, "--airframe") == 0) ok = parseRange(value, 0.0f, grid.airframeKg);
+    else if (strcmp(name, "--payload") == 0) grid.payloadKg = strtof(value, nullptr);
+    else if (strcmp(name, "--top") == 0) ok = parseCount(value, top);
+    else if (strcmp(name, "--threads") == 0) threads = atoi(value);
+    else if (strcmp(name, "--motor") == 0) filter.motor = value;
+    else if (strcmp(name, "--prop") == 0) filter.prop = value;
+    else if (strcmp(name, "--prop-in") == 0) filter.propDiameterIn = strtof(value, nullptr);
+    else ok = false;
+    if (!ok) {
+      usage();
+      return 2;
+    }
+  }
+
+  RunStore store;
+  if (!store.open(argv[1], false)) {
+    perror(argv[1]);
+    return 1;
+  }
+  const RunMeta* runs = store.runs();
+  const float* thrust = store.floatColumn(COL_THRUST);
+  const float* power = store.floatColumn(COL_POWER);
+  std::vector<ThrustCurve> curves;
+  std::vector<const RunMeta*> curveRuns;
+  for (size_t i = 0; i < store.runCount() && thrust != nullptr; i++) {
+    const RunMeta& run = runs[i];
+    if (!runMatches(run, filter)) continue;
+    ThrustCurve curve;
+    if (buildThrustCurve(run.runId, thrust + run.firstPoint, power != nullptr ? power + run.firstPoint : nullptr,
+                         run.pointCount, curve)) {
+      curves.push_back(curve);
+      curveRuns.push_back(&run);
+    }
+  }
+  if (curves.empty()) {
+    fprintf(stderr, "%s: no matching runs with thrust data\n", argv[1]);
+    return 1;
+  }
+
+  OptimizerStats stats;
+  std::vector<DesignResult> ranked = rankDesigns(curves, grid, objective, top, threads, stats);
+
+  printf("%-4s %-20s %-12s %-14s %6s %6s %5s %8s %8s %8s %6s\n", "#", "motor", "prop", "battery", "run",
+         "motors", "T/W", "frame_kg", "payload", "hover_W", "g/W");
+  for (size_t i = 0; i < ranked.size(); i++) {
+    const DesignResult& r = ranked[i];
+    const RunMeta& run = *curveRuns[r.curve];
+    printf("%-4zu %-20.32s %-12.24s %-14.24s %6u %6d %5.2f %8.3f %8.3f %8.1f %6.2f\n", i + 1, run.motor, run.prop,
+           run.battery, run.runId, r.motors, r.twRatio, r.airframeKg, r.payloadKg, r.hoverPowerW, r.hoverGPerW);
+  }
+  if (ranked.empty()) {
+    printf("no design carries %.3f kg\n", grid.payloadKg);
+  }
+  printf("\n%zu curves x %zu frames = %llu designs, %llu feasible, %.3f s on %d thread%s (%.1f M designs/s)\n",
+         curves.size(), grid.motors.size() * grid.twRatios.size() * grid.airframeKg.size(),
+         (unsigned long long)stats.evaluated, (unsigned long long)stats.feasible, stats.seconds, stats.threads,
+         stats.threads == 1 ? "" : "s", stats.seconds > 0.0 ? stats.evaluated / stats.seconds / 1e6 : 0.0);
+  return 0;
+}
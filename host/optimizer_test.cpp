@@ -0,0 +1,220 @@
+// Design optimizer checks - synthetic thrust curves, batched against the scalar path
+// Build and run: make test-optimize
+
+#include <math.h>
+#include <stdio.h>
+
+#include <thread>
+#include <vector>
+
+#include "PayloadOptimizer.h"
+#include "Sweep.h"
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+  printf("[%s] %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) {
+    failures++;
+  }
+}
+
+// Same shape as the run database checks: 1340 -> 1210 -> 1340 in 10 us steps,
+// thrust and current both square in throttle. `lossFactor` scales the current.
+// The fastest step is 130/140 throttle, so the curve peaks at PEAK * maxThrust.
+const float PEAK = (130.0f / 140.0f) * (130.0f / 140.0f);
+
+static ThrustCurve makeCurve(uint32_t runId, float maxThrust, float lossFactor) {
+  float thrust[28];
+  float power[28];
+  size_t count = 0;
+  for (int phase = 0; phase < 2; phase++) {
+    for (int i = 0; i < 14; i++) {
+      int pwm = phase == 0 ? 1340 - i * 10 : 1210 + i * 10;
+      float throttle = (1340 - pwm) / 140.0f;
+      thrust[count] = maxThrust * throttle * throttle;
+      power[count] = 16.4f * (1.0f + 30.0f * lossFactor * throttle * throttle);
+      count++;
+    }
+  }
+  ThrustCurve curve;
+  buildThrustCurve(runId, thrust, power, count, curve);
+  return curve;
+}
+
+static void fillRange(std::vector<float>& out, float from, float to, float step) {
+  out.clear();
+  int count = (int)((to - from) / step + 1.5f);
+  for (int i = 0; i < count; i++) {
+    out.push_back(from + step * i);
+  }
+}
+
+static bool sameResults(const std::vector<DesignResult>& a, const std::vector<DesignResult>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].order != b[i].order || a[i].curve != b[i].curve || a[i].score != b[i].score) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void testCurve() {
+  ThrustCurve curve = makeCurve(7, 0.8f, 1.0f);
+  check(curve.runId == 7 && fabsf(curve.maxThrustKg - 0.8f * PEAK) < 1e-6f, "curve: peak thrust of the sweep");
+  check(curve.hasPower, "curve: power present");
+
+  // Thrust 0.8 * t^2 draws 16.4 * (1 + 30 t^2) W, so power is linear in thrust
+  float worst = 0.0f;
+  for (float kg = 0.05f; kg <= 0.65f; kg += 0.05f) {
+    float expected = 16.4f * (1.0f + 30.0f * kg / 0.8f);
+    worst = fmaxf(worst, fabsf(curvePowerW(curve, kg) - expected));
+  }
+  check(worst < 0.01f, "curve: power interpolated between measured steps");
+  check(fabsf(curvePowerW(curve, curve.maxThrustKg) - 16.4f * (1.0f + 30.0f * PEAK)) < 0.01f,
+        "curve: power at full thrust");
+
+  float thrust[] = {0.0f, 0.0f, 0.3f};
+  float power[] = {16.0f, 17.0f, 60.0f};
+  ThrustCurve flat;
+  check(!buildThrustCurve(1, thrust, power, 3, flat), "curve: one row with thrust is rejected");
+
+  float thrust2[] = {0.1f, 0.3f};
+  float power2[] = {NAN, NAN};
+  ThrustCurve unpowered;
+  check(buildThrustCurve(2, thrust2, power2, 2, unpowered) && !unpowered.hasPower,
+        "curve: sweep without power monitor kept, marked");
+}
+
+static void testAgainstScalar() {
+  std::vector<ThrustCurve> curves = {makeCurve(1, 0.8f, 1.0f), makeCurve(2, 1.2f, 1.3f)};
+  DesignGrid grid;
+  grid.motors = {4, 6};
+  fillRange(grid.twRatios, 1.5f, 3.0f, 0.25f);
+  fillRange(grid.airframeKg, 0.3f, 1.5f, 0.1f);
+  grid.payloadKg = 0.2f;
+
+  OptimizerStats stats;
+  std::vector<DesignResult> all = rankDesigns(curves, grid, OBJ_PAYLOAD, 100000, 1, stats);
+  check(stats.evaluated == 2 * 2 * 7 * 13, "grid: every design evaluated");
+  check(stats.feasible == all.size() && !all.empty(), "grid: feasible designs all returned");
+
+  bool matchScalar = true;
+  bool matchSweep = true;
+  bool feasible = true;
+  for (const DesignResult& r : all) {
+    const ThrustCurve& curve = curves[r.curve];
+    DesignResult s = evaluateDesign(curve, r.motors, r.twRatio, r.airframeKg, grid.payloadKg);
+    if (s.payloadKg != r.payloadKg || s.hoverPowerW != r.hoverPowerW || s.hoverGPerW != r.hoverGPerW) {
+      matchScalar = false;
+    }
+    PayloadModel model = {r.airframeKg, r.motors, r.twRatio};
+    if (fabsf(payloadCapacityKg(curve.maxThrustKg, model) - r.payloadKg) > 1e-5f) {
+      matchSweep = false;
+    }
+    if (r.payloadKg < grid.payloadKg) {
+      feasible = false;
+    }
+  }
+  check(matchScalar, "grid: batched results equal the scalar path");
+  check(matchSweep, "grid: payload equals the stand's payloadCapacityKg()");
+  check(feasible, "grid: nothing below the required payload");
+
+  bool sorted = true;
+  for (size_t i = 1; i < all.size(); i++) {
+    if (all[i].score > all[i - 1].score) sorted = false;
+  }
+  check(sorted, "grid: ranked best first");
+}
+
+static void testRanking() {
+  // Curve 1 lifts most; curve 2 lifts less but wastes less
+  std::vector<ThrustCurve> curves = {makeCurve(10, 0.6f, 1.0f), makeCurve(11, 1.0f, 1.0f),
+                                     makeCurve(12, 0.8f, 0.6f)};
+  DesignGrid grid;
+  grid.motors = {4, 6, 8};
+  fillRange(grid.twRatios, 2.0f, 3.0f, 0.5f);
+  fillRange(grid.airframeKg, 0.5f, 1.0f, 0.25f);
+  grid.payloadKg = 0.3f;
+
+  OptimizerStats stats;
+  std::vector<DesignResult> best = rankDesigns(curves, grid, OBJ_PAYLOAD, 5, 2, stats);
+  check(best.size() == 5, "rank: top N kept");
+  const DesignResult& top = best[0];
+  check(top.curve == 1 && top.motors == 8 && top.twRatio == 2.0f && top.airframeKg == 0.5f,
+        "rank: payload picks strongest motor, most motors, lowest T/W, lightest frame");
+  check(fabsf(top.payloadKg - (PEAK * 8 / 2.0f - 0.5f)) < 1e-5f, "rank: payload value");
+
+  std::vector<DesignResult> efficient = rankDesigns(curves, grid, OBJ_HOVER_EFFICIENCY, 5, 2, stats);
+  check(!efficient.empty() && efficient[0].curve == 2, "rank: efficiency picks the low-loss motor");
+  check(!efficient.empty() && efficient[0].score == efficient[0].hoverGPerW && efficient[0].hoverGPerW > 0.0f,
+        "rank: efficiency score is hover g/W");
+
+  grid.payloadKg = 50.0f;
+  std::vector<DesignResult> none = rankDesigns(curves, grid, OBJ_PAYLOAD, 5, 2, stats);
+  check(none.empty() && stats.feasible == 0, "rank: impossible payload gives no designs");
+
+  grid.payloadKg = 0.3f;
+  std::vector<DesignResult> empty = rankDesigns(curves, grid, OBJ_PAYLOAD, 0, 2, stats);
+  check(empty.empty() && stats.evaluated == 3 * 3 * 3 * 3, "rank: top 0 keeps nothing but still counts");
+}
+
+static void testThreads() {
+  std::vector<ThrustCurve> curves;
+  for (int i = 0; i < 40; i++) {
+    curves.push_back(makeCurve(i, 0.4f + (i % 7) * 0.1f, 0.8f + (i % 5) * 0.1f));
+  }
+  DesignGrid grid;
+  grid.motors = {4, 6, 8};
+  fillRange(grid.twRatios, 1.5f, 4.0f, 0.1f);
+  fillRange(grid.airframeKg, 0.2f, 2.0f, 0.01f);
+  grid.payloadKg = 0.25f;
+
+  OptimizerStats one;
+  OptimizerStats four;
+  std::vector<DesignResult> a = rankDesigns(curves, grid, OBJ_PAYLOAD, 50, 1, one);
+  std::vector<DesignResult> b = rankDesigns(curves, grid, OBJ_PAYLOAD, 50, 4, four);
+  check(four.threads == 4 && sameResults(a, b) && one.feasible == four.feasible,
+        "threads: payload ranking same on 1 and 4 threads");
+  a = rankDesigns(curves, grid, OBJ_HOVER_EFFICIENCY, 50, 1, one);
+  b = rankDesigns(curves, grid, OBJ_HOVER_EFFICIENCY, 50, 4, four);
+  check(sameResults(a, b), "threads: efficiency ranking same on 1 and 4 threads");
+}
+
+static void testThroughput() {
+  std::vector<ThrustCurve> curves;
+  for (int i = 0; i < 100; i++) {
+    curves.push_back(makeCurve(i, 0.3f + i * 0.01f, 0.7f + (i % 9) * 0.05f));
+  }
+  DesignGrid grid;
+  grid.motors = {4, 6, 8};
+  fillRange(grid.twRatios, 1.5f, 4.0f, 0.1f);
+  fillRange(grid.airframeKg, 0.2f, 3.0f, 0.002f);
+  grid.payloadKg = 0.5f;
+
+  int threads = (int)std::thread::hardware_concurrency();
+  OptimizerStats stats;
+  std::vector<DesignResult> best = rankDesigns(curves, grid, OBJ_HOVER_EFFICIENCY, 20, threads, stats);
+  check(stats.evaluated > 10000000 && best.size() == 20, "throughput: over ten million designs ranked");
+  check(stats.seconds < 5.0, "throughput: within seconds");
+  printf("       %llu designs on %d thread%s in %.3f s (%.1f M designs/s)\n",
+         (unsigned long long)stats.evaluated, stats.threads, stats.threads == 1 ? "" : "s", stats.seconds,
+         stats.evaluated / stats.seconds / 1e6);
+}
+
+int main() {
+  printf("=== Design Optimizer Checks ===\n\n");
+
+  testCurve();
+  testAgainstScalar();
+  testRanking();
+  testThreads();
+  testThroughput();
+
+  printf("\n%s (%d failure%s)\n", failures == 0 ? "ALL PASSED" : "FAILED",
+         failures, failures == 1 ? "" : "s");
+  return failures == 0 ? 0 : 1;
+}
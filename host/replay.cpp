@@ -0,0 +1,230 @@
+// Replay - runs a recorded sweep through the stand's processing code on the host
+// Build: make replay    Run: make replay-run LOG=run.log ARGS="--ab --settle 3"
+//
+// Usage: replay <log> [--no-zero-track] [--settle N] [--ab]
+//
+// <log> is a saved serial log (e.g. from the telemetry hub) of runs made with
+// `set record 1`. Without options the sweep is recomputed as the stand did it;
+// the options change the processing, and --ab prints both side by side.
+// With a log saved through the telemetry hub, runs are also placed in Unix
+// time from the hub's CLOCK_MAP frames.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ClockSync.h"
+#include "RawRecord.h"
+#include "Telemetry.h"
+
+struct ReplayedStep {
+  int pwm;
+  StepPowerResult result;
+};
+
+struct ReplayedRun {
+  ReplayRun run;
+  std::vector<ReplayedStep> steps;
+  bool hasClock;
+  ClockMap clock;  // latest from the hub when the run ended
+};
+
+// Collects every run of the log
+class RunCollector : public ReplayListener {
+ public:
+  void runStarted(const RecordHeader&) override { _steps.clear(); }
+
+  void stepDone(int pwm, const StepPowerResult& step) override {
+    ReplayedStep s = {pwm, step};
+    _steps.push_back(s);
+  }
+
+  void runEnded(const ReplayRun& run) override {
+    ReplayedRun r;
+    r.run = run;
+    r.steps = _steps;
+    r.hasClock = hasClock;
+    r.clock = clock;
+    runs.push_back(r);
+  }
+
+  std::vector<ReplayedRun> runs;
+  bool hasClock = false;
+  ClockMap clock;
+
+ private:
+  std::vector<ReplayedStep> _steps;
+};
+
+static void usage() {
+  fprintf(stderr, "usage: replay <log> [--no-zero-track] [--settle N] [--ab]\n");
+}
+
+static bool readFile(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (f == nullptr) {
+    return false;
+  }
+  uint8_t buffer[65536];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    out.insert(out.end(), buffer, buffer + n);
+  }
+  fclose(f);
+  return true;
+}
+
+// Returns the replay time in ms
+static double replay(const std::vector<uint8_t>& log, const ReplayOptions& options, RunCollector& collector,
+                     uint32_t& lostFrames, uint32_t& crcErrors) {
+  auto start = std::chrono::steady_clock::now();
+  TelemetryDecoder decoder;
+  ReplayEngine engine(options, collector);
+  for (uint8_t byte : log) {
+    if (decoder.feed(byte)) {
+      if (decoder.type() == TELEMETRY_CLOCK_MAP &&
+          decodeClockMap(decoder.payload(), decoder.length(), collector.clock)) {
+        collector.hasClock = true;
+      }
+      engine.feed(decoder.type(), decoder.payload(), decoder.length());
+    }
+  }
+  lostFrames = engine.lostFrames();
+  crcErrors = decoder.crcErrors();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void printRunHeader(const ReplayRun& run, const ReplayOptions& options) {
+  const RecordHeader& h = run.header;
+  int settle = options.settleSamples >= 0 ? options.settleSamples : h.settleSamples;
+  printf("\n=== Run %u: %d->%dus, step %dus, settle %d, zero tracking %s%s ===\n", h.run, h.sweep.slowPwm,
+         h.sweep.fastPwm, h.sweep.stepPwm, settle, options.zeroTracking ? "on" : "off",
+         run.completed ? "" : " (aborted)");
+  if (h.sweep.rampUsPerS > 0) {
+    printf("Ramp at %d us/s, rows averaged over +/- %d us of each point\n", h.sweep.rampUsPerS,
+           h.sweep.stepPwm / 2);
+  }
+  if (run.lostFrames > 0) {
+    printf("WARNING: %u record frames lost, results incomplete\n", run.lostFrames);
+  }
+}
+
+static void printTotals(const char* label, const ReplayRun& run) {
+  printf("%sMax thrust %.3f kg | best %.2f g/W at %dus | peak %.1f W | payload %.3f kg\n", label,
+         run.totals.maxThrustKg, run.totals.bestEfficiencyGPerW, run.totals.bestEfficiencyPwm,
+         run.totals.maxPowerW, run.payloadKg);
+}
+
+// Sample rate and ESC lag from the capture stamps; host time with a clock map
+static void printTiming(const ReplayedRun& r) {
+  const ReplayRun& run = r.run;
+  if (run.sampleIntervalUs.count() > 0) {
+    printf("HX711 every %.2f ms (%.0f us jitter, %.0f Hz) | ESC to next reading %.2f ms (max %.2f)\n",
+           run.sampleIntervalUs.mean() / 1000.0f, run.sampleIntervalUs.stddev(),
+           1e6f / run.sampleIntervalUs.mean(), run.escToSampleUs.mean() / 1000.0f,
+           run.escToSampleUs.max() / 1000.0f);
+  }
+  if (r.hasClock) {
+    int64_t hostUs = mapToHostUs(r.clock, run.firstUs);
+    time_t seconds = (time_t)(hostUs / 1000000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &utc);
+    printf("Started %s.%06d UTC (+/- %u us), device %.6f s\n", text, (int)(hostUs % 1000000), r.clock.errorUs,
+           run.firstUs / 1e6);
+  }
+}
+
+static void printRun(const ReplayedRun& r, const ReplayOptions& options) {
+  printRunHeader(r.run, options);
+  printf("PWM (us) | Thrust (kg) | Voltage | Current | Power | Efficiency\n");
+  for (const ReplayedStep& s : r.steps) {
+    printf("%d\t | %.3f\t| %.2f V\t| %.2f A\t| %.1f W\t| %.2f g/W\n", s.pwm, s.result.thrustKg,
+           s.result.voltageV, s.result.currentA, s.result.powerW, s.result.efficiencyGPerW);
+  }
+  printTotals("", r.run);
+  printTiming(r);
+}
+
+static void printComparison(const ReplayedRun& a, const ReplayedRun& b, const ReplayOptions& options) {
+  printRunHeader(b.run, options);
+  printf("PWM (us) | A thrust (kg) | B thrust (kg) | Delta (g)\n");
+  float worstG = 0.0f;
+  for (size_t i = 0; i < a.steps.size() && i < b.steps.size(); i++) {
+    float deltaG = (b.steps[i].result.thrustKg - a.steps[i].result.thrustKg) * 1000.0f;
+    if (fabsf(deltaG) > fabsf(worstG)) worstG = deltaG;
+    printf("%d\t | %.4f\t| %.4f\t| %+.2f\n", a.steps[i].pwm, a.steps[i].result.thrustKg,
+           b.steps[i].result.thrustKg, deltaG);
+  }
+  printTotals("A: ", a.run);
+  printTotals("B: ", b.run);
+  printf("Largest step difference: %+.2f g, payload %+.1f g\n", worstG,
+         (b.run.payloadKg - a.run.payloadKg) * 1000.0f);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  ReplayOptions variant = recordedReplayOptions();
+  bool compare = false;
+  for (int i = 2; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--no-zero-track") == 0) {
+      variant.zeroTracking = false;
+    } else if (strcmp(argv[i], "--settle") == 0 && hasValue) {
+      variant.settleSamples = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ab") == 0) {
+      compare = true;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  std::vector<uint8_t> log;
+  if (!readFile(argv[1], log)) {
+    fprintf(stderr, "%s: cannot read\n", argv[1]);
+    return 1;
+  }
+
+  RunCollector collector;
+  uint32_t lostFrames = 0;
+  uint32_t crcErrors = 0;
+  double ms = replay(log, variant, collector, lostFrames, crcErrors);
+  if (collector.runs.empty()) {
+    fprintf(stderr, "%s: no recorded runs (set record 1 before the sweep)\n", argv[1]);
+    return 1;
+  }
+
+  if (compare) {
+    RunCollector baseline;
+    uint32_t baselineLost = 0;
+    uint32_t baselineCrc = 0;
+    replay(log, recordedReplayOptions(), baseline, baselineLost, baselineCrc);
+    for (size_t i = 0; i < collector.runs.size() && i < baseline.runs.size(); i++) {
+      printComparison(baseline.runs[i], collector.runs[i], variant);
+    }
+  } else {
+    for (const ReplayedRun& r : collector.runs) {
+      printRun(r, variant);
+    }
+  }
+
+  double recordedS = 0.0;
+  for (const ReplayedRun& r : collector.runs) {
+    recordedS += r.run.durationUs / 1e6;
+  }
+  printf("\n%zu run%s, %.1f s recorded, replayed in %.2f ms (%.0fx real time)", collector.runs.size(),
+         collector.runs.size() == 1 ? "" : "s", recordedS, ms, ms > 0.0 ? recordedS * 1000.0 / ms : 0.0);
+  printf(", %u frames lost, %u CRC errors\n", lostFrames, crcErrors);
+  return 0;
+}
@@ -0,0 +1,209 @@
+// Run database - stores algorithm-test sweeps and answers queries over them
+// Build: make run-db
+//
+// Usage:
+//   run_db ingest <db> <log> --motor NAME --prop NAME --prop-in INCHES
+//                 [--battery NAME] [--drone-weight KG] [--date YYYY-MM-DD]
+//   run_db list   <db> [filters]
+//   run_db query  <db> --pwm US [filters]
+// Filters: --motor NAME --prop NAME --prop-in INCHES --from DATE --to DATE
+//
+// <log> is a saved serial log of one algorithm test (e.g. from the
+// telemetry hub); rows are read from the "PWM (us) | Throttle % | ..." table.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+
+#include "RunStore.h"
+
+const size_t MAX_POINTS = 1024;
+
+static void usage() {
+  fprintf(stderr,
+          "usage: run_db ingest <db> <log> --motor NAME --prop NAME --prop-in IN [--battery NAME]\n"
+          "                     [--drone-weight KG] [--date YYYY-MM-DD]\n"
+          "       run_db list <db> [filters]\n"
+          "       run_db query <db> --pwm US [filters]\n"
+          "filters: --motor NAME --prop NAME --prop-in IN --from DATE --to DATE\n");
+}
+
+static int64_t parseDate(const char* text) {
+  struct tm tm;
+  memset(&tm, 0, sizeof(tm));
+  if (sscanf(text, "%d-%d-%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday) != 3) {
+    return -1;
+  }
+  tm.tm_year -= 1900;
+  tm.tm_mon -= 1;
+  return (int64_t)timegm(&tm);
+}
+
+static void formatDate(int64_t seconds, char* out, size_t capacity) {
+  time_t t = (time_t)seconds;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  strftime(out, capacity, "%Y-%m-%d", &tm);
+}
+
+struct Options {
+  const char* motor = nullptr;
+  const char* prop = nullptr;
+  const char* battery = nullptr;
+  float propIn = 0.0f;
+  float droneWeight = NAN;
+  int64_t date = 0;
+  int64_t from = 0;
+  int64_t to = 0;
+  int pwm = 0;
+};
+
+static bool parseOptions(int argc, char** argv, int first, Options& options) {
+  for (int i = first; i < argc; i++) {
+    if (i + 1 >= argc) return false;
+    const char* name = argv[i];
+    const char* value = argv[++i];
+    if (strcmp(name, "--motor") == 0) options.motor = value;
+    else if (strcmp(name, "--prop") == 0) options.prop = value;
+    else if (strcmp(name, "--battery") == 0) options.battery = value;
+    else if (strcmp(name, "--prop-in") == 0) options.propIn = strtof(value, nullptr);
+    else if (strcmp(name, "--drone-weight") == 0) options.droneWeight = strtof(value, nullptr);
+    else if (strcmp(name, "--date") == 0) options.date = parseDate(value);
+    else if (strcmp(name, "--from") == 0) options.from = parseDate(value);
+    else if (strcmp(name, "--to") == 0) options.to = parseDate(value) + 86399;  // whole day
+    else if (strcmp(name, "--pwm") == 0) options.pwm = atoi(value);
+    else return false;
+  }
+  return options.date >= 0 && options.from >= 0 && options.to >= 0;
+}
+
+static RunFilter filterFrom(const Options& options) {
+  RunFilter filter = anyRun();
+  filter.motor = options.motor;
+  filter.prop = options.prop;
+  filter.propDiameterIn = options.propIn;
+  filter.fromDate = options.from;
+  filter.toDate = options.to;
+  return filter;
+}
+
+static int ingest(RunStore& store, const char* logPath, const Options& options) {
+  if (options.motor == nullptr || options.prop == nullptr || options.propIn <= 0.0f) {
+    fprintf(stderr, "ingest needs --motor, --prop and --prop-in\n");
+    return 2;
+  }
+  FILE* f = fopen(logPath, "r");
+  if (f == nullptr) {
+    perror(logPath);
+    return 1;
+  }
+  static RunPoint points[MAX_POINTS];
+  size_t count = parseSweepLog(f, points, MAX_POINTS);
+  fclose(f);
+  if (count == 0) {
+    fprintf(stderr, "%s: no sweep rows found\n", logPath);
+    return 1;
+  }
+
+  RunMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  meta.dateUnix = options.date != 0 ? options.date : (int64_t)time(nullptr);
+  meta.propDiameterIn = options.propIn;
+  meta.droneWeightKg = options.droneWeight;
+  strncpy(meta.motor, options.motor, sizeof(meta.motor) - 1);
+  strncpy(meta.prop, options.prop, sizeof(meta.prop) - 1);
+  if (options.battery != nullptr) {
+    strncpy(meta.battery, options.battery, sizeof(meta.battery) - 1);
+  }
+  if (!store.append(meta, points, count)) {
+    perror("append");
+    return 1;
+  }
+  printf("run %u: %u steps, max thrust %.3f kg\n", meta.runId, meta.pointCount, meta.maxThrustKg);
+  return 0;
+}
+
+static int list(RunStore& store, const RunFilter& filter) {
+  const RunMeta* runs = store.runs();
+  printf("%-6s %-10s %-20s %-12s %-6s %-14s %8s %6s\n",
+         "run", "date", "motor", "prop", "in", "battery", "max_kg", "steps");
+  for (size_t i = 0; i < store.runCount(); i++) {
+    const RunMeta& run = runs[i];
+    if (!runMatches(run, filter)) continue;
+    char date[16];
+    formatDate(run.dateUnix, date, sizeof(date));
+    printf("%-6u %-10s %-20.32s %-12.24s %-6.1f %-14.24s %8.3f %6u\n", run.runId, date, run.motor,
+           run.prop, run.propDiameterIn, run.battery, run.maxThrustKg, run.pointCount);
+  }
+  return 0;
+}
+
+static int query(RunStore& store, const RunFilter& filter, int pwm) {
+  auto start = std::chrono::steady_clock::now();
+  const RunMeta* runs = store.runs();
+  size_t matched = 0;
+  size_t visited = 0;
+  float best = NAN;
+  float sum = 0.0f;
+  uint32_t bestRun = 0;
+  for (size_t i = 0; i < store.runCount(); i++) {
+    if (!runMatches(runs[i], filter)) continue;
+    matched++;
+    float thrust = store.thrustAtPwm(runs[i], pwm);
+    if (isnan(thrust)) continue;
+    visited++;
+    sum += thrust;
+    if (!(thrust <= best)) {
+      best = thrust;
+      bestRun = runs[i].runId;
+    }
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  printf("runs matched: %zu, with %d us: %zu\n", matched, pwm, visited);
+  if (visited > 0) {
+    printf("max thrust: %.3f kg (run %u)\nmean over runs: %.3f kg\n", best, bestRun, sum / visited);
+  }
+  printf("query time: %.2f ms\n", ms);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    usage();
+    return 2;
+  }
+  const char* command = argv[1];
+  bool isIngest = strcmp(command, "ingest") == 0;
+  if (isIngest && argc < 4) {
+    usage();
+    return 2;
+  }
+
+  Options options;
+  if (!parseOptions(argc, argv, isIngest ? 4 : 3, options)) {
+    usage();
+    return 2;
+  }
+
+  RunStore store;
+  if (!store.open(argv[2], isIngest)) {
+    perror(argv[2]);
+    return 1;
+  }
+  if (isIngest) {
+    return ingest(store, argv[3], options);
+  }
+  if (strcmp(command, "list") == 0) {
+    return list(store, filterFrom(options));
+  }
+  if (strcmp(command, "query") == 0 && options.pwm > 0) {
+    return query(store, filterFrom(options), options.pwm);
+  }
+  usage();
+  return 2;
+}
@@ -0,0 +1,196 @@
+// Run database checks - 10k synthetic sweeps in a temporary store
+// Build and run: make test-run-db
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <chrono>
+
+#include "RunStore.h"
+
+static int failures = 0;
+
+static void check(bool condition, const char* what) {
+  printf("[%s] %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) {
+    failures++;
+  }
+}
+
+const int NUM_RUNS = 10000;
+const char* const MOTORS[] = {"2207-1750KV", "2306-2450KV", "1404-3800KV", "2806-1300KV"};
+const char* const PROPS[] = {"5x4.3x3", "5x3x3", "6x4x2", "4x2.5x3"};
+const float PROP_INCHES[] = {5.0f, 5.0f, 6.0f, 4.0f};
+
+// Same shape as a default algorithm test: 1340 -> 1210 -> 1340 in 10 us steps
+static size_t makeSweep(int run, RunPoint* points) {
+  size_t count = 0;
+  float maxThrust = 0.3f + (run % 97) * 0.003f;
+  for (int phase = 0; phase < 2; phase++) {
+    for (int i = 0; i < 14; i++) {
+      int pwm = phase == 0 ? 1340 - i * 10 : 1210 + i * 10;
+      float throttle = (1340 - pwm) / 140.0f;
+      RunPoint& p = points[count++];
+      p.pwm = (int16_t)pwm;
+      p.phase = (uint8_t)phase;
+      p.thrustKg = maxThrust * throttle * throttle + phase * 0.002f;  // slight hysteresis
+      p.voltageV = 16.4f;
+      p.currentA = 1.0f + 30.0f * throttle * throttle;
+      p.powerW = p.voltageV * p.currentA;
+      p.efficiencyGPerW = p.thrustKg * 1000.0f / p.powerW;
+    }
+  }
+  return count;
+}
+
+static off_t sizeOf(const char* dir, const char* name) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  struct stat st;
+  return stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+static void appendBytes(const char* dir, const char* name, size_t count) {
+  char path[256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+  FILE* f = fopen(path, "ab");
+  for (size_t i = 0; i < count; i++) fputc(0x7F, f);
+  fclose(f);
+}
+
+static void testStore(const char* dir) {
+  RunStore store;
+  check(store.open(dir, true), "store: create");
+
+  RunPoint points[64];
+  float expectedBest = 0.0f;
+  int expectedRuns = 0;
+  bool appended = true;
+  for (int run = 0; run < NUM_RUNS; run++) {
+    size_t count = makeSweep(run, points);
+    RunMeta meta;
+    memset(&meta, 0, sizeof(meta));
+    meta.dateUnix = 1767225600 + run * 3600;  // 2026-01-01, hourly
+    strcpy(meta.motor, MOTORS[run % 4]);
+    strcpy(meta.prop, PROPS[(run / 4) % 4]);
+    meta.propDiameterIn = PROP_INCHES[(run / 4) % 4];
+    meta.droneWeightKg = 0.5f;
+    appended = appended && store.append(meta, points, count);
+    if (meta.propDiameterIn == 5.0f) {
+      expectedRuns++;
+      float thrust = points[18].thrustKg;  // 1250 us on the way back up is the larger one
+      if (thrust > expectedBest) expectedBest = thrust;
+    }
+  }
+  check(appended && store.runCount() == NUM_RUNS, "store: 10k runs appended");
+  store.close();
+
+  // Fresh reader: query only touches the pwm and thrust columns
+  RunStore reader;
+  check(reader.open(dir, false) && reader.runCount() == NUM_RUNS, "store: reopened read-only");
+  RunFilter filter = anyRun();
+  filter.propDiameterIn = 5.0f;
+
+  auto start = std::chrono::steady_clock::now();
+  const RunMeta* runs = reader.runs();
+  int matched = 0;
+  float best = 0.0f;
+  for (size_t i = 0; i < reader.runCount(); i++) {
+    if (!runMatches(runs[i], filter)) continue;
+    matched++;
+    float thrust = reader.thrustAtPwm(runs[i], 1250);
+    if (thrust > best) best = thrust;
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  printf("       max thrust at 1250 us, 5\" props: %.3f kg over %d runs in %.2f ms\n", best, matched, ms);
+
+  check(matched == expectedRuns && fabsf(best - expectedBest) < 1e-6f, "query: max thrust at 1250 us for 5\" props");
+  check(reader.mappedColumns() == ((1u << COL_PWM) | (1u << COL_THRUST)), "query: only pwm and thrust columns mapped");
+  check(ms < 50.0, "query: 10k runs in milliseconds");
+
+  filter = anyRun();
+  filter.motor = "2806-1300KV";
+  filter.fromDate = 1767225600 + 100 * 3600;
+  filter.toDate = 1767225600 + 199 * 3600;
+  matched = 0;
+  for (size_t i = 0; i < reader.runCount(); i++) {
+    if (runMatches(runs[i], filter)) matched++;
+  }
+  check(matched == 25, "query: motor and date range filter");
+  reader.close();
+
+  // Crash mid-append: column tails and half an index record are discarded
+  off_t thrustSize = sizeOf(dir, "thrust.col");
+  off_t indexSize = sizeOf(dir, "runs.idx");
+  appendBytes(dir, "thrust.col", 4 * 28);
+  appendBytes(dir, "pwm.col", 2 * 28);
+  appendBytes(dir, "runs.idx", 50);
+  RunStore repaired;
+  check(repaired.open(dir, true) && repaired.runCount() == NUM_RUNS, "repair: committed runs survive");
+  check(sizeOf(dir, "thrust.col") == thrustSize && sizeOf(dir, "runs.idx") == indexSize,
+        "repair: unindexed tails trimmed");
+
+  // Index written but a column lost its tail (writeback order after power loss)
+  size_t count = makeSweep(1, points);
+  RunMeta meta;
+  memset(&meta, 0, sizeof(meta));
+  strcpy(meta.motor, "late");
+  repaired.append(meta, points, count);
+  repaired.close();
+  char path[256];
+  snprintf(path, sizeof(path), "%s/efficiency.col", dir);
+  check(truncate(path, sizeOf(dir, "efficiency.col") - 8) == 0, "repair: simulate a short column");
+  check(repaired.open(dir, true) && repaired.runCount() == NUM_RUNS, "repair: run with a short column dropped");
+  repaired.close();
+}
+
+static void testLogParser() {
+  const char* log =
+      "\n=== Algorithm Test Mode ===\n"
+      "PWM (us) | Throttle % | Thrust (kg) | Progress | Voltage | Current | Power | Efficiency\n"
+      "=== Speeding up ===\n"
+      "1340us\t| 0%\t| 0.002 kg\t| 3%\t| 16.80 V\t| 0.42 A\t| 7.1 W\t| 0.28 g/W\r\n"
+      "1250us\t| 64%\t| 0.241 kg\t| 36%\t| 16.21 V\t| 9.87 A\t| 160.0 W\t| 1.51 g/W\t| 3012456789\r\n"
+      "\n[HOLD] At maximum speed for 2 seconds\n\n"
+      "=== Slowing down ===\n"
+      "1250us\t| 64%\t| 0.245 kg\t| 70%\r\n"
+      "1340us\t| 0%\t| 0.003 kg\t| 100%\t| 3040123456\r\n"
+      "\n========== PAYLOAD CALCULATION ==========\n"
+      "Max single motor thrust: 0.245 kg\n";
+  FILE* f = fmemopen((void*)log, strlen(log), "r");
+  RunPoint points[8];
+  size_t count = parseSweepLog(f, points, 8);
+  fclose(f);
+  check(count == 4, "log: sweep rows parsed, other lines skipped");
+  check(points[1].pwm == 1250 && fabsf(points[1].thrustKg - 0.241f) < 1e-6f &&
+        fabsf(points[1].powerW - 160.0f) < 1e-4f, "log: row with power columns");
+  check(points[2].phase == 1 && isnan(points[2].powerW), "log: phase and missing power columns");
+  check(points[3].pwm == 1340 && fabsf(points[3].thrustKg - 0.003f) < 1e-6f && isnan(points[3].voltageV),
+        "log: device time column is not taken for power");
+}
+
+int main() {
+  printf("=== Run Database Checks ===\n\n");
+
+  char dir[] = "/tmp/run_db_test_XXXXXX";
+  if (mkdtemp(dir) == nullptr) {
+    perror("mkdtemp");
+    return 1;
+  }
+  testStore(dir);
+  testLogParser();
+
+  char command[320];
+  snprintf(command, sizeof(command), "rm -rf %s", dir);
+  if (system(command) != 0) {
+    printf("could not remove %s\n", dir);
+  }
+
+  printf("\n%s (%d failure%s)\n", failures == 0 ? "ALL PASSED" : "FAILED",
+         failures, failures == 1 ? "" : "s");
+  return failures == 0 ? 0 : 1;
+}
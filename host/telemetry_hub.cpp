@@ -0,0 +1,91 @@
+// Telemetry hub - owns the stand's serial port and fans it out to local clients
+// Build: make hub    Run: make hub-run PORT=/dev/ttyUSB0
+//
+// Usage: telemetry_hub <serial-device> [--baud N] [--unix PATH] [--tcp PORT]
+//                      [--ring BYTES] [--sync MS]
+// Subscribe with e.g. `socat - UNIX-CONNECT:/tmp/thrust_stand.sock` or
+// `nc 127.0.0.1 PORT`. Each client gets text lines and CRC-checked binary
+// frames exactly as the stand sends them; lines a client writes are
+// forwarded to the stand's serial console. Every --sync ms (default 1000,
+// 0 = off) the hub sends `sync <token>` and follows each reply with a
+// CLOCK_MAP frame mapping esp_timer to Unix time.
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TelemetryHub.h"
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+  stopRequested = 1;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "usage: telemetry_hub <serial-device> [--baud N] [--unix PATH] [--tcp PORT] [--ring BYTES]"
+          " [--sync MS]\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    usage();
+    return 2;
+  }
+
+  HubConfig config = defaultHubConfig();
+  config.serialPath = argv[1];
+  for (int i = 2; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (strcmp(argv[i], "--baud") == 0 && hasValue) {
+      config.baud = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--unix") == 0 && hasValue) {
+      config.unixPath = argv[++i];
+    } else if (strcmp(argv[i], "--tcp") == 0 && hasValue) {
+      config.tcpPort = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--ring") == 0 && hasValue) {
+      config.ringBytes = (size_t)strtoul(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "--sync") == 0 && hasValue) {
+      config.syncPeriodMs = atoi(argv[++i]);
+    } else {
+      usage();
+      return 2;
+    }
+  }
+  if (config.ringBytes < 4096) {
+    fprintf(stderr, "ring must be at least 4096 bytes\n");
+    return 2;
+  }
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  TelemetryHub hub(config);
+  if (!hub.open()) {
+    fprintf(stderr, "telemetry_hub: %s: %s\n", config.serialPath, strerror(errno));
+    return 1;
+  }
+  fprintf(stderr, "telemetry_hub: %s -> %s%s%s\n", config.serialPath,
+          config.unixPath != nullptr ? config.unixPath : "",
+          config.unixPath != nullptr && config.tcpPort > 0 ? ", " : "",
+          config.tcpPort > 0 ? "tcp 127.0.0.1" : "");
+
+  while (!stopRequested) {
+    hub.pollOnce(500);
+  }
+
+  const HubStats& stats = hub.stats();
+  fprintf(stderr, "serial_bytes=%llu lines=%u frames=%u bad_frames=%u reopens=%u\n",
+          (unsigned long long)stats.serialBytes, hub.splitter().lines(), hub.splitter().frames(),
+          hub.splitter().badFrames(), stats.serialReopens);
+  fprintf(stderr, "clients_accepted=%u clients_dropped_slow=%u clients_closed=%u commands=%u\n",
+          stats.clientsAccepted, stats.clientsDropped, stats.clientsClosed, stats.commandsForwarded);
+  const ClockSync& clock = hub.clock();
+  fprintf(stderr, "sync_sent=%u sync_replies=%u drift_ppm=%.2f best_rtt_us=%lld error_us=%lld restarts=%u\n",
+          stats.syncSent, stats.syncReplies, clock.driftPpm(), (long long)clock.bestRttUs(),
+          (long long)clock.errorUs(), clock.restarts());
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include "BatchQueue.h"
+
+#include <stddef.h>
+
+// CRC-32 (reflected, 0xEDB88320), bitwise: one checkpoint per sweep step
+uint32_t checkpointCrc(const BatchCheckpoint& checkpoint) {
+  const uint8_t* data = (const uint8_t*)&checkpoint;
+  size_t length = offsetof(BatchCheckpoint, crc);
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+    }
+  }
+  return ~crc;
+}
+
+bool BatchQueue::begin(const BatchPlan& plan) {
+  if (plan.repetitions == 0 || plan.profileCount == 0 || plan.profileCount > BATCH_MAX_PROFILES) {
+    return false;
+  }
+  for (int i = 0; i < plan.profileCount; i++) {
+    const BatchProfile& p = plan.profiles[i];
+    if (p.fastPwm >= p.slowPwm || p.stepPwm <= 0) {
+      return false;
+    }
+  }
+
+  _cp = BatchCheckpoint();  // value-initialised: padding is zero for the CRC
+  _cp.magic = BATCH_CHECKPOINT_MAGIC;
+  _cp.size = sizeof(_cp);
+  _cp.plan = plan;
+  _active = true;
+  save();
+  return true;
+}
+
+bool BatchQueue::resume() {
+  BatchCheckpoint loaded;
+  if (!_store.load(loaded) || loaded.magic != BATCH_CHECKPOINT_MAGIC || loaded.size != sizeof(loaded) ||
+      loaded.crc != checkpointCrc(loaded) || loaded.plan.profileCount == 0 ||
+      loaded.plan.profileCount > BATCH_MAX_PROFILES ||
+      loaded.run >= loaded.plan.repetitions * loaded.plan.profileCount) {
+    return false;
+  }
+  _cp = loaded;
+  _active = true;
+  return true;
+}
+
+void BatchQueue::cancel() {
+  _active = false;
+  _store.clear();
+}
+
+void BatchQueue::stepDone(int nextStep, const RunSummary& partial) {
+  _cp.nextStep = (int16_t)nextStep;
+  _cp.current = partial;
+  save();
+}
+
+bool BatchQueue::runDone(const RunSummary& summary) {
+  _cp.maxThrust[profileIndex()].add(summary.maxThrustKg);
+  _cp.run++;
+  _cp.nextStep = 0;
+  _cp.current = RunSummary();
+
+  if (_cp.run >= totalRuns()) {
+    // Finished: nothing to resume; totals stay readable until the next begin()
+    _active = false;
+    _store.clear();
+    return false;
+  }
+  save();
+  return true;
+}
+
+void BatchQueue::save() {
+  _cp.crc = checkpointCrc(_cp);
+  if (_store.save(_cp)) {
+    _writes++;
+  }
+}
+
+#ifdef ARDUINO
+bool NvsCheckpointStore::load(BatchCheckpoint& out) {
+  if (!_prefs.begin("batch", true)) {
+    return false;
+  }
+  size_t n = _prefs.getBytes("checkpoint", &out, sizeof(out));
+  _prefs.end();
+  return n == sizeof(out);
+}
+
+bool NvsCheckpointStore::save(const BatchCheckpoint& checkpoint) {
+  if (!_prefs.begin("batch", false)) {
+    return false;
+  }
+  size_t n = _prefs.putBytes("checkpoint", &checkpoint, sizeof(checkpoint));
+  _prefs.end();
+  return n == sizeof(checkpoint);
+}
+
+void NvsCheckpointStore::clear() {
+  if (_prefs.begin("batch", false)) {
+    _prefs.remove("checkpoint");
+    _prefs.end();
+  }
+}
+#endif
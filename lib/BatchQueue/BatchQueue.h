@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stdint.h>
+#include "SampleStats.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#endif
+
+const int BATCH_MAX_PROFILES = 8;
+const uint32_t BATCH_CHECKPOINT_MAGIC = 0x42545131;  // "BTQ1"
+
+// One sweep setup; runs cycle through the profiles, repetition by repetition
+struct BatchProfile {
+  int16_t slowPwm;
+  int16_t fastPwm;
+  int16_t stepPwm;
+  uint16_t stepDelayMs;
+  uint16_t rampUsPerS;  // 0 = stepped sweep
+};
+
+struct BatchPlan {
+  uint16_t repetitions;
+  uint8_t profileCount;
+  bool autoTare;
+  uint32_t cooldownMs;
+  BatchProfile profiles[BATCH_MAX_PROFILES];
+};
+
+// Results of one sweep (also the partial results of the run in progress)
+struct RunSummary {
+  float maxThrustKg;
+  float bestEfficiencyGPerW;
+  int16_t bestEfficiencyPwm;
+  float maxPowerW;
+};
+
+// Everything needed to continue after a reset, stored as one flash record
+struct BatchCheckpoint {
+  uint32_t magic;
+  uint16_t size;
+  uint16_t run;       // run in progress, 0-based
+  int16_t nextStep;   // first sweep step not yet measured
+  BatchPlan plan;
+  RunSummary current;
+  RunningStats maxThrust[BATCH_MAX_PROFILES];  // per profile, completed runs
+  uint32_t crc;       // over everything above
+};
+
+// Where the checkpoint lives: NVS on the ESP32, RAM in native tests
+class CheckpointStore {
+ public:
+  virtual ~CheckpointStore() {}
+  virtual bool load(BatchCheckpoint& out) = 0;
+  virtual bool save(const BatchCheckpoint& checkpoint) = 0;
+  virtual void clear() = 0;
+};
+
+#ifdef ARDUINO
+class NvsCheckpointStore : public CheckpointStore {
+ public:
+  bool load(BatchCheckpoint& out) override;
+  bool save(const BatchCheckpoint& checkpoint) override;
+  void clear() override;
+
+ private:
+  Preferences _prefs;
+};
+#endif
+
+class BatchQueue {
+ public:
+  explicit BatchQueue(CheckpointStore& store) : _store(store), _active(false), _writes(0) {}
+
+  // Starts a new batch (checkpointed right away); false if the plan is invalid
+  bool begin(const BatchPlan& plan);
+  // Picks up a checkpoint left by a reset; false if there is none or it is corrupt
+  bool resume();
+  // Abandons the batch and forgets the checkpoint
+  void cancel();
+
+  bool active() const { return _active; }
+  int totalRuns() const { return _cp.plan.repetitions * _cp.plan.profileCount; }
+  int run() const { return _cp.run; }
+  int repetition() const { return _cp.run / _cp.plan.profileCount; }
+  int profileIndex() const { return _cp.run % _cp.plan.profileCount; }
+  const BatchProfile& profile() const { return _cp.plan.profiles[profileIndex()]; }
+  const BatchPlan& plan() const { return _cp.plan; }
+
+  // Where the current run continues, and what it had measured so far
+  int resumeStep() const { return _cp.nextStep; }
+  const RunSummary& partial() const { return _cp.current; }
+
+  // After each measured step: checkpoint so a reset resumes at nextStep
+  void stepDone(int nextStep, const RunSummary& partial);
+  // Completes the current run; returns true while runs remain
+  bool runDone(const RunSummary& summary);
+
+  const RunningStats& profileStats(int profile) const { return _cp.maxThrust[profile]; }
+  uint32_t checkpointWrites() const { return _writes; }
+
+ private:
+  void save();
+
+  CheckpointStore& _store;
+  BatchCheckpoint _cp;
+  bool _active;
+  uint32_t _writes;
+};
+
+uint32_t checkpointCrc(const BatchCheckpoint& checkpoint);
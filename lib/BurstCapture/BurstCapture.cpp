@@ -0,0 +1,184 @@
+#include "BurstCapture.h"
+
+#include <math.h>
+
+#include "Telemetry.h"
+
+BurstCapture::BurstCapture()
+    : _samples(nullptr), _capacity(0), _count(0), _inPsram(false),
+      _startUs(0), _stepUs(0), _fromPwm(0), _toPwm(0) {}
+
+bool BurstCapture::allocate(TieredArena& memory, size_t capacity) {
+  if (_samples != nullptr) {
+    return capacity <= _capacity;
+  }
+
+  MemoryTier tier;
+  _samples = (BurstSample*)memory.allocate(capacity * sizeof(BurstSample), true, tier);
+  if (_samples == nullptr) {
+    return false;
+  }
+  _inPsram = tier == TIER_PSRAM;
+
+  _capacity = capacity;
+  _count = 0;
+  return true;
+}
+
+void BurstCapture::start(int64_t nowUs) {
+  _startUs = nowUs;
+  _count = 0;
+  _stepUs = 0;
+  _fromPwm = 0;
+  _toPwm = 0;
+}
+
+void BurstCapture::markStep(int64_t nowUs, uint16_t fromPwm, uint16_t toPwm) {
+  _stepUs = elapsedUs(nowUs);
+  _fromPwm = fromPwm;
+  _toPwm = toPwm;
+}
+
+bool BurstCapture::add(int64_t nowUs, int32_t raw, uint16_t pwm, uint16_t currentMa) {
+  if (full()) {
+    return false;
+  }
+  BurstSample& s = _samples[_count++];
+  s.timeUs = elapsedUs(nowUs);
+  s.raw = raw;
+  s.pwm = pwm;
+  s.currentMa = currentMa;
+  return true;
+}
+
+namespace {
+
+// First time (after the step) the response reaches the given fraction of the change,
+// linearly interpolated between samples; -1 if never reached
+float crossingTimeS(const BurstSample* samples, size_t count, uint32_t stepUs,
+                    float baseline, float delta, float fraction) {
+  float threshold = baseline + delta * fraction;
+  for (size_t i = 1; i < count; i++) {
+    if (samples[i].timeUs < stepUs) {
+      continue;
+    }
+    float prev = (float)samples[i - 1].raw;
+    float curr = (float)samples[i].raw;
+    bool crossed = delta > 0.0f ? curr >= threshold : curr <= threshold;
+    if (!crossed) {
+      continue;
+    }
+    float t0 = (float)samples[i - 1].timeUs;
+    float t1 = (float)samples[i].timeUs;
+    float t = t1;
+    if (curr != prev) {
+      t = t0 + (threshold - prev) / (curr - prev) * (t1 - t0);
+    }
+    if (t < (float)stepUs) {
+      t = (float)stepUs;
+    }
+    return (t - stepUs) / 1000000.0f;
+  }
+  return -1.0f;
+}
+
+}  // namespace
+
+BurstAnalysis analyzeBurst(const BurstSample* samples, size_t count, uint32_t stepUs) {
+  BurstAnalysis a = {};
+  a.samples = count;
+  a.deadTimeS = -1.0f;
+  a.riseTimeS = -1.0f;
+  a.timeConstantS = -1.0f;
+  if (count < 5) {
+    return a;
+  }
+
+  uint32_t spanUs = samples[count - 1].timeUs - samples[0].timeUs;
+  a.sampleRateHz = spanUs > 0 ? (count - 1) * 1000000.0f / spanUs : 0.0f;
+
+  // Baseline from pre-trigger samples, or the first sample without any
+  double sum = 0.0;
+  size_t pre = 0;
+  while (pre < count && samples[pre].timeUs < stepUs) {
+    sum += samples[pre].raw;
+    pre++;
+  }
+  a.baselineRaw = pre > 0 ? (float)(sum / pre) : (float)samples[0].raw;
+
+  size_t tail = count / 5;
+  if (tail < 3) tail = 3;
+  sum = 0.0;
+  for (size_t i = count - tail; i < count; i++) {
+    sum += samples[i].raw;
+  }
+  a.finalRaw = (float)(sum / tail);
+
+  float delta = a.finalRaw - a.baselineRaw;
+  if (delta == 0.0f) {
+    return a;
+  }
+
+  a.deadTimeS = crossingTimeS(samples, count, stepUs, a.baselineRaw, delta, 0.05f);
+  float t10 = crossingTimeS(samples, count, stepUs, a.baselineRaw, delta, 0.10f);
+  float t90 = crossingTimeS(samples, count, stepUs, a.baselineRaw, delta, 0.90f);
+  a.timeConstantS = crossingTimeS(samples, count, stepUs, a.baselineRaw, delta, 0.632f);
+  if (t10 >= 0.0f && t90 >= 0.0f) {
+    a.riseTimeS = t90 - t10;
+  }
+  a.valid = a.riseTimeS >= 0.0f && a.timeConstantS >= 0.0f;
+  return a;
+}
+
+size_t encodeBurstHeader(const BurstCapture& capture, uint16_t stepIndex,
+                         uint8_t* out, size_t outCapacity) {
+  uint8_t payload[24];
+  PayloadWriter w(payload, sizeof(payload));
+  w.putU16(stepIndex);
+  w.putU16(capture.fromPwm());
+  w.putU16(capture.toPwm());
+  w.putU32(capture.stepUs());
+  w.putU32((uint32_t)capture.count());
+  w.putU64((uint64_t)capture.startUs());  // device time of sample time 0
+  return encodeTelemetryFrame(TELEMETRY_BURST_HEADER, payload, w.length(), out, outCapacity);
+}
+
+size_t encodeBurstSamples(const BurstCapture& capture, uint16_t stepIndex, size_t first,
+                          uint8_t* out, size_t outCapacity) {
+  if (first >= capture.count()) {
+    return 0;
+  }
+  size_t n = capture.count() - first;
+  if (n > BURST_SAMPLES_PER_FRAME) {
+    n = BURST_SAMPLES_PER_FRAME;
+  }
+
+  uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+  PayloadWriter w(payload, sizeof(payload));
+  w.putU16(stepIndex);
+  w.putU32((uint32_t)first);
+  w.putU8((uint8_t)n);
+  for (size_t i = 0; i < n; i++) {
+    const BurstSample& s = capture.samples()[first + i];
+    w.putU32(s.timeUs);
+    w.putI32(s.raw);
+    w.putU16(s.pwm);
+    w.putU16(s.currentMa);
+  }
+  return encodeTelemetryFrame(TELEMETRY_BURST_SAMPLES, payload, w.length(), out, outCapacity);
+}
+
+size_t encodeBurstResult(const BurstAnalysis& analysis, uint16_t stepIndex,
+                         uint8_t* out, size_t outCapacity) {
+  uint8_t payload[40];
+  PayloadWriter w(payload, sizeof(payload));
+  w.putU16(stepIndex);
+  w.putU8(analysis.valid ? 1 : 0);
+  w.putF32(analysis.sampleRateHz);
+  w.putF32(analysis.baselineRaw);
+  w.putF32(analysis.finalRaw);
+  w.putF32(analysis.deadTimeS);
+  w.putF32(analysis.riseTimeS);
+  w.putF32(analysis.timeConstantS);
+  return encodeTelemetryFrame(TELEMETRY_BURST_RESULT, payload, w.length(), out, outCapacity);
+}
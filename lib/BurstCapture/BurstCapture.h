@@ -0,0 +1,76 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "MemoryArena.h"
+
+// One raw sample of a step capture; time is relative to capture start
+struct BurstSample {
+  uint32_t timeUs;
+  int32_t raw;        // HX711 counts, untared
+  uint16_t pwm;       // ESC command at the time of the sample
+  uint16_t currentMa; // 0 without a power monitor
+};
+
+// Capture buffer for one PWM step, taken from the arenas at boot (PSRAM when the board has it)
+class BurstCapture {
+ public:
+  BurstCapture();
+
+  // Called once at boot; the buffer is reused for every capture
+  bool allocate(TieredArena& memory, size_t capacity);
+
+  void start(int64_t nowUs);
+  void markStep(int64_t nowUs, uint16_t fromPwm, uint16_t toPwm);
+  bool add(int64_t nowUs, int32_t raw, uint16_t pwm, uint16_t currentMa);
+
+  const BurstSample* samples() const { return _samples; }
+  // The buffer itself, for modes that never run beside a capture
+  BurstSample* storage() { return _samples; }
+  size_t count() const { return _count; }
+  size_t capacity() const { return _capacity; }
+  bool full() const { return _count >= _capacity; }
+  bool inPsram() const { return _inPsram; }
+
+  uint32_t elapsedUs(int64_t nowUs) const { return (uint32_t)(nowUs - _startUs); }
+  int64_t startUs() const { return _startUs; }
+  uint32_t stepUs() const { return _stepUs; }
+  uint16_t fromPwm() const { return _fromPwm; }
+  uint16_t toPwm() const { return _toPwm; }
+
+ private:
+  BurstSample* _samples;
+  size_t _capacity;
+  size_t _count;
+  bool _inPsram;
+  int64_t _startUs;
+  uint32_t _stepUs;
+  uint16_t _fromPwm;
+  uint16_t _toPwm;
+};
+
+// Step response of one capture, in raw counts and seconds after the PWM step
+struct BurstAnalysis {
+  bool valid;
+  uint32_t samples;
+  float sampleRateHz;
+  float baselineRaw;   // mean before the step
+  float finalRaw;      // mean of the last 20 % of the window
+  float deadTimeS;     // step to 5 % of the change
+  float riseTimeS;     // 10 % to 90 %
+  float timeConstantS; // step to 63.2 % (first-order tau incl. dead time)
+};
+
+BurstAnalysis analyzeBurst(const BurstSample* samples, size_t count, uint32_t stepUs);
+
+// Burst dump over the binary telemetry link (see Telemetry.h):
+// header, then BURST_SAMPLES_PER_FRAME samples per frame, then the analysis
+const size_t BURST_SAMPLES_PER_FRAME = 20;
+
+size_t encodeBurstHeader(const BurstCapture& capture, uint16_t stepIndex,
+                         uint8_t* out, size_t outCapacity);
+size_t encodeBurstSamples(const BurstCapture& capture, uint16_t stepIndex, size_t first,
+                          uint8_t* out, size_t outCapacity);
+size_t encodeBurstResult(const BurstAnalysis& analysis, uint16_t stepIndex,
+                         uint8_t* out, size_t outCapacity);
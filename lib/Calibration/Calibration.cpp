@@ -0,0 +1,126 @@
+#include "Calibration.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include "Telemetry.h"
+
+void clearCalibration(CalibrationRecord& record) {
+  record = CalibrationRecord();
+  record.magic = CAL_RECORD_MAGIC;
+  record.size = sizeof(record);
+}
+
+bool addCalibrationPoint(CalibrationRecord& record, float refKg, long netCounts, CalLoad load) {
+  if (record.pointCount >= CAL_MAX_POINTS) {
+    return false;
+  }
+  CalPoint& point = record.points[record.pointCount++];
+  point.refKg = refKg;
+  point.netCounts = (int32_t)netCounts;
+  point.load = load;
+  point.residualKg = 0.0f;
+  return true;
+}
+
+bool fitCalibration(CalibrationRecord& record, int order) {
+  if (order < 1 || order > 2 || record.pointCount < order + 1) {
+    return false;
+  }
+
+  // Normal equations; counts scaled to ~1 so n^4 stays well conditioned
+  const double unit = 1.0e5;
+  double s2 = 0, s3 = 0, s4 = 0, sy1 = 0, sy2 = 0;
+  for (int i = 0; i < record.pointCount; i++) {
+    double n = record.points[i].netCounts / unit;
+    double y = record.points[i].refKg;
+    s2 += n * n;
+    s3 += n * n * n;
+    s4 += n * n * n * n;
+    sy1 += n * y;
+    sy2 += n * n * y;
+  }
+
+  double a1, a2;
+  if (order == 1) {
+    if (s2 <= 0.0) return false;
+    a1 = sy1 / s2;
+    a2 = 0.0;
+  } else {
+    double det = s2 * s4 - s3 * s3;
+    if (fabs(det) <= 1e-12 * s2 * s4) return false;  // loads not spread out enough
+    a1 = (sy1 * s4 - sy2 * s3) / det;
+    a2 = (s2 * sy2 - s3 * sy1) / det;
+  }
+  record.order = (uint8_t)order;
+  record.c1 = (float)(a1 / unit);
+  record.c2 = (float)(a2 / (unit * unit));
+
+  double sumSq = 0, pulleySq = 0;
+  int pulleyCount = 0;
+  record.maxKg = 0.0f;
+  for (int i = 0; i < record.pointCount; i++) {
+    CalPoint& point = record.points[i];
+    double n = point.netCounts / unit;
+    point.residualKg = (float)(a1 * n + a2 * n * n - point.refKg);
+    sumSq += (double)point.residualKg * point.residualKg;
+    if (fabsf(point.residualKg) > record.maxKg) record.maxKg = fabsf(point.residualKg);
+    if (point.load == CAL_PULLEY) {
+      pulleySq += (double)point.residualKg * point.residualKg;
+      pulleyCount++;
+    }
+  }
+  record.rmsKg = (float)sqrt(sumSq / record.pointCount);
+  record.rmsPulleyKg = pulleyCount > 0 ? (float)sqrt(pulleySq / pulleyCount) : 0.0f;
+  return true;
+}
+
+void buildCalibrationLut(const CalibrationRecord& record, CalibrationLut& lut) {
+  long largest = 0;
+  for (int i = 0; i < record.pointCount; i++) {
+    long n = labs((long)record.points[i].netCounts);
+    if (n > largest) largest = n;
+  }
+  lut.build(record.c1, record.c2, largest * 2);
+}
+
+uint16_t calibrationCrc(const CalibrationRecord& record) {
+  return crc16Ccitt((const uint8_t*)&record, offsetof(CalibrationRecord, crc));
+}
+
+bool calibrationValid(const CalibrationRecord& record) {
+  return record.magic == CAL_RECORD_MAGIC && record.size == sizeof(record) &&
+         record.crc == calibrationCrc(record) && record.order >= 1 && record.order <= 2 &&
+         record.pointCount <= CAL_MAX_POINTS;
+}
+
+#ifdef ARDUINO
+bool loadCalibration(CalibrationRecord& record) {
+  Preferences prefs;
+  if (!prefs.begin("cal", true)) {
+    return false;
+  }
+  size_t n = prefs.getBytes("record", &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record) && calibrationValid(record);
+}
+
+bool saveCalibration(CalibrationRecord& record) {
+  record.crc = calibrationCrc(record);
+  Preferences prefs;
+  if (!prefs.begin("cal", false)) {
+    return false;
+  }
+  size_t n = prefs.putBytes("record", &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record);
+}
+
+void eraseCalibration() {
+  Preferences prefs;
+  if (prefs.begin("cal", false)) {
+    prefs.remove("record");
+    prefs.end();
+  }
+}
+#endif
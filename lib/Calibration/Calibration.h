@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include "LoadCell.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#endif
+
+const int CAL_MAX_POINTS = 12;
+const uint32_t CAL_RECORD_MAGIC = 0x43414C31;  // "CAL1"
+
+// How the reference load was applied
+enum CalLoad : uint8_t {
+  CAL_DIRECT,  // weight resting on the cell
+  CAL_PULLEY   // weight pulling in the thrust direction over a pulley
+};
+
+struct CalPoint {
+  float refKg;       // signed in the thrust direction
+  int32_t netCounts;  // averaged reading minus the tare offset
+  uint8_t load;       // CalLoad
+  float residualKg;   // fitted minus reference
+};
+
+// One calibration as stored in NVS: the points, the fit and its residuals.
+// The table is rebuilt from the coefficients at boot.
+struct CalibrationRecord {
+  uint32_t magic;
+  uint8_t order;       // 1 linear, 2 quadratic (through the tare point)
+  uint8_t pointCount;
+  uint16_t size;
+  float c1;            // kg per count
+  float c2;            // kg per count^2
+  float rmsKg;
+  float maxKg;         // largest residual magnitude
+  float rmsPulleyKg;   // pulley points alone (friction shows up here)
+  CalPoint points[CAL_MAX_POINTS];
+  uint16_t crc;
+};
+
+void clearCalibration(CalibrationRecord& record);
+bool addCalibrationPoint(CalibrationRecord& record, float refKg, long netCounts, CalLoad load);
+
+// Least squares of kg = c1 * n + c2 * n^2 (c2 = 0 for order 1) through the tare
+// point; fills the coefficients and residuals. False without enough points.
+bool fitCalibration(CalibrationRecord& record, int order);
+
+// Table over twice the largest calibrated load, so thrust past the heaviest
+// reference weight stays inside it
+void buildCalibrationLut(const CalibrationRecord& record, CalibrationLut& lut);
+
+uint16_t calibrationCrc(const CalibrationRecord& record);
+bool calibrationValid(const CalibrationRecord& record);
+
+#ifdef ARDUINO
+bool loadCalibration(CalibrationRecord& record);
+bool saveCalibration(CalibrationRecord& record);
+void eraseCalibration();
+#endif
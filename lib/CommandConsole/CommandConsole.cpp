@@ -0,0 +1,236 @@
+#include "CommandConsole.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void ConsoleOutput::printInt(long value) {
+  char text[16];
+  snprintf(text, sizeof(text), "%ld", value);
+  write(text);
+}
+
+void ConsoleOutput::printFloat(float value, int digits) {
+  char text[24];
+  snprintf(text, sizeof(text), "%.*f", digits, (double)value);
+  write(text);
+}
+
+CommandConsole::CommandConsole(const ConsoleCommand* commands, size_t commandCount,
+                               const ConsoleParam* params, size_t paramCount,
+                               ConsoleOutput& out)
+    : _commands(commands),
+      _commandCount(commandCount),
+      _params(params),
+      _paramCount(paramCount),
+      _out(out),
+      _length(0),
+      _discarding(false),
+      _ready(false),
+      _linesExecuted(0),
+      _errors(0),
+      _overflows(0) {
+  _line[0] = '\0';
+}
+
+bool CommandConsole::feed(char c) {
+  if (_ready) {
+    return true;  // previous line not executed yet
+  }
+
+  if (c == '\r' || c == '\n') {
+    if (_discarding) {
+      _discarding = false;
+      _length = 0;
+      _out.println("ERR line too long");
+      return false;
+    }
+    if (_length == 0) {
+      return false;  // empty line or second half of CRLF
+    }
+    _line[_length] = '\0';
+    _ready = true;
+    return true;
+  }
+
+  if (_discarding) {
+    return false;
+  }
+  if (_length >= CONSOLE_LINE_SIZE - 1) {
+    _discarding = true;
+    _overflows++;
+    _errors++;
+    return false;
+  }
+  _line[_length++] = c;
+  return false;
+}
+
+// Splits the line in place; -1 when it has more than CONSOLE_MAX_ARGS tokens,
+// so the rest is never handed over merged into the last one
+int CommandConsole::tokenize(ConsoleArgs& args) {
+  args.argc = 0;
+  char* p = _line;
+  while (*p != '\0') {
+    while (*p == ' ' || *p == '\t') {
+      *p++ = '\0';
+    }
+    if (*p == '\0') {
+      break;
+    }
+    if (args.argc >= (int)CONSOLE_MAX_ARGS) {
+      return -1;
+    }
+    args.argv[args.argc++] = p;
+    while (*p != '\0' && *p != ' ' && *p != '\t') {
+      p++;
+    }
+  }
+  return args.argc;
+}
+
+void CommandConsole::execute() {
+  if (!_ready) {
+    return;
+  }
+
+  ConsoleArgs args;
+  int count = tokenize(args);
+  if (count < 0) {
+    _errors++;
+    _out.println("ERR too many arguments");
+  } else if (count > 0) {
+    _linesExecuted++;
+    const char* name = args.argv[0];
+
+    if (strcmp(name, "help") == 0) {
+      builtinHelp();
+    } else if (strcmp(name, "get") == 0) {
+      builtinGet(args);
+    } else if (strcmp(name, "set") == 0) {
+      builtinSet(args);
+    } else {
+      bool found = false;
+      for (size_t i = 0; i < _commandCount; i++) {
+        if (strcmp(name, _commands[i].name) == 0) {
+          _commands[i].handler(args, _out);
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        _errors++;
+        _out.print("ERR unknown command: ");
+        _out.println(name);
+      }
+    }
+  }
+
+  _length = 0;
+  _ready = false;
+}
+
+const ConsoleParam* CommandConsole::findParam(const char* name) const {
+  for (size_t i = 0; i < _paramCount; i++) {
+    if (strcmp(name, _params[i].name) == 0) {
+      return &_params[i];
+    }
+  }
+  return nullptr;
+}
+
+void CommandConsole::printParam(const ConsoleParam& param) {
+  _out.print(param.name);
+  _out.print("=");
+  switch (param.type) {
+    case PARAM_INT:
+      _out.printInt(*(int*)param.value);
+      break;
+    case PARAM_ULONG:
+      _out.printInt((long)*(unsigned long*)param.value);
+      break;
+    case PARAM_FLOAT:
+      _out.printFloat(*(float*)param.value, 3);
+      break;
+  }
+  _out.print("\n");
+}
+
+bool CommandConsole::setParam(const ConsoleParam& param, const char* text) {
+  char* end = nullptr;
+  float value = strtof(text, &end);
+  if (end == text || *end != '\0') {
+    return false;
+  }
+  if (value < param.minValue || value > param.maxValue) {
+    return false;
+  }
+  if (param.type != PARAM_FLOAT && value != (float)(long)value) {
+    return false;  // integers only
+  }
+
+  switch (param.type) {
+    case PARAM_INT:
+      *(int*)param.value = (int)value;
+      break;
+    case PARAM_ULONG:
+      *(unsigned long*)param.value = (unsigned long)value;
+      break;
+    case PARAM_FLOAT:
+      *(float*)param.value = value;
+      break;
+  }
+  return true;
+}
+
+void CommandConsole::builtinHelp() {
+  _out.println("help | get [name] | set <name> <value>");
+  for (size_t i = 0; i < _commandCount; i++) {
+    _out.println(_commands[i].usage);
+  }
+}
+
+void CommandConsole::builtinGet(const ConsoleArgs& args) {
+  if (args.argc < 2) {
+    for (size_t i = 0; i < _paramCount; i++) {
+      printParam(_params[i]);
+    }
+    return;
+  }
+  const ConsoleParam* param = findParam(args.argv[1]);
+  if (param == nullptr) {
+    _errors++;
+    _out.print("ERR unknown parameter: ");
+    _out.println(args.argv[1]);
+    return;
+  }
+  printParam(*param);
+}
+
+void CommandConsole::builtinSet(const ConsoleArgs& args) {
+  if (args.argc != 3) {
+    _errors++;
+    _out.println("ERR usage: set <name> <value>");
+    return;
+  }
+  const ConsoleParam* param = findParam(args.argv[1]);
+  if (param == nullptr) {
+    _errors++;
+    _out.print("ERR unknown parameter: ");
+    _out.println(args.argv[1]);
+    return;
+  }
+  if (!setParam(*param, args.argv[2])) {
+    _errors++;
+    _out.print("ERR ");
+    _out.print(param->name);
+    _out.print(" range ");
+    _out.printFloat(param->minValue, param->type == PARAM_FLOAT ? 3 : 0);
+    _out.print("..");
+    _out.printFloat(param->maxValue, param->type == PARAM_FLOAT ? 3 : 0);
+    _out.print("\n");
+    return;
+  }
+  _out.print("OK ");
+  printParam(*param);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Line-oriented serial console with fixed buffers: no heap, no String.
+// poll() consumes at most maxBytes per call and executes at most one line,
+// so it can run every control-loop tick without disturbing timing.
+const size_t CONSOLE_LINE_SIZE = 64;
+const size_t CONSOLE_MAX_ARGS = 8;  // profile add with a ramp rate takes 7
+
+class ConsoleOutput {
+ public:
+  virtual ~ConsoleOutput() {}
+  virtual void write(const char* text) = 0;
+
+  void print(const char* text) { write(text); }
+  void println(const char* text) { write(text); write("\n"); }
+  void printInt(long value);
+  void printFloat(float value, int digits);
+};
+
+#ifdef ARDUINO
+// Console replies on a Print (Serial)
+class PrintConsoleOutput : public ConsoleOutput {
+ public:
+  explicit PrintConsoleOutput(Print& print) : _print(print) {}
+  void write(const char* text) override { _print.print(text); }
+
+ private:
+  Print& _print;
+};
+#endif
+
+// Tokens of one command line; argv[0] is the command name
+struct ConsoleArgs {
+  int argc;
+  char* argv[CONSOLE_MAX_ARGS];
+};
+
+typedef void (*ConsoleHandler)(const ConsoleArgs& args, ConsoleOutput& out);
+
+struct ConsoleCommand {
+  const char* name;
+  const char* usage;
+  ConsoleHandler handler;
+};
+
+enum ConsoleParamType : uint8_t {
+  PARAM_INT,
+  PARAM_ULONG,
+  PARAM_FLOAT
+};
+
+// Runtime parameter reachable with get/set, range checked on set
+struct ConsoleParam {
+  const char* name;
+  ConsoleParamType type;
+  void* value;
+  float minValue;
+  float maxValue;
+};
+
+class CommandConsole {
+ public:
+  CommandConsole(const ConsoleCommand* commands, size_t commandCount,
+                 const ConsoleParam* params, size_t paramCount,
+                 ConsoleOutput& out);
+
+  // Input needs available() and read(), e.g. HardwareSerial
+  template <typename Input>
+  size_t poll(Input& in, size_t maxBytes) {
+    size_t consumed = 0;
+    while (consumed < maxBytes && in.available() > 0) {
+      int c = in.read();
+      if (c < 0) {
+        break;
+      }
+      consumed++;
+      if (feed((char)c)) {
+        execute();
+        break;  // at most one command per tick
+      }
+    }
+    return consumed;
+  }
+
+  // Returns true when a complete line is buffered and ready for execute()
+  bool feed(char c);
+  void execute();
+
+  const ConsoleParam* findParam(const char* name) const;
+
+  uint32_t linesExecuted() const { return _linesExecuted; }
+  uint32_t errors() const { return _errors; }
+  uint32_t overflows() const { return _overflows; }
+
+ private:
+  int tokenize(ConsoleArgs& args);
+  void printParam(const ConsoleParam& param);
+  bool setParam(const ConsoleParam& param, const char* text);
+  void builtinHelp();
+  void builtinGet(const ConsoleArgs& args);
+  void builtinSet(const ConsoleArgs& args);
+
+  const ConsoleCommand* _commands;
+  size_t _commandCount;
+  const ConsoleParam* _params;
+  size_t _paramCount;
+  ConsoleOutput& _out;
+
+  char _line[CONSOLE_LINE_SIZE];
+  size_t _length;
+  bool _discarding;  // rest of an overlong line is dropped
+  bool _ready;
+
+  uint32_t _linesExecuted;
+  uint32_t _errors;
+  uint32_t _overflows;
+};
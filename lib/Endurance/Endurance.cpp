@@ -0,0 +1,340 @@
+#include "Endurance.h"
+
+#include <math.h>
+#include <string.h>
+#include "Telemetry.h"
+
+EnduranceTriggers defaultEnduranceTriggers() {
+  EnduranceTriggers triggers;
+  triggers.dropFraction = 0.10f;
+  triggers.spikeKg = 0.0f;
+  triggers.minVoltageV = 0.0f;
+  return triggers;
+}
+
+const char* enduranceAnomalyName(EnduranceAnomaly anomaly) {
+  switch (anomaly) {
+    case ANOMALY_NONE: return "none";
+    case ANOMALY_DROP: return "drop";
+    case ANOMALY_SPIKE: return "spike";
+    case ANOMALY_SAG: return "sag";
+    case ANOMALY_MANUAL: return "manual";
+  }
+  return "?";
+}
+
+void IntervalStats::reset() {
+  _thrust.reset();
+  _sumA = 0.0f;
+  _minV = 0.0f;
+}
+
+void IntervalStats::add(float thrustKg, const PowerReading& power) {
+  _thrust.add(thrustKg);
+  _sumA += power.currentA;
+  // 0 V: no power monitor, not a sag
+  if (power.voltageV > 0.0f && (_minV == 0.0f || power.voltageV < _minV)) {
+    _minV = power.voltageV;
+  }
+}
+
+EnduranceSummary IntervalStats::summary(uint32_t index) const {
+  EnduranceSummary s;
+  s.index = index;
+  s.count = _thrust.count();
+  s.meanKg = _thrust.mean();
+  s.minKg = s.count > 0 ? _thrust.min() : 0.0f;
+  s.maxKg = s.count > 0 ? _thrust.max() : 0.0f;
+  s.stddevKg = _thrust.stddev();
+  s.meanA = s.count > 0 ? _sumA / s.count : 0.0f;
+  s.minV = _minV;
+  return s;
+}
+
+AnomalyWindow::AnomalyWindow() : _samples(nullptr), _capacity(0) {
+  reset();
+}
+
+void AnomalyWindow::attach(BurstSample* storage, size_t capacity) {
+  _samples = storage;
+  _capacity = storage ? capacity : 0;
+  reset();
+}
+
+void AnomalyWindow::reset() {
+  _count = 0;
+  _next = 0;
+  _postLeft = 0;
+  _triggered = false;
+  _frozen = false;
+  _triggerUs = 0;
+}
+
+bool AnomalyWindow::add(uint32_t timeUs, int32_t raw, uint16_t pwm, uint16_t currentMa) {
+  if (_capacity == 0 || _frozen) {
+    return false;
+  }
+  _samples[_next] = {timeUs, raw, pwm, currentMa};
+  _next = (_next + 1) % _capacity;
+  if (_count < _capacity) {
+    _count++;
+  }
+  if (_triggered && --_postLeft == 0) {
+    _frozen = true;
+    return true;
+  }
+  return false;
+}
+
+void AnomalyWindow::trigger(uint32_t timeUs) {
+  if (_capacity == 0 || _triggered) {
+    return;
+  }
+  _triggered = true;
+  _triggerUs = timeUs;
+  _postLeft = _capacity / 2 > 0 ? _capacity / 2 : 1;
+}
+
+const BurstSample& AnomalyWindow::sample(size_t i) const {
+  size_t oldest = _count < _capacity ? 0 : _next;
+  return _samples[(oldest + i) % _capacity];
+}
+
+void DecayChart::reset() {
+  for (int i = 0; i < ENDURANCE_CHART_COLUMNS; i++) {
+    _sum[i] = 0.0f;
+    _count[i] = 0;
+  }
+  _columns = 0;
+  _bucketSeconds = ENDURANCE_CHART_BUCKET_S;
+}
+
+void DecayChart::add(uint32_t second, float meanKg) {
+  while (second / _bucketSeconds >= (uint32_t)ENDURANCE_CHART_COLUMNS) {
+    // Merge pairs: column i takes 2i and 2i+1
+    for (int i = 0; i < ENDURANCE_CHART_COLUMNS / 2; i++) {
+      _sum[i] = _sum[2 * i] + _sum[2 * i + 1];
+      _count[i] = _count[2 * i] + _count[2 * i + 1];
+    }
+    for (int i = ENDURANCE_CHART_COLUMNS / 2; i < ENDURANCE_CHART_COLUMNS; i++) {
+      _sum[i] = 0.0f;
+      _count[i] = 0;
+    }
+    _columns = (_columns + 1) / 2;
+    _bucketSeconds *= 2;
+  }
+  int column = (int)(second / _bucketSeconds);
+  _sum[column] += meanKg;
+  _count[column]++;
+  if (column + 1 > _columns) {
+    _columns = column + 1;
+  }
+}
+
+int DecayChart::heights(uint8_t* out, int levels, float minSpanKg, float& bottomKg,
+                        float& topKg) const {
+  bottomKg = 0.0f;
+  topKg = 0.0f;
+  bool any = false;
+  for (int i = 0; i < _columns; i++) {
+    if (_count[i] == 0) continue;
+    float kg = column(i);
+    if (!any || kg < bottomKg) bottomKg = kg;
+    if (!any || kg > topKg) topKg = kg;
+    any = true;
+  }
+  if (topKg - bottomKg < minSpanKg) {
+    bottomKg = topKg - minSpanKg;
+  }
+  float span = topKg - bottomKg;
+  for (int i = 0; i < _columns; i++) {
+    if (_count[i] == 0 || span <= 0.0f) {
+      out[i] = 0;
+      continue;
+    }
+    // The lowest column keeps one level so it reads as a bar, not a gap
+    int h = 1 + (int)lroundf((column(i) - bottomKg) / span * (levels - 1));
+    out[i] = (uint8_t)(h < 1 ? 1 : (h > levels ? levels : h));
+  }
+  return _columns;
+}
+
+int enduranceMinutesKept(const EnduranceRecord& record) {
+  return record.minutes < ENDURANCE_MAX_MINUTES ? record.minutes : ENDURANCE_MAX_MINUTES;
+}
+
+uint32_t enduranceFirstMinute(const EnduranceRecord& record) {
+  return record.minutes - enduranceMinutesKept(record);
+}
+
+const EnduranceMinute& enduranceMinute(const EnduranceRecord& record, int i) {
+  return record.minute[(enduranceFirstMinute(record) + i) % ENDURANCE_MAX_MINUTES];
+}
+
+uint16_t enduranceCrc(const EnduranceRecord& record) {
+  return crc16Ccitt((const uint8_t*)&record, offsetof(EnduranceRecord, crc));
+}
+
+bool enduranceValid(const EnduranceRecord& record) {
+  return record.magic == ENDURANCE_RECORD_MAGIC && record.size == sizeof(record) &&
+         record.crc == enduranceCrc(record);
+}
+
+EnduranceRun::EnduranceRun() : _triggers(defaultEnduranceTriggers()), _saveEveryMinutes(0) {
+  begin(_triggers, 0, 0);
+}
+
+void EnduranceRun::begin(const EnduranceTriggers& triggers, uint16_t pwm, int saveEveryMinutes) {
+  _triggers = triggers;
+  _saveEveryMinutes = saveEveryMinutes;
+  _secondStats.reset();
+  _minuteStats.reset();
+  _lastSecond = _secondStats.summary(0);
+  _lastMinute = _minuteStats.summary(0);
+  _second = 0;
+  _haveSecond = false;
+  _dropActive = false;
+  _spikeActive = false;
+  _sagActive = false;
+  _lastAnomaly = ANOMALY_NONE;
+  _window.reset();
+  _chart.reset();
+  memset(&_record, 0, sizeof(_record));
+  _record.magic = ENDURANCE_RECORD_MAGIC;
+  _record.size = sizeof(_record);
+  _record.pwm = pwm;
+}
+
+uint8_t EnduranceRun::startAnomaly(EnduranceAnomaly anomaly, uint32_t elapsedUs) {
+  _lastAnomaly = anomaly;
+  if (_record.triggers < UINT16_MAX) {
+    _record.triggers++;
+  }
+  if (_record.anomaly == ANOMALY_NONE) {
+    _record.anomaly = anomaly;
+    _record.anomalyMs = elapsedUs / 1000;
+  }
+  _window.trigger(elapsedUs);
+  return ENDURANCE_TRIGGER;
+}
+
+uint8_t EnduranceRun::freeze(uint32_t elapsedUs) {
+  return startAnomaly(ANOMALY_MANUAL, elapsedUs);
+}
+
+uint8_t EnduranceRun::add(uint32_t elapsedUs, int32_t raw, float thrustKg,
+                          const PowerReading& power) {
+  uint8_t events = 0;
+  // A reading past the second being filled closes it first (and any the
+  // stand skipped, so the seconds keep their index)
+  while (elapsedUs / 1000000UL > _second) {
+    events |= closeSecond(elapsedUs);
+  }
+
+  // Edge-triggered: a condition that stays true counts once
+  if (_triggers.spikeKg > 0.0f && _haveSecond) {
+    bool spike = fabsf(thrustKg - _lastSecond.meanKg) > _triggers.spikeKg;
+    if (spike && !_spikeActive) {
+      events |= startAnomaly(ANOMALY_SPIKE, elapsedUs);
+    }
+    _spikeActive = spike;
+  }
+  if (_triggers.minVoltageV > 0.0f && power.voltageV > 0.0f) {
+    bool sag = power.voltageV < _triggers.minVoltageV;
+    if (sag && !_sagActive) {
+      events |= startAnomaly(ANOMALY_SAG, elapsedUs);
+    }
+    _sagActive = sag;
+  }
+
+  _secondStats.add(thrustKg, power);
+  _minuteStats.add(thrustKg, power);
+  float currentMa = power.currentA * 1000.0f;
+  uint16_t ma = currentMa <= 0.0f ? 0 : (currentMa >= 65535.0f ? 65535 : (uint16_t)currentMa);
+  if (_window.add(elapsedUs, raw, _record.pwm, ma)) {
+    events |= ENDURANCE_FROZEN;
+  }
+  return events;
+}
+
+uint8_t EnduranceRun::closeSecond(uint32_t elapsedUs) {
+  uint8_t events = 0;
+  if (_secondStats.count() > 0) {
+    _lastSecond = _secondStats.summary(_second);
+    _haveSecond = true;
+    _chart.add(_second, _lastSecond.meanKg);
+    events |= ENDURANCE_SECOND;
+
+    if (_triggers.dropFraction > 0.0f && _record.referenceKg > 0.0f) {
+      bool drop = _lastSecond.meanKg < (1.0f - _triggers.dropFraction) * _record.referenceKg;
+      if (drop && !_dropActive) {
+        events |= startAnomaly(ANOMALY_DROP, elapsedUs);
+      }
+      _dropActive = drop;
+    }
+  }
+  _secondStats.reset();
+  _second++;
+  _record.seconds = _second;
+
+  if (_second % 60 == 0) {
+    closeMinute();
+    events |= ENDURANCE_MINUTE;
+    if (_saveEveryMinutes > 0 && _record.minutes % _saveEveryMinutes == 0) {
+      events |= ENDURANCE_SAVE_DUE;
+    }
+  }
+  return events;
+}
+
+void EnduranceRun::closeMinute() {
+  _lastMinute = _minuteStats.summary(_record.minutes);
+  _minuteStats.reset();
+  EnduranceMinute& m = _record.minute[_record.minutes % ENDURANCE_MAX_MINUTES];
+  m.meanKg = _lastMinute.meanKg;
+  m.minKg = _lastMinute.minKg;
+  m.maxKg = _lastMinute.maxKg;
+  m.stddevKg = _lastMinute.stddevKg;
+  m.meanA = _lastMinute.meanA;
+  m.minV = _lastMinute.minV;
+  if (_record.minutes == 0) {
+    _record.referenceKg = _lastMinute.meanKg;
+  }
+  if (_record.minutes < UINT16_MAX) {
+    _record.minutes++;
+  }
+}
+
+#ifdef ARDUINO
+bool loadEndurance(EnduranceRecord& record) {
+  Preferences prefs;
+  if (!prefs.begin("endurance", true)) {
+    return false;
+  }
+  size_t n = prefs.getBytes("last", &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record) && enduranceValid(record);
+}
+
+bool saveEndurance(EnduranceRecord& record) {
+  if (record.saves < UINT16_MAX) {
+    record.saves++;
+  }
+  record.crc = enduranceCrc(record);
+  Preferences prefs;
+  if (!prefs.begin("endurance", false)) {
+    return false;
+  }
+  size_t n = prefs.putBytes("last", &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record);
+}
+
+void eraseEndurance() {
+  Preferences prefs;
+  if (prefs.begin("endurance", false)) {
+    prefs.remove("last");
+    prefs.end();
+  }
+}
+#endif
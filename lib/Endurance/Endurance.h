@@ -0,0 +1,224 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "BurstCapture.h"
+#include "PowerMonitor.h"
+#include "SampleStats.h"
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#endif
+
+// Long runs at a fixed throttle. Every reading goes into per-second and
+// per-minute statistics, a rolling raw window that freezes around the first
+// anomaly, and a decay chart; only the decimated records leave the stand.
+// Memory is fixed (the window borrows the step-capture buffer) and the
+// minute summaries reach NVS once every saveEveryMinutes.
+
+const int ENDURANCE_MAX_MINUTES = 60;     // minute summaries kept (the latest)
+const int ENDURANCE_CHART_COLUMNS = 20;   // one LCD row
+const uint32_t ENDURANCE_CHART_BUCKET_S = 5;  // first column width, doubles as the run grows
+const uint32_t ENDURANCE_RECORD_MAGIC = 0x454E4431;  // "END1"
+
+// Statistics of one second or one minute
+struct EnduranceSummary {
+  uint32_t index;  // seconds or minutes since the start
+  uint32_t count;  // readings
+  float meanKg;
+  float minKg;
+  float maxKg;
+  float stddevKg;
+  float meanA;  // 0 without a power monitor
+  float minV;
+};
+
+// Anomaly triggers, each 0 = off
+struct EnduranceTriggers {
+  float dropFraction;  // second mean this far below the first minute's mean
+  float spikeKg;       // reading this far from the previous second's mean
+  float minVoltageV;   // supply sag
+};
+
+EnduranceTriggers defaultEnduranceTriggers();
+
+enum EnduranceAnomaly : uint8_t {
+  ANOMALY_NONE,
+  ANOMALY_DROP,
+  ANOMALY_SPIKE,
+  ANOMALY_SAG,
+  ANOMALY_MANUAL
+};
+
+const char* enduranceAnomalyName(EnduranceAnomaly anomaly);
+
+// add() result flags
+enum EnduranceEvent : uint8_t {
+  ENDURANCE_SECOND = 1,    // secondSummary() is new
+  ENDURANCE_MINUTE = 2,    // minuteSummary() is new
+  ENDURANCE_SAVE_DUE = 4,  // a save interval ended with this minute
+  ENDURANCE_TRIGGER = 8,   // an anomaly started with this reading
+  ENDURANCE_FROZEN = 16    // the raw window just froze
+};
+
+// Mean, min, max and stddev of thrust with current and voltage beside it
+class IntervalStats {
+ public:
+  IntervalStats() { reset(); }
+
+  void reset();
+  void add(float thrustKg, const PowerReading& power);
+  uint32_t count() const { return _thrust.count(); }
+  EnduranceSummary summary(uint32_t index) const;
+
+ private:
+  RunningStats _thrust;
+  float _sumA;
+  float _minV;
+};
+
+// Raw readings of the last capacity samples; after a trigger it keeps
+// recording for half the capacity, then freezes so the anomaly sits in the
+// middle. Later triggers are counted and leave it alone.
+class AnomalyWindow {
+ public:
+  AnomalyWindow();
+
+  void attach(BurstSample* storage, size_t capacity);
+  bool attached() const { return _samples != nullptr; }
+  void reset();
+
+  // False once frozen (or without storage); true when this sample froze it
+  bool add(uint32_t timeUs, int32_t raw, uint16_t pwm, uint16_t currentMa);
+  void trigger(uint32_t timeUs);
+
+  bool triggered() const { return _triggered; }
+  bool frozen() const { return _frozen; }
+  size_t count() const { return _count; }
+  size_t capacity() const { return _capacity; }
+  uint32_t triggerUs() const { return _triggerUs; }
+  // Oldest first
+  const BurstSample& sample(size_t i) const;
+
+ private:
+  BurstSample* _samples;
+  size_t _capacity;
+  size_t _count;
+  size_t _next;
+  size_t _postLeft;  // samples still to record after the trigger
+  bool _triggered;
+  bool _frozen;
+  uint32_t _triggerUs;
+};
+
+// Thrust over the whole run in ENDURANCE_CHART_COLUMNS columns: each column
+// is the mean of its seconds; when the run outgrows the chart, neighbouring
+// columns merge and the column width doubles
+class DecayChart {
+ public:
+  DecayChart() { reset(); }
+
+  void reset();
+  void add(uint32_t second, float meanKg);
+
+  int columns() const { return _columns; }
+  uint32_t bucketSeconds() const { return _bucketSeconds; }
+  float column(int i) const { return _count[i] > 0 ? _sum[i] / _count[i] : 0.0f; }
+
+  // Bar heights 0..levels scaled to the columns' range (at least minSpanKg
+  // below the top, so noise does not fill the chart); returns columns()
+  int heights(uint8_t* out, int levels, float minSpanKg, float& bottomKg, float& topKg) const;
+
+ private:
+  float _sum[ENDURANCE_CHART_COLUMNS];
+  uint32_t _count[ENDURANCE_CHART_COLUMNS];
+  int _columns;
+  uint32_t _bucketSeconds;
+};
+
+// One minute as stored
+struct EnduranceMinute {
+  float meanKg;
+  float minKg;
+  float maxKg;
+  float stddevKg;
+  float meanA;
+  float minV;
+};
+
+// The run as stored in NVS: settings, anomaly and the latest minute summaries
+struct EnduranceRecord {
+  uint32_t magic;
+  uint16_t size;
+  uint16_t pwm;
+  uint32_t seconds;    // run length
+  uint16_t minutes;    // summaries written; the ring keeps the latest ENDURANCE_MAX_MINUTES
+  uint16_t saves;
+  uint8_t anomaly;     // first one, EnduranceAnomaly
+  uint8_t completed;   // ran its full duration
+  uint16_t triggers;   // anomalies started, the first included
+  uint32_t anomalyMs;  // first anomaly, from the start
+  float referenceKg;   // first minute's mean, 0 before it ends
+  EnduranceMinute minute[ENDURANCE_MAX_MINUTES];
+  uint16_t crc;
+};
+
+// Minute i of those kept, oldest first
+int enduranceMinutesKept(const EnduranceRecord& record);
+const EnduranceMinute& enduranceMinute(const EnduranceRecord& record, int i);
+uint32_t enduranceFirstMinute(const EnduranceRecord& record);
+
+uint16_t enduranceCrc(const EnduranceRecord& record);
+bool enduranceValid(const EnduranceRecord& record);
+
+class EnduranceRun {
+ public:
+  EnduranceRun();
+
+  // Raw window storage; without it the run keeps statistics only
+  void attachWindow(BurstSample* storage, size_t capacity) { _window.attach(storage, capacity); }
+
+  void begin(const EnduranceTriggers& triggers, uint16_t pwm, int saveEveryMinutes);
+
+  // One reading; elapsedUs since begin(). EnduranceEvent flags.
+  uint8_t add(uint32_t elapsedUs, int32_t raw, float thrustKg, const PowerReading& power);
+  // Operator trigger; EnduranceEvent flags
+  uint8_t freeze(uint32_t elapsedUs);
+
+  const EnduranceSummary& secondSummary() const { return _lastSecond; }
+  const EnduranceSummary& minuteSummary() const { return _lastMinute; }
+  EnduranceAnomaly lastAnomaly() const { return _lastAnomaly; }
+  uint32_t elapsedSeconds() const { return _second; }
+
+  const AnomalyWindow& window() const { return _window; }
+  const DecayChart& chart() const { return _chart; }
+  EnduranceRecord& record() { return _record; }
+  const EnduranceRecord& record() const { return _record; }
+
+ private:
+  uint8_t startAnomaly(EnduranceAnomaly anomaly, uint32_t elapsedUs);
+  uint8_t closeSecond(uint32_t elapsedUs);
+  void closeMinute();
+
+  EnduranceTriggers _triggers;
+  int _saveEveryMinutes;
+  IntervalStats _secondStats;
+  IntervalStats _minuteStats;
+  EnduranceSummary _lastSecond;
+  EnduranceSummary _lastMinute;
+  uint32_t _second;  // index of the second being filled
+  bool _haveSecond;  // _lastSecond is from this run
+  bool _dropActive;
+  bool _spikeActive;
+  bool _sagActive;
+  EnduranceAnomaly _lastAnomaly;
+  AnomalyWindow _window;
+  DecayChart _chart;
+  EnduranceRecord _record;
+};
+
+#ifdef ARDUINO
+bool loadEndurance(EnduranceRecord& record);
+bool saveEndurance(EnduranceRecord& record);
+void eraseEndurance();
+#endif
@@ -0,0 +1,349 @@
+#include "EscDiscovery.h"
+
+#include <ctype.h>
+#include <string.h>
+#include "Telemetry.h"
+
+EscDiscoveryConfig defaultEscDiscoveryConfig() {
+  EscDiscoveryConfig config;
+  config.searchSlowPwm = 1400;   // past the stand ESC's 1360 stop value
+  config.searchFastPwm = 1100;
+  config.coarseStepPwm = 20;
+  config.resolutionPwm = 2;
+  config.minSpinKg = 0.010f;
+  config.noiseSigmas = 5.0f;
+  config.flatFraction = 0.02f;
+  config.flatSteps = 2;
+  config.stopMarginPwm = 20;
+  return config;
+}
+
+const char* escDiscoveryPhaseName(EscDiscoveryPhase phase) {
+  switch (phase) {
+    case DISC_IDLE: return "idle";
+    case DISC_START_COARSE: return "spin-up";
+    case DISC_START_FINE: return "spin-up fine";
+    case DISC_CLIMB_COARSE: return "climb";
+    case DISC_CLIMB_FINE: return "climb fine";
+    case DISC_STALL_COARSE: return "stall";
+    case DISC_STALL_FINE: return "stall fine";
+    case DISC_VERIFY_STOP: return "verify stop";
+    case DISC_DONE: return "done";
+    case DISC_FAILED: return "failed";
+  }
+  return "?";
+}
+
+EscDiscovery::EscDiscovery()
+    : _config(defaultEscDiscoveryConfig()),
+      _phase(DISC_IDLE),
+      _failure(""),
+      _result(),
+      _probe(),
+      _stillPwm(0),
+      _turnPwm(0),
+      _restStillPwm(0),
+      _targetKg(0.0f),
+      _flatRun(0),
+      _points(0) {}
+
+void EscDiscovery::begin(const EscDiscoveryConfig& config, float noiseKg) {
+  _config = config;
+  if (_config.coarseStepPwm < 1) _config.coarseStepPwm = 1;
+  if (_config.resolutionPwm < 1) _config.resolutionPwm = 1;
+  _result = EscEndpoints();
+  float noiseSpinKg = _config.noiseSigmas * noiseKg;
+  _result.spinKg = noiseSpinKg > _config.minSpinKg ? noiseSpinKg : _config.minSpinKg;
+  _failure = "";
+
+  // Spin-up: from the slow end of the search toward the fast end, a stop
+  // before every probe, until the motor turns
+  _phase = DISC_START_COARSE;
+  _probe = {_config.searchSlowPwm, ESC_PROBE_FROM_REST, 0};
+}
+
+bool EscDiscovery::next(EscProbe& probe) {
+  if (_phase == DISC_IDLE || finished()) {
+    return false;
+  }
+  probe = _probe;
+  return true;
+}
+
+void EscDiscovery::fail(const char* reason) {
+  _failure = reason;
+  _phase = DISC_FAILED;
+}
+
+void EscDiscovery::measured(float thrustKg) {
+  if (_phase == DISC_IDLE || finished()) {
+    return;
+  }
+  _result.probes++;
+  int pwm = _probe.pwm;
+  bool turns = turning(thrustKg);
+
+  switch (_phase) {
+    case DISC_START_COARSE:
+      if (!turns) {
+        if (pwm <= _config.searchFastPwm) {
+          fail("no spin-up down to the fast end of the search");
+          return;
+        }
+        _stillPwm = pwm;
+        int nextPwm = pwm - _config.coarseStepPwm;
+        _probe.pwm = nextPwm > _config.searchFastPwm ? nextPwm : _config.searchFastPwm;
+        return;
+      }
+      if (pwm == _config.searchSlowPwm) {
+        fail("turning at the slow end of the search");
+        return;
+      }
+      _turnPwm = pwm;
+      _phase = DISC_START_FINE;
+      break;
+
+    case DISC_START_FINE:
+      if (turns) {
+        _turnPwm = pwm;
+      } else {
+        _stillPwm = pwm;
+      }
+      break;
+
+    case DISC_CLIMB_COARSE: {
+      if (_points == 0 && !turns) {
+        fail("no thrust at the spin-up pulse");
+        return;
+      }
+      if (_points > 0) {
+        float gain = thrustKg - _climbKg[_points - 1];
+        _flatRun = gain < _config.flatFraction * thrustKg ? _flatRun + 1 : 0;
+      }
+      _climbPwm[_points] = (int16_t)pwm;
+      _climbKg[_points] = thrustKg;
+      _points++;
+      if (thrustKg > _result.maxThrustKg) {
+        _result.maxThrustKg = thrustKg;
+      }
+      // Early end: thrust has gone flat, no need to push on to the fast end
+      if (_flatRun >= _config.flatSteps) {
+        _result.saturated = 1;
+        endClimb();
+      } else if (pwm <= _config.searchFastPwm || _points >= ESC_DISCOVERY_MAX_POINTS) {
+        endClimb();
+      } else {
+        int nextPwm = pwm - _config.coarseStepPwm;
+        _probe = {nextPwm > _config.searchFastPwm ? nextPwm : _config.searchFastPwm,
+                  ESC_PROBE_RUNNING, 0};
+      }
+      return;
+    }
+
+    case DISC_CLIMB_FINE:
+      // Here _stillPwm is the side short of the target, _turnPwm the side reaching it
+      if (thrustKg >= _targetKg) {
+        _turnPwm = pwm;
+      } else {
+        _stillPwm = pwm;
+      }
+      if (_stillPwm - _turnPwm > _config.resolutionPwm) {
+        _probe.pwm = (_stillPwm + _turnPwm) / 2;
+      } else {
+        _result.fastPwm = (int16_t)_turnPwm;
+        startStall();
+      }
+      return;
+
+    case DISC_STALL_COARSE:
+      if (turns) {
+        if (pwm >= _config.searchSlowPwm) {
+          fail("still turning at the slow end of the search");
+          return;
+        }
+        _turnPwm = pwm;
+        int nextPwm = pwm + _config.coarseStepPwm;
+        _probe = {nextPwm < _config.searchSlowPwm ? nextPwm : _config.searchSlowPwm,
+                  ESC_PROBE_RUNNING, 0};
+        return;
+      }
+      _stillPwm = pwm;
+      _phase = DISC_STALL_FINE;
+      break;
+
+    case DISC_STALL_FINE:
+      if (turns) {
+        _turnPwm = pwm;
+      } else {
+        _stillPwm = pwm;
+      }
+      break;
+
+    case DISC_VERIFY_STOP:
+      if (turns) {
+        fail("stop value turns the motor");
+      } else {
+        _phase = DISC_DONE;
+      }
+      return;
+
+    default:
+      return;
+  }
+
+  // Bisect the spin-up or stall bracket; each probe starts the motor the
+  // same way as the one that found the bracket
+  if (_stillPwm - _turnPwm > _config.resolutionPwm) {
+    int mid = (_stillPwm + _turnPwm) / 2;
+    if (_phase == DISC_START_FINE) {
+      _probe = {mid, ESC_PROBE_FROM_REST, 0};
+    } else {
+      _probe = {mid, ESC_PROBE_FROM_SPIN, _result.startPwm};
+    }
+  } else if (_phase == DISC_START_FINE) {
+    _result.startPwm = (int16_t)_turnPwm;
+    _restStillPwm = _stillPwm;
+    startClimb();
+  } else {
+    endStall();
+  }
+}
+
+// From the spin-up pulse toward the fast end, the motor kept turning
+void EscDiscovery::startClimb() {
+  _phase = DISC_CLIMB_COARSE;
+  _points = 0;
+  _flatRun = 0;
+  _probe = {_result.startPwm, ESC_PROBE_FROM_REST, 0};
+}
+
+// Saturation: the slowest pulse within flatFraction of the plateau, bracketed
+// by the coarse points and then bisected
+void EscDiscovery::endClimb() {
+  int last = _points - 1;
+  if (!_result.saturated) {
+    _result.fastPwm = _climbPwm[last];
+    startStall();
+    return;
+  }
+  _targetKg = (1.0f - _config.flatFraction) * _result.maxThrustKg;
+  int reach = 0;
+  while (reach < last && _climbKg[reach] < _targetKg) {
+    reach++;
+  }
+  if (reach == 0) {
+    _result.fastPwm = _climbPwm[0];
+    startStall();
+    return;
+  }
+  _stillPwm = _climbPwm[reach - 1];
+  _turnPwm = _climbPwm[reach];
+  if (_stillPwm - _turnPwm <= _config.resolutionPwm) {
+    _result.fastPwm = (int16_t)_turnPwm;
+    startStall();
+    return;
+  }
+  _phase = DISC_CLIMB_FINE;
+  _probe = {(_stillPwm + _turnPwm) / 2, ESC_PROBE_RUNNING, 0};
+}
+
+// A turning motor often keeps going at pulses too slow to start it: from the
+// spin-up pulse toward the slow end until it stops
+void EscDiscovery::startStall() {
+  _phase = DISC_STALL_COARSE;
+  _turnPwm = _result.startPwm;
+  int pwm = _result.startPwm + _config.coarseStepPwm;
+  _probe = {pwm < _config.searchSlowPwm ? pwm : _config.searchSlowPwm, ESC_PROBE_FROM_SPIN,
+            _result.startPwm};
+}
+
+// Still from rest and after a spin; the stop value is checked after a spin
+void EscDiscovery::endStall() {
+  _result.stallPwm = (int16_t)_turnPwm;
+  _result.slowPwm = (int16_t)(_restStillPwm > _stillPwm ? _restStillPwm : _stillPwm);
+  _result.stopPwm = (int16_t)(_result.slowPwm + _config.stopMarginPwm);
+  _phase = DISC_VERIFY_STOP;
+  _probe = {_result.stopPwm, ESC_PROBE_FROM_SPIN, _result.startPwm};
+}
+
+bool escNameValid(const char* name) {
+  size_t length = strlen(name);
+  if (length == 0 || length >= ESC_NAME_MAX) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (!isalnum((unsigned char)name[i]) && name[i] != '-' && name[i] != '_') {
+      return false;
+    }
+  }
+  return true;
+}
+
+void clearEscProfile(EscProfileRecord& record, const char* name) {
+  record = EscProfileRecord();
+  record.magic = ESC_PROFILE_MAGIC;
+  record.size = sizeof(record);
+  strncpy(record.name, name, ESC_NAME_MAX - 1);
+}
+
+uint16_t escProfileCrc(const EscProfileRecord& record) {
+  return crc16Ccitt((const uint8_t*)&record, offsetof(EscProfileRecord, crc));
+}
+
+bool escProfileValid(const EscProfileRecord& record) {
+  const EscEndpoints& e = record.endpoints;
+  return record.magic == ESC_PROFILE_MAGIC && record.size == sizeof(record) &&
+         record.crc == escProfileCrc(record) && record.name[ESC_NAME_MAX - 1] == '\0' &&
+         e.fastPwm < e.slowPwm && e.slowPwm <= e.stopPwm;
+}
+
+#ifdef ARDUINO
+bool loadEscProfile(const char* name, EscProfileRecord& record) {
+  Preferences prefs;
+  if (!prefs.begin("esc", true)) {
+    return false;
+  }
+  size_t n = prefs.getBytes(name, &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record) && escProfileValid(record) && strcmp(record.name, name) == 0;
+}
+
+bool saveEscProfile(EscProfileRecord& record) {
+  record.crc = escProfileCrc(record);
+  Preferences prefs;
+  if (!prefs.begin("esc", false)) {
+    return false;
+  }
+  size_t n = prefs.putBytes(record.name, &record, sizeof(record));
+  prefs.end();
+  return n == sizeof(record);
+}
+
+void eraseEscProfile(const char* name) {
+  Preferences prefs;
+  if (prefs.begin("esc", false)) {
+    prefs.remove(name);
+    prefs.end();
+  }
+}
+
+bool loadActiveEscName(char* name, size_t size) {
+  Preferences prefs;
+  if (!prefs.begin("esc_active", true)) {
+    return false;
+  }
+  size_t n = prefs.getString("name", name, size);
+  prefs.end();
+  return n > 0 && escNameValid(name);
+}
+
+bool saveActiveEscName(const char* name) {
+  Preferences prefs;
+  if (!prefs.begin("esc_active", false)) {
+    return false;
+  }
+  size_t n = prefs.putString("name", name);
+  prefs.end();
+  return n > 0;
+}
+#endif
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ARDUINO
+#include <Preferences.h>
+#endif
+
+// Finds a reversed ESC's endpoints from load-cell feedback: the pulse that
+// spins the motor up from rest, the pulse past which thrust stops growing
+// and a stop value that leaves the prop still. Each search steps coarsely
+// until it brackets its answer, then bisects the bracket down to
+// resolutionPwm; the climb ends as soon as thrust goes flat. The caller runs
+// the probes (command, settle, average) and feeds back the mean thrust.
+
+const int ESC_DISCOVERY_MAX_POINTS = 64;   // coarse climb points kept
+const uint32_t ESC_PROFILE_MAGIC = 0x45534331;  // "ESC1"
+const size_t ESC_NAME_MAX = 16;  // NVS key limit (15 chars) plus the terminator
+
+struct EscDiscoveryConfig {
+  int searchSlowPwm;     // slowest pulse probed; the prop must be still here
+  int searchFastPwm;     // fastest pulse probed
+  int coarseStepPwm;
+  int resolutionPwm;     // bisection stops at this bracket width
+  float minSpinKg;       // thrust counted as turning, at least
+  float noiseSigmas;     // ... and this many resting standard deviations
+  float flatFraction;    // a step adding less than this share of the thrust is flat
+  int flatSteps;         // flat coarse steps in a row that end the climb
+  int stopMarginPwm;     // stop value this far past the still end
+};
+
+EscDiscoveryConfig defaultEscDiscoveryConfig();
+
+// How the motor gets to a probe's pulse
+enum EscProbeStart : uint8_t {
+  ESC_PROBE_RUNNING,    // straight from the previous probe
+  ESC_PROBE_FROM_REST,  // stopped first (spin-up threshold)
+  ESC_PROBE_FROM_SPIN   // stopped, spun up at spinPwm, then the pulse (stall)
+};
+
+struct EscProbe {
+  int pwm;
+  EscProbeStart start;
+  int spinPwm;  // ESC_PROBE_FROM_SPIN only
+};
+
+enum EscDiscoveryPhase : uint8_t {
+  DISC_IDLE,
+  DISC_START_COARSE,
+  DISC_START_FINE,
+  DISC_CLIMB_COARSE,
+  DISC_CLIMB_FINE,
+  DISC_STALL_COARSE,
+  DISC_STALL_FINE,
+  DISC_VERIFY_STOP,
+  DISC_DONE,
+  DISC_FAILED
+};
+
+const char* escDiscoveryPhaseName(EscDiscoveryPhase phase);
+
+struct EscEndpoints {
+  int16_t fastPwm;    // saturation: faster adds under flatFraction of the thrust
+  int16_t slowPwm;    // prop still, from rest and from spinning
+  int16_t stopPwm;    // slowPwm plus the margin, checked still after a spin
+  int16_t startPwm;   // slowest pulse that spins the motor up from rest
+  int16_t stallPwm;   // slowest pulse a turning motor keeps turning at
+  uint16_t probes;
+  uint8_t saturated;  // 0: still climbing at searchFastPwm
+  float maxThrustKg;  // largest thrust on the climb
+  float spinKg;       // turning threshold used
+};
+
+class EscDiscovery {
+ public:
+  EscDiscovery();
+
+  // noiseKg: standard deviation of single readings at rest
+  void begin(const EscDiscoveryConfig& config, float noiseKg);
+
+  // The next probe to run; false once done or failed
+  bool next(EscProbe& probe);
+  // Mean thrust at the probe last returned by next()
+  void measured(float thrustKg);
+
+  EscDiscoveryPhase phase() const { return _phase; }
+  bool finished() const { return _phase == DISC_DONE || _phase == DISC_FAILED; }
+  bool ok() const { return _phase == DISC_DONE; }
+  const char* failure() const { return _failure; }
+  const EscEndpoints& endpoints() const { return _result; }
+  int probes() const { return _result.probes; }
+
+ private:
+  bool turning(float thrustKg) const { return thrustKg > _result.spinKg; }
+  void fail(const char* reason);
+  void startClimb();
+  void endClimb();
+  void startStall();
+  void endStall();
+
+  EscDiscoveryConfig _config;
+  EscDiscoveryPhase _phase;
+  const char* _failure;
+  EscEndpoints _result;
+  EscProbe _probe;
+  int _stillPwm;    // bracket end where the prop stayed still
+  int _turnPwm;     // bracket end where it turned
+  int _restStillPwm;  // still end of the spin-up bracket
+  float _targetKg;  // climb: thrust marking saturation
+  int _flatRun;
+  int _points;
+  int16_t _climbPwm[ESC_DISCOVERY_MAX_POINTS];
+  float _climbKg[ESC_DISCOVERY_MAX_POINTS];
+};
+
+// One ESC's endpoints as stored in NVS, keyed by the ESC's name
+struct EscProfileRecord {
+  uint32_t magic;
+  uint16_t size;
+  char name[ESC_NAME_MAX];
+  EscEndpoints endpoints;
+  uint16_t crc;
+};
+
+// 1-15 letters, digits, '-' or '_'
+bool escNameValid(const char* name);
+
+void clearEscProfile(EscProfileRecord& record, const char* name);
+uint16_t escProfileCrc(const EscProfileRecord& record);
+bool escProfileValid(const EscProfileRecord& record);
+
+#ifdef ARDUINO
+bool loadEscProfile(const char* name, EscProfileRecord& record);
+bool saveEscProfile(EscProfileRecord& record);
+void eraseEscProfile(const char* name);
+
+// The ESC on the stand now, kept across resets
+bool loadActiveEscName(char* name, size_t size);
+bool saveActiveEscName(const char* name);
+#endif
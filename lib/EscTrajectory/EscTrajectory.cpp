@@ -0,0 +1,128 @@
+#include "EscTrajectory.h"
+
+#include <math.h>
+
+#ifdef ESP32
+#include <esp_timer.h>
+#endif
+
+void EscTrajectory::reset(int pwm) {
+  _output = (float)pwm;
+  _velocity = 0.0f;
+  _target = pwm;
+}
+
+// Velocity heads for the slew limit, capped so the output can still brake to
+// rest at the target (v = sqrt(2 a d)), and changes by at most accel * dt per
+// step. Passing the target (a new target behind a fast-moving output, or the
+// last fraction of a step) lands on it at rest.
+float EscTrajectory::step(float dtS) {
+  float error = (float)_target - _output;
+  if (error == 0.0f && _velocity == 0.0f) {
+    return _output;
+  }
+  if (_limits.slewUsPerS <= 0.0f) {
+    reset(_target);
+    return _output;
+  }
+
+  float distance = fabsf(error);
+  float desired = _limits.slewUsPerS;
+  if (_limits.accelUsPerS2 > 0.0f) {
+    desired = fminf(desired, sqrtf(2.0f * _limits.accelUsPerS2 * distance));
+  }
+  if (error < 0.0f) {
+    desired = -desired;
+  }
+
+  float change = desired - _velocity;
+  if (_limits.accelUsPerS2 > 0.0f) {
+    float maxChange = _limits.accelUsPerS2 * dtS;
+    change = fmaxf(-maxChange, fminf(maxChange, change));
+  }
+  _velocity += change;
+  _output += _velocity * dtS;
+
+  float after = (float)_target - _output;
+  if (after == 0.0f || (after < 0.0f) != (error < 0.0f)) {
+    reset(_target);
+  }
+  return _output;
+}
+
+EscOutputStage::EscOutputStage(EscWriteFn write, int initialPwm)
+    : _write(write),
+      _slewUsPerS(0.0f),
+      _accelUsPerS2(0.0f),
+      _target(initialPwm),
+      _jump(initialPwm),
+      _output(initialPwm),
+      _settledAt(NO_PWM),
+      _writtenUs(0),
+      _ticks(0),
+      _lastTickUs(0),
+      _written(false) {
+  _trajectory.reset(initialPwm);
+}
+
+void EscOutputStage::setLimits(const TrajectoryLimits& limits) {
+  _slewUsPerS.store(limits.slewUsPerS, std::memory_order_relaxed);
+  _accelUsPerS2.store(limits.accelUsPerS2, std::memory_order_relaxed);
+}
+
+void EscOutputStage::jumpTo(int pwm) {
+  _target.store(pwm, std::memory_order_release);
+  _jump.store(pwm, std::memory_order_release);
+}
+
+bool EscOutputStage::settled() const {
+  return _jump.load(std::memory_order_acquire) == NO_PWM &&
+         _settledAt.load(std::memory_order_acquire) == _target.load(std::memory_order_acquire);
+}
+
+void EscOutputStage::tick(uint32_t nowUs) {
+  float dtS = _written ? (uint32_t)(nowUs - _lastTickUs) / 1000000.0f : 0.0f;
+  _lastTickUs = nowUs;
+
+  int jump = _jump.exchange(NO_PWM, std::memory_order_acq_rel);
+  if (jump != NO_PWM) {
+    _trajectory.reset(jump);
+  }
+  TrajectoryLimits limits = {_slewUsPerS.load(std::memory_order_relaxed),
+                             _accelUsPerS2.load(std::memory_order_relaxed)};
+  _trajectory.setLimits(limits);
+  _trajectory.setTarget(_target.load(std::memory_order_acquire));
+  int pwm = (int)lroundf(_trajectory.step(dtS));
+
+  if (!_written || pwm != _output.load(std::memory_order_relaxed)) {
+    _write(pwm);
+    _output.store(pwm, std::memory_order_release);
+    _writtenUs.store(nowUs, std::memory_order_release);
+    _written = true;
+  }
+  _settledAt.store(_trajectory.settled() ? _trajectory.target() : NO_PWM, std::memory_order_release);
+  _ticks.fetch_add(1, std::memory_order_relaxed);
+}
+
+#ifdef ESP32
+namespace {
+
+void escOutputTick(void* param) {
+  ((EscOutputStage*)param)->tick((uint32_t)esp_timer_get_time());
+}
+
+}  // namespace
+
+bool startEscOutput(EscOutputStage& stage, uint32_t hz) {
+  esp_timer_create_args_t args = {};
+  args.callback = escOutputTick;
+  args.arg = &stage;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "esc_output";
+  esp_timer_handle_t timer;
+  if (esp_timer_create(&args, &timer) != ESP_OK) {
+    return false;
+  }
+  return esp_timer_start_periodic(timer, 1000000 / hz) == ESP_OK;
+}
+#endif
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP32
+#include <Arduino.h>
+#endif
+
+// ESC output stage, separate from the step logic. The control code sets a
+// target pulse width; the stage moves the output there on its own tick at a
+// bounded slew (us/s) and a bounded change of slew (us/s^2), so a sweep step
+// or a pot slammed to the end becomes an S-shaped ramp instead of a jump.
+// On the ESP32 the tick is a periodic esp_timer at a few hundred Hz; native
+// tests call tick() with a virtual clock.
+
+struct TrajectoryLimits {
+  float slewUsPerS;    // fastest output change, 0 = jump to the target
+  float accelUsPerS2;  // fastest change of the slew, 0 = unlimited
+};
+
+// Pure motion profile: position, velocity, target
+class EscTrajectory {
+ public:
+  EscTrajectory() : _limits{0.0f, 0.0f}, _output(0.0f), _velocity(0.0f), _target(0) {}
+
+  // Output at pwm and at rest
+  void reset(int pwm);
+  void setLimits(const TrajectoryLimits& limits) { _limits = limits; }
+  // A new target keeps the current velocity; the profile bends toward it
+  void setTarget(int pwm) { _target = pwm; }
+
+  // Advance by dtS; returns the output in us
+  float step(float dtS);
+
+  float output() const { return _output; }
+  float velocity() const { return _velocity; }
+  int target() const { return _target; }
+  bool settled() const { return _output == (float)_target && _velocity == 0.0f; }
+
+ private:
+  TrajectoryLimits _limits;
+  float _output;
+  float _velocity;  // us/s
+  int _target;
+};
+
+typedef void (*EscWriteFn)(int pwm);
+
+// Thread-safe front of the trajectory: the control loop and the supervisor
+// set targets and jumps from their tasks, tick() (one task) owns the profile
+// and is the only caller of the write function
+class EscOutputStage {
+ public:
+  EscOutputStage(EscWriteFn write, int initialPwm);
+
+  void setLimits(const TrajectoryLimits& limits);
+  void setTarget(int pwm) { _target.store(pwm, std::memory_order_release); }
+  // Output goes straight to pwm on the next tick (stop, step capture)
+  void jumpTo(int pwm);
+
+  // Advance to nowUs (any wrap-safe microsecond clock) and write the output
+  // when its rounded value changes
+  void tick(uint32_t nowUs);
+
+  int target() const { return _target.load(std::memory_order_acquire); }
+  int output() const { return _output.load(std::memory_order_acquire); }
+  // Clock value of the last write
+  uint32_t writtenUs() const { return _writtenUs.load(std::memory_order_acquire); }
+  // Output at the current target and at rest
+  bool settled() const;
+  uint32_t ticks() const { return _ticks.load(std::memory_order_relaxed); }
+
+ private:
+  static const int NO_PWM = -1;
+
+  EscWriteFn _write;
+  EscTrajectory _trajectory;
+  std::atomic<float> _slewUsPerS;
+  std::atomic<float> _accelUsPerS2;
+  std::atomic<int> _target;
+  std::atomic<int> _jump;
+  std::atomic<int> _output;
+  std::atomic<int> _settledAt;  // target the profile came to rest at, NO_PWM while moving
+  std::atomic<uint32_t> _writtenUs;
+  std::atomic<uint32_t> _ticks;
+  uint32_t _lastTickUs;
+  bool _written;
+};
+
+#ifdef ESP32
+// Ticks the stage from a periodic esp_timer (hardware timer, dispatched to the
+// esp_timer task) with the low 32 bits of esp_timer as the clock
+bool startEscOutput(EscOutputStage& stage, uint32_t hz);
+#endif
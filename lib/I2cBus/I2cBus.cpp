@@ -0,0 +1,217 @@
+#include "I2cBus.h"
+
+#include <string.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+namespace {
+
+struct CallState {
+  I2cResult* result;
+  std::atomic<bool> done;
+};
+
+void finishCall(void* context, const I2cResult& result) {
+  CallState* call = (CallState*)context;
+  *call->result = result;
+  call->done.store(true, std::memory_order_release);
+}
+
+}  // namespace
+
+I2cScheduler::I2cScheduler(I2cPort& port, uint32_t clockHz, uint32_t maxWaitUs)
+    : _port(port),
+      _deviceCount(0),
+      _clockHz(clockHz),
+      _maxWaitUs(maxWaitUs),
+      _ownerRunning(false),
+      _appliedHz(0),
+      _agedRuns(0) {
+  for (size_t p = 0; p < I2C_PRIORITY_COUNT; p++) {
+    _queues[p].head.store(0);
+    _queues[p].tail.store(0);
+  }
+  memset(_stats, 0, sizeof(_stats));
+}
+
+int I2cScheduler::addDevice(const char* name, uint8_t address) {
+  if (_deviceCount >= I2C_MAX_DEVICES) {
+    return -1;
+  }
+  _stats[_deviceCount].name = name;
+  _stats[_deviceCount].address = address;
+  return (int)_deviceCount++;
+}
+
+bool I2cScheduler::submit(I2cPriority priority, I2cTransaction& t) {
+  if (priority >= I2C_PRIORITY_COUNT || t.device >= _deviceCount ||
+      t.writeLength > I2C_MAX_DATA || t.readLength > I2C_MAX_DATA) {
+    return false;
+  }
+  Queue& q = _queues[priority];
+  size_t head = q.head.load(std::memory_order_relaxed);
+  if (head - q.tail.load(std::memory_order_acquire) >= I2C_QUEUE_DEPTH) {
+    _stats[t.device].dropped++;
+    return false;
+  }
+  t.queuedUs = _port.nowUs();
+  q.slots[head % I2C_QUEUE_DEPTH] = t;
+  q.head.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+size_t I2cScheduler::space(I2cPriority priority) const {
+  const Queue& q = _queues[priority];
+  return I2C_QUEUE_DEPTH - (q.head.load(std::memory_order_relaxed) -
+                            q.tail.load(std::memory_order_acquire));
+}
+
+bool I2cScheduler::transact(I2cPriority priority, I2cTransaction& t, I2cResult& result) {
+  CallState call;
+  call.result = &result;
+  call.done.store(false);
+  t.done = finishCall;
+  t.context = &call;
+  if (!submit(priority, t)) {
+    result.ok = false;
+    result.length = 0;
+    return false;
+  }
+  // The call always completes (the port has its own timeout), so the
+  // state on this stack outlives the callback
+  while (!call.done.load(std::memory_order_acquire)) {
+    if (!_ownerRunning.load()) {
+      runOnce();
+    } else {
+#ifdef ESP32
+      taskYIELD();
+#endif
+    }
+  }
+  return result.ok;
+}
+
+bool I2cScheduler::runOnce() {
+  uint32_t hz = _clockHz.load(std::memory_order_relaxed);
+  if (hz != _appliedHz) {
+    _port.setClock(hz);
+    _appliedHz = hz;
+  }
+
+  Queue& sensor = _queues[I2C_PRIORITY_SENSOR];
+  Queue& display = _queues[I2C_PRIORITY_DISPLAY];
+  size_t sensorTail = sensor.tail.load(std::memory_order_relaxed);
+  size_t displayTail = display.tail.load(std::memory_order_relaxed);
+  bool sensorWaiting = sensorTail != sensor.head.load(std::memory_order_acquire);
+  bool displayWaiting = displayTail != display.head.load(std::memory_order_acquire);
+  if (!sensorWaiting && !displayWaiting) {
+    return false;
+  }
+
+  // Sensors first, unless the oldest display transaction has waited too long
+  Queue* q = &sensor;
+  if (displayWaiting) {
+    uint32_t maxWait = _maxWaitUs.load(std::memory_order_relaxed);
+    uint32_t waited = _port.nowUs() - display.slots[displayTail % I2C_QUEUE_DEPTH].queuedUs;
+    if (!sensorWaiting) {
+      q = &display;
+    } else if (maxWait > 0 && waited >= maxWait) {
+      q = &display;
+      _agedRuns++;
+    }
+  }
+
+  size_t tail = q->tail.load(std::memory_order_relaxed);
+  I2cTransaction t = q->slots[tail % I2C_QUEUE_DEPTH];
+  q->tail.store(tail + 1, std::memory_order_release);
+  run(t);
+  return true;
+}
+
+void I2cScheduler::run(const I2cTransaction& t) {
+  I2cDeviceStats& s = _stats[t.device];
+  I2cResult result;
+  result.length = 0;
+
+  uint32_t startUs = _port.nowUs();
+  result.ok = _port.transfer(s.address, t.data, t.writeLength, result.data, t.readLength);
+  uint32_t endUs = _port.nowUs();
+  if (result.ok) {
+    result.length = t.readLength;
+  } else {
+    s.errors++;
+  }
+
+  uint32_t waitUs = startUs - t.queuedUs;
+  s.transactions++;
+  s.bytes += t.writeLength + t.readLength;
+  s.busUs += endUs - startUs;
+  s.totalWaitUs += waitUs;
+  if (waitUs > s.maxWaitUs) {
+    s.maxWaitUs = waitUs;
+  }
+
+  if (t.done != nullptr) {
+    t.done(t.context, result);
+  }
+}
+
+void I2cScheduler::resetStats() {
+  for (size_t i = 0; i < _deviceCount; i++) {
+    I2cDeviceStats& s = _stats[i];
+    s.transactions = 0;
+    s.errors = 0;
+    s.dropped = 0;
+    s.bytes = 0;
+    s.busUs = 0;
+    s.maxWaitUs = 0;
+    s.totalWaitUs = 0;
+  }
+  _agedRuns = 0;
+}
+
+#ifdef ARDUINO
+bool WireI2cPort::transfer(uint8_t address, const uint8_t* tx, size_t txLength,
+                           uint8_t* rx, size_t rxLength) {
+  _wire.beginTransmission(address);
+  _wire.write(tx, txLength);
+  if (rxLength == 0) {
+    return _wire.endTransmission() == 0;
+  }
+  if (_wire.endTransmission(false) != 0) {
+    return false;
+  }
+  if (_wire.requestFrom(address, (uint8_t)rxLength) != rxLength) {
+    return false;
+  }
+  for (size_t i = 0; i < rxLength; i++) {
+    rx[i] = (uint8_t)_wire.read();
+  }
+  return true;
+}
+#endif
+
+#ifdef ESP32
+namespace {
+
+void i2cBusTask(void* param) {
+  I2cScheduler* bus = (I2cScheduler*)param;
+  while (true) {
+    if (!bus->runOnce()) {
+      vTaskDelay(1);
+    }
+  }
+}
+
+}  // namespace
+
+bool startI2cBus(I2cScheduler& bus, uint8_t priority, int core) {
+  bool started = xTaskCreatePinnedToCore(i2cBusTask, "i2c_bus", 3072, &bus,
+                                         priority, nullptr, core) == pdPASS;
+  bus.setOwnerRunning(started);
+  return started;
+}
+#endif
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <Wire.h>
+#endif
+
+// One owner for the shared I2C bus (LCD backpack, INA219, MPU-6050).
+// Clients queue transactions and return at once; the owner runs them one at
+// a time, sensor reads ahead of display updates. A display transaction that
+// has waited maxWaitUs goes next regardless, so a busy sensor cannot starve
+// the LCD. Each priority queue has a single producer (the loop).
+
+const size_t I2C_MAX_DATA = 32;     // bytes written (or read) in one transaction
+const size_t I2C_QUEUE_DEPTH = 32;  // per priority
+const size_t I2C_MAX_DEVICES = 4;
+
+enum I2cPriority : uint8_t {
+  I2C_PRIORITY_SENSOR = 0,
+  I2C_PRIORITY_DISPLAY = 1,
+  I2C_PRIORITY_COUNT = 2
+};
+
+// Raw bus: write txLength bytes, then (rxLength > 0) repeated start and read
+class I2cPort {
+ public:
+  virtual ~I2cPort() {}
+  virtual void setClock(uint32_t hz) = 0;
+  virtual bool transfer(uint8_t address, const uint8_t* tx, size_t txLength,
+                        uint8_t* rx, size_t rxLength) = 0;
+  virtual uint32_t nowUs() = 0;
+};
+
+struct I2cResult {
+  bool ok;
+  uint8_t length;  // bytes read
+  uint8_t data[I2C_MAX_DATA];
+};
+
+// Called on the owner task right after the transfer
+typedef void (*I2cDoneFn)(void* context, const I2cResult& result);
+
+struct I2cTransaction {
+  uint8_t device;  // index from addDevice()
+  uint8_t writeLength;
+  uint8_t readLength;
+  uint8_t data[I2C_MAX_DATA];  // bytes to write
+  I2cDoneFn done;              // may be null
+  void* context;
+  uint32_t queuedUs;  // stamped by submit()
+};
+
+// Per device; written by the owner (dropped by the producer), read unlocked
+struct I2cDeviceStats {
+  const char* name;
+  uint8_t address;
+  uint32_t transactions;
+  uint32_t errors;   // NACK or short read
+  uint32_t dropped;  // queue full at submit
+  uint32_t bytes;    // written + read, address bytes not counted
+  uint32_t busUs;    // time holding the bus
+  uint32_t maxWaitUs;
+  uint64_t totalWaitUs;  // queued to started
+};
+
+class I2cScheduler {
+ public:
+  I2cScheduler(I2cPort& port, uint32_t clockHz, uint32_t maxWaitUs);
+
+  // Before the owner starts; device index, or -1 when the table is full
+  int addDevice(const char* name, uint8_t address);
+
+  // Never waits; false (counted as dropped) when the queue is full or the
+  // transaction is malformed
+  bool submit(I2cPriority priority, I2cTransaction& t);
+  size_t space(I2cPriority priority) const;
+
+  // Queues and waits for the result: setup and capture windows only. Runs
+  // the bus itself when no owner task is running.
+  bool transact(I2cPriority priority, I2cTransaction& t, I2cResult& result);
+
+  // Owner side: runs the next transaction; false when both queues are empty
+  bool runOnce();
+  void setOwnerRunning(bool running) { _ownerRunning.store(running); }
+  bool ownerRunning() const { return _ownerRunning.load(); }
+
+  // Taken up by the owner before its next transaction
+  void setClock(uint32_t hz) { _clockHz.store(hz); }
+  uint32_t clock() const { return _clockHz.load(); }
+  void setMaxWaitUs(uint32_t us) { _maxWaitUs.store(us); }  // 0 = strict priority
+
+  size_t devices() const { return _deviceCount; }
+  const I2cDeviceStats& stats(size_t device) const { return _stats[device]; }
+  void resetStats();
+  uint32_t agedRuns() const { return _agedRuns; }  // display run ahead of a waiting sensor
+
+  I2cPort& port() { return _port; }
+
+ private:
+  struct Queue {
+    I2cTransaction slots[I2C_QUEUE_DEPTH];
+    std::atomic<size_t> head;  // written by the producer only
+    std::atomic<size_t> tail;  // written by the owner only
+  };
+
+  void run(const I2cTransaction& t);
+
+  I2cPort& _port;
+  Queue _queues[I2C_PRIORITY_COUNT];
+  I2cDeviceStats _stats[I2C_MAX_DEVICES];
+  size_t _deviceCount;
+  std::atomic<uint32_t> _clockHz;
+  std::atomic<uint32_t> _maxWaitUs;
+  std::atomic<bool> _ownerRunning;
+  uint32_t _appliedHz;  // owner only
+  uint32_t _agedRuns;
+};
+
+#ifdef ARDUINO
+// The Arduino Wire driver; only the owner task may call it
+class WireI2cPort : public I2cPort {
+ public:
+  explicit WireI2cPort(TwoWire& wire) : _wire(wire) {}
+
+  void setClock(uint32_t hz) override { _wire.setClock(hz); }
+  bool transfer(uint8_t address, const uint8_t* tx, size_t txLength,
+                uint8_t* rx, size_t rxLength) override;
+  uint32_t nowUs() override { return micros(); }
+
+ private:
+  TwoWire& _wire;
+};
+#endif
+
+#ifdef ESP32
+// Bus owner task: runs queued transactions, sleeps a tick when idle
+bool startI2cBus(I2cScheduler& bus, uint8_t priority, int core);
+#endif
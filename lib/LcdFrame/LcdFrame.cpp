@@ -0,0 +1,174 @@
+#include "LcdFrame.h"
+
+#include <string.h>
+
+namespace {
+
+// PCF8574 pins on the backpack
+const uint8_t LCD_RS = 0x01;
+const uint8_t LCD_EN = 0x04;
+const uint8_t LCD_BACKLIGHT = 0x08;
+
+const size_t WRITES_PER_LCD_BYTE = 6;  // two nibbles of data, E high, E low
+const uint8_t LCD_SET_DDRAM = 0x80;
+const uint8_t LCD_ROW_OFFSETS[LcdFrame::ROWS] = {0x00, 0x40, 0x14, 0x54};
+
+}  // namespace
+
+void LcdFrame::clear() {
+  memset(_target, ' ', sizeof(_target));
+  memset(_shown, ' ', sizeof(_shown));
+  _scanRow = 0;
+  _scanCol = 0;
+}
+
+void LcdFrame::blank() {
+  memset(_target, ' ', sizeof(_target));
+}
+
+void LcdFrame::invalidate() {
+  // 0 never matches a printable character
+  memset(_shown, 0, sizeof(_shown));
+  _scanRow = 0;
+  _scanCol = 0;
+}
+
+void LcdFrame::put(uint8_t col, uint8_t row, char c) {
+  if (row < ROWS && col < COLS) {
+    _target[row][col] = c;
+  }
+}
+
+void LcdFrame::write(uint8_t col, uint8_t row, const char* text) {
+  if (row >= ROWS) {
+    return;
+  }
+  for (uint8_t c = col; c < COLS && *text != '\0'; c++, text++) {
+    _target[row][c] = *text;
+  }
+}
+
+void LcdFrame::writePadded(uint8_t col, uint8_t row, const char* text, uint8_t width) {
+  if (row >= ROWS) {
+    return;
+  }
+  uint8_t end = col + width;
+  if (end > COLS) {
+    end = COLS;
+  }
+  for (uint8_t c = col; c < end; c++) {
+    _target[row][c] = (*text != '\0') ? *text++ : ' ';
+  }
+}
+
+bool LcdFrame::nextRun(LcdRun& run) {
+  while (_scanRow < ROWS) {
+    const char* target = _target[_scanRow];
+    char* shown = _shown[_scanRow];
+
+    // Find the first changed cell
+    uint8_t c = _scanCol;
+    while (c < COLS && target[c] == shown[c]) {
+      c++;
+    }
+    if (c == COLS) {
+      _scanRow++;
+      _scanCol = 0;
+      continue;
+    }
+
+    // Extend while cells differ or the unchanged gap is short
+    uint8_t start = c;
+    uint8_t end = c + 1;
+    uint8_t probe = end;
+    while (probe < COLS) {
+      if (target[probe] != shown[probe]) {
+        end = probe + 1;
+      } else if (probe - end >= MERGE_GAP) {
+        break;
+      }
+      probe++;
+    }
+
+    memcpy(shown + start, target + start, end - start);
+    run.row = _scanRow;
+    run.col = start;
+    run.length = end - start;
+    run.text = target + start;
+    _scanCol = end;
+    return true;
+  }
+
+  _scanRow = 0;
+  _scanCol = 0;
+  return false;
+}
+
+bool LcdFrame::dirty() const {
+  return memcmp(_target, _shown, sizeof(_target)) != 0;
+}
+
+I2cLcd::I2cLcd(I2cScheduler& bus, int device) : _bus(bus), _queued(0), _lost(false) {
+  memset(&_pending, 0, sizeof(_pending));
+  _pending.device = (uint8_t)device;
+}
+
+size_t I2cLcd::flush(LcdFrame& frame) {
+  size_t before = _queued;
+  LcdRun run;
+  while (_bus.space(I2C_PRIORITY_DISPLAY) >= MAX_RUN_TRANSACTIONS && frame.nextRun(run)) {
+    append(LCD_SET_DDRAM | (LCD_ROW_OFFSETS[run.row] + run.col), false);
+    for (uint8_t i = 0; i < run.length; i++) {
+      append((uint8_t)run.text[i], true);
+    }
+    send();
+    if (_lost) {
+      // Part of a run never reached the queue: redraw everything
+      _lost = false;
+      frame.invalidate();
+      break;
+    }
+  }
+  return _queued - before;
+}
+
+void I2cLcd::append(uint8_t value, bool data) {
+  if (_pending.writeLength + WRITES_PER_LCD_BYTE > I2C_MAX_DATA) {
+    send();
+  }
+  uint8_t mode = (data ? LCD_RS : 0) | LCD_BACKLIGHT;
+  uint8_t nibbles[2] = {(uint8_t)(value & 0xF0), (uint8_t)((value << 4) & 0xF0)};
+  for (uint8_t nibble : nibbles) {
+    _pending.data[_pending.writeLength++] = nibble | mode;
+    _pending.data[_pending.writeLength++] = nibble | mode | LCD_EN;
+    _pending.data[_pending.writeLength++] = nibble | mode;
+  }
+}
+
+void I2cLcd::send() {
+  if (_pending.writeLength == 0) {
+    return;
+  }
+  if (_bus.submit(I2C_PRIORITY_DISPLAY, _pending)) {
+    _queued++;
+  } else {
+    _lost = true;
+  }
+  _pending.writeLength = 0;
+}
+
+#ifdef ARDUINO
+void LcdCanvas::clear() {
+  _frame.blank();
+  _col = 0;
+  _row = 0;
+}
+
+size_t LcdCanvas::write(uint8_t c) {
+  _frame.put(_col, _row, (char)c);
+  if (_col < LcdFrame::COLS) {
+    _col++;
+  }
+  return 1;
+}
+#endif
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include "I2cBus.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Changed segment of the frame, ready for setCursor(col, row) + write(text, length)
+struct LcdRun {
+  uint8_t row;
+  uint8_t col;
+  uint8_t length;
+  const char* text;
+};
+
+// Shadow of the 20x4 LCD; only cells that changed since the last flush are sent.
+// A setCursor costs about as much as two characters on the PCF8574 backpack,
+// so runs separated by short unchanged gaps are merged.
+class LcdFrame {
+ public:
+  static const uint8_t COLS = 20;
+  static const uint8_t ROWS = 4;
+  static const uint8_t MERGE_GAP = 2;
+
+  LcdFrame() { clear(); }
+
+  // Call after lcd.clear(): target and shown content are both blank
+  void clear();
+
+  // Blank the target only; the display catches up on the next flush
+  void blank();
+
+  // Force the whole target to be resent (e.g. after a display reset)
+  void invalidate();
+
+  void put(uint8_t col, uint8_t row, char c);
+  void write(uint8_t col, uint8_t row, const char* text);
+  void writePadded(uint8_t col, uint8_t row, const char* text, uint8_t width);
+
+  // Next changed run in row-major order; marks it as shown. False when up to date.
+  bool nextRun(LcdRun& run);
+
+  bool dirty() const;
+
+ private:
+  char _target[ROWS][COLS];
+  char _shown[ROWS][COLS];
+  uint8_t _scanRow;
+  uint8_t _scanCol;
+};
+
+// HD44780 behind the PCF8574 backpack (LiquidCrystal_I2C wiring), written
+// through the bus scheduler at display priority. LiquidCrystal_I2C still
+// initializes the controller at boot; this sends cursor moves and text.
+// Each HD44780 byte is two nibbles of three expander writes (data, E high,
+// E low), so one transaction carries five of them.
+class I2cLcd {
+ public:
+  static const uint8_t BYTES_PER_TRANSACTION = 5;
+  // Cursor move + a full row
+  static const uint8_t MAX_RUN_TRANSACTIONS =
+      (1 + LcdFrame::COLS + BYTES_PER_TRANSACTION - 1) / BYTES_PER_TRANSACTION;
+
+  I2cLcd(I2cScheduler& bus, int device);
+
+  // Queues the frame's changed runs while the display queue has room for a
+  // whole run; the rest stay dirty for the next call. Transactions queued.
+  size_t flush(LcdFrame& frame);
+
+ private:
+  void append(uint8_t value, bool data);
+  void send();
+
+  I2cScheduler& _bus;
+  I2cTransaction _pending;
+  size_t _queued;
+  bool _lost;  // a submit failed mid-run
+};
+
+#ifdef ARDUINO
+// LiquidCrystal-style setCursor/print drawing into the frame; nothing
+// touches the bus until I2cLcd::flush()
+class LcdCanvas : public Print {
+ public:
+  explicit LcdCanvas(LcdFrame& frame) : _frame(frame), _col(0), _row(0) {}
+
+  void setCursor(uint8_t col, uint8_t row) {
+    _col = col;
+    _row = row;
+  }
+  void clear();
+
+  // One cell; text past the end of the row is dropped
+  size_t write(uint8_t c) override;
+  using Print::write;
+
+ private:
+  LcdFrame& _frame;
+  uint8_t _col;
+  uint8_t _row;
+};
+#endif
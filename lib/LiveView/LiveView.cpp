@@ -0,0 +1,43 @@
+#include "LiveView.h"
+
+void RateGate::setHz(float hz) {
+  _periodUs = hz > 0.0f ? (uint32_t)(1000000.0f / hz + 0.5f) : 0;
+  _started = false;
+}
+
+bool RateGate::due(uint32_t nowUs) {
+  if (_periodUs == 0) {
+    _fired++;
+    return true;
+  }
+  if (_started && (int32_t)(nowUs - _nextUs) < 0) {
+    return false;
+  }
+  // Keep the cadence; more than a period late starts over from now
+  _nextUs = _started && (int32_t)(nowUs - _nextUs) < (int32_t)_periodUs ? _nextUs + _periodUs
+                                                                        : nowUs + _periodUs;
+  _started = true;
+  _fired++;
+  return true;
+}
+
+void LiveAggregator::configure(const LiveRates& rates) {
+  _thrust.setLength(rates.window);
+  _sampleGate = RateGate(rates.sampleHz);
+  _displayGate = RateGate(rates.displayHz);
+  _logGate = RateGate(rates.logHz);
+  _pwm = 0;
+}
+
+void LiveAggregator::add(float thrustKg, int pwm, uint32_t nowUs) {
+  _thrust.add(thrustKg, nowUs);
+  _pwm = pwm;
+}
+
+LiveSnapshot LiveAggregator::snapshot() const {
+  LiveSnapshot s;
+  s.thrust = _thrust.summary();
+  s.pwm = _pwm;
+  s.samples = _thrust.total();
+  return s;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include "SampleStats.h"
+
+// Aggregation between acquisition and presentation. The loop reads every
+// conversion; accepted samples go into a sliding window, and the LCD and the
+// log each take a snapshot of it at their own fixed rate, so the sampling,
+// display and log rates are set independently and a faster ADC does not
+// flood the LCD or the UART.
+
+// Fixed-rate trigger on a wrap-safe microsecond clock; 0 Hz fires on every call.
+// A caller that falls behind skips the missed periods instead of bursting.
+class RateGate {
+ public:
+  explicit RateGate(float hz = 0.0f) : _fired(0) { setHz(hz); }
+
+  void setHz(float hz);
+  bool due(uint32_t nowUs);
+  uint32_t fired() const { return _fired; }
+
+ private:
+  uint32_t _periodUs;
+  uint32_t _nextUs;
+  bool _started;
+  uint32_t _fired;
+};
+
+struct LiveRates {
+  float sampleHz;   // samples into the window, 0 = every conversion
+  float displayHz;  // LCD snapshots
+  float logHz;      // log rows
+  int window;       // samples the statistics cover
+};
+
+struct LiveSnapshot {
+  WindowSummary thrust;  // kg
+  int pwm;               // command at the newest sample
+  uint32_t samples;      // accepted since configure()
+};
+
+class LiveAggregator {
+ public:
+  LiveAggregator() : _pwm(0) {}
+
+  // New rates and an empty window
+  void configure(const LiveRates& rates);
+
+  // Decimation to the sample rate; false = leave this conversion out
+  bool accept(uint32_t nowUs) { return _sampleGate.due(nowUs); }
+  void add(float thrustKg, int pwm, uint32_t nowUs);
+
+  bool displayDue(uint32_t nowUs) { return _displayGate.due(nowUs); }
+  bool logDue(uint32_t nowUs) { return _logGate.due(nowUs); }
+  LiveSnapshot snapshot() const;
+
+  uint32_t displayed() const { return _displayGate.fired(); }
+  uint32_t logged() const { return _logGate.fired(); }
+
+ private:
+  WindowStats _thrust;
+  RateGate _sampleGate;
+  RateGate _displayGate;
+  RateGate _logGate;
+  int _pwm;
+};
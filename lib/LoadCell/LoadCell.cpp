@@ -0,0 +1,171 @@
+#include "LoadCell.h"
+
+#include <math.h>
+
+DriftModel noDrift() {
+  DriftModel model = {25.0f, 0.0f, 0.0f};
+  return model;
+}
+
+void LoadCellConverter::setCalibration(long offset, float scale, float correction) {
+  _offset = offset;
+  _scale = scale != 0.0f ? scale : 1.0f;
+  _correction = correction;
+  fold();
+}
+
+void CalibrationLut::build(float c1, float c2, long rangeCounts) {
+  // Smallest power-of-two segment covering the range on both sides
+  _shift = 0;
+  while (((long)(CAL_LUT_SIZE - 1) << _shift) < 2 * rangeCounts && _shift < 30) {
+    _shift++;
+  }
+  _minCounts = -((long)(CAL_LUT_SIZE - 1) << _shift) / 2;
+  _invStep = 1.0f / (float)(1L << _shift);
+  for (int i = 0; i < CAL_LUT_SIZE; i++) {
+    double n = (double)_minCounts + ((double)i * (double)(1L << _shift));
+    _table[i] = (float)(c1 * n + c2 * n * n);
+  }
+  _valid = true;
+}
+
+void CalibrationLut::load(const float* table, int shift) {
+  _shift = shift;
+  _minCounts = -((long)(CAL_LUT_SIZE - 1) << _shift) / 2;
+  _invStep = 1.0f / (float)(1L << _shift);
+  for (int i = 0; i < CAL_LUT_SIZE; i++) {
+    _table[i] = table[i];
+  }
+  _valid = true;
+}
+
+float CalibrationLut::slopeAtZero() const {
+  int middle = (CAL_LUT_SIZE - 1) / 2;
+  return (_table[middle + 1] - _table[middle - 1]) * 0.5f * _invStep;
+}
+
+void LoadCellConverter::setLut(const CalibrationLut* lut) {
+  _lut = lut != nullptr && lut->valid() ? lut : nullptr;
+  fold();
+}
+
+void LoadCellConverter::tare(long raw) {
+  _offset = raw - lroundf(_zeroShiftKg / _kgPerCount);
+}
+
+void LoadCellConverter::setDriftModel(const DriftModel& model) {
+  float shiftCounts = _zeroShiftKg / _kgPerCount;
+  _drift = model;
+  fold();
+  _offset += lroundf(shiftCounts - _zeroShiftKg / _kgPerCount);
+}
+
+void LoadCellConverter::setTemperature(float tempC) {
+  _temperatureC = tempC;
+  fold();
+}
+
+void LoadCellConverter::fold() {
+  float deltaC = _temperatureC - _drift.refTempC;
+  _span = 1.0f + _drift.spanPerC * deltaC;
+  _kgPerCount = (_lut != nullptr ? _lut->slopeAtZero() : _correction / _scale) * _span;
+  _zeroShiftKg = _drift.zeroKgPerC * deltaC;
+}
+
+ZeroTrackConfig defaultZeroTrackConfig() {
+  ZeroTrackConfig config;
+  config.settleS = 3.0f;         // 5" prop coasts down in ~2 s
+  config.windowSamples = 10;     // 1 s at 10 SPS
+  config.bandKg = 0.050f;        // creep and heating stay well inside this
+  config.stableKg = 0.004f;      // ~2x HX711 noise at 10 SPS
+  config.maxRateKgPerS = 0.002f;
+  return config;
+}
+
+ZeroTracker::ZeroTracker(const ZeroTrackConfig& config)
+    : _config(config), _stoppedSinceS(-1.0f), _windowStartS(0.0f), _count(0),
+      _sum(0.0f), _min(0.0f), _max(0.0f), _lastErrorKg(0.0f), _correctionKg(0.0f), _updates(0),
+      _rejected(0) {}
+
+bool ZeroTracker::update(LoadCellConverter& cell, long raw, float timeS) {
+  if (_stoppedSinceS < 0.0f) {
+    _stoppedSinceS = timeS;
+  }
+  if (timeS - _stoppedSinceS < _config.settleS) {
+    return false;
+  }
+
+  float kg = cell.toKg(raw);
+  if (_count == 0) {
+    _windowStartS = timeS;
+    _sum = 0.0f;
+    _min = kg;
+    _max = kg;
+  }
+  _sum += kg;
+  if (kg < _min) _min = kg;
+  if (kg > _max) _max = kg;
+  if (++_count < _config.windowSamples) {
+    return false;
+  }
+  _count = 0;
+
+  float errorKg = _sum / _config.windowSamples;
+  _lastErrorKg = errorKg;
+  if (_max - _min > _config.stableKg || fabsf(errorKg) > _config.bandKg || cell.kgPerCount() == 0.0f) {
+    _rejected++;
+    return false;
+  }
+
+  // Windows are back to back, so limiting each one limits the rate
+  float limitKg = _config.maxRateKgPerS * (timeS - _windowStartS);
+  float stepKg = errorKg > limitKg ? limitKg : (errorKg < -limitKg ? -limitKg : errorKg);
+
+  long stepCounts = lroundf(stepKg / cell.kgPerCount());
+  if (stepCounts == 0) {
+    return false;
+  }
+  cell.setOffset(cell.offset() + stepCounts);
+  _correctionKg += stepCounts * cell.kgPerCount();
+  _updates++;
+  return true;
+}
+
+void DriftFit::reset() {
+  _count = 0;
+  _sumT = 0.0;
+  _sumZ = 0.0;
+  _sumTT = 0.0;
+  _sumTZ = 0.0;
+}
+
+void DriftFit::add(float tempC, float zeroKg) {
+  _count++;
+  _sumT += tempC;
+  _sumZ += zeroKg;
+  _sumTT += (double)tempC * tempC;
+  _sumTZ += (double)tempC * zeroKg;
+}
+
+bool DriftFit::fit(DriftModel& model) const {
+  if (_count < 3) {
+    return false;
+  }
+  double n = _count;
+  double varianceT = _sumTT / n - (_sumT / n) * (_sumT / n);
+  if (varianceT < 0.25) {  // under ~0.5 C of spread the slope is noise
+    return false;
+  }
+  double covariance = _sumTZ / n - (_sumT / n) * (_sumZ / n);
+  model.zeroKgPerC = (float)(covariance / varianceT);
+  return true;
+}
+
+float ntcTemperatureC(int adc, int adcMax, float seriesOhms, float ohmsAt25C, float beta) {
+  if (adc <= 0 || adc >= adcMax) {
+    return NAN;  // open or shorted thermistor
+  }
+  float ohms = seriesOhms * adc / (float)(adcMax - adc);
+  float inverseK = 1.0f / 298.15f + logf(ohms / ohmsAt25C) / beta;
+  return 1.0f / inverseK - 273.15f;
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <stdint.h>
+
+// Single-point fallback until a multi-point calibration is stored: scale from
+// the reading after tare over the reference weight, times an empirical correction
+const float CALIBRATION_WEIGHT_KG = 0.800;
+const float CORRECTION_K = 3.265;
+
+const int CAL_LUT_SIZE = 65;  // 64 segments
+
+// Net counts -> kg by linear interpolation in a table of the fitted calibration
+// curve. Segments are a power of two wide, so the index is a shift; beyond the
+// table the end segments are extended.
+class CalibrationLut {
+ public:
+  CalibrationLut() : _minCounts(0), _shift(0), _invStep(1.0f), _valid(false) {}
+
+  // Tabulates kg = c1 * n + c2 * n^2 over at least [-rangeCounts, +rangeCounts]
+  void build(float c1, float c2, long rangeCounts);
+  void clear() { _valid = false; }
+  bool valid() const { return _valid; }
+
+  float toKg(long netCounts) const {
+    long i = (netCounts - _minCounts) >> _shift;
+    if (i < 0) i = 0;
+    if (i > CAL_LUT_SIZE - 2) i = CAL_LUT_SIZE - 2;
+    float t = (float)(netCounts - _minCounts - (i << _shift)) * _invStep;
+    return _table[i] + (_table[i + 1] - _table[i]) * t;
+  }
+
+  float slopeAtZero() const;  // kg per count around the tare point
+  long rangeCounts() const { return -_minCounts; }
+
+  // The table as built, to carry it into a record and back unchanged
+  const float* table() const { return _table; }
+  int shift() const { return _shift; }
+  void load(const float* table, int shift);
+
+ private:
+  float _table[CAL_LUT_SIZE];
+  long _minCounts;
+  int _shift;
+  float _invStep;
+  bool _valid;
+};
+
+// Zero shift and span change with temperature, linear around refTempC:
+//   zero(T) = zeroKgPerC * (T - refTempC)     (kg added to the reading)
+//   span(T) = 1 + spanPerC * (T - refTempC)   (gain factor)
+struct DriftModel {
+  float refTempC;
+  float zeroKgPerC;
+  float spanPerC;
+};
+
+DriftModel noDrift();
+
+// Raw HX711 counts -> kg: the calibration table when one is set, otherwise
+// HX711::get_units() * CORRECTION_K; the drift model is folded in whenever
+// the temperature changes
+class LoadCellConverter {
+ public:
+  LoadCellConverter()
+      : _offset(0), _scale(1.0f), _correction(1.0f), _kgPerCount(1.0f), _span(1.0f),
+        _zeroShiftKg(0.0f), _lut(nullptr), _drift(noDrift()), _temperatureC(0.0f) {}
+
+  void setCalibration(long offset, float scale, float correction);
+  // Multi-point calibration; nullptr goes back to scale and correction
+  void setLut(const CalibrationLut* lut);
+  void setOffset(long offset) { _offset = offset; }
+  // Zero from a raw reading with no load, at the current temperature
+  void tare(long raw);
+  // Keeps the current zero; only later temperature changes move the reading
+  void setDriftModel(const DriftModel& model);
+  void setTemperature(float tempC);
+
+  long offset() const { return _offset; }
+  float scale() const { return _scale; }
+  float correction() const { return _correction; }
+  float kgPerCount() const { return _kgPerCount; }  // local gain at zero with a table
+  bool hasLut() const { return _lut != nullptr; }
+  float zeroShiftKg() const { return _zeroShiftKg; }
+  float temperature() const { return _temperatureC; }
+  const DriftModel& driftModel() const { return _drift; }
+
+  float toKg(long raw) const {
+    if (_lut != nullptr) {
+      return _lut->toKg(raw - _offset) * _span - _zeroShiftKg;
+    }
+    return (raw - _offset) * _kgPerCount - _zeroShiftKg;
+  }
+
+  // Uncompensated zero in kg (offset plus modelled shift), to fit the model against
+  float rawZeroKg() const { return _offset * _kgPerCount + _zeroShiftKg; }
+
+ private:
+  void fold();
+
+  long _offset;
+  float _scale;
+  float _correction;
+  float _kgPerCount;   // correction / scale * span(T), folded on change
+  float _span;         // span(T)
+  float _zeroShiftKg;  // zero(T)
+  const CalibrationLut* _lut;
+  DriftModel _drift;
+  float _temperatureC;
+};
+
+struct ZeroTrackConfig {
+  float settleS;        // after the stop command: prop spin-down, airflow
+  int windowSamples;    // samples averaged per offset update
+  float bandKg;         // larger errors are a load on the cell, not drift
+  float stableKg;       // window peak-to-peak limit
+  float maxRateKgPerS;  // offset slew limit
+};
+
+ZeroTrackConfig defaultZeroTrackConfig();
+
+// Automatic zero tracking while the motor is commanded stopped: the window
+// mean of the converted reading is walked back to 0 kg at a limited rate.
+class ZeroTracker {
+ public:
+  explicit ZeroTracker(const ZeroTrackConfig& config);
+
+  // Motor commanded to run: the next stopped sample starts a new settle period
+  void reset() { _stoppedSinceS = -1.0f; _count = 0; }
+
+  // One sample while the motor is stopped; true when the offset was moved
+  bool update(LoadCellConverter& cell, long raw, float timeS);
+
+  float lastErrorKg() const { return _lastErrorKg; }
+  float correctionKg() const { return _correctionKg; }  // sum of applied steps
+  uint32_t updates() const { return _updates; }
+  uint32_t rejected() const { return _rejected; }
+
+ private:
+  ZeroTrackConfig _config;
+  float _stoppedSinceS;
+  float _windowStartS;
+  int _count;
+  float _sum;
+  float _min;
+  float _max;
+  float _lastErrorKg;
+  float _correctionKg;
+  uint32_t _updates;
+  uint32_t _rejected;
+};
+
+// Least-squares line through (temperature, zero) points, e.g. the zero
+// found by the tracker at different temperatures during a batch
+class DriftFit {
+ public:
+  DriftFit() { reset(); }
+
+  void reset();
+  void add(float tempC, float zeroKg);
+
+  // Fills zeroKgPerC only: the caller picks refTempC (usually the temperature
+  // now, so applying the model does not step the reading); false without spread
+  bool fit(DriftModel& model) const;
+  uint32_t count() const { return _count; }
+
+ private:
+  uint32_t _count;
+  double _sumT;
+  double _sumZ;
+  double _sumTT;
+  double _sumTZ;
+};
+
+// NTC thermistor to ground, series resistor to the ADC reference (Beta model)
+float ntcTemperatureC(int adc, int adcMax, float seriesOhms, float ohmsAt25C, float beta);
@@ -0,0 +1,77 @@
+#include "MemoryArena.h"
+
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+MemoryArena::MemoryArena(const char* name)
+    : _name(name), _base(nullptr), _capacity(0), _used(0), _allocations(0), _failures(0) {}
+
+void MemoryArena::attach(void* block, size_t capacity) {
+  _base = (uint8_t*)block;
+  _capacity = block != nullptr ? capacity : 0;
+  _used = 0;
+}
+
+void* MemoryArena::allocate(size_t bytes, size_t align) {
+  if (_base == nullptr || align == 0) {
+    _failures++;
+    return nullptr;
+  }
+  uintptr_t start = (uintptr_t)_base + _used;
+  size_t padding = (align - start % align) % align;
+  if (bytes > _capacity - _used || padding > _capacity - _used - bytes) {
+    _failures++;
+    return nullptr;
+  }
+  _used += padding + bytes;
+  _allocations++;
+  return (void*)(start + padding);
+}
+
+void* TieredArena::allocate(size_t bytes, bool large, MemoryTier& tier) {
+  if (large && _psram.attached()) {
+    void* block = _psram.allocate(bytes);
+    if (block != nullptr) {
+      tier = TIER_PSRAM;
+      return block;
+    }
+  }
+  tier = TIER_SRAM;
+  return _sram.allocate(bytes);
+}
+
+#ifdef ESP32
+HeapStats internalHeapStats() {
+  const uint32_t caps = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+  HeapStats stats = {(uint32_t)heap_caps_get_free_size(caps), (uint32_t)heap_caps_get_minimum_free_size(caps),
+                     (uint32_t)heap_caps_get_largest_free_block(caps)};
+  return stats;
+}
+
+HeapStats psramHeapStats() {
+  const uint32_t caps = MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT;
+  HeapStats stats = {(uint32_t)heap_caps_get_free_size(caps), (uint32_t)heap_caps_get_minimum_free_size(caps),
+                     (uint32_t)heap_caps_get_largest_free_block(caps)};
+  return stats;
+}
+
+uint32_t taskStackFree(const char* name) {
+  TaskHandle_t task = name != nullptr ? xTaskGetHandle(name) : nullptr;
+  if (name != nullptr && task == nullptr) {
+    return 0;
+  }
+  return (uint32_t)uxTaskGetStackHighWaterMark(task);  // bytes on ESP-IDF
+}
+
+void* allocatePsramBlock(size_t bytes) {
+#ifdef BOARD_HAS_PSRAM
+  return heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+  (void)bytes;
+  return nullptr;
+#endif
+}
+#endif
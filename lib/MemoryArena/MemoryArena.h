@@ -0,0 +1,80 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator over one fixed block. Run-time buffers are taken from it at
+// boot and never returned, so a night of runs cannot fragment the heap; a
+// request that does not fit fails (and is counted) instead of growing.
+class MemoryArena {
+ public:
+  explicit MemoryArena(const char* name);
+
+  void attach(void* block, size_t capacity);
+  bool attached() const { return _base != nullptr; }
+
+  // nullptr when the arena is not attached or the request does not fit
+  void* allocate(size_t bytes, size_t align = 8);
+
+  template <typename T>
+  T* allocateArray(size_t count) {
+    return (T*)allocate(count * sizeof(T), alignof(T));
+  }
+
+  const char* name() const { return _name; }
+  size_t used() const { return _used; }
+  size_t capacity() const { return _capacity; }
+  size_t remaining() const { return _capacity - _used; }
+  uint32_t allocations() const { return _allocations; }
+  uint32_t failures() const { return _failures; }
+
+ private:
+  const char* _name;
+  uint8_t* _base;
+  size_t _capacity;
+  size_t _used;
+  uint32_t _allocations;
+  uint32_t _failures;
+};
+
+enum MemoryTier : uint8_t {
+  TIER_SRAM,
+  TIER_PSRAM
+};
+
+// Internal SRAM for buffers touched on every sample, PSRAM (when the board
+// has it) for large ones that are filled once and read back later
+class TieredArena {
+ public:
+  TieredArena(MemoryArena& sram, MemoryArena& psram) : _sram(sram), _psram(psram) {}
+
+  bool hasPsram() const { return _psram.attached(); }
+
+  // Large buffers try PSRAM first and fall back to SRAM
+  void* allocate(size_t bytes, bool large, MemoryTier& tier);
+
+  MemoryArena& sram() { return _sram; }
+  MemoryArena& psram() { return _psram; }
+
+ private:
+  MemoryArena& _sram;
+  MemoryArena& _psram;
+};
+
+#ifdef ESP32
+struct HeapStats {
+  uint32_t freeBytes;
+  uint32_t minFreeBytes;  // low-water mark since boot
+  uint32_t largestBlock;  // fragmentation shows as largest << free
+};
+
+HeapStats internalHeapStats();
+HeapStats psramHeapStats();  // all zero without PSRAM
+
+// Stack never used by a task since it started (bytes); nullptr = calling
+// task, 0 when there is no task with that name
+uint32_t taskStackFree(const char* name);
+
+// The PSRAM arena block, taken once at boot; nullptr without PSRAM
+void* allocatePsramBlock(size_t bytes);
+#endif
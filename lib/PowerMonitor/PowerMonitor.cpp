@@ -0,0 +1,170 @@
+#include "PowerMonitor.h"
+
+#include <math.h>
+
+namespace {
+
+const float GRAVITY = 9.80665f;
+const float AIR_DENSITY = 1.225f;  // kg/m^3 at sea level, 15 C
+const float PI_F = 3.14159265f;
+
+// INA219 registers
+const uint8_t INA219_REG_CONFIG = 0x00;
+const uint8_t INA219_REG_SHUNT = 0x01;
+const uint8_t INA219_REG_BUS = 0x02;
+
+// 32V bus range, /8 gain (320 mV shunt), 12-bit conversions, continuous
+const uint16_t INA219_CONFIG = 0x399F;
+
+}  // namespace
+
+Ina219PowerSensor::Ina219PowerSensor(I2cScheduler& bus, int device, float shuntOhms)
+    : _bus(bus),
+      _device((uint8_t)device),
+      _shuntOhms(shuntOhms),
+      _pending(false),
+      _latest(-1),
+      _completed(0),
+      _shuntRaw(0),
+      _shuntOk(false) {
+  _valid[0] = false;
+  _valid[1] = false;
+}
+
+bool Ina219PowerSensor::begin() {
+  I2cTransaction t;
+  t.device = _device;
+  t.data[0] = INA219_REG_CONFIG;
+  t.data[1] = (uint8_t)(INA219_CONFIG >> 8);
+  t.data[2] = (uint8_t)(INA219_CONFIG & 0xFF);
+  t.writeLength = 3;
+  t.readLength = 0;
+  I2cResult result;
+  return _bus.transact(I2C_PRIORITY_SENSOR, t, result);
+}
+
+void Ina219PowerSensor::request() {
+  // Both halves or neither; the producer is the only one taking space
+  if (_pending.load(std::memory_order_acquire) || _bus.space(I2C_PRIORITY_SENSOR) < 2) {
+    return;
+  }
+  _pending.store(true, std::memory_order_relaxed);
+  I2cTransaction t;
+  t.device = _device;
+  t.writeLength = 1;
+  t.readLength = 2;
+  t.context = this;
+  t.data[0] = INA219_REG_SHUNT;
+  t.done = onShunt;
+  _bus.submit(I2C_PRIORITY_SENSOR, t);
+  t.data[0] = INA219_REG_BUS;
+  t.done = onBus;
+  _bus.submit(I2C_PRIORITY_SENSOR, t);
+}
+
+bool Ina219PowerSensor::read(PowerReading& out) {
+  // Copy before requesting: the owner only refills this slot after the
+  // next pair, which starts with the request below
+  int slot = _latest.load(std::memory_order_acquire);
+  bool ok = slot >= 0 && _valid[slot];
+  if (ok) {
+    out = _readings[slot];
+  }
+  request();
+  return ok;
+}
+
+void Ina219PowerSensor::onShunt(void* context, const I2cResult& result) {
+  Ina219PowerSensor* self = (Ina219PowerSensor*)context;
+  self->_shuntOk = result.ok;
+  self->_shuntRaw = (int16_t)((result.data[0] << 8) | result.data[1]);
+}
+
+void Ina219PowerSensor::onBus(void* context, const I2cResult& result) {
+  Ina219PowerSensor* self = (Ina219PowerSensor*)context;
+  int slot = self->_latest.load(std::memory_order_relaxed) == 0 ? 1 : 0;
+  PowerReading& out = self->_readings[slot];
+  uint16_t busRaw = (uint16_t)((result.data[0] << 8) | result.data[1]);
+
+  float shuntV = self->_shuntRaw * 10e-6f;                  // 10 uV per LSB
+  out.voltageV = (busRaw >> 3) * 0.004f;                    // 4 mV per LSB
+  out.currentA = shuntV / self->_shuntOhms;
+  out.powerW = out.voltageV * out.currentA;
+  self->_valid[slot] = self->_shuntOk && result.ok;
+
+  self->_latest.store(slot, std::memory_order_release);
+  self->_completed.fetch_add(1);
+  self->_pending.store(false, std::memory_order_release);
+}
+
+#ifdef ARDUINO
+AdcPowerSensor::AdcPowerSensor(uint8_t voltagePin, uint8_t currentPin,
+                               float dividerRatio, float shuntOhms, float ampGain)
+    : _voltagePin(voltagePin),
+      _currentPin(currentPin),
+      _dividerRatio(dividerRatio),
+      _shuntOhms(shuntOhms),
+      _ampGain(ampGain) {}
+
+bool AdcPowerSensor::begin() {
+  pinMode(_voltagePin, INPUT);
+  pinMode(_currentPin, INPUT);
+  return true;
+}
+
+bool AdcPowerSensor::read(PowerReading& out) {
+  // analogReadMilliVolts uses the factory eFuse calibration of the ADC
+  float voltageMv = analogReadMilliVolts(_voltagePin);
+  float currentMv = analogReadMilliVolts(_currentPin);
+
+  out.voltageV = voltageMv / 1000.0f * _dividerRatio;
+  out.currentA = currentMv / 1000.0f / (_shuntOhms * _ampGain);
+  out.powerW = out.voltageV * out.currentA;
+  return true;
+}
+#endif
+
+float efficiencyGramsPerWatt(float thrustKg, float powerW) {
+  if (powerW <= 0.0f || thrustKg <= 0.0f) {
+    return 0.0f;
+  }
+  return thrustKg * 1000.0f / powerW;
+}
+
+float idealMechanicalPowerW(float thrustKg, float propDiameterM) {
+  if (thrustKg <= 0.0f || propDiameterM <= 0.0f) {
+    return 0.0f;
+  }
+  float thrustN = thrustKg * GRAVITY;
+  float diskArea = PI_F * propDiameterM * propDiameterM / 4.0f;
+  return sqrtf(thrustN * thrustN * thrustN / (2.0f * AIR_DENSITY * diskArea));
+}
+
+StepPowerAccumulator::StepPowerAccumulator(float propDiameterM)
+    : _propDiameterM(propDiameterM) {}
+
+void StepPowerAccumulator::reset() {
+  _thrust.reset();
+  _voltage.reset();
+  _current.reset();
+  _power.reset();
+}
+
+void StepPowerAccumulator::add(float thrustKg, const PowerReading& reading) {
+  _thrust.add(thrustKg);
+  _voltage.add(reading.voltageV);
+  _current.add(reading.currentA);
+  _power.add(reading.powerW);
+}
+
+StepPowerResult StepPowerAccumulator::result() const {
+  StepPowerResult r;
+  r.samples = _thrust.count();
+  r.thrustKg = _thrust.mean();
+  r.voltageV = _voltage.mean();
+  r.currentA = _current.mean();
+  r.powerW = _power.mean();
+  r.efficiencyGPerW = efficiencyGramsPerWatt(r.thrustKg, r.powerW);
+  r.mechanicalPowerW = idealMechanicalPowerW(r.thrustKg, _propDiameterM);
+  return r;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include "I2cBus.h"
+#include "SampleStats.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// One electrical sample from the motor supply
+struct PowerReading {
+  float voltageV;
+  float currentA;
+  float powerW;
+};
+
+// Voltage/current source sampled next to the HX711
+class PowerSensor {
+ public:
+  virtual ~PowerSensor() {}
+  virtual bool begin() = 0;
+  virtual bool read(PowerReading& out) = 0;
+  // Start a conversion for the next read(); sensors read in place ignore it
+  virtual void request() {}
+};
+
+// INA219 on the shared I2C bus (shunt on the high side of the ESC supply).
+// read() never waits: it returns the newest completed shunt/bus pair and
+// queues the next one. request() queues one early, e.g. before blocking on
+// the HX711, so the pair is fresh by the time the thrust sample is.
+class Ina219PowerSensor : public PowerSensor {
+ public:
+  Ina219PowerSensor(I2cScheduler& bus, int device, float shuntOhms);
+
+  bool begin() override;  // waits for the configuration write
+  bool read(PowerReading& out) override;
+  void request() override;
+
+  uint32_t completed() const { return _completed.load(); }
+
+ private:
+  static void onShunt(void* context, const I2cResult& result);
+  static void onBus(void* context, const I2cResult& result);
+
+  I2cScheduler& _bus;
+  uint8_t _device;
+  float _shuntOhms;
+  std::atomic<bool> _pending;
+  // Two slots: the owner fills the one the loop is not reading
+  PowerReading _readings[2];
+  bool _valid[2];
+  std::atomic<int> _latest;  // -1 until the first pair completes
+  std::atomic<uint32_t> _completed;
+  int16_t _shuntRaw;  // owner only, between the two callbacks
+  bool _shuntOk;
+};
+
+#ifdef ARDUINO
+// Resistor divider for battery voltage + shunt amplifier on two ADC pins
+class AdcPowerSensor : public PowerSensor {
+ public:
+  AdcPowerSensor(uint8_t voltagePin, uint8_t currentPin,
+                 float dividerRatio, float shuntOhms, float ampGain);
+
+  bool begin() override;
+  bool read(PowerReading& out) override;
+
+ private:
+  uint8_t _voltagePin;
+  uint8_t _currentPin;
+  float _dividerRatio;
+  float _shuntOhms;
+  float _ampGain;
+};
+#endif
+
+// Thrust per electrical watt (g/W); 0 when the motor draws no power
+float efficiencyGramsPerWatt(float thrustKg, float powerW);
+
+// Ideal induced power from momentum theory: P = sqrt(T^3 / (2 * rho * A))
+float idealMechanicalPowerW(float thrustKg, float propDiameterM);
+
+// Averages thrust and power samples taken during one sweep step
+struct StepPowerResult {
+  uint32_t samples;
+  float thrustKg;
+  float voltageV;
+  float currentA;
+  float powerW;
+  float efficiencyGPerW;
+  float mechanicalPowerW;
+};
+
+class StepPowerAccumulator {
+ public:
+  explicit StepPowerAccumulator(float propDiameterM);
+
+  void reset();
+  void add(float thrustKg, const PowerReading& reading);
+  StepPowerResult result() const;
+
+ private:
+  float _propDiameterM;
+  RunningStats _thrust;
+  RunningStats _voltage;
+  RunningStats _current;
+  RunningStats _power;
+};
@@ -0,0 +1,360 @@
+#include "RawRecord.h"
+
+#include <string.h>
+
+namespace {
+
+int32_t floatBits(float value) {
+  int32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+float bitsFloat(int32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// Converter as it was at the start of the run. The drift model is set
+// before the offset, which setDriftModel() would otherwise move.
+void restoreConverter(LoadCellConverter& cell, const RecordHeader& header, const CalibrationLut* lut) {
+  cell.setCalibration(header.offset, header.scale, header.correction);
+  cell.setLut(lut);
+  cell.setTemperature(header.temperatureC);
+  cell.setDriftModel(header.drift);
+  cell.setOffset(header.offset);
+}
+
+}  // namespace
+
+void fillRecordHeader(RecordHeader& header, const LoadCellConverter& cell) {
+  header.offset = cell.offset();
+  header.scale = cell.scale();
+  header.correction = cell.correction();
+  header.hasLut = cell.hasLut();
+  header.temperatureC = cell.temperature();
+  header.drift = cell.driftModel();
+}
+
+RawRecorder::RawRecorder(RecordSink sink)
+    : _sink(sink), _active(false), _sequence(0), _count(0), _events(0), _frames(0) {}
+
+void RawRecorder::start(const RecordHeader& header, const CalibrationLut* lut) {
+  _active = true;
+  _sequence = 0;
+  _count = 0;
+
+  uint8_t payload[RECORD_MAX_FRAME];
+  PayloadWriter out(payload, sizeof(payload));
+  out.putU16(_sequence++);
+  out.putU8(RECORD_VERSION);
+  out.putU16(header.run);
+  out.putU64(header.startUs);
+  out.putI32((int32_t)header.offset);
+  out.putF32(header.scale);
+  out.putF32(header.correction);
+  bool hasLut = header.hasLut && lut != nullptr && lut->valid();
+  out.putU8(hasLut ? 1 : 0);
+  out.putU8(hasLut ? (uint8_t)lut->shift() : 0);
+  out.putF32(header.temperatureC);
+  out.putF32(header.drift.refTempC);
+  out.putF32(header.drift.zeroKgPerC);
+  out.putF32(header.drift.spanPerC);
+  out.putU16((uint16_t)header.sweep.slowPwm);
+  out.putU16((uint16_t)header.sweep.fastPwm);
+  out.putU16((uint16_t)header.sweep.stepPwm);
+  out.putU8(header.sweep.returnSweep ? 1 : 0);
+  out.putU16((uint16_t)header.sweep.rampUsPerS);
+  out.putU8(header.settleSamples);
+  out.putU16(header.stoppedPwm);
+  out.putF32(header.propDiameterM);
+  out.putF32(header.payload.droneWeightKg);
+  out.putU8((uint8_t)header.payload.motors);
+  out.putF32(header.payload.thrustToWeightRatio);
+  send(TELEMETRY_RECORD_HEADER, payload, out.length());
+
+  for (size_t first = 0; hasLut && first < (size_t)CAL_LUT_SIZE; first += RECORD_LUT_PER_FRAME) {
+    size_t count = CAL_LUT_SIZE - first < RECORD_LUT_PER_FRAME ? CAL_LUT_SIZE - first : RECORD_LUT_PER_FRAME;
+    PayloadWriter table(payload, sizeof(payload));
+    table.putU16(_sequence++);
+    table.putU8((uint8_t)first);
+    table.putU8((uint8_t)count);
+    for (size_t i = 0; i < count; i++) {
+      table.putF32(lut->table()[first + i]);
+    }
+    send(TELEMETRY_RECORD_LUT, payload, table.length());
+  }
+}
+
+void RawRecorder::add(uint8_t type, int32_t value, uint32_t timeUs) {
+  if (!_active) {
+    return;
+  }
+  RecordEvent& e = _pending[_count++];
+  e.timeUs = timeUs;
+  e.type = type;
+  e.value = value;
+  _events++;
+  if (_count == RECORD_EVENTS_PER_FRAME) {
+    flush();
+  }
+}
+
+void RawRecorder::addFloat(uint8_t type, float value, uint32_t timeUs) {
+  add(type, floatBits(value), timeUs);
+}
+
+void RawRecorder::stop(bool completed, uint32_t timeUs) {
+  if (!_active) {
+    return;
+  }
+  add(REC_RUN_END, completed ? 1 : 0, timeUs);
+  flush();
+  _active = false;
+}
+
+void RawRecorder::flush() {
+  if (_count == 0) {
+    return;
+  }
+  uint8_t payload[RECORD_MAX_FRAME];
+  PayloadWriter out(payload, sizeof(payload));
+  out.putU16(_sequence++);
+  out.putU8((uint8_t)_count);
+  for (size_t i = 0; i < _count; i++) {
+    out.putU32(_pending[i].timeUs);
+    out.putU8(_pending[i].type);
+    out.putI32(_pending[i].value);
+  }
+  _count = 0;
+  send(TELEMETRY_RECORD_EVENTS, payload, out.length());
+}
+
+void RawRecorder::send(uint8_t type, const uint8_t* payload, size_t length) {
+  size_t n = encodeTelemetryFrame(type, payload, length, _frame, sizeof(_frame));
+  if (n > 0) {
+    _sink(_frame, n);
+    _frames++;
+  }
+}
+
+ReplayOptions recordedReplayOptions() {
+  ReplayOptions options = {true, -1};
+  return options;
+}
+
+ReplayEngine::ReplayEngine(const ReplayOptions& options, ReplayListener& listener)
+    : _options(options), _listener(listener), _inRun(false), _nextSequence(0),
+      _zero(defaultZeroTrackConfig()), _power(0.0f), _reading(),
+      _driftZeroKgPerC(0.0f), _settle(0), _inStep(false), _stepPwm(0), _stepSample(0),
+      _timed(false), _deviceUs(0), _lastSampleUs(0), _escUs(0), _escPending(false),
+      _runs(0), _totalLost(0) {}
+
+void ReplayEngine::feed(uint8_t type, const uint8_t* payload, size_t length) {
+  if (type != TELEMETRY_RECORD_HEADER && type != TELEMETRY_RECORD_LUT && type != TELEMETRY_RECORD_EVENTS) {
+    return;
+  }
+  PayloadReader in(payload, length);
+  uint16_t seq = in.getU16();
+  if (type == TELEMETRY_RECORD_HEADER) {
+    if (seq == 0) {
+      beginRun(in);
+    }
+    return;
+  }
+  if (!_inRun) {
+    return;
+  }
+  trackSequence(seq);
+  if (type == TELEMETRY_RECORD_LUT) {
+    loadTable(in);
+    return;
+  }
+
+  uint8_t count = in.getU8();
+  for (uint8_t i = 0; i < count && _inRun; i++) {
+    RecordEvent e;
+    e.timeUs = in.getU32();
+    e.type = in.getU8();
+    e.value = in.getI32();
+    if (in.underflow()) {
+      break;
+    }
+    event(e);
+  }
+}
+
+// A gap means frames were dropped; the run goes on but is flagged
+void ReplayEngine::trackSequence(uint16_t seq) {
+  if (seq != _nextSequence) {
+    uint16_t lost = (uint16_t)(seq - _nextSequence);
+    _run.lostFrames += lost;
+    _totalLost += lost;
+  }
+  _nextSequence = (uint16_t)(seq + 1);
+}
+
+void ReplayEngine::beginRun(PayloadReader& in) {
+  if (in.getU8() != RECORD_VERSION) {
+    _inRun = false;
+    return;
+  }
+  RecordHeader& h = _run.header;
+  h.run = in.getU16();
+  h.startUs = in.getU64();
+  h.offset = in.getI32();
+  h.scale = in.getF32();
+  h.correction = in.getF32();
+  h.hasLut = in.getU8() != 0;
+  h.lutShift = in.getU8();
+  h.temperatureC = in.getF32();
+  h.drift.refTempC = in.getF32();
+  h.drift.zeroKgPerC = in.getF32();
+  h.drift.spanPerC = in.getF32();
+  h.sweep.slowPwm = (int16_t)in.getU16();
+  h.sweep.fastPwm = (int16_t)in.getU16();
+  h.sweep.stepPwm = (int16_t)in.getU16();
+  h.sweep.returnSweep = in.getU8() != 0;
+  h.sweep.rampUsPerS = in.getU16();
+  h.settleSamples = in.getU8();
+  h.stoppedPwm = in.getU16();
+  h.propDiameterM = in.getF32();
+  h.payload.droneWeightKg = in.getF32();
+  h.payload.motors = in.getU8();
+  h.payload.thrustToWeightRatio = in.getF32();
+  if (in.underflow()) {
+    _inRun = false;
+    return;
+  }
+
+  _inRun = true;
+  _nextSequence = 1;
+  _run.steps = 0;
+  _run.totals.reset();
+  _run.payloadKg = 0.0f;
+  _run.completed = false;
+  _run.lostFrames = 0;
+  _run.events = 0;
+  _run.firstUs = h.startUs;
+  _run.durationUs = 0;
+  _run.sampleIntervalUs.reset();
+  _run.escToSampleUs.reset();
+  _timed = false;
+  _deviceUs = h.startUs;
+  _lastSampleUs = 0;
+  _escPending = false;
+
+  // With a table the converter is restored again once the table is in
+  _lut.clear();
+  restoreConverter(_cell, h, nullptr);
+  _zero = ZeroTracker(defaultZeroTrackConfig());
+  _power = StepPowerAccumulator(h.propDiameterM);
+  _settle = _options.settleSamples >= 0 ? _options.settleSamples : h.settleSamples;
+  _inStep = false;
+  _listener.runStarted(h);
+}
+
+void ReplayEngine::loadTable(PayloadReader& in) {
+  size_t first = in.getU8();
+  size_t count = in.getU8();
+  for (size_t i = 0; i < count && first + i < (size_t)CAL_LUT_SIZE; i++) {
+    _lutTable[first + i] = in.getF32();
+  }
+  if (!in.underflow() && first + count == (size_t)CAL_LUT_SIZE) {
+    _lut.load(_lutTable, _run.header.lutShift);
+    restoreConverter(_cell, _run.header, &_lut);
+  }
+}
+
+// Each case does what the firmware does with the same input
+void ReplayEngine::event(const RecordEvent& e) {
+  // Events are in capture order, a reading may be stamped a little before
+  // the power values sent ahead of it: step by the signed difference
+  uint64_t nowUs = _deviceUs + (int64_t)(int32_t)(e.timeUs - (uint32_t)_deviceUs);
+  _deviceUs = nowUs;
+  if (!_timed) {
+    _run.firstUs = nowUs;
+    _timed = true;
+  }
+  if (nowUs > _run.firstUs + _run.durationUs) {
+    _run.durationUs = nowUs - _run.firstUs;
+  }
+  _run.events++;
+
+  switch (e.type) {
+    case REC_SAMPLE: {
+      float kg = _cell.toKg(e.value);
+      if (_inStep && _stepSample > 0) {
+        _run.sampleIntervalUs.add((float)(nowUs - _lastSampleUs));
+      }
+      if (_escPending) {
+        _run.escToSampleUs.add((float)(nowUs - _escUs));
+        _escPending = false;
+      }
+      _lastSampleUs = nowUs;
+      if (_inStep && _stepSample++ >= _settle) {
+        _power.add(kg, _reading);
+      }
+      _reading = {0.0f, 0.0f, 0.0f};
+      break;
+    }
+    case REC_IDLE_SAMPLE:
+      if (_options.zeroTracking) {
+        _zero.update(_cell, e.value, nowUs / 1e6);
+      }
+      break;
+    case REC_VOLTAGE:
+      _reading.voltageV = bitsFloat(e.value);
+      break;
+    case REC_CURRENT:
+      _reading.currentA = bitsFloat(e.value);
+      break;
+    case REC_POWER:
+      _reading.powerW = bitsFloat(e.value);
+      break;
+    case REC_ESC:
+      if (e.value < _run.header.stoppedPwm) {
+        _zero.reset();
+      }
+      _escUs = nowUs;
+      _escPending = true;
+      break;
+    case REC_STEP_BEGIN:
+      _power.reset();
+      _reading = {0.0f, 0.0f, 0.0f};
+      _stepPwm = e.value;
+      _stepSample = 0;
+      _inStep = true;
+      break;
+    case REC_STEP_END:
+      if (_inStep) {
+        StepPowerResult step = _power.result();
+        _run.totals.add(_stepPwm, step);
+        _run.steps++;
+        _inStep = false;
+        _listener.stepDone(_stepPwm, step);
+      }
+      break;
+    case REC_TEMPERATURE:
+      _cell.setTemperature(bitsFloat(e.value));
+      break;
+    case REC_DRIFT_ZERO:
+      _driftZeroKgPerC = bitsFloat(e.value);
+      break;
+    case REC_DRIFT_SPAN: {
+      DriftModel model = {_cell.temperature(), _driftZeroKgPerC, bitsFloat(e.value)};
+      _cell.setDriftModel(model);
+      break;
+    }
+    case REC_RUN_END:
+      _run.completed = e.value != 0;
+      _run.payloadKg = payloadCapacityKg(_run.totals.maxThrustKg, _run.header.payload);
+      _inRun = false;
+      _runs++;
+      _listener.runEnded(_run);
+      break;
+    default:
+      break;  // buttons and newer event types change nothing here
+  }
+}
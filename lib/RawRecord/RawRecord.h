@@ -0,0 +1,180 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "LoadCell.h"
+#include "PowerMonitor.h"
+#include "SampleStats.h"
+#include "Sweep.h"
+#include "Telemetry.h"
+#include "TextLogger.h"
+
+// Raw-sample record of a sweep: HX711 counts, power readings, ESC commands,
+// buttons and temperature, each stamped from esp_timer when it is read or
+// written. Frames go through the log queue, in order with the text rows, and
+// the host replays them through the same conversion, zero tracking, step
+// averaging and payload code.
+//
+// Every record frame starts with a u16 sequence number (0 = header), so the
+// host can tell a frame dropped by a full queue from a short run.
+//   0x20 header: version, run, start time (u64 us), converter state, sweep,
+//                settle, payload model
+//   0x21 table:  first index, count, floats of the calibration table
+//   0x22 events: count, then per event u32 time (us) | u8 type | i32 value
+// Event times are the low 32 bits of esp_timer_get_time() and wrap every
+// 71 minutes; the host unwraps them from the start time.
+
+const uint8_t RECORD_VERSION = 3;
+const size_t RECORD_EVENT_SIZE = 9;
+// A frame is one log queue entry: below LOG_LINE_SIZE with header and CRC
+const size_t RECORD_MAX_FRAME = LOG_LINE_SIZE - 1;
+const size_t RECORD_EVENTS_PER_FRAME = 13;
+const size_t RECORD_LUT_PER_FRAME = 29;
+
+enum RecordEventType : uint8_t {
+  REC_SAMPLE = 1,    // raw counts measured for the current step
+  REC_IDLE_SAMPLE,   // raw counts fed to zero tracking (motor stopped)
+  REC_VOLTAGE,       // power reading taken with the next sample (float bits)
+  REC_CURRENT,
+  REC_POWER,
+  REC_ESC,           // command written (us)
+  REC_STEP_BEGIN,    // PWM of the step
+  REC_STEP_END,      // samples read
+  REC_TEMPERATURE,   // degC (float bits)
+  REC_DRIFT_ZERO,    // new drift model at the current temperature (float bits),
+  REC_DRIFT_SPAN,    //   applied with the span
+  REC_BUTTON,        // 1 short press, 2 long press
+  REC_RUN_END        // 1 completed, 0 aborted
+};
+
+struct RecordEvent {
+  uint32_t timeUs;
+  uint8_t type;
+  int32_t value;
+};
+
+// Everything the events start from
+struct RecordHeader {
+  uint16_t run;           // since boot
+  uint64_t startUs;       // esp_timer at the start of the run
+  long offset;
+  float scale;
+  float correction;
+  bool hasLut;
+  uint8_t lutShift;
+  float temperatureC;
+  DriftModel drift;
+  SweepConfig sweep;
+  uint8_t settleSamples;  // skipped at the start of each step
+  uint16_t stoppedPwm;    // commands at or above this leave the prop still
+  float propDiameterM;
+  PayloadModel payload;
+};
+
+// Converter state now, for the header
+void fillRecordHeader(RecordHeader& header, const LoadCellConverter& cell);
+
+// Finished frames go to the sink (e.g. the log queue)
+typedef void (*RecordSink)(const uint8_t* frame, size_t length);
+
+class RawRecorder {
+ public:
+  explicit RawRecorder(RecordSink sink);
+
+  // Sends the header and, with a table set, the table; events follow
+  void start(const RecordHeader& header, const CalibrationLut* lut);
+  // Ignored unless recording
+  void add(uint8_t type, int32_t value, uint32_t timeUs);
+  void addFloat(uint8_t type, float value, uint32_t timeUs);
+  // Run end event, then whatever is still buffered
+  void stop(bool completed, uint32_t timeUs);
+
+  bool active() const { return _active; }
+  uint32_t events() const { return _events; }
+  uint32_t frames() const { return _frames; }
+
+ private:
+  void flush();
+  void send(uint8_t type, const uint8_t* payload, size_t length);
+
+  RecordSink _sink;
+  bool _active;
+  uint16_t _sequence;
+  RecordEvent _pending[RECORD_EVENTS_PER_FRAME];
+  size_t _count;
+  uint32_t _events;
+  uint32_t _frames;
+  uint8_t _frame[RECORD_MAX_FRAME];
+};
+
+struct ReplayOptions {
+  bool zeroTracking;  // feed the idle samples to the zero tracker
+  int settleSamples;  // per step; -1 = as recorded
+};
+
+ReplayOptions recordedReplayOptions();
+
+struct ReplayRun {
+  RecordHeader header;
+  int steps;
+  SweepTotals totals;
+  float payloadKg;
+  bool completed;
+  uint32_t lostFrames;  // sequence gaps: the numbers are not trustworthy
+  uint32_t events;
+  uint64_t firstUs;     // device time of the first event, unwrapped
+  uint64_t durationUs;  // first to last event
+  RunningStats sampleIntervalUs;  // between readings of one step
+  RunningStats escToSampleUs;     // ESC command to the next reading
+};
+
+class ReplayListener {
+ public:
+  virtual ~ReplayListener() {}
+  virtual void runStarted(const RecordHeader& header) { (void)header; }
+  virtual void stepDone(int pwm, const StepPowerResult& step) = 0;
+  virtual void runEnded(const ReplayRun& run) = 0;
+};
+
+// Host side: decoded frames in, the sweep as the stand would have computed it
+// out. Events before the first header of a run are skipped.
+class ReplayEngine {
+ public:
+  ReplayEngine(const ReplayOptions& options, ReplayListener& listener);
+
+  // One decoded telemetry frame; frames that are not part of a record are ignored
+  void feed(uint8_t type, const uint8_t* payload, size_t length);
+
+  uint32_t runs() const { return _runs; }
+  uint32_t lostFrames() const { return _totalLost; }
+
+ private:
+  void beginRun(PayloadReader& in);
+  void loadTable(PayloadReader& in);
+  void event(const RecordEvent& e);
+  void trackSequence(uint16_t seq);
+
+  ReplayOptions _options;
+  ReplayListener& _listener;
+  bool _inRun;
+  uint16_t _nextSequence;
+  ReplayRun _run;
+  float _lutTable[CAL_LUT_SIZE];
+  CalibrationLut _lut;
+  LoadCellConverter _cell;
+  ZeroTracker _zero;
+  StepPowerAccumulator _power;
+  PowerReading _reading;
+  float _driftZeroKgPerC;
+  int _settle;
+  bool _inStep;
+  int _stepPwm;
+  int _stepSample;
+  bool _timed;
+  uint64_t _deviceUs;   // last event time, unwrapped
+  uint64_t _lastSampleUs;
+  uint64_t _escUs;
+  bool _escPending;
+  uint32_t _runs;
+  uint32_t _totalLost;
+};
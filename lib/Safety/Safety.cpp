@@ -0,0 +1,169 @@
+#include "Safety.h"
+
+#ifdef ESP32
+#include <esp_idf_version.h>
+#include <esp_task_wdt.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+const char* safetyFaultName(SafetyFault fault) {
+  switch (fault) {
+    case FAULT_NONE: return "none";
+    case FAULT_THRUST_LIMIT: return "thrust limit";
+    case FAULT_THRUST_RATE: return "thrust rate";
+    case FAULT_LOADCELL: return "load cell";
+    case FAULT_SAMPLE_TIMEOUT: return "sample timeout";
+    case FAULT_LOOP_STALL: return "loop stall";
+    case FAULT_HOST_LOST: return "host lost";
+    default: return "unknown";
+  }
+}
+
+SafetyLimits defaultSafetyLimits() {
+  SafetyLimits limits;
+  limits.maxThrustKg = 0.700f;     // ~1.3x the 5" setup at full throttle
+  limits.minThrustKg = -0.200f;
+  limits.maxRateKgPerS = 15.0f;    // spin-up is ~6 kg/s (80 ms to 0.5 kg)
+  limits.sampleTimeoutMs = 1500;   // waits feed every conversion; 10 SPS leaves 15 of margin
+  limits.loopTimeoutMs = 1500;
+  limits.hostTimeoutMs = 0;
+  limits.stuckSamples = 20;
+  return limits;
+}
+
+SafetySupervisor::SafetySupervisor(const SafetyLimits& limits, SafetyStopFn stop)
+    : _limits(limits), _stop(stop), _armed(false), _fault(FAULT_NONE), _faultValue(0.0f),
+      _havePrevious(false), _previousKg(0.0f), _previousUs(0), _previousRaw(0), _sameRaw(0),
+      _lastKg(0.0f), _lastSampleUs(0),
+      _lastLatencyUs(0), _worstLatencyUs(0), _trips(0), _checks(0) {
+  for (std::atomic<uint32_t>& beat : _beats) {
+    beat.store(0, std::memory_order_relaxed);
+  }
+}
+
+void SafetySupervisor::arm(uint32_t nowUs) {
+  if (armed()) {
+    return;
+  }
+  for (std::atomic<uint32_t>& beat : _beats) {
+    beat.store(nowUs, std::memory_order_relaxed);
+  }
+  _havePrevious = false;
+  _armed.store(true, std::memory_order_release);
+}
+
+void SafetySupervisor::sample(long raw, float thrustKg, uint32_t nowUs) {
+  heartbeat(HB_SAMPLE, nowUs);
+  _lastKg = thrustKg;
+  _lastSampleUs = nowUs;
+
+  // HX711 clips at the 24-bit limits; a dead or disturbed chip repeats itself
+  _sameRaw = raw == _previousRaw ? _sameRaw + 1 : 0;
+  _previousRaw = raw;
+  if (raw >= 0x7FFFFF || raw <= -0x800000 || _sameRaw >= _limits.stuckSamples) {
+    trip(FAULT_LOADCELL, (float)raw, nowUs, nowUs);
+    return;
+  }
+
+  if (thrustKg > _limits.maxThrustKg || thrustKg < _limits.minThrustKg) {
+    trip(FAULT_THRUST_LIMIT, thrustKg, nowUs, nowUs);
+    return;
+  }
+
+  if (_havePrevious && nowUs != _previousUs) {
+    float rate = (thrustKg - _previousKg) / ((nowUs - _previousUs) / 1000000.0f);
+    if (rate > _limits.maxRateKgPerS || rate < -_limits.maxRateKgPerS) {
+      trip(FAULT_THRUST_RATE, rate, nowUs, nowUs);
+      return;
+    }
+  }
+  _havePrevious = true;
+  _previousKg = thrustKg;
+  _previousUs = nowUs;
+}
+
+void SafetySupervisor::check(uint32_t nowUs) {
+  _checks++;
+  if (!armed() || tripped()) {
+    return;
+  }
+
+  const unsigned long timeoutsMs[HB_COUNT] = {_limits.loopTimeoutMs, _limits.sampleTimeoutMs, _limits.hostTimeoutMs};
+  const SafetyFault faults[HB_COUNT] = {FAULT_LOOP_STALL, FAULT_SAMPLE_TIMEOUT, FAULT_HOST_LOST};
+  for (int i = 0; i < HB_COUNT; i++) {
+    if (timeoutsMs[i] == 0) {
+      continue;
+    }
+    uint32_t deadlineUs = _beats[i].load(std::memory_order_acquire) + (uint32_t)(timeoutsMs[i] * 1000);
+    if ((int32_t)(nowUs - deadlineUs) >= 0) {
+      trip(faults[i], (nowUs - deadlineUs) / 1000.0f, deadlineUs, nowUs);
+      return;
+    }
+  }
+}
+
+void SafetySupervisor::trip(SafetyFault fault, float value, uint32_t onsetUs, uint32_t nowUs) {
+  // First fault wins; the stop is repeated regardless
+  uint8_t expected = FAULT_NONE;
+  if (_fault.compare_exchange_strong(expected, fault)) {
+    _faultValue = value;
+    _trips++;
+  }
+  if (_stop != nullptr) {
+    _stop();
+  }
+  _armed.store(false, std::memory_order_release);
+  _lastLatencyUs = nowUs - onsetUs;
+  if (_lastLatencyUs > _worstLatencyUs) {
+    _worstLatencyUs = _lastLatencyUs;
+  }
+}
+
+void SafetySupervisor::clear() {
+  _havePrevious = false;
+  _sameRaw = 0;
+  _fault.store(FAULT_NONE, std::memory_order_release);
+}
+
+#ifdef ESP32
+namespace {
+
+struct SupervisorContext {
+  SafetySupervisor* supervisor;
+  uint32_t periodMs;
+};
+
+SupervisorContext supervisorContext;
+
+void supervisorTask(void* param) {
+  SupervisorContext* ctx = (SupervisorContext*)param;
+  esp_task_wdt_add(nullptr);
+  TickType_t wake = xTaskGetTickCount();
+  while (true) {
+    ctx->supervisor->check(micros());
+    esp_task_wdt_reset();
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(ctx->periodMs));
+  }
+}
+
+}  // namespace
+
+bool startSafetySupervisor(SafetySupervisor& supervisor, uint32_t periodMs, uint32_t watchdogMs,
+                           uint8_t priority, int core) {
+  // Panic (reset) on timeout; if the core already started the watchdog, reconfigure it
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_task_wdt_config_t config = {watchdogMs, 0, true};
+  if (esp_task_wdt_reconfigure(&config) != ESP_OK) {
+    esp_task_wdt_init(&config);
+  }
+#else
+  esp_task_wdt_init((watchdogMs + 999) / 1000, true);
+#endif
+
+  supervisorContext.supervisor = &supervisor;
+  supervisorContext.periodMs = periodMs;
+  return xTaskCreatePinnedToCore(supervisorTask, "safety", 2048, &supervisorContext, priority,
+                                 nullptr, core) == pdPASS;
+}
+#endif
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP32
+#include <Arduino.h>
+#endif
+
+// Motor cutoff independent of the control loop. The acquisition and control
+// stages report samples and heartbeats; the supervisor (its own task on the
+// ESP32, called directly in native tests) trips on a limit or a missed
+// deadline and calls the stop function right away. Times are microseconds
+// from any clock (micros(), or a virtual one in tests); wrap-safe.
+
+enum SafetyFault : uint8_t {
+  FAULT_NONE,
+  FAULT_THRUST_LIMIT,    // above max, or below min (cell pulled the wrong way)
+  FAULT_THRUST_RATE,     // jump between samples faster than any spin-up
+  FAULT_LOADCELL,        // HX711 saturated or stuck on one value
+  FAULT_SAMPLE_TIMEOUT,  // no load-cell sample while the motor runs
+  FAULT_LOOP_STALL,      // control loop heartbeat missed
+  FAULT_HOST_LOST,       // no serial input from the host (when required)
+  FAULT_COUNT
+};
+
+const char* safetyFaultName(SafetyFault fault);
+
+enum HeartbeatSource : uint8_t {
+  HB_LOOP,
+  HB_SAMPLE,
+  HB_HOST,
+  HB_COUNT
+};
+
+struct SafetyLimits {
+  float maxThrustKg;
+  float minThrustKg;        // negative: pull in the wrong direction
+  float maxRateKgPerS;
+  unsigned long sampleTimeoutMs;
+  unsigned long loopTimeoutMs;
+  unsigned long hostTimeoutMs;  // 0 = no host required
+  uint16_t stuckSamples;    // identical raw readings in a row
+};
+
+SafetyLimits defaultSafetyLimits();
+
+typedef void (*SafetyStopFn)();
+
+class SafetySupervisor {
+ public:
+  // limits is read on every check, so changes (console) apply right away
+  SafetySupervisor(const SafetyLimits& limits, SafetyStopFn stop);
+
+  // Motor commanded to run: deadlines start now. Disarmed, only the sample
+  // limits apply (a stopped motor can still see a load-cell fault).
+  void arm(uint32_t nowUs);
+  void disarm() { _armed.store(false, std::memory_order_release); }
+  bool armed() const { return _armed.load(std::memory_order_acquire); }
+
+  void heartbeat(HeartbeatSource source, uint32_t nowUs) {
+    _beats[source].store(nowUs, std::memory_order_release);
+  }
+
+  // Every load-cell sample; limit and rate faults stop the motor from here
+  void sample(long raw, float thrustKg, uint32_t nowUs);
+
+  // Deadline checks, from the supervisor task every few ms
+  void check(uint32_t nowUs);
+
+  bool tripped() const { return _fault.load(std::memory_order_acquire) != FAULT_NONE; }
+  SafetyFault fault() const { return (SafetyFault)_fault.load(std::memory_order_acquire); }
+  float faultValue() const { return _faultValue; }  // kg, kg/s or ms late
+  // Operator acknowledged; a disarmed motor stays stopped until commanded again
+  void clear();
+
+  // Fault onset (sample time or missed deadline) to the stop call
+  uint32_t lastLatencyUs() const { return _lastLatencyUs; }
+  // Latest sample passed to sample(), whatever the outcome; 0 us before the first
+  float lastThrustKg() const { return _lastKg; }
+  uint32_t lastSampleUs() const { return _lastSampleUs; }
+  uint32_t worstLatencyUs() const { return _worstLatencyUs; }
+  uint32_t trips() const { return _trips; }
+  uint32_t checks() const { return _checks; }
+
+ private:
+  void trip(SafetyFault fault, float value, uint32_t onsetUs, uint32_t nowUs);
+
+  const SafetyLimits& _limits;
+  SafetyStopFn _stop;
+  std::atomic<bool> _armed;
+  std::atomic<uint32_t> _beats[HB_COUNT];
+  std::atomic<uint8_t> _fault;
+  float _faultValue;
+  bool _havePrevious;
+  float _previousKg;
+  uint32_t _previousUs;
+  long _previousRaw;
+  uint16_t _sameRaw;
+  float _lastKg;
+  uint32_t _lastSampleUs;
+  uint32_t _lastLatencyUs;
+  uint32_t _worstLatencyUs;
+  uint32_t _trips;
+  uint32_t _checks;
+};
+
+#ifdef ESP32
+// Runs supervisor.check() every periodMs at high priority, subscribed to the
+// task watchdog: if this task stops, the chip resets and the ESC loses its signal
+bool startSafetySupervisor(SafetySupervisor& supervisor, uint32_t periodMs, uint32_t watchdogMs,
+                           uint8_t priority, int core);
+#endif
@@ -0,0 +1,83 @@
+#include "SampleStats.h"
+
+#include <math.h>
+
+void RunningStats::reset() {
+  _count = 0;
+  _mean = 0.0f;
+  _m2 = 0.0f;
+  _min = 0.0f;
+  _max = 0.0f;
+}
+
+void RunningStats::add(float value) {
+  _count++;
+  if (_count == 1) {
+    _min = value;
+    _max = value;
+  } else {
+    if (value < _min) _min = value;
+    if (value > _max) _max = value;
+  }
+
+  float delta = value - _mean;
+  _mean += delta / _count;
+  _m2 += delta * (value - _mean);
+}
+
+float RunningStats::variance() const {
+  if (_count < 2) {
+    return 0.0f;
+  }
+  return _m2 / (_count - 1);
+}
+
+float RunningStats::stddev() const {
+  return sqrtf(variance());
+}
+
+void WindowStats::setLength(int length) {
+  _length = length < 1 ? 1 : (length > WINDOW_STATS_MAX ? WINDOW_STATS_MAX : length);
+  reset();
+}
+
+void WindowStats::reset() {
+  _count = 0;
+  _next = 0;
+  _total = 0;
+}
+
+void WindowStats::add(float value, uint32_t timeUs) {
+  _values[_next] = value;
+  _times[_next] = timeUs;
+  _next = (_next + 1) % _length;
+  if (_count < _length) {
+    _count++;
+  }
+  _total++;
+}
+
+WindowSummary WindowStats::summary() const {
+  WindowSummary s = {_count, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+  if (_count == 0) {
+    return s;
+  }
+  int newest = (_next + _length - 1) % _length;
+  int oldest = (_next + _length - _count) % _length;
+  s.last = _values[newest];
+  s.min = s.last;
+  s.max = s.last;
+  float sum = 0.0f;
+  for (int i = 0; i < _count; i++) {
+    float v = _values[(oldest + i) % _length];
+    sum += v;
+    if (v < s.min) s.min = v;
+    if (v > s.max) s.max = v;
+  }
+  s.mean = sum / _count;
+  uint32_t spanUs = _times[newest] - _times[oldest];
+  if (_count >= 2 && spanUs > 0) {
+    s.rateHz = (_count - 1) * 1000000.0f / spanUs;
+  }
+  return s;
+}
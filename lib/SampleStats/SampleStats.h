@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdint.h>
+
+// Streaming mean/min/max/stddev (Welford), constant memory per channel
+class RunningStats {
+ public:
+  RunningStats() { reset(); }
+
+  void reset();
+  void add(float value);
+
+  uint32_t count() const { return _count; }
+  float mean() const { return _mean; }
+  float min() const { return _min; }
+  float max() const { return _max; }
+  float variance() const;
+  float stddev() const;
+
+ private:
+  uint32_t _count;
+  float _mean;
+  float _m2;
+  float _min;
+  float _max;
+};
+
+const int WINDOW_STATS_MAX = 256;
+
+struct WindowSummary {
+  int count;
+  float mean;
+  float min;
+  float max;     // peak hold over the window
+  float last;
+  float rateHz;  // oldest to newest sample, 0 below two samples
+};
+
+// Mean/min/max over the latest N values (sliding window) with their times;
+// add() is O(1), summary() one pass over the window
+class WindowStats {
+ public:
+  WindowStats() : _length(WINDOW_STATS_MAX) { reset(); }
+
+  // 1..WINDOW_STATS_MAX, starts a new window
+  void setLength(int length);
+  int length() const { return _length; }
+
+  void reset();
+  void add(float value, uint32_t timeUs);
+
+  int count() const { return _count; }
+  uint32_t total() const { return _total; }  // since the last reset
+  WindowSummary summary() const;
+
+ private:
+  float _values[WINDOW_STATS_MAX];
+  uint32_t _times[WINDOW_STATS_MAX];
+  int _length;
+  int _count;
+  int _next;
+  uint32_t _total;
+};
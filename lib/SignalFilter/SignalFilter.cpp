@@ -0,0 +1,10 @@
+#include "SignalFilter.h"
+
+#include <math.h>
+
+float EmaFilter::alphaFor(float timeConstantS, float samplePeriodS) {
+  if (timeConstantS <= 0.0f) {
+    return 1.0f;
+  }
+  return 1.0f - expf(-samplePeriodS / timeConstantS);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// First-order low-pass (exponential moving average) for the load-cell signal
+class EmaFilter {
+ public:
+  explicit EmaFilter(float alpha) : _alpha(alpha), _value(0.0f), _primed(false) {}
+
+  // Time-constant form: alpha for a given sample period
+  static float alphaFor(float timeConstantS, float samplePeriodS);
+
+  void reset() { _primed = false; _value = 0.0f; }
+  void reset(float value) { _primed = true; _value = value; }
+  void setAlpha(float alpha) { _alpha = alpha; }
+
+  float update(float sample) {
+    if (!_primed) {
+      _value = sample;
+      _primed = true;
+    } else {
+      _value += _alpha * (sample - _value);
+    }
+    return _value;
+  }
+
+  float value() const { return _value; }
+
+ private:
+  float _alpha;
+  float _value;
+  bool _primed;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <stdint.h>
+
+#ifdef ESP32
+#include <sdkconfig.h>  // CONFIG_IDF_TARGET_*
+#endif
+
+// Stand variants as compile-time traits: board wiring and ESC endpoints are
+// types, the firmware and the bench tests read them from here, and every
+// conversion between throttle and pulse width folds to a constant. A wiring
+// or endpoint mistake stops the build instead of spinning the motor the
+// wrong way.
+
+// Chip a board's pin map is for; the GPIO checks below differ per chip
+enum BoardChip : uint8_t {
+  CHIP_ESP32,
+  CHIP_ESP32S3
+};
+
+// ESP32 DevKit wiring on the stand
+struct DevKitBoard {
+  static constexpr BoardChip CHIP = CHIP_ESP32;
+  static constexpr uint8_t ESC_PIN = 19;
+  static constexpr uint8_t POT_PIN = 34;      // ADC1_CH6
+  static constexpr uint8_t BUTTON_PIN = 4;
+  static constexpr uint8_t LOADCELL_DT_PIN = 18;
+  static constexpr uint8_t LOADCELL_SCK_PIN = 23;
+  static constexpr uint8_t VOLTAGE_PIN = 35;  // ADC1_CH7, only with POWER_SENSOR_ADC
+  static constexpr uint8_t CURRENT_PIN = 32;  // ADC1_CH4, only with POWER_SENSOR_ADC
+  static constexpr uint8_t TEMP_PIN = 33;     // ADC1_CH5, only with TEMP_SENSOR_NTC
+  static constexpr int ADC_MAX = 4095;        // 12-bit analogRead()
+};
+
+// ESP32-S3 DevKitM-1 wiring (-DSTAND_BOARD_S3): ADC1 is GPIO 1-10 there, and
+// 19/20 (USB), 26-37 (flash, octal PSRAM) and the strapping pins stay free
+struct S3DevKitBoard {
+  static constexpr BoardChip CHIP = CHIP_ESP32S3;
+  static constexpr uint8_t ESC_PIN = 17;
+  static constexpr uint8_t POT_PIN = 4;       // ADC1_CH3
+  static constexpr uint8_t BUTTON_PIN = 21;
+  static constexpr uint8_t LOADCELL_DT_PIN = 16;
+  static constexpr uint8_t LOADCELL_SCK_PIN = 15;
+  static constexpr uint8_t VOLTAGE_PIN = 5;   // ADC1_CH4, only with POWER_SENSOR_ADC
+  static constexpr uint8_t CURRENT_PIN = 6;   // ADC1_CH5, only with POWER_SENSOR_ADC
+  static constexpr uint8_t TEMP_PIN = 7;      // ADC1_CH6, only with TEMP_SENSOR_NTC
+  static constexpr int ADC_MAX = 4095;        // 12-bit analogRead()
+};
+
+// The stand's ESC: reversed, a shorter pulse spins faster. Arming and stop
+// sit a little past the slow end.
+struct ReversedStandEsc {
+  static constexpr int FAST_PWM = 1200;   // Full throttle
+  static constexpr int SLOW_PWM = 1340;   // Slowest, prop still
+  static constexpr int STOP_PWM = 1360;   // Arming value, motor stopped
+  static constexpr int ATTACH_MIN_US = 1000;  // Servo pulse limits
+  static constexpr int ATTACH_MAX_US = 2000;
+};
+
+// Pin and rounding checks, one return statement each so they stay constant
+// expressions on the C++11 ESP32 toolchain
+constexpr bool gpioInputOnly(BoardChip chip, int pin) {
+  return chip == CHIP_ESP32 && pin >= 34 && pin <= 39;  // the S3 has none
+}
+
+// ADC2 is taken by the radio
+constexpr bool gpioAdc1(BoardChip chip, int pin) {
+  return chip == CHIP_ESP32 ? pin >= 32 && pin <= 39 : pin >= 1 && pin <= 10;
+}
+
+// Pins the module or USB already uses
+constexpr bool gpioReserved(BoardChip chip, int pin) {
+  return chip == CHIP_ESP32 ? pin >= 6 && pin <= 11
+                            : pin == 19 || pin == 20 || (pin >= 26 && pin <= 37);
+}
+
+constexpr bool pinDiffers(int) {
+  return true;
+}
+
+template <typename... Rest>
+constexpr bool pinDiffers(int pin, int next, Rest... rest) {
+  return pin != next && pinDiffers(pin, rest...);
+}
+
+constexpr bool pinsDistinct() {
+  return true;
+}
+
+template <typename... Rest>
+constexpr bool pinsDistinct(int first, Rest... rest) {
+  return pinDiffers(first, rest...) && pinsDistinct(rest...);
+}
+
+constexpr int roundHalfAway(float x) {
+  return x >= 0.0f ? (int)(x + 0.5f) : -(int)(-x + 0.5f);
+}
+
+// ESC endpoints known at run time (discovered per ESC). Works for either
+// direction: throttle 0 is slowPwm, 1 is fastPwm.
+struct EscRange {
+  int fastPwm;
+  int slowPwm;
+  int stopPwm;
+
+  constexpr bool inverted() const { return fastPwm < slowPwm; }
+
+  // Inside the usable range (either end included)
+  constexpr bool contains(int pwm) const {
+    return inverted() ? pwm >= fastPwm && pwm <= slowPwm : pwm <= fastPwm && pwm >= slowPwm;
+  }
+
+  // At the slow end or beyond it: the prop is still
+  constexpr bool stopped(int pwm) const {
+    return inverted() ? pwm >= slowPwm : pwm <= slowPwm;
+  }
+
+  // 0..1, rounded like lroundf()
+  constexpr int pwmFromThrottle(float throttle) const {
+    return slowPwm + roundHalfAway(throttle * (fastPwm - slowPwm));
+  }
+
+  constexpr float throttleFromPwm(int pwm) const {
+    return (float)(pwm - slowPwm) / (fastPwm - slowPwm);
+  }
+
+  // Truncated like Arduino map(pwm, slow, fast, 0, 100)
+  constexpr int percentFromPwm(int pwm) const {
+    return (pwm - slowPwm) * 100 / (fastPwm - slowPwm);
+  }
+
+  // Pot at 0 is full throttle; map(raw, 0, adcMax, fast, slow)
+  constexpr int pwmFromPot(int raw, int adcMax) const {
+    return fastPwm + (int)((long)raw * (slowPwm - fastPwm) / adcMax);
+  }
+};
+
+// Wiring checks, run when the board type is first used
+template <typename Board>
+struct BoardTraits : Board {
+  static_assert(pinsDistinct(Board::ESC_PIN, Board::POT_PIN, Board::BUTTON_PIN,
+                             Board::LOADCELL_DT_PIN, Board::LOADCELL_SCK_PIN, Board::VOLTAGE_PIN,
+                             Board::CURRENT_PIN, Board::TEMP_PIN),
+                "board: two signals on one pin");
+  static_assert(!gpioInputOnly(Board::CHIP, Board::ESC_PIN) &&
+                    !gpioInputOnly(Board::CHIP, Board::LOADCELL_SCK_PIN),
+                "board: output on an input-only GPIO");
+  static_assert(gpioAdc1(Board::CHIP, Board::POT_PIN) && gpioAdc1(Board::CHIP, Board::VOLTAGE_PIN) &&
+                    gpioAdc1(Board::CHIP, Board::CURRENT_PIN) && gpioAdc1(Board::CHIP, Board::TEMP_PIN),
+                "board: analog input off ADC1");
+  static_assert(!gpioReserved(Board::CHIP, Board::ESC_PIN) &&
+                    !gpioReserved(Board::CHIP, Board::POT_PIN) && !gpioReserved(Board::CHIP, Board::BUTTON_PIN) &&
+                    !gpioReserved(Board::CHIP, Board::LOADCELL_DT_PIN) &&
+                    !gpioReserved(Board::CHIP, Board::LOADCELL_SCK_PIN) &&
+                    !gpioReserved(Board::CHIP, Board::VOLTAGE_PIN) &&
+                    !gpioReserved(Board::CHIP, Board::CURRENT_PIN) && !gpioReserved(Board::CHIP, Board::TEMP_PIN),
+                "board: signal on a flash, PSRAM or USB pin");
+#if defined(CONFIG_IDF_TARGET_ESP32)
+  static_assert(Board::CHIP == CHIP_ESP32, "board: pin map is not for the classic ESP32");
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+  static_assert(Board::CHIP == CHIP_ESP32S3, "board: pin map is not for the ESP32-S3");
+#endif
+};
+
+// Polarity, span and the throttle <-> pulse conversions of one ESC, checked
+// at compile time; the conversions are EscRange's on the fixed endpoints
+template <typename Esc>
+struct EscTraits : Esc {
+  static constexpr bool INVERTED = Esc::FAST_PWM < Esc::SLOW_PWM;
+  static constexpr int SPAN = INVERTED ? Esc::SLOW_PWM - Esc::FAST_PWM : Esc::FAST_PWM - Esc::SLOW_PWM;
+
+  static_assert(SPAN > 0, "esc: fast and slow ends are the same pulse");
+  static_assert(Esc::ATTACH_MIN_US <= Esc::FAST_PWM && Esc::FAST_PWM <= Esc::ATTACH_MAX_US &&
+                    Esc::ATTACH_MIN_US <= Esc::SLOW_PWM && Esc::SLOW_PWM <= Esc::ATTACH_MAX_US &&
+                    Esc::ATTACH_MIN_US <= Esc::STOP_PWM && Esc::STOP_PWM <= Esc::ATTACH_MAX_US,
+                "esc: endpoint outside the servo pulse limits");
+  static_assert(INVERTED ? Esc::STOP_PWM >= Esc::SLOW_PWM : Esc::STOP_PWM <= Esc::SLOW_PWM,
+                "esc: stop value on the spinning side of the slow end");
+
+  static constexpr EscRange range() { return {Esc::FAST_PWM, Esc::SLOW_PWM, Esc::STOP_PWM}; }
+
+  static constexpr bool contains(int pwm) { return range().contains(pwm); }
+  static constexpr bool stopped(int pwm) { return range().stopped(pwm); }
+  static constexpr int pwmFromThrottle(float throttle) { return range().pwmFromThrottle(throttle); }
+  static constexpr float throttleFromPwm(int pwm) { return range().throttleFromPwm(pwm); }
+  static constexpr int percentFromPwm(int pwm) { return range().percentFromPwm(pwm); }
+  static constexpr int pwmFromPot(int raw, int adcMax) { return range().pwmFromPot(raw, adcMax); }
+};
+
+// The variant this build is for; a second stand adds its structs above and
+// picks them here under its own build flag. An ESP32 target without a pin
+// map stops the build rather than running the classic one.
+#if defined(ESP32) && !defined(CONFIG_IDF_TARGET_ESP32) && !defined(CONFIG_IDF_TARGET_ESP32S3)
+#error "StandConfig.h: no board trait for this ESP32 target"
+#endif
+#ifdef STAND_BOARD_S3
+typedef BoardTraits<S3DevKitBoard> StandBoard;
+#else
+typedef BoardTraits<DevKitBoard> StandBoard;
+#endif
+typedef EscTraits<ReversedStandEsc> StandEsc;
+
+static_assert(StandEsc::percentFromPwm(StandEsc::FAST_PWM) == 100 &&
+                  StandEsc::percentFromPwm(StandEsc::SLOW_PWM) == 0,
+              "esc: throttle percent endpoints");
+static_assert(StandEsc::pwmFromThrottle(1.0f) == StandEsc::FAST_PWM &&
+                  StandEsc::pwmFromThrottle(0.0f) == StandEsc::SLOW_PWM,
+              "esc: throttle endpoints");
+static_assert(StandEsc::pwmFromPot(0, StandBoard::ADC_MAX) == StandEsc::FAST_PWM &&
+                  StandEsc::pwmFromPot(StandBoard::ADC_MAX, StandBoard::ADC_MAX) == StandEsc::SLOW_PWM,
+              "esc: pot travel spans the range");
@@ -0,0 +1,246 @@
+#include "StandSim.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "StandConfig.h"
+
+float SimNoise::next(float amplitude) {
+  // xorshift32
+  _state ^= _state << 13;
+  _state ^= _state >> 17;
+  _state ^= _state << 5;
+  float unit = (_state & 0xFFFFFF) / (float)0xFFFFFF;  // 0..1
+  return (unit * 2.0f - 1.0f) * amplitude;
+}
+
+MotorModelConfig defaultMotorModelConfig() {
+  // Roughly the 5" motor/prop on the stand: ~0.46 kg at 1210 us
+  MotorModelConfig c;
+  c.stopPwm = StandEsc::SLOW_PWM;
+  c.startPwm = 0;
+  c.fullPwm = StandEsc::FAST_PWM;
+  c.idleThrottle = 0.0f;
+  c.maxThrustKg = 0.520f;
+  c.timeConstantS = 0.080f;
+  c.idleCurrentA = 0.30f;
+  c.currentPerKgA = 38.0f;
+  c.batteryV = 16.8f;
+  c.batteryOhms = 0.045f;
+  return c;
+}
+
+MotorModel::MotorModel(const MotorModelConfig& config)
+    : _config(config), _pwm(config.stopPwm), _spinning(false), _thrustKg(0.0f) {}
+
+void MotorModel::setPwm(int pwmUs) {
+  _pwm = pwmUs;
+  int startPwm = _config.startPwm > 0 ? _config.startPwm : _config.stopPwm;
+  if (_pwm >= _config.stopPwm) {
+    _spinning = false;
+  } else if (_pwm < startPwm) {
+    _spinning = true;
+  }
+}
+
+float MotorModel::throttle() const {
+  // Inverted ESC: lower PWM = faster
+  float span = (float)(_config.stopPwm - _config.fullPwm);
+  if (!_spinning) return 0.0f;
+  float t = (_config.stopPwm - _pwm) / span;
+  if (t < _config.idleThrottle) return _config.idleThrottle;
+  if (t > 1.0f) return 1.0f;
+  return t;
+}
+
+float MotorModel::steadyThrustKg() const {
+  // Static thrust grows with RPM^2, RPM roughly linear in throttle
+  float t = throttle();
+  return _config.maxThrustKg * t * t;
+}
+
+void MotorModel::update(float dtS) {
+  float target = steadyThrustKg();
+  if (_config.timeConstantS <= 0.0f) {
+    _thrustKg = target;
+    return;
+  }
+  float alpha = 1.0f - expf(-dtS / _config.timeConstantS);
+  _thrustKg += (target - _thrustKg) * alpha;
+}
+
+float MotorModel::currentA() const {
+  if (_pwm >= _config.stopPwm) {
+    return 0.0f;
+  }
+  float t = _thrustKg > 0.0f ? _thrustKg : 0.0f;
+  return _config.idleCurrentA + _config.currentPerKgA * t * sqrtf(t);
+}
+
+float MotorModel::voltageV() const {
+  return _config.batteryV - currentA() * _config.batteryOhms;
+}
+
+SimPowerSensor::SimPowerSensor(const MotorModel& motor, float noiseA, uint32_t seed)
+    : _motor(motor), _noiseA(noiseA), _noise(seed) {}
+
+bool SimPowerSensor::read(PowerReading& out) {
+  out.voltageV = _motor.voltageV();
+  out.currentA = _motor.currentA() + _noise.next(_noiseA);
+  if (out.currentA < 0.0f) {
+    out.currentA = 0.0f;
+  }
+  out.powerW = out.voltageV * out.currentA;
+  return true;
+}
+
+SimLoadCell::SimLoadCell(const MotorModel& motor, long offset, float countsPerKg,
+                         float noiseKg, uint32_t seed)
+    : _motor(motor), _offset(offset), _countsPerKg(countsPerKg),
+      _noiseKg(noiseKg), _driftKg(0.0f), _noise(seed) {}
+
+long SimLoadCell::readRaw() {
+  return _offset + lroundf(readKg() * _countsPerKg);
+}
+
+float SimLoadCell::readKg() {
+  return _motor.thrustKg() + _driftKg + _noise.next(_noiseKg);
+}
+
+FakeI2cPort::FakeI2cPort() : _deviceCount(0), _clockHz(100000), _nowUs(0), _logCount(0) {}
+
+FakeI2cPort::Device* FakeI2cPort::find(uint8_t address) {
+  for (size_t i = 0; i < _deviceCount; i++) {
+    if (_devices[i].address == address) {
+      return &_devices[i];
+    }
+  }
+  return nullptr;
+}
+
+const FakeI2cPort::Device* FakeI2cPort::find(uint8_t address) const {
+  for (size_t i = 0; i < _deviceCount; i++) {
+    if (_devices[i].address == address) {
+      return &_devices[i];
+    }
+  }
+  return nullptr;
+}
+
+FakeI2cPort::Device* FakeI2cPort::add(uint8_t address) {
+  if (_deviceCount >= MAX_DEVICES) {
+    return nullptr;
+  }
+  Device& d = _devices[_deviceCount++];
+  memset(&d, 0, sizeof(d));
+  d.address = address;
+  return &d;
+}
+
+void FakeI2cPort::addRegisterDevice(uint8_t address, uint8_t registerBytes) {
+  Device* d = add(address);
+  if (d != nullptr) {
+    d->registerBytes = registerBytes;
+  }
+}
+
+void FakeI2cPort::setRegister(uint8_t address, uint8_t reg, uint16_t value) {
+  Device* d = find(address);
+  if (d == nullptr || (size_t)(reg + 1) * d->registerBytes > sizeof(d->memory)) {
+    return;
+  }
+  uint8_t* at = d->memory + reg * d->registerBytes;
+  if (d->registerBytes == 2) {
+    at[0] = (uint8_t)(value >> 8);
+    at[1] = (uint8_t)value;
+  } else {
+    at[0] = (uint8_t)value;
+  }
+}
+
+uint16_t FakeI2cPort::registerValue(uint8_t address, uint8_t reg) const {
+  const Device* d = find(address);
+  if (d == nullptr || (size_t)(reg + 1) * d->registerBytes > sizeof(d->memory)) {
+    return 0;
+  }
+  const uint8_t* at = d->memory + reg * d->registerBytes;
+  return d->registerBytes == 2 ? (uint16_t)((at[0] << 8) | at[1]) : at[0];
+}
+
+void FakeI2cPort::addLcd(uint8_t address) {
+  Device* d = add(address);
+  if (d != nullptr) {
+    d->lcd = true;
+    d->highNibble = true;
+    memset(d->memory, ' ', sizeof(d->memory));
+  }
+}
+
+void FakeI2cPort::lcdRow(uint8_t row, char* out) const {
+  static const uint8_t ROW_OFFSETS[4] = {0x00, 0x40, 0x14, 0x54};
+  const Device* d = nullptr;
+  for (size_t i = 0; i < _deviceCount && d == nullptr; i++) {
+    if (_devices[i].lcd) d = &_devices[i];
+  }
+  for (uint8_t c = 0; c < 20; c++) {
+    out[c] = (d != nullptr && row < 4) ? (char)d->memory[ROW_OFFSETS[row] + c] : ' ';
+  }
+  out[20] = '\0';
+}
+
+// PCF8574 pins: P0 RS, P2 E, P4..P7 D4..D7; a nibble latches as E falls
+void FakeI2cPort::lcdWrite(Device& d, uint8_t value) {
+  bool falling = (d.lastWrite & 0x04) != 0 && (value & 0x04) == 0;
+  if (falling) {
+    uint8_t nibble = d.lastWrite >> 4;
+    if (d.highNibble) {
+      d.partial = (uint8_t)(nibble << 4);
+      d.highNibble = false;
+    } else {
+      uint8_t byte = d.partial | nibble;
+      d.highNibble = true;
+      if (d.lastWrite & 0x01) {
+        if (d.cursor < sizeof(d.memory)) d.memory[d.cursor++] = byte;
+      } else if (byte & 0x80) {
+        d.cursor = byte & 0x7F;
+      }
+    }
+  }
+  d.lastWrite = value;
+}
+
+bool FakeI2cPort::transfer(uint8_t address, const uint8_t* tx, size_t txLength,
+                           uint8_t* rx, size_t rxLength) {
+  uint32_t startUs = _nowUs;
+  size_t bits = 2 + 9 * (1 + txLength);
+  if (rxLength > 0) {
+    bits += 1 + 9 * (1 + rxLength);
+  }
+  _nowUs += (uint32_t)((bits * 1000000ull + _clockHz - 1) / _clockHz);
+
+  Device* d = find(address);
+  bool ok = d != nullptr;
+  if (ok && d->lcd) {
+    for (size_t i = 0; i < txLength; i++) {
+      lcdWrite(*d, tx[i]);
+    }
+    ok = rxLength == 0;
+  } else if (ok) {
+    if (txLength > 0) {
+      d->pointer = tx[0];
+    }
+    size_t at = (size_t)d->pointer * d->registerBytes;
+    for (size_t i = 1; i < txLength && at < sizeof(d->memory); i++) {
+      d->memory[at++] = tx[i];
+    }
+    at = (size_t)d->pointer * d->registerBytes;
+    for (size_t i = 0; i < rxLength; i++) {
+      rx[i] = at < sizeof(d->memory) ? d->memory[at++] : 0xFF;
+    }
+  }
+
+  if (_logCount < LOG_SIZE) {
+    _log[_logCount++] = {address, startUs, _nowUs, ok};
+  }
+  return ok;
+}
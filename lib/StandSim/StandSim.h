@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "I2cBus.h"
+#include "PowerMonitor.h"
+
+// Deterministic noise source so simulated runs are repeatable
+class SimNoise {
+ public:
+  explicit SimNoise(uint32_t seed = 0x12345678u) : _state(seed) {}
+
+  // Uniform in [-amplitude, +amplitude]
+  float next(float amplitude);
+
+ private:
+  uint32_t _state;
+};
+
+// Motor + prop + battery model driven by an inverted ESC
+struct MotorModelConfig {
+  int stopPwm;          // us, no thrust at or above this value
+  int startPwm;         // us, spins up from rest below this value (0 = stopPwm)
+  int fullPwm;          // us, full throttle at or below this value
+  float idleThrottle;   // least throttle while turning (ESC idle), 0 = none
+  float maxThrustKg;    // steady-state thrust at full throttle
+  float timeConstantS;  // first-order spin-up lag
+  float idleCurrentA;   // ESC + motor current at zero thrust
+  float currentPerKgA;  // current scale: I = idle + k * T^1.5
+  float batteryV;       // open-circuit pack voltage
+  float batteryOhms;    // pack + wiring resistance (voltage sag)
+};
+
+MotorModelConfig defaultMotorModelConfig();
+
+class MotorModel {
+ public:
+  explicit MotorModel(const MotorModelConfig& config);
+
+  // A running motor keeps turning down to stopPwm, one at rest needs startPwm
+  void setPwm(int pwmUs);
+  int pwm() const { return _pwm; }
+
+  // Advance the model by dtS seconds
+  void update(float dtS);
+
+  float throttle() const;
+  float steadyThrustKg() const;
+  float thrustKg() const { return _thrustKg; }
+  float currentA() const;
+  float voltageV() const;
+
+  const MotorModelConfig& config() const { return _config; }
+
+ private:
+  MotorModelConfig _config;
+  int _pwm;
+  bool _spinning;
+  float _thrustKg;
+};
+
+// PowerSensor backend reading the simulated motor supply
+class SimPowerSensor : public PowerSensor {
+ public:
+  SimPowerSensor(const MotorModel& motor, float noiseA, uint32_t seed = 1);
+
+  bool begin() override { return true; }
+  bool read(PowerReading& out) override;
+
+ private:
+  const MotorModel& _motor;
+  float _noiseA;
+  SimNoise _noise;
+};
+
+// HX711 + load cell on the simulated motor (raw counts and kg)
+class SimLoadCell {
+ public:
+  SimLoadCell(const MotorModel& motor, long offset, float countsPerKg,
+              float noiseKg, uint32_t seed = 2);
+
+  long readRaw();
+  float readKg();
+
+  // Zero drift on top of the thrust (creep, heating)
+  void setDriftKg(float kg) { _driftKg = kg; }
+
+  long offset() const { return _offset; }
+  float countsPerKg() const { return _countsPerKg; }
+
+ private:
+  const MotorModel& _motor;
+  long _offset;
+  float _countsPerKg;
+  float _noiseKg;
+  float _driftKg;
+  SimNoise _noise;
+};
+
+// Native I2C bus on a virtual clock. Each transfer advances the clock by its
+// bit time at the set clock (9 bits per byte incl. address, start/stop) and
+// is logged. Register devices answer reads from the pointer written first;
+// an LCD device decodes the PCF8574/HD44780 nibble stream into DDRAM.
+// Addresses with no device NACK.
+class FakeI2cPort : public I2cPort {
+ public:
+  static const size_t MAX_DEVICES = 4;
+  static const size_t LOG_SIZE = 512;
+
+  struct Transfer {
+    uint8_t address;
+    uint32_t startUs;
+    uint32_t endUs;
+    bool ok;
+  };
+
+  FakeI2cPort();
+
+  void setClock(uint32_t hz) override { _clockHz = hz; }
+  bool transfer(uint8_t address, const uint8_t* tx, size_t txLength,
+                uint8_t* rx, size_t rxLength) override;
+  uint32_t nowUs() override { return _nowUs; }
+
+  void advanceUs(uint32_t us) { _nowUs += us; }
+  uint32_t clockHz() const { return _clockHz; }
+
+  // 8- or 16-bit registers, big-endian
+  void addRegisterDevice(uint8_t address, uint8_t registerBytes);
+  void setRegister(uint8_t address, uint8_t reg, uint16_t value);
+  uint16_t registerValue(uint8_t address, uint8_t reg) const;
+
+  void addLcd(uint8_t address);
+  // One row as shown (20 characters + terminator)
+  void lcdRow(uint8_t row, char* out) const;
+
+  // Oldest first; the log stops when full
+  size_t transfers() const { return _logCount; }
+  const Transfer& transferAt(size_t i) const { return _log[i]; }
+  void clearLog() { _logCount = 0; }
+
+ private:
+  struct Device {
+    uint8_t address;
+    bool lcd;
+    uint8_t registerBytes;
+    uint8_t pointer;
+    uint8_t memory[128];  // registers, or HD44780 DDRAM
+    // LCD decoder state
+    uint8_t lastWrite;
+    bool highNibble;  // next latched nibble is the high one
+    uint8_t partial;
+    uint8_t cursor;
+  };
+
+  Device* find(uint8_t address);
+  const Device* find(uint8_t address) const;
+  Device* add(uint8_t address);
+  void lcdWrite(Device& d, uint8_t value);
+
+  Device _devices[MAX_DEVICES];
+  size_t _deviceCount;
+  uint32_t _clockHz;
+  uint32_t _nowUs;
+  Transfer _log[LOG_SIZE];
+  size_t _logCount;
+};
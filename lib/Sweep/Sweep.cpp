@@ -0,0 +1,67 @@
+#include "Sweep.h"
+
+void SweepStepper::begin(const SweepConfig& config) {
+  _config = config;
+  if (_config.stepPwm <= 0) {
+    _config.stepPwm = 1;
+  }
+  _pointsPerPhase = (_config.slowPwm - _config.fastPwm) / _config.stepPwm + 1;
+  if (_pointsPerPhase < 1) {
+    _pointsPerPhase = 1;
+  }
+  _total = _config.returnSweep ? _pointsPerPhase * 2 : _pointsPerPhase;
+  _index = 0;
+}
+
+bool SweepStepper::next(SweepPoint& point) {
+  if (done()) {
+    return false;
+  }
+
+  int phaseIndex = _index % _pointsPerPhase;
+  point.phase = _index < _pointsPerPhase ? SWEEP_SPEEDING_UP : SWEEP_SLOWING_DOWN;
+  point.phaseStart = phaseIndex == 0;
+
+  int offset = phaseIndex * _config.stepPwm;
+  if (point.phase == SWEEP_SPEEDING_UP) {
+    point.pwm = _config.slowPwm - offset;
+  } else {
+    // Slowing down starts from the last point actually reached on the way down
+    int lowest = _config.slowPwm - (_pointsPerPhase - 1) * _config.stepPwm;
+    point.pwm = lowest + offset;
+  }
+
+  int span = _config.slowPwm - _config.fastPwm;
+  point.throttlePercent = span > 0 ? (_config.slowPwm - point.pwm) * 100 / span : 0;
+  point.progressPercent = _total > 1 ? _index * 100 / (_total - 1) : 100;
+  point.index = _index;
+
+  _index++;
+  return true;
+}
+
+void SweepTotals::reset() {
+  maxThrustKg = 0.0f;
+  bestEfficiencyGPerW = 0.0f;
+  bestEfficiencyPwm = 0;
+  maxPowerW = 0.0f;
+}
+
+void SweepTotals::add(int pwm, const StepPowerResult& step) {
+  if (step.thrustKg > maxThrustKg) {
+    maxThrustKg = step.thrustKg;
+  }
+  if (step.efficiencyGPerW > bestEfficiencyGPerW) {
+    bestEfficiencyGPerW = step.efficiencyGPerW;
+    bestEfficiencyPwm = pwm;
+  }
+  if (step.powerW > maxPowerW) {
+    maxPowerW = step.powerW;
+  }
+}
+
+float payloadCapacityKg(float singleMotorThrustKg, const PayloadModel& model) {
+  float totalThrust = singleMotorThrustKg * model.motors;
+  float maxTotalWeight = totalThrust / model.thrustToWeightRatio;
+  return maxTotalWeight - model.droneWeightKg;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdint.h>
+#include "PowerMonitor.h"
+
+// PWM sweep on an inverted ESC: from the slow end down to the fast end (speeding up),
+// then optionally back up (slowing down). Both ends are measured in each phase.
+struct SweepConfig {
+  int slowPwm;   // start/end of the sweep (e.g. MAX_PWM_ALGO)
+  int fastPwm;   // turning point (e.g. MIN_PWM_ALGO)
+  int stepPwm;
+  bool returnSweep;
+  int rampUsPerS;  // 0 = hold each step; else a continuous ramp through the points
+};
+
+enum SweepPhase : uint8_t {
+  SWEEP_SPEEDING_UP,
+  SWEEP_SLOWING_DOWN
+};
+
+struct SweepPoint {
+  int pwm;
+  int index;            // 0..totalSteps-1
+  int throttlePercent;  // 0 at slowPwm, 100 at fastPwm
+  int progressPercent;  // 0 at the first point, 100 at the last
+  SweepPhase phase;
+  bool phaseStart;      // first point of its phase
+};
+
+class SweepStepper {
+ public:
+  SweepStepper() : _index(0), _total(0), _pointsPerPhase(0) {}
+
+  void begin(const SweepConfig& config);
+  bool next(SweepPoint& point);
+
+  bool done() const { return _index >= _total; }
+  int totalSteps() const { return _total; }
+  int index() const { return _index; }
+  const SweepConfig& config() const { return _config; }
+
+  // Resume after a restart (e.g. from a checkpoint)
+  void seek(int index) { _index = index < _total ? index : _total; }
+
+ private:
+  SweepConfig _config;
+  int _index;
+  int _total;
+  int _pointsPerPhase;
+};
+
+// Best values over the steps of one sweep
+struct SweepTotals {
+  float maxThrustKg;
+  float bestEfficiencyGPerW;
+  int bestEfficiencyPwm;
+  float maxPowerW;
+
+  void reset();
+  void add(int pwm, const StepPowerResult& step);
+};
+
+struct PayloadModel {
+  float droneWeightKg;
+  int motors;
+  float thrustToWeightRatio;
+};
+
+// Payload the drone can carry at the given thrust-to-weight ratio
+float payloadCapacityKg(float singleMotorThrustKg, const PayloadModel& model);
@@ -0,0 +1,176 @@
+#include "Telemetry.h"
+
+#include <string.h>
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t length, uint16_t crc) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= (uint16_t)data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t encodeTelemetryFrame(uint8_t type, const uint8_t* payload, size_t length,
+                            uint8_t* out, size_t outCapacity) {
+  size_t frameSize = TELEMETRY_HEADER_SIZE + length + TELEMETRY_CRC_SIZE;
+  if (length > TELEMETRY_MAX_PAYLOAD || frameSize > outCapacity) {
+    return 0;
+  }
+
+  out[0] = TELEMETRY_SYNC_1;
+  out[1] = TELEMETRY_SYNC_2;
+  out[2] = type;
+  out[3] = (uint8_t)(length & 0xFF);
+  out[4] = (uint8_t)(length >> 8);
+  if (length > 0) {
+    memcpy(out + TELEMETRY_HEADER_SIZE, payload, length);
+  }
+
+  uint16_t crc = crc16Ccitt(out + 2, 3 + length);
+  out[TELEMETRY_HEADER_SIZE + length] = (uint8_t)(crc & 0xFF);
+  out[TELEMETRY_HEADER_SIZE + length + 1] = (uint8_t)(crc >> 8);
+  return frameSize;
+}
+
+void PayloadWriter::putU8(uint8_t value) {
+  if (_length + 1 > _capacity) {
+    _overflow = true;
+    return;
+  }
+  _buffer[_length++] = value;
+}
+
+void PayloadWriter::putU16(uint16_t value) {
+  putU8((uint8_t)(value & 0xFF));
+  putU8((uint8_t)(value >> 8));
+}
+
+void PayloadWriter::putU32(uint32_t value) {
+  putU16((uint16_t)(value & 0xFFFF));
+  putU16((uint16_t)(value >> 16));
+}
+
+void PayloadWriter::putU64(uint64_t value) {
+  putU32((uint32_t)(value & 0xFFFFFFFF));
+  putU32((uint32_t)(value >> 32));
+}
+
+void PayloadWriter::putF32(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putU32(bits);
+}
+
+uint8_t PayloadReader::getU8() {
+  if (_pos + 1 > _length) {
+    _underflow = true;
+    return 0;
+  }
+  return _buffer[_pos++];
+}
+
+uint16_t PayloadReader::getU16() {
+  uint16_t lo = getU8();
+  uint16_t hi = getU8();
+  return (uint16_t)(lo | (hi << 8));
+}
+
+uint32_t PayloadReader::getU32() {
+  uint32_t lo = getU16();
+  uint32_t hi = getU16();
+  return lo | (hi << 16);
+}
+
+uint64_t PayloadReader::getU64() {
+  uint64_t lo = getU32();
+  uint64_t hi = getU32();
+  return lo | (hi << 32);
+}
+
+float PayloadReader::getF32() {
+  uint32_t bits = getU32();
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void TelemetryDecoder::reset() {
+  _state = WAIT_SYNC_1;
+  _type = 0;
+  _length = 0;
+  _received = 0;
+  _crc = 0;
+  _crcErrors = 0;
+  _skippedBytes = 0;
+}
+
+bool TelemetryDecoder::feed(uint8_t byte) {
+  switch (_state) {
+    case WAIT_SYNC_1:
+      if (byte == TELEMETRY_SYNC_1) {
+        _state = WAIT_SYNC_2;
+      } else {
+        _skippedBytes++;
+      }
+      return false;
+
+    case WAIT_SYNC_2:
+      if (byte == TELEMETRY_SYNC_2) {
+        _state = READ_TYPE;
+      } else {
+        _skippedBytes += 2;
+        _state = (byte == TELEMETRY_SYNC_1) ? WAIT_SYNC_2 : WAIT_SYNC_1;
+      }
+      return false;
+
+    case READ_TYPE:
+      _type = byte;
+      _state = READ_LEN_LO;
+      return false;
+
+    case READ_LEN_LO:
+      _length = byte;
+      _state = READ_LEN_HI;
+      return false;
+
+    case READ_LEN_HI:
+      _length |= (uint16_t)byte << 8;
+      _received = 0;
+      if (_length > TELEMETRY_MAX_PAYLOAD) {
+        _crcErrors++;
+        _state = WAIT_SYNC_1;
+      } else {
+        _state = _length > 0 ? READ_PAYLOAD : READ_CRC_LO;
+      }
+      return false;
+
+    case READ_PAYLOAD:
+      _payload[_received++] = byte;
+      if (_received == _length) {
+        _state = READ_CRC_LO;
+      }
+      return false;
+
+    case READ_CRC_LO:
+      _crc = byte;
+      _state = READ_CRC_HI;
+      return false;
+
+    case READ_CRC_HI: {
+      _crc |= (uint16_t)byte << 8;
+      _state = WAIT_SYNC_1;
+
+      uint8_t header[3] = {_type, (uint8_t)(_length & 0xFF), (uint8_t)(_length >> 8)};
+      uint16_t crc = crc16Ccitt(header, sizeof(header));
+      crc = crc16Ccitt(_payload, _length, crc);
+      if (crc != _crc) {
+        _crcErrors++;
+        return false;
+      }
+      return true;
+    }
+  }
+  return false;
+}
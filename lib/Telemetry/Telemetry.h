@@ -0,0 +1,111 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Binary frames share the serial port with the text output:
+//   0xA5 0x5A | type | length (u16 LE) | payload | CRC16-CCITT (u16 LE)
+// The CRC covers type, length and payload. Hosts resync on the sync bytes,
+// so text lines between frames are skipped by the decoder.
+const uint8_t TELEMETRY_SYNC_1 = 0xA5;
+const uint8_t TELEMETRY_SYNC_2 = 0x5A;
+const size_t TELEMETRY_HEADER_SIZE = 5;
+const size_t TELEMETRY_CRC_SIZE = 2;
+const size_t TELEMETRY_MAX_PAYLOAD = 256;
+const size_t TELEMETRY_MAX_FRAME = TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_PAYLOAD + TELEMETRY_CRC_SIZE;
+
+// Frame types
+enum TelemetryType : uint8_t {
+  TELEMETRY_BURST_HEADER = 0x10,
+  TELEMETRY_BURST_SAMPLES = 0x11,
+  TELEMETRY_BURST_RESULT = 0x12,
+  TELEMETRY_RECORD_HEADER = 0x20,
+  TELEMETRY_RECORD_LUT = 0x21,
+  TELEMETRY_RECORD_EVENTS = 0x22,
+  TELEMETRY_TIME_SYNC = 0x30,  // stand: reply to `sync <token>`, u32 token | u64 esp_timer us
+  TELEMETRY_CLOCK_MAP = 0x31   // hub: device-to-host time fit (see host/ClockSync.h)
+};
+
+uint16_t crc16Ccitt(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+// Writes a complete frame into out; returns the frame size or 0 if it does not fit
+size_t encodeTelemetryFrame(uint8_t type, const uint8_t* payload, size_t length,
+                            uint8_t* out, size_t outCapacity);
+
+// Little-endian payload builder over a caller-owned buffer
+class PayloadWriter {
+ public:
+  PayloadWriter(uint8_t* buffer, size_t capacity)
+      : _buffer(buffer), _capacity(capacity), _length(0), _overflow(false) {}
+
+  void putU8(uint8_t value);
+  void putU16(uint16_t value);
+  void putU32(uint32_t value);
+  void putI32(int32_t value) { putU32((uint32_t)value); }
+  void putU64(uint64_t value);
+  void putF32(float value);
+
+  size_t length() const { return _length; }
+  size_t remaining() const { return _capacity - _length; }
+  bool overflow() const { return _overflow; }
+
+ private:
+  uint8_t* _buffer;
+  size_t _capacity;
+  size_t _length;
+  bool _overflow;
+};
+
+// Little-endian payload reader (host tools and tests)
+class PayloadReader {
+ public:
+  PayloadReader(const uint8_t* buffer, size_t length)
+      : _buffer(buffer), _length(length), _pos(0), _underflow(false) {}
+
+  uint8_t getU8();
+  uint16_t getU16();
+  uint32_t getU32();
+  int32_t getI32() { return (int32_t)getU32(); }
+  uint64_t getU64();
+  float getF32();
+
+  size_t remaining() const { return _length - _pos; }
+  bool underflow() const { return _underflow; }
+
+ private:
+  const uint8_t* _buffer;
+  size_t _length;
+  size_t _pos;
+  bool _underflow;
+};
+
+// Byte-at-a-time frame decoder; feed() returns true when a valid frame is complete
+class TelemetryDecoder {
+ public:
+  TelemetryDecoder() { reset(); }
+
+  void reset();
+  bool feed(uint8_t byte);
+
+  uint8_t type() const { return _type; }
+  const uint8_t* payload() const { return _payload; }
+  size_t length() const { return _length; }
+
+  // True between frames: the next byte is either a sync byte or text
+  bool idle() const { return _state == WAIT_SYNC_1; }
+
+  uint32_t crcErrors() const { return _crcErrors; }
+  uint32_t skippedBytes() const { return _skippedBytes; }
+
+ private:
+  enum State { WAIT_SYNC_1, WAIT_SYNC_2, READ_TYPE, READ_LEN_LO, READ_LEN_HI, READ_PAYLOAD, READ_CRC_LO, READ_CRC_HI };
+
+  State _state;
+  uint8_t _type;
+  uint16_t _length;
+  uint16_t _received;
+  uint16_t _crc;
+  uint8_t _payload[TELEMETRY_MAX_PAYLOAD];
+  uint32_t _crcErrors;
+  uint32_t _skippedBytes;
+};
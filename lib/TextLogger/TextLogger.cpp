@@ -0,0 +1,252 @@
+#include "TextLogger.h"
+
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+namespace {
+
+const int32_t POW10[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+// Digits of an unsigned value, most significant first
+size_t writeDigits(char* out, size_t capacity, uint32_t value, uint8_t minDigits) {
+  char reversed[10];
+  size_t n = 0;
+  do {
+    reversed[n++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  while (n < minDigits) {
+    reversed[n++] = '0';
+  }
+  if (n > capacity) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    out[i] = reversed[n - 1 - i];
+  }
+  return n;
+}
+
+}  // namespace
+
+size_t formatInt(char* out, size_t capacity, long value) {
+  if (capacity == 0) return 0;
+  size_t length = 0;
+  uint32_t magnitude = (uint32_t)value;
+  if (value < 0) {
+    if (capacity < 2) return 0;
+    out[length++] = '-';
+    magnitude = 0u - (uint32_t)value;
+  }
+  size_t digits = writeDigits(out + length, capacity - length - 1, magnitude, 1);
+  if (digits == 0) {
+    return 0;
+  }
+  length += digits;
+  out[length] = '\0';
+  return length;
+}
+
+size_t formatUint(char* out, size_t capacity, uint32_t value) {
+  if (capacity == 0) return 0;
+  size_t length = writeDigits(out, capacity - 1, value, 1);
+  out[length] = '\0';
+  return length;
+}
+
+size_t formatFixed(char* out, size_t capacity, float value, uint8_t decimals) {
+  if (capacity == 0) return 0;
+  if (decimals > 6) {
+    decimals = 6;
+  }
+  if (isnan(value) || isinf(value) || fabsf(value) * POW10[decimals] > 2147483000.0f) {
+    const char* text = isnan(value) ? "nan" : (isinf(value) ? "inf" : "ovf");
+    if (capacity < 4) return 0;
+    memcpy(out, text, 4);
+    return 3;
+  }
+
+  // Emit the scaled integer right to left, dropping the point in on the way
+  uint32_t scaled = (uint32_t)(fabsf(value) * POW10[decimals] + 0.5f);
+  bool negative = value < 0.0f && scaled != 0;  // no "-0.000"
+  char reversed[16];
+  size_t n = 0;
+  do {
+    if (n == decimals && decimals > 0) {
+      reversed[n++] = '.';
+    }
+    reversed[n++] = (char)('0' + scaled % 10);
+    scaled /= 10;
+  } while (scaled != 0 || n <= decimals);
+  if (negative) {
+    reversed[n++] = '-';
+  }
+
+  if (n + 1 > capacity) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    out[i] = reversed[n - 1 - i];
+  }
+  out[n] = '\0';
+  return n;
+}
+
+LineBuilder& LineBuilder::text(const char* s) {
+  size_t n = strlen(s);
+  if (n > LOG_LINE_SIZE - 1 - _length) {
+    n = LOG_LINE_SIZE - 1 - _length;
+  }
+  memcpy(_text + _length, s, n);
+  _length += n;
+  _text[_length] = '\0';
+  return *this;
+}
+
+LineBuilder& LineBuilder::fixed(float value, uint8_t decimals) {
+  size_t n = formatFixed(_text + _length, LOG_LINE_SIZE - _length, value, decimals);
+  _length += n;
+  _text[_length] = '\0';
+  return *this;
+}
+
+LineBuilder& LineBuilder::integer(long value) {
+  size_t n = formatInt(_text + _length, LOG_LINE_SIZE - _length, value);
+  _length += n;
+  _text[_length] = '\0';
+  return *this;
+}
+
+LineBuilder& LineBuilder::unsignedInt(uint32_t value) {
+  size_t n = formatUint(_text + _length, LOG_LINE_SIZE - _length, value);
+  _length += n;
+  _text[_length] = '\0';
+  return *this;
+}
+
+LogQueue::LogQueue(uint8_t* storage, size_t capacity)
+    : _storage(storage),
+      _capacity(capacity),
+      _head(0),
+      _tail(0),
+      _linesQueued(0),
+      _linesDropped(0),
+      _bytesDropped(0),
+      _highWater(0) {}
+
+size_t LogQueue::used() const {
+  return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+// A line may wrap the end of the storage: at most two copies
+void LogQueue::copyIn(size_t at, const char* data, size_t length) {
+  size_t first = _capacity - at < length ? _capacity - at : length;
+  memcpy(_storage + at, data, first);
+  memcpy(_storage, data + first, length - first);
+}
+
+void LogQueue::copyOut(size_t at, char* data, size_t length) const {
+  size_t first = _capacity - at < length ? _capacity - at : length;
+  memcpy(data, _storage + at, first);
+  memcpy(data + first, _storage, length - first);
+}
+
+bool LogQueue::push(const char* line, size_t length) {
+  // One length byte in front of each line
+  if (length == 0 || length >= LOG_LINE_SIZE || length > 255) {
+    _linesDropped++;
+    _bytesDropped += length;
+    return false;
+  }
+
+  size_t head = _head.load(std::memory_order_relaxed);
+  size_t tail = _tail.load(std::memory_order_acquire);
+  if (head - tail + length + 1 > _capacity) {
+    _linesDropped++;
+    _bytesDropped += length;
+    return false;
+  }
+
+  size_t at = head % _capacity;
+  _storage[at] = (uint8_t)length;
+  copyIn((at + 1) % _capacity, line, length);
+  _head.store(head + 1 + length, std::memory_order_release);
+
+  _linesQueued++;
+  size_t fill = head + 1 + length - tail;
+  if (fill > _highWater) {
+    _highWater = fill;
+  }
+  return true;
+}
+
+size_t LogQueue::peek(char* out, size_t capacity) const {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  if (tail == _head.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  size_t at = tail % _capacity;
+  size_t length = _storage[at];
+  if (length > capacity) {
+    return 0;
+  }
+  copyOut((at + 1) % _capacity, out, length);
+  return length;
+}
+
+void LogQueue::pop() {
+  size_t tail = _tail.load(std::memory_order_relaxed);
+  if (tail == _head.load(std::memory_order_acquire)) {
+    return;
+  }
+  _tail.store(tail + 1 + _storage[tail % _capacity], std::memory_order_release);
+}
+
+#ifdef ESP32
+namespace {
+
+struct LogWriterContext {
+  LogQueue* queue;
+  HardwareSerial* serial;
+};
+
+LogWriterContext writerContext;
+
+void logWriterTask(void* param) {
+  LogWriterContext* ctx = (LogWriterContext*)param;
+  while (true) {
+    ctx->queue->drain(*ctx->serial);
+    vTaskDelay(1);
+  }
+}
+
+}  // namespace
+
+void OrderedPrint::waitForQueue() {
+  while (_queue && !_queue->empty()) {
+    vTaskDelay(1);
+  }
+}
+
+size_t OrderedPrint::write(uint8_t c) {
+  waitForQueue();
+  return _out.write(c);
+}
+
+size_t OrderedPrint::write(const uint8_t* buffer, size_t size) {
+  waitForQueue();
+  return _out.write(buffer, size);
+}
+
+bool startLogWriter(LogQueue& queue, HardwareSerial& serial, uint8_t priority, int core) {
+  writerContext.queue = &queue;
+  writerContext.serial = &serial;
+  return xTaskCreatePinnedToCore(logWriterTask, "log_writer", 3072, &writerContext,
+                                 priority, nullptr, core) == pdPASS;
+}
+#endif
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#ifdef ESP32
+#include <Arduino.h>
+#endif
+
+// Integer fixed-point formatting: no dtostrf, no float printf.
+// Writes value rounded to `decimals` places (max 6); returns the length, 0 if it
+// does not fit. Values beyond +/-2^31 / 10^decimals print "ovf" like Print::print.
+size_t formatFixed(char* out, size_t capacity, float value, uint8_t decimals);
+size_t formatInt(char* out, size_t capacity, long value);
+size_t formatUint(char* out, size_t capacity, uint32_t value);
+
+const size_t LOG_LINE_SIZE = 128;
+
+// One log row, built in place; excess text is truncated, never overflows
+class LineBuilder {
+ public:
+  LineBuilder() { clear(); }
+
+  void clear() { _length = 0; _text[0] = '\0'; }
+
+  LineBuilder& text(const char* s);
+  LineBuilder& fixed(float value, uint8_t decimals);
+  LineBuilder& integer(long value);
+  LineBuilder& unsignedInt(uint32_t value);  // device times past 2^31 us
+  LineBuilder& newline() { return text("\n"); }
+
+  const char* c_str() const { return _text; }
+  size_t length() const { return _length; }
+
+ private:
+  char _text[LOG_LINE_SIZE];
+  size_t _length;
+};
+
+// Single-producer/single-consumer queue of complete lines over caller-owned storage.
+// push() never blocks: a line that does not fit is dropped and counted.
+class LogQueue {
+ public:
+  LogQueue(uint8_t* storage, size_t capacity);
+
+  bool push(const char* line, size_t length);
+  bool push(const LineBuilder& line) { return push(line.c_str(), line.length()); }
+
+  // Copies the oldest line into out; returns its length, 0 when empty
+  size_t peek(char* out, size_t capacity) const;
+  void pop();
+
+  // Writes whole lines while the output has room; never blocks on a full UART
+  template <typename Output>
+  size_t drain(Output& output) {
+    char line[LOG_LINE_SIZE];
+    size_t written = 0;
+    while (true) {
+      size_t length = peek(line, sizeof(line));
+      if (length == 0 || output.availableForWrite() < (int)length) {
+        break;
+      }
+      output.write((const uint8_t*)line, length);
+      pop();
+      written += length;
+    }
+    return written;
+  }
+
+  bool empty() const { return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire); }
+  size_t used() const;
+  size_t capacity() const { return _capacity; }
+
+  uint32_t linesQueued() const { return _linesQueued; }
+  uint32_t linesDropped() const { return _linesDropped; }
+  uint32_t bytesDropped() const { return _bytesDropped; }
+  size_t highWater() const { return _highWater; }
+
+ private:
+  void copyIn(size_t at, const char* data, size_t length);
+  void copyOut(size_t at, char* data, size_t length) const;
+
+  uint8_t* _storage;
+  size_t _capacity;
+  std::atomic<size_t> _head;  // written by the producer only
+  std::atomic<size_t> _tail;  // written by the consumer only
+  uint32_t _linesQueued;
+  uint32_t _linesDropped;
+  uint32_t _bytesDropped;
+  size_t _highWater;
+};
+
+#ifdef ESP32
+// Background UART writer: drains the queue from its own FreeRTOS task so the
+// sampling path never waits on the TX FIFO
+bool startLogWriter(LogQueue& queue, HardwareSerial& serial, uint8_t priority, int core);
+
+// Direct output to the writer's port (headers, summaries, console replies):
+// each write waits until the writer task has emptied the queue, so it never
+// lands in the middle of a queued row. Same thread as the producer only.
+class OrderedPrint : public Print {
+ public:
+  explicit OrderedPrint(Print& out) : _out(out), _queue(nullptr) {}
+
+  // Once the writer task runs; until then writes go straight out
+  void attachQueue(LogQueue* queue) { _queue = queue; }
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+
+ private:
+  void waitForQueue();
+
+  Print& _out;
+  LogQueue* _queue;
+};
+#endif
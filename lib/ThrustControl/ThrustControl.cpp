@@ -0,0 +1,128 @@
+#include "ThrustControl.h"
+
+#include <math.h>
+
+namespace {
+
+float clampf(float value, float lo, float hi) {
+  if (value < lo) return lo;
+  if (value > hi) return hi;
+  return value;
+}
+
+// Move current towards target by at most ratePerS * dtS
+float slew(float current, float target, float ratePerS, float dtS) {
+  if (ratePerS <= 0.0f) {
+    return target;
+  }
+  float maxDelta = ratePerS * dtS;
+  return current + clampf(target - current, -maxDelta, maxDelta);
+}
+
+}  // namespace
+
+PidConfig defaultThrustPidConfig() {
+  // Tuned against the simulator (lib/StandSim) at 10 SPS
+  PidConfig c;
+  c.kp = 0.60f;
+  c.ki = 1.50f;
+  c.kd = 0.02f;
+  c.outputMin = 0.0f;
+  c.outputMax = 1.0f;
+  c.outputRatePerS = 0.50f;
+  c.setpointRateKgPerS = 0.0f;
+  c.derivativeFilterS = 0.20f;
+  return c;
+}
+
+ThrustPid::ThrustPid(const PidConfig& config) : _config(config) {
+  reset(0.0f, 0.0f);
+}
+
+void ThrustPid::reset(float output, float measurementKg) {
+  _output = clampf(output, _config.outputMin, _config.outputMax);
+  _integral = _output;  // bumpless: integrator carries the current throttle
+  _setpoint = measurementKg;
+  _lastMeasurement = measurementKg;
+  _derivative = 0.0f;
+  _saturated = false;
+}
+
+float ThrustPid::update(float setpointKg, float measurementKg, float dtS) {
+  if (dtS <= 0.0f) {
+    return _output;
+  }
+
+  _setpoint = slew(_setpoint, setpointKg, _config.setpointRateKgPerS, dtS);
+  float error = _setpoint - measurementKg;
+
+  // Derivative on measurement avoids a kick on setpoint changes
+  float rawDerivative = -(measurementKg - _lastMeasurement) / dtS;
+  _lastMeasurement = measurementKg;
+  float alpha = _config.derivativeFilterS > 0.0f
+      ? dtS / (_config.derivativeFilterS + dtS)
+      : 1.0f;
+  _derivative += alpha * (rawDerivative - _derivative);
+
+  // Conditional integration: freeze the integrator while pushing into a limit
+  float candidateIntegral = _integral + _config.ki * error * dtS;
+  float unclamped = _config.kp * error + candidateIntegral + _config.kd * _derivative;
+  bool pushingHigh = unclamped > _config.outputMax && error > 0.0f;
+  bool pushingLow = unclamped < _config.outputMin && error < 0.0f;
+  if (!pushingHigh && !pushingLow) {
+    _integral = clampf(candidateIntegral, _config.outputMin, _config.outputMax);
+  }
+
+  float target = _config.kp * error + _integral + _config.kd * _derivative;
+  float limited = clampf(target, _config.outputMin, _config.outputMax);
+  _saturated = limited != target;
+
+  _output = slew(_output, limited, _config.outputRatePerS, dtS);
+  return _output;
+}
+
+StepResponseAnalyzer::StepResponseAnalyzer(float bandFraction, float holdTimeS)
+    : _bandFraction(bandFraction), _holdTimeS(holdTimeS), _active(false) {}
+
+void StepResponseAnalyzer::begin(float initialKg, float targetKg, float startTimeS) {
+  _active = true;
+  _initial = initialKg;
+  _target = targetKg;
+  _startTime = startTimeS;
+  _time10 = -1.0f;
+  _time90 = -1.0f;
+  _peakExcursion = 0.0f;
+  _lastOutsideTime = startTimeS;
+  _lastTime = startTimeS;
+}
+
+void StepResponseAnalyzer::add(float timeS, float valueKg) {
+  if (!_active) {
+    return;
+  }
+  _lastTime = timeS;
+
+  float step = _target - _initial;
+  if (step == 0.0f) {
+    return;
+  }
+
+  // Progress along the step, 0 at start and 1 at target (sign-independent)
+  float progress = (valueKg - _initial) / step;
+  if (_time10 < 0.0f && progress >= 0.1f) _time10 = timeS;
+  if (_time90 < 0.0f && progress >= 0.9f) _time90 = timeS;
+  if (progress - 1.0f > _peakExcursion) _peakExcursion = progress - 1.0f;
+
+  if (fabsf(valueKg - _target) > fabsf(step) * _bandFraction) {
+    _lastOutsideTime = timeS;
+  }
+}
+
+StepResponseMetrics StepResponseAnalyzer::metrics() const {
+  StepResponseMetrics m;
+  m.riseTimeS = (_time10 >= 0.0f && _time90 >= 0.0f) ? _time90 - _time10 : -1.0f;
+  m.overshootPercent = _peakExcursion * 100.0f;
+  m.settled = _active && (_lastTime - _lastOutsideTime) >= _holdTimeS;
+  m.settlingTimeS = m.settled ? _lastOutsideTime - _startTime : -1.0f;
+  return m;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <stdint.h>
+
+// PID gains and limits; output is throttle in 0..1 (caller maps to ESC PWM)
+struct PidConfig {
+  float kp;                  // throttle per kg of error
+  float ki;                  // throttle per kg*s
+  float kd;                  // throttle per kg/s (on measurement)
+  float outputMin;
+  float outputMax;
+  float outputRatePerS;      // max throttle change per second, 0 = unlimited
+  float setpointRateKgPerS;  // max setpoint slew, 0 = unlimited
+  float derivativeFilterS;   // low-pass on the derivative term
+};
+
+PidConfig defaultThrustPidConfig();
+
+// PID around the filtered load-cell signal with anti-windup and rate limits
+class ThrustPid {
+ public:
+  explicit ThrustPid(const PidConfig& config);
+
+  void setConfig(const PidConfig& config) { _config = config; }
+  const PidConfig& config() const { return _config; }
+
+  // Bumpless start from the current throttle and measured thrust
+  void reset(float output, float measurementKg);
+
+  float update(float setpointKg, float measurementKg, float dtS);
+
+  float output() const { return _output; }
+  float integral() const { return _integral; }
+  float rampedSetpoint() const { return _setpoint; }
+  bool saturated() const { return _saturated; }
+
+ private:
+  PidConfig _config;
+  float _integral;
+  float _output;
+  float _setpoint;
+  float _lastMeasurement;
+  float _derivative;
+  bool _saturated;
+};
+
+// Rise time (10-90 %), overshoot and settling time of one setpoint step
+struct StepResponseMetrics {
+  float riseTimeS;          // -1 until the 90 % crossing
+  float overshootPercent;
+  float settlingTimeS;      // -1 until inside the band for holdTimeS
+  bool settled;
+};
+
+class StepResponseAnalyzer {
+ public:
+  // bandFraction: settling band as a fraction of the step size (e.g. 0.05)
+  StepResponseAnalyzer(float bandFraction, float holdTimeS);
+
+  void begin(float initialKg, float targetKg, float startTimeS);
+  void add(float timeS, float valueKg);
+
+  bool active() const { return _active; }
+  StepResponseMetrics metrics() const;
+
+ private:
+  float _bandFraction;
+  float _holdTimeS;
+  bool _active;
+  float _initial;
+  float _target;
+  float _startTime;
+  float _time10;
+  float _time90;
+  float _peakExcursion;
+  float _lastOutsideTime;
+  float _lastTime;
+};
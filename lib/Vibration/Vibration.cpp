@@ -0,0 +1,289 @@
+#include "Vibration.h"
+
+#include <math.h>
+
+namespace {
+
+const float PI_F = 3.14159265f;
+
+#ifdef ARDUINO
+// MPU-6050 registers
+const uint8_t MPU_REG_SMPLRT_DIV = 0x19;
+const uint8_t MPU_REG_CONFIG = 0x1A;
+const uint8_t MPU_REG_ACCEL_CONFIG = 0x1C;
+const uint8_t MPU_REG_ACCEL_XOUT_H = 0x3B;
+const uint8_t MPU_REG_PWR_MGMT_1 = 0x6B;
+const uint8_t MPU_REG_WHO_AM_I = 0x75;
+const uint8_t MPU_WHO_AM_I = 0x68;
+#endif
+
+// cos(2 pi k / VIB_FFT_MAX) in Q15; sin is the same table a quarter turn back
+int16_t cosTable[VIB_FFT_MAX];
+bool tablesReady = false;
+
+void buildTables() {
+  if (tablesReady) {
+    return;
+  }
+  for (int k = 0; k < VIB_FFT_MAX; k++) {
+    cosTable[k] = (int16_t)lroundf(32767.0f * cosf(2.0f * PI_F * k / VIB_FFT_MAX));
+  }
+  tablesReady = true;
+}
+
+inline int16_t sinQ15(int k) {
+  return cosTable[(k - VIB_FFT_MAX / 4) & (VIB_FFT_MAX - 1)];
+}
+
+inline int16_t mulQ15(int32_t a, int32_t b) {
+  return (int16_t)((a * b + 0x4000) >> 15);
+}
+
+}  // namespace
+
+void fftQ15(int16_t* re, int16_t* im, int log2n) {
+  buildTables();
+  int n = 1 << log2n;
+
+  // Bit-reversed order
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1) {
+      j ^= bit;
+    }
+    j |= bit;
+    if (i < j) {
+      int16_t t = re[i]; re[i] = re[j]; re[j] = t;
+      t = im[i]; im[i] = im[j]; im[j] = t;
+    }
+  }
+
+  // Butterflies, halved at every stage
+  for (int size = 2; size <= n; size <<= 1) {
+    int half = size >> 1;
+    int stride = VIB_FFT_MAX / size;
+    for (int j = 0; j < half; j++) {
+      int32_t wr = cosTable[j * stride];
+      int32_t wi = -sinQ15(j * stride);
+      for (int a = j; a < n; a += size) {
+        int b = a + half;
+        int32_t tr = ((wr * re[b] - wi * im[b]) + 0x4000) >> 15;
+        int32_t ti = ((wr * im[b] + wi * re[b]) + 0x4000) >> 15;
+        int32_t ar = re[a];
+        int32_t ai = im[a];
+        re[a] = (int16_t)((ar + tr) >> 1);
+        im[a] = (int16_t)((ai + ti) >> 1);
+        re[b] = (int16_t)((ar - tr) >> 1);
+        im[b] = (int16_t)((ai - ti) >> 1);
+      }
+    }
+  }
+}
+
+VibrationAnalyzer::VibrationAnalyzer() : _count(0), _points(0), _scale(1.0f), _windowSum2(1.0f) {
+  buildTables();
+}
+
+bool VibrationAnalyzer::add(int32_t sample) {
+  if (_count >= VIB_FFT_MAX) {
+    return false;
+  }
+  _samples[_count++] = sample;
+  return true;
+}
+
+// Sine peak from the energy of the line's main lobe (Hann: +/-2 bins)
+float VibrationAnalyzer::lineAmplitude(int bin, int bins) const {
+  float energy = 0.0f;
+  for (int k = bin - 2; k <= bin + 2; k++) {
+    if (k >= 1 && k < bins) {
+      energy += (float)_power[k];
+    }
+  }
+  return 2.0f * sqrtf(energy * _points / _windowSum2) / _scale;
+}
+
+bool VibrationAnalyzer::analyze(float sampleRateHz, float rotorHz, float rotorBand,
+                                VibrationSpectrum& out) {
+  out.valid = false;
+  out.peakCount = 0;
+  out.rotorHz = rotorHz;
+  out.rotorSeenHz = 0.0f;
+  out.rotorAmplitude = 0.0f;
+
+  int log2n = 0;
+  while (log2n < VIB_FFT_MAX_LOG2 && (2 << log2n) <= _count) {
+    log2n++;
+  }
+  int n = 1 << log2n;
+  if (n < VIB_FFT_MIN || sampleRateHz <= 0.0f) {
+    return false;
+  }
+  _points = n;
+
+  // Mean and spread, then a power-of-two scale to +/-16384
+  int64_t sum = 0;
+  for (int i = 0; i < n; i++) {
+    sum += _samples[i];
+  }
+  int32_t mean = (int32_t)(sum / n);
+  int32_t maxDev = 0;
+  float sumSq = 0.0f;
+  for (int i = 0; i < n; i++) {
+    int32_t dev = _samples[i] - mean;
+    int32_t mag = dev < 0 ? -dev : dev;
+    if (mag > maxDev) maxDev = mag;
+    sumSq += (float)dev * (float)dev;
+  }
+  int shift = 0;
+  if (maxDev > 16384) {
+    while ((maxDev >> -shift) > 16384) {
+      shift--;
+    }
+  } else {
+    while (maxDev > 0 && (maxDev << (shift + 1)) <= 16384) {
+      shift++;
+    }
+  }
+  _scale = ldexpf(1.0f, shift);
+
+  // Periodic Hann, 0.5 - 0.5 cos(2 pi i / n); sum of w^2 is 3n/8
+  int stride = VIB_FFT_MAX / n;
+  for (int i = 0; i < n; i++) {
+    int32_t dev = _samples[i] - mean;
+    int32_t scaled = shift >= 0 ? dev << shift : dev >> -shift;
+    int32_t window = (32767 - cosTable[i * stride]) >> 1;
+    _re[i] = mulQ15(scaled, window);
+    _im[i] = 0;
+  }
+  _windowSum2 = 0.375f * n;
+
+  fftQ15(_re, _im, log2n);
+
+  int bins = n / 2;
+  for (int k = 0; k < bins; k++) {
+    _power[k] = (uint32_t)((int32_t)_re[k] * _re[k] + (int32_t)_im[k] * _im[k]);
+  }
+
+  float binHz = sampleRateHz / n;
+  bool rotorAliased = rotorHz >= sampleRateHz / 2;
+
+  // Log-parabolic interpolation of the peak position (close to exact for Hann)
+  auto refine = [&](int k) {
+    float delta = 0.0f;
+    if (k > 0 && k + 1 < bins && _power[k - 1] > 0 && _power[k + 1] > 0) {
+      float a = logf((float)_power[k - 1]);
+      float b = logf((float)_power[k]);
+      float c = logf((float)_power[k + 1]);
+      float denom = a - 2.0f * b + c;
+      if (denom < 0.0f) {
+        delta = 0.5f * (a - c) / denom;
+      }
+    }
+    return (k + delta) * binHz;
+  };
+
+  // Largest local maxima; the two lowest bins hold the window's leakage of any trend
+  for (int k = 2; k + 1 < bins; k++) {
+    if (_power[k] == 0 || _power[k] <= _power[k - 1] || _power[k] < _power[k + 1]) {
+      continue;
+    }
+    VibrationPeak peak;
+    peak.frequencyHz = refine(k);
+    peak.amplitude = lineAmplitude(k, bins);
+    peak.order = rotorHz > 0.0f && !rotorAliased ? peak.frequencyHz / rotorHz : 0.0f;
+
+    int at = out.peakCount < VIB_MAX_PEAKS ? out.peakCount++ : VIB_MAX_PEAKS;
+    while (at > 0 && out.peaks[at - 1].amplitude < peak.amplitude) {
+      if (at < VIB_MAX_PEAKS) out.peaks[at] = out.peaks[at - 1];
+      at--;
+    }
+    if (at < VIB_MAX_PEAKS) out.peaks[at] = peak;
+  }
+
+  // Rotor line: strongest bin that some frequency in the band folds onto
+  if (rotorHz > 0.0f) {
+    float lo = rotorHz * (1.0f - rotorBand) - binHz / 2;
+    float hi = rotorHz * (1.0f + rotorBand) + binHz / 2;
+    int firstFold = (int)floorf(lo / sampleRateHz);
+    int lastFold = (int)floorf(hi / sampleRateHz) + 1;
+    int best = -1;
+    for (int k = 1; k < bins; k++) {
+      float f = k * binHz;
+      bool inBand = false;
+      for (int m = firstFold; m <= lastFold && !inBand; m++) {
+        float up = m * sampleRateHz + f;
+        float down = m * sampleRateHz - f;
+        inBand = (up >= lo && up <= hi) || (down >= lo && down <= hi);
+      }
+      if (inBand && (best < 0 || _power[k] > _power[best])) {
+        best = k;
+      }
+    }
+    if (best >= 0) {
+      out.rotorSeenHz = refine(best);
+      out.rotorAmplitude = lineAmplitude(best, bins);
+    }
+  }
+
+  out.valid = true;
+  out.points = n;
+  out.sampleRateHz = sampleRateHz;
+  out.binHz = binHz;
+  out.rmsAmplitude = sqrtf(sumSq / n);
+  return true;
+}
+
+float expectedRotorHz(float kv, float volts, float throttle) {
+  return kv * volts * throttle / 60.0f;
+}
+
+float aliasedHz(float f, float fs) {
+  float folded = fmodf(f, fs);
+  return folded > fs / 2 ? fs - folded : folded;
+}
+
+#ifdef ARDUINO
+Mpu6050Accel::Mpu6050Accel(I2cScheduler& bus, int device, uint8_t axis)
+    : _bus(bus), _device((uint8_t)device), _axis(axis) {}
+
+bool Mpu6050Accel::begin() {
+  I2cTransaction t;
+  t.device = _device;
+  t.data[0] = MPU_REG_WHO_AM_I;
+  t.writeLength = 1;
+  t.readLength = 1;
+  I2cResult result;
+  if (!_bus.transact(I2C_PRIORITY_SENSOR, t, result) || result.data[0] != MPU_WHO_AM_I) {
+    return false;
+  }
+  // Gyro X clock, 1 kHz accelerometer output (DLPF off), +/-8 g
+  return writeRegister(MPU_REG_PWR_MGMT_1, 0x01) && writeRegister(MPU_REG_SMPLRT_DIV, 0x00) &&
+         writeRegister(MPU_REG_CONFIG, 0x00) && writeRegister(MPU_REG_ACCEL_CONFIG, 0x10);
+}
+
+bool Mpu6050Accel::read(int16_t& out) {
+  I2cTransaction t;
+  t.device = _device;
+  t.data[0] = (uint8_t)(MPU_REG_ACCEL_XOUT_H + 2 * _axis);
+  t.writeLength = 1;
+  t.readLength = 2;
+  I2cResult result;
+  if (!_bus.transact(I2C_PRIORITY_SENSOR, t, result)) {
+    return false;
+  }
+  out = (int16_t)((result.data[0] << 8) | result.data[1]);
+  return true;
+}
+
+bool Mpu6050Accel::writeRegister(uint8_t reg, uint8_t value) {
+  I2cTransaction t;
+  t.device = _device;
+  t.data[0] = reg;
+  t.data[1] = value;
+  t.writeLength = 2;
+  t.readLength = 0;
+  I2cResult result;
+  return _bus.transact(I2C_PRIORITY_SENSOR, t, result);
+}
+#endif
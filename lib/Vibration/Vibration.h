@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include "I2cBus.h"
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+// Vibration spectrum of one high-rate window per sweep step: load-cell counts
+// (HX711 at 80 SPS, so rotor lines arrive aliased) or accelerometer LSBs.
+// Mean removed, block-scaled to Q15, Hann window, radix-2 FFT in Q15.
+
+const int VIB_FFT_MAX_LOG2 = 9;
+const int VIB_FFT_MAX = 1 << VIB_FFT_MAX_LOG2;  // 512 points
+const int VIB_FFT_MIN = 16;
+const int VIB_MAX_PEAKS = 4;
+
+// In-place complex FFT, n = 1 << log2n <= VIB_FFT_MAX. Each stage halves the
+// values, so the result is the DFT divided by n and never overflows for
+// inputs within +/-16384.
+void fftQ15(int16_t* re, int16_t* im, int log2n);
+
+struct VibrationPeak {
+  float frequencyHz;  // as sampled (interpolated between bins)
+  float amplitude;    // input units, sine peak
+  float order;        // frequencyHz / rotorHz; 0 when the rotor line is aliased
+};
+
+struct VibrationSpectrum {
+  bool valid;
+  int points;           // FFT size used
+  float sampleRateHz;
+  float binHz;
+  float rmsAmplitude;   // AC RMS of the window, input units
+  float rotorHz;        // expected rotor frequency (0 = unknown)
+  float rotorSeenHz;    // where the rotor line was found after folding
+  float rotorAmplitude; // sine peak of that line, input units
+  int peakCount;
+  VibrationPeak peaks[VIB_MAX_PEAKS];  // largest first
+};
+
+class VibrationAnalyzer {
+ public:
+  VibrationAnalyzer();
+
+  void reset() { _count = 0; }
+  // false once the window is full
+  bool add(int32_t sample);
+  int count() const { return _count; }
+  bool full() const { return _count >= VIB_FFT_MAX; }
+
+  // Uses the largest power of two of the collected samples. The rotor line is
+  // searched within rotorBand (fraction) of rotorHz, wherever it folds to.
+  bool analyze(float sampleRateHz, float rotorHz, float rotorBand, VibrationSpectrum& out);
+
+  // re^2 + im^2 per bin of the last analysis (Q15 units, DFT / n)
+  const uint32_t* power() const { return _power; }
+
+ private:
+  float lineAmplitude(int bin, int bins) const;
+
+  int32_t _samples[VIB_FFT_MAX];
+  int16_t _re[VIB_FFT_MAX];
+  int16_t _im[VIB_FFT_MAX];
+  uint32_t _power[VIB_FFT_MAX / 2];
+  int _count;
+  int _points;
+  float _scale;       // Q15 value per input unit
+  float _windowSum2;  // sum of w^2 (w in 0..1)
+};
+
+// Unloaded rotor speed from the motor KV, in revolutions per second
+float expectedRotorHz(float kv, float volts, float throttle);
+
+// Frequency a line at f appears at when sampled at fs (0 .. fs/2)
+float aliasedHz(float f, float fs);
+
+#ifdef ARDUINO
+// MPU-6050 on the shared I2C bus, one axis at up to 1 kHz, +/-8 g. Reads
+// go ahead of queued LCD updates but wait for their result, so they belong
+// in the capture window, not the control loop.
+class Mpu6050Accel {
+ public:
+  static const int LSB_PER_G = 4096;
+
+  Mpu6050Accel(I2cScheduler& bus, int device, uint8_t axis);  // axis 0..2 = X..Z
+
+  bool begin();
+  bool read(int16_t& out);
+
+ private:
+  bool writeRegister(uint8_t reg, uint8_t value);
+
+  I2cScheduler& _bus;
+  uint8_t _device;
+  uint8_t _axis;
+};
+#endif
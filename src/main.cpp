@@ -3,45 +3,272 @@
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
 #include "HX711.h"
-
-// Pin definitions
-#define MOTOR_PIN 19      // PWM pin for motor ESC
-#define POT_PIN 34        // Potentiometer analog input (ADC1_CH6)
-#define BUTTON_PIN 4      // Button for menu navigation
-#define DT 18             // Load cell data pin
-#define SCK 23            // Load cell clock pin
-
-// PWM range for ESC (INVERTED: lower PWM = faster)
-#define MIN_PWM 1200      // Maximum speed (fastest)
-#define MAX_PWM 1340      // Minimum spinning speed (slowest)
+#include <esp_timer.h>
+#include "BatchQueue.h"
+#include "BurstCapture.h"
+#include "Calibration.h"
+#include "CommandConsole.h"
+#include "Endurance.h"
+#include "EscDiscovery.h"
+#include "EscTrajectory.h"
+#include "I2cBus.h"
+#include "LcdFrame.h"
+#include "LiveView.h"
+#include "LoadCell.h"
+#include "MemoryArena.h"
+#include "PowerMonitor.h"
+#include "RawRecord.h"
+#include "Safety.h"
+#include "SignalFilter.h"
+#include "StandConfig.h"
+#include "Sweep.h"
+#include "Telemetry.h"
+#include "TextLogger.h"
+#include "ThrustControl.h"
+#include "Vibration.h"
+
+// Pins, ESC endpoints and polarity come from the stand variant (StandConfig.h);
+// a discovered profile for the ESC on the stand replaces the endpoints at run
+// time (escRange). The sweep, zero tracking and step capture code below is
+// written for a reversed ESC: lower PWM = faster.
+static_assert(StandEsc::INVERTED, "sweep and capture logic assumes a reversed ESC");
+
+// ESC output stage: commands become slew-limited ramps (stop and jumps excepted)
+#define ESC_OUTPUT_HZ 250          // Trajectory tick (esp_timer)
+#define ESC_SLEW_US_PER_S 500      // 1340->1200 in about 0.3 s, 0 = jump
+#define ESC_ACCEL_US_PER_S2 5000   // Full slew after 0.1 s, 0 = unlimited
 
 // Algorithm test settings
 #define MIN_PWM_ALGO 1210
 #define MAX_PWM_ALGO 1340
+static_assert(StandEsc::contains(MIN_PWM_ALGO) && StandEsc::contains(MAX_PWM_ALGO) &&
+                  MIN_PWM_ALGO < MAX_PWM_ALGO,
+              "sweep range outside the ESC's usable range");
 #define PWM_STEP 10
 #define STEP_DELAY 2000
-
-// Load cell calibration
-const float CALIBRATION_WEIGHT_KG = 0.800;
-const float CORRECTION_K = 3.265;
+#define SAMPLES_PER_STEP 10
+#define CONVERSION_WAIT_MS 500    // Longest wait for one HX711 conversion (100 ms at 10 SPS)
+#define SETTLE_SAMPLES 0          // Samples skipped at the start of each step
+#define RAMP_RATE_US_PER_S 0      // Continuous ramp through the points, 0 = stepped sweep
+
+// Live view (manual mode): sampling, LCD and log rates are independent
+#define LIVE_SAMPLE_HZ 0           // Samples into the window, 0 = every HX711 conversion
+#define LIVE_WINDOW 10             // Samples behind mean/min/peak (1 s at 10 SPS)
+#define LCD_HZ 4                   // LCD refresh
+#define LIVE_LOG_HZ 4              // Serial rows
+
+// Load cell calibration: multi-point from NVS ('cal' command), otherwise the
+// single-point CALIBRATION_WEIGHT_KG / CORRECTION_K fallback in LoadCell.h
+#define CAL_SAMPLES 20             // Readings averaged per reference weight
+
+// Zero tracking (motor commanded stopped) and temperature drift model
+const float DRIFT_ZERO_KG_PER_C = 0.0;  // Zero tempco, or fit it with 'drift fit'
+const float DRIFT_SPAN_PER_C = 0.0;     // Sensitivity tempco, from the load cell datasheet
+const float NTC_SERIES_OHMS = 10000.0;  // NTC to GND, series resistor to 3.3 V
+const float NTC_OHMS_25C = 10000.0;
+const float NTC_BETA = 3950.0;
+#define TEMPERATURE_PERIOD_MS 1000
 
 // Drone payload calculation
 const float DRONE_WEIGHT_KG = 0.500;
 const int NUM_MOTORS = 4;
 const float THRUST_TO_WEIGHT_RATIO = 2.0;
 
+// Power monitor (INA219 on the LCD I2C bus, or -DPOWER_SENSOR_ADC for divider + shunt)
+#define INA219_ADDRESS 0x40
+const float SHUNT_OHMS = 0.002;           // 2 mOhm shunt, ~160 A full scale on INA219
+const float VOLTAGE_DIVIDER_RATIO = 11.0; // 100k / 10k battery divider
+const float CURRENT_AMP_GAIN = 50.0;      // Shunt amplifier gain (ADC backend)
+const float PROP_DIAMETER_M = 0.127;      // 5" prop, for mechanical power estimate
+
+// Thrust hold (closed loop on the load cell)
+const float HOLD_MAX_SETPOINT_KG = 0.450;  // Setpoint at full pot travel
+const float HOLD_SETPOINT_STEP_KG = 0.010; // Pot setpoint resolution
+const float HOLD_FILTER_TIME_S = 0.15;     // Load-cell low-pass before the PID
+const float HX711_SAMPLE_PERIOD_S = 0.1;   // 10 SPS (RATE pin low)
+const float HOLD_SETTLE_BAND = 0.05;       // Settling band, fraction of step size
+const float HOLD_SETTLE_TIME_S = 2.0;      // Time inside the band to count as settled
+
+// Run-time buffer arenas, sized here and taken once at boot; nothing is
+// allocated after setup(), so batch nights cannot fragment the heap
+#define SRAM_ARENA_BYTES 16384      // 1024-sample capture fallback + slack
+#define PSRAM_ARENA_BYTES 524288    // 32768-sample capture, PSRAM boards only
+
+// Step capture (burst mode); tie the HX711 RATE pin high for 80 SPS
+#define BURST_CAPACITY_PSRAM 32768   // Samples, when the module has PSRAM
+#define BURST_CAPACITY 1024          // Samples, internal SRAM fallback
+#define BURST_STEP_PWM 40            // PWM change per captured step
+#define BURST_SETTLE_MS 2000         // Hold before each step
+const unsigned long BURST_PRE_TRIGGER_US = 200000;  // Baseline before the step
+const unsigned long BURST_WINDOW_US = 1500000;      // Capture length per step
+
+// Serial console
+#define CONSOLE_BYTES_PER_TICK 16  // Bounded parse cost per loop iteration
+
+// Serial log; baud follows monitor_speed in platformio.ini (up to 921600)
+#ifndef STAND_SERIAL_BAUD
+#define STAND_SERIAL_BAUD 9600
+#endif
+#define LOG_QUEUE_BYTES 4096       // Queued rows while the UART catches up
+#define SERIAL_TX_BUFFER 1024      // Driver TX buffer behind the writer task
+#define LOG_WRITER_PRIORITY 1      // Below the sampling loop
+#define LOG_WRITER_CORE 0          // Arduino loop runs on core 1
+
+// Shared I2C bus (LCD, INA219, MPU-6050): one owner task, sensor reads ahead of LCD updates
+#define LCD_ADDRESS 0x27
+#define I2C_CLOCK_HZ 400000           // Fast mode; the PCF8574, INA219 and MPU-6050 all take it
+#define I2C_DISPLAY_MAX_WAIT_US 50000 // LCD update waiting this long goes ahead of sensors
+#define I2C_BUS_PRIORITY 2            // Queued reads start without waiting for the log writer
+#define I2C_BUS_CORE 0
+
+// Vibration spectrum per sweep step (VIB_SOURCE: 0 off, 1 load cell, 2 MPU-6050)
+#define VIB_SOURCE 0
+#define MPU6050_ADDRESS 0x68       // On the LCD I2C bus
+#define VIB_ACCEL_AXIS 2           // Z, mounted along the motor shaft
+#define VIB_ACCEL_PERIOD_US 1000   // 1 kHz accelerometer rate, 512-sample window
+#define VIB_LOADCELL_SAMPLES 64    // 0.8 s at 80 SPS (RATE pin high)
+const float MOTOR_KV = 1750.0;             // Rotor frequency estimate: KV * V * throttle
+const float NOMINAL_BATTERY_V = 16.8;      // Without a power monitor (4S full)
+const float VIB_ROTOR_BAND = 0.3;          // Rotor line search around the estimate (props load the motor)
+
+// Safety supervisor: own task above everything else, on the hardware watchdog
+#define SAFETY_PERIOD_MS 5         // Deadline checks; bounds the cutoff latency
+#define SAFETY_WATCHDOG_MS 1000    // Supervisor silent this long: chip reset, ESC signal lost
+#define SAFETY_PRIORITY 20         // Above the loop (1) and the log writer
+#define SAFETY_CORE 0
+
+// Batch queue (unattended runs, checkpointed to NVS after every step)
+#define BATCH_REPETITIONS 3        // Runs per profile
+#define BATCH_COOLDOWN_S 60        // Motor stopped between runs
+#define BATCH_RESUME_COUNTDOWN_S 10  // Time to cancel a resume after a reset
+
+// ESC endpoint discovery (search range: disc_* settings), stored per ESC name
+#define ESC_DISCOVER_REST_MS 2000    // Stopped before each spin-up probe
+#define ESC_DISCOVER_SPIN_MS 1000    // At the spin-up pulse before a stall probe
+#define ESC_DISCOVER_SETTLE_MS 1000  // At the probe pulse before averaging
+#define ESC_DISCOVER_SAMPLES 10      // Readings averaged per probe (1 s at 10 SPS)
+#define ESC_DEFAULT_NAME "stand"     // Until 'esc use <name>'
+
+// Endurance runs: one pulse for end_minutes, rows per second and per minute,
+// raw window frozen around the first anomaly (triggers: end_* settings)
+#define ENDURANCE_PWM 1270          // About half throttle on the stand ESC
+static_assert(StandEsc::contains(ENDURANCE_PWM) && !StandEsc::stopped(ENDURANCE_PWM),
+              "endurance pulse outside the ESC's turning range");
+#define ENDURANCE_MINUTES 20
+#define ENDURANCE_SETTLE_MS 5000    // At the pulse before the clock starts
+#define ENDURANCE_SAVE_MINUTES 5    // Minute summaries to NVS this often, and at the end
+const float ENDURANCE_CHART_SPAN_KG = 0.02;  // Chart floor at least this far below its top
+const char LCD_BAR_GLYPH = 8;       // CGRAM 0-7 (bottom 1-8 pixel rows lit), as codes 8-15
+
 // UI States
 enum UIState {
   STATE_WELCOME,
   STATE_MENU,
   STATE_MANUAL_TEST,
-  STATE_ALGORITHM_TEST
+  STATE_ALGORITHM_TEST,
+  STATE_THRUST_HOLD,
+  STATE_STEP_CAPTURE,
+  STATE_BATCH,
+  STATE_ESC_DISCOVERY,
+  STATE_ENDURANCE
 };
 
+// Menu entries, shown MENU_ROWS at a time below the title
+const int NUM_MENU_OPTIONS = 7;
+const int MENU_ROWS = 3;
+const char* const MENU_OPTIONS[NUM_MENU_OPTIONS] = {
+  "1) Manual test",
+  "2) Algorithm test",
+  "3) Thrust hold",
+  "4) Step capture",
+  "5) Batch queue",
+  "6) ESC discovery",
+  "7) Endurance"
+};
+
+// Bus devices, registered in this order in setup()
+enum I2cDeviceIndex { I2C_DEV_LCD, I2C_DEV_INA219, I2C_DEV_MPU6050 };
+
 // Hardware objects
 Servo esc;
 HX711 scale;
-LiquidCrystal_I2C lcd(0x27, 20, 4);
+LiquidCrystal_I2C lcdDriver(LCD_ADDRESS, 20, 4);  // Controller init at boot; the bus task draws after
+WireI2cPort i2cPort(Wire);
+I2cScheduler i2cBus(i2cPort, I2C_CLOCK_HZ, I2C_DISPLAY_MAX_WAIT_US);
+bool i2cBusRunning = false;
+LcdFrame lcdFrame;
+LcdCanvas lcd(lcdFrame);
+I2cLcd lcdOut(i2cBus, I2C_DEV_LCD);
+#ifdef POWER_SENSOR_ADC
+AdcPowerSensor powerSensor(StandBoard::VOLTAGE_PIN, StandBoard::CURRENT_PIN, VOLTAGE_DIVIDER_RATIO, SHUNT_OHMS, CURRENT_AMP_GAIN);
+#else
+Ina219PowerSensor powerSensor(i2cBus, I2C_DEV_INA219, SHUNT_OHMS);
+#endif
+StepPowerAccumulator stepPower(PROP_DIAMETER_M);
+LoadCellConverter loadCell;
+CalibrationRecord calibration;
+CalibrationLut calibrationLut;
+ZeroTracker zeroTracker(defaultZeroTrackConfig());
+DriftFit driftFit;
+// ESC endpoints in use: the stand ESC's until a discovered profile is loaded
+EscRange escRange = StandEsc::range();
+char escName[ESC_NAME_MAX] = ESC_DEFAULT_NAME;
+EscProfileRecord escProfile;
+bool escProfileLoaded = false;
+EscDiscovery escDiscovery;
+EscDiscoveryConfig escDiscoveryConfig = defaultEscDiscoveryConfig();
+int escCommandUs = StandEsc::STOP_PWM;  // Last value commanded, see setEsc()
+void writeEscOutput(int pwm);
+EscOutputStage escOutput(writeEscOutput, StandEsc::STOP_PWM);
+bool escOutputRunning = false;
+bool temperatureAvailable = false;
+unsigned long lastTemperatureMs = 0;
+LiveAggregator live;
+alignas(8) uint8_t sramArenaBlock[SRAM_ARENA_BYTES];
+MemoryArena sramArena("sram");
+MemoryArena psramArena("psram");
+TieredArena memory(sramArena, psramArena);
+bool powerAvailable = false;
+VibrationAnalyzer vibration;
+Mpu6050Accel accel(i2cBus, I2C_DEV_MPU6050, VIB_ACCEL_AXIS);
+bool accelAvailable = false;
+VibrationSpectrum lastVibration;
+unsigned long vibAnalyzeUs = 0;
+void safetyStop();
+SafetyLimits safetyLimits = defaultSafetyLimits();
+SafetySupervisor safety(safetyLimits, safetyStop);
+bool safetyRunning = false;
+uint8_t logStorage[LOG_QUEUE_BYTES];
+LogQueue logQueue(logStorage, sizeof(logStorage));
+bool logWriterRunning = false;
+OrderedPrint serialOut(Serial);  // Direct output, kept behind queued rows
+void sendFrame(const uint8_t* frame, size_t length);
+RawRecorder recorder(sendFrame);
+uint32_t readingUs = 0;  // captureUs() of the newest HX711 reading: the time column of live rows
+uint16_t recordRuns = 0;
+uint32_t syncReplies = 0;
+
+// Runtime settings, defaults from above (serial console: get/set)
+int sweepMinPwm = MIN_PWM_ALGO;
+int sweepMaxPwm = MAX_PWM_ALGO;
+int sweepStepPwm = PWM_STEP;
+unsigned long stepDelayMs = STEP_DELAY;
+float droneWeightKg = DRONE_WEIGHT_KG;
+float thrustToWeightRatio = THRUST_TO_WEIGHT_RATIO;
+int zeroTrackEnabled = 1;
+float driftZeroKgPerC = DRIFT_ZERO_KG_PER_C;
+float driftSpanPerC = DRIFT_SPAN_PER_C;
+int vibSource = VIB_SOURCE;
+int settleSamples = SETTLE_SAMPLES;
+int recordEnabled = 0;
+int escSlewUsPerS = ESC_SLEW_US_PER_S;
+int escAccelUsPerS2 = ESC_ACCEL_US_PER_S2;
+int rampRateUsPerS = RAMP_RATE_US_PER_S;
+float liveSampleHz = LIVE_SAMPLE_HZ;
+int liveWindow = LIVE_WINDOW;
+float lcdHz = LCD_HZ;
+float liveLogHz = LIVE_LOG_HZ;
+unsigned long i2cClockHz = I2C_CLOCK_HZ;
 
 // State variables
 UIState currentState = STATE_WELCOME;
@@ -50,12 +277,45 @@ bool buttonWasPressed = false;
 unsigned long buttonPressStart = 0;
 const unsigned long LONG_PRESS_TIME = 3000;
 const unsigned long DEBOUNCE_DELAY = 50;
+bool abortRequested = false;
+int pendingOption = 0;  // Menu option requested from the console
 
 // Algorithm test variables
 bool algorithmTestCompleted = false;
-float maxThrustKg = 0.0;
-int algorithmStep = 0;
-int totalAlgorithmSteps = 0;
+SweepStepper sweep;
+SweepTotals sweepTotals;
+
+// Thrust hold variables
+ThrustPid holdPid(defaultThrustPidConfig());
+EmaFilter holdFilter(1.0);
+StepResponseAnalyzer holdStep(HOLD_SETTLE_BAND, HOLD_SETTLE_TIME_S);
+float holdSetpointKg = 0.0;
+unsigned long holdLastSampleUs = 0;
+bool holdStepReported = true;
+
+// Step capture variables
+BurstCapture burst;
+bool burstAvailable = false;
+uint8_t telemetryFrame[TELEMETRY_MAX_FRAME];
+
+// Batch queue variables; with no profiles the batch repeats the sweep settings
+NvsCheckpointStore checkpointStore;
+BatchQueue batch(checkpointStore);
+BatchProfile batchProfiles[BATCH_MAX_PROFILES];
+int batchProfileCount = 0;
+int batchRepetitions = BATCH_REPETITIONS;
+unsigned long batchCooldownS = BATCH_COOLDOWN_S;
+int batchAutoTare = 1;
+
+// Endurance variables; the raw window borrows the step capture buffer
+EnduranceRun endurance;
+EnduranceTriggers enduranceTriggers = defaultEnduranceTriggers();
+int endurancePwm = ENDURANCE_PWM;
+int enduranceMinutes = ENDURANCE_MINUTES;
+int enduranceSaveMinutes = ENDURANCE_SAVE_MINUTES;
+int64_t enduranceStartUs = 0;
+bool enduranceStored = false;      // endurance.record() holds a run, this boot's or from NVS
+bool enduranceWindowHeld = false;  // Raw window not yet overwritten by a step capture
 
 // Function prototypes
 void displayWelcomeScreen();
@@ -64,39 +324,399 @@ void setupManualTest();
 void runManualTest();
 void setupAlgorithmTest();
 void runAlgorithmTest();
+void beginSweep(const SweepConfig& config);
+bool runSweepSteps(unsigned long delayMs, bool checkpoint);
+bool runRampSweep(bool checkpoint);
+bool runSweep(unsigned long delayMs, bool checkpoint);
+RunSummary sweepSummary();
+void printPayloadSummary();
+void showSweepResults();
+void startBatch();
+void runBatch();
+bool batchCooldown(unsigned long ms);
+void printBatchTotals();
+void offerBatchResume();
+float readSweepSample(PowerReading& reading, long* rawOut = nullptr);
+StepPowerResult measureSweepStep();
+bool waitForConversion();
+bool recordSweepStep(const SweepPoint& point);
+bool measureRampPoint(const SweepPoint& point, int direction, bool atRest);
+void reportSweepStep(const SweepPoint& point, const StepPowerResult& step);
+void clearLcd();
+void flushLcd();
+void setEsc(int pwm, bool jump = false);
+void rampEsc(int pwm, int usPerS);
+void commandEsc(int pwm, bool jump, float slewUsPerS);
+bool waitForEsc();
+bool motorStopped();
+uint32_t captureUs();
+void trackZero(long raw, uint64_t readUs);
+void updateTemperature();
+void serviceLoadCell();
+void pollConsole();
+void setupThrustHold();
+void runThrustHold();
+void exitToMenu(const char* message);
+void runStepCapture();
+bool captureStep(int fromPwm, int toPwm);
+void dumpBurst(uint16_t stepIndex, const BurstAnalysis& analysis);
 bool checkButtonPress();
 bool checkButtonLongPress();
+bool exitRequested();
+bool serviceDelay(unsigned long ms);
+bool sweepRangeUsable();
+void startOption(int option);
+float computePayloadKg(float singleMotorThrustKg);
+PayloadModel payloadModel();
+void calibrateLoadCell();
+void consoleStart(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleAbort(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleTare(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleCalibrate(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleStats(const ConsoleArgs& args, ConsoleOutput& out);
+float vibrationUnit();
+void recordVibration(const SweepPoint& point, float voltageV);
+void startRecord(const SweepConfig& config);
+void consoleProfile(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleDrift(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleCal(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleSafety(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleMem(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleSync(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleI2c(const ConsoleArgs& args, ConsoleOutput& out);
+void consoleEsc(const ConsoleArgs& args, ConsoleOutput& out);
+void useEscProfile(const char* name);
+void applyEscProfile();
+void runEscDiscovery();
+float runEscProbe(const EscProbe& probe);
+bool holdSampling(unsigned long ms);
+float enduranceChangePercent(float thrustKg);
+void setupEndurance();
+void runEndurance();
+void finishEndurance(bool completed);
+void reportEnduranceAnomaly(uint32_t elapsedUs);
+void showEndurance();
+void printEnduranceSummary(ConsoleOutput& out);
+void consoleEndurance(const ConsoleArgs& args, ConsoleOutput& out);
+void printMemoryReport(ConsoleOutput& out);
+void printCalibrationReport(ConsoleOutput& out);
+
+// Serial console tables
+const ConsoleParam CONSOLE_PARAMS[] = {
+  {"min_pwm", PARAM_INT, &sweepMinPwm, 1000, 2000},
+  {"max_pwm", PARAM_INT, &sweepMaxPwm, 1000, 2000},
+  {"pwm_step", PARAM_INT, &sweepStepPwm, 1, 200},
+  {"step_delay", PARAM_ULONG, &stepDelayMs, 100, 60000},
+  {"drone_weight", PARAM_FLOAT, &droneWeightKg, 0.0, 25.0},
+  {"tw_ratio", PARAM_FLOAT, &thrustToWeightRatio, 1.0, 10.0},
+  {"batch_reps", PARAM_INT, &batchRepetitions, 1, 100},
+  {"batch_cooldown", PARAM_ULONG, &batchCooldownS, 0, 3600},
+  {"batch_tare", PARAM_INT, &batchAutoTare, 0, 1},
+  {"zero_track", PARAM_INT, &zeroTrackEnabled, 0, 1},
+  {"drift_zero", PARAM_FLOAT, &driftZeroKgPerC, -0.01, 0.01},
+  {"drift_span", PARAM_FLOAT, &driftSpanPerC, -0.01, 0.01},
+  {"vib_source", PARAM_INT, &vibSource, 0, 2},
+  {"settle_samples", PARAM_INT, &settleSamples, 0, SAMPLES_PER_STEP - 1},
+  {"ramp_rate", PARAM_INT, &rampRateUsPerS, 0, 1000},
+  {"esc_slew", PARAM_INT, &escSlewUsPerS, 0, 100000},
+  {"esc_accel", PARAM_INT, &escAccelUsPerS2, 0, 1000000},
+  {"sample_hz", PARAM_FLOAT, &liveSampleHz, 0.0, 80.0},
+  {"live_window", PARAM_INT, &liveWindow, 1, WINDOW_STATS_MAX},
+  {"lcd_hz", PARAM_FLOAT, &lcdHz, 0.5, 20.0},
+  {"log_hz", PARAM_FLOAT, &liveLogHz, 0.5, 80.0},
+  {"i2c_clock", PARAM_ULONG, &i2cClockHz, 100000, 1000000},
+  {"record", PARAM_INT, &recordEnabled, 0, 1},
+  {"max_thrust", PARAM_FLOAT, &safetyLimits.maxThrustKg, 0.05, 20.0},
+  {"max_rate", PARAM_FLOAT, &safetyLimits.maxRateKgPerS, 0.5, 200.0},
+  {"sample_timeout", PARAM_ULONG, &safetyLimits.sampleTimeoutMs, 50, 10000},
+  {"loop_timeout", PARAM_ULONG, &safetyLimits.loopTimeoutMs, 50, 10000},
+  {"host_timeout", PARAM_ULONG, &safetyLimits.hostTimeoutMs, 0, 600000},
+  {"disc_slow", PARAM_INT, &escDiscoveryConfig.searchSlowPwm, 1000, 1900},
+  {"disc_fast", PARAM_INT, &escDiscoveryConfig.searchFastPwm, 1000, 1900},
+  {"disc_step", PARAM_INT, &escDiscoveryConfig.coarseStepPwm, 2, 100},
+  {"disc_res", PARAM_INT, &escDiscoveryConfig.resolutionPwm, 1, 20},
+  {"end_pwm", PARAM_INT, &endurancePwm, 1000, 2000},
+  {"end_minutes", PARAM_INT, &enduranceMinutes, 1, ENDURANCE_MAX_MINUTES},
+  {"end_save", PARAM_INT, &enduranceSaveMinutes, 1, ENDURANCE_MAX_MINUTES},
+  {"end_drop", PARAM_FLOAT, &enduranceTriggers.dropFraction, 0.0, 0.9},
+  {"end_spike", PARAM_FLOAT, &enduranceTriggers.spikeKg, 0.0, 20.0},
+  {"end_min_v", PARAM_FLOAT, &enduranceTriggers.minVoltageV, 0.0, 60.0}
+};
+const ConsoleCommand CONSOLE_COMMANDS[] = {
+  {"start", "start <manual|sweep|hold|capture|batch|discover|endurance>", consoleStart},
+  {"abort", "abort - stop the motor and return to the menu", consoleAbort},
+  {"tare", "tare - zero the load cell (idle only)", consoleTare},
+  {"calibrate", "calibrate - rerun the boot calibration (idle only)", consoleCalibrate},
+  {"stats", "stats - last run results and live thrust", consoleStats},
+  {"profile", "profile <add MIN MAX STEP DELAY [RAMP]|clear|list> - batch sweeps", consoleProfile},
+  {"drift", "drift <show|fit|clear> - load cell temperature model", consoleDrift},
+  {"cal", "cal <add KG [pulley]|fit [1|2]|report|clear> - multi-point calibration", consoleCal},
+  {"safety", "safety [clear] - supervisor status, acknowledge a stop", consoleSafety},
+  {"mem", "mem - heap, arena and task stack high-water marks", consoleMem},
+  {"i2c", "i2c [reset] - bus clock and per-device latency/throughput", consoleI2c},
+  {"esc", "esc [use NAME|forget] - ESC on the stand and its discovered endpoints", consoleEsc},
+  {"endurance", "endurance [dump|freeze|clear] - last endurance run and its raw window", consoleEndurance},
+  {"sync", "sync <token> - clock exchange for the host (binary reply)", consoleSync}
+};
+PrintConsoleOutput consoleOut(serialOut);
+CommandConsole console(CONSOLE_COMMANDS, sizeof(CONSOLE_COMMANDS) / sizeof(CONSOLE_COMMANDS[0]),
+                       CONSOLE_PARAMS, sizeof(CONSOLE_PARAMS) / sizeof(CONSOLE_PARAMS[0]),
+                       consoleOut);
 
-void displayWelcomeScreen() {
+// Blank the frame; the next flush sends only the cells that were lit
+void clearLcd() {
   lcd.clear();
+}
+
+// Without the owner task the bus runs here, on the loop
+void serviceI2c() {
+  if (!i2cBusRunning) {
+    while (i2cBus.runOnce()) {
+    }
+  }
+}
+
+// Queue the LCD cells that changed since the last flush; never waits for the bus
+void flushLcd() {
+  lcdOut.flush(lcdFrame);
+  serviceI2c();
+}
+
+void displayWelcomeScreen() {
+  clearLcd();
   lcd.setCursor(0, 1);
   lcd.print("Motor Thrust Stand");
 }
 
 void displayMenu() {
-  lcd.clear();
+  clearLcd();
   lcd.setCursor(0, 0);
-  lcd.print("Choose option:");
-
-  lcd.setCursor(0, 1);
-  if (selectedOption == 1) {
-    lcd.print("> ");
+  if (safety.tripped()) {
+    lcd.print("STOP: ");
+    lcd.print(safetyFaultName(safety.fault()));
   } else {
-    lcd.print("  ");
+    lcd.print("Choose option:");
   }
-  lcd.print("1) Manual test");
 
-  lcd.setCursor(0, 2);
-  if (selectedOption == 2) {
-    lcd.print("> ");
+  // Scroll so the selected option is always visible
+  int firstOption = 1;
+  if (selectedOption > MENU_ROWS) {
+    firstOption = selectedOption - MENU_ROWS + 1;
+  }
+
+  for (int row = 0; row < MENU_ROWS; row++) {
+    int option = firstOption + row;
+    if (option > NUM_MENU_OPTIONS) {
+      break;
+    }
+    lcd.setCursor(0, row + 1);
+    if (selectedOption == option) {
+      lcd.print("> ");
+    } else {
+      lcd.print("  ");
+    }
+    lcd.print(MENU_OPTIONS[option - 1]);
+  }
+}
+
+// Supervisor cutoff, from whichever task detects the fault: straight to the
+// ESC, and the output stage starts over from the stop value
+void safetyStop() {
+  esc.writeMicroseconds(escRange.stopPwm);
+  escOutput.jumpTo(escRange.stopPwm);
+}
+
+// The output stage's only write; a tick racing a safety stop still writes the stop
+void writeEscOutput(int pwm) {
+  esc.writeMicroseconds(safety.tripped() ? escRange.stopPwm : pwm);
+}
+
+// Every ESC command goes through here, so zero tracking and the supervisor know
+// when the motor runs; after a safety stop the motor stays stopped until cleared.
+// The output ramps to the command at esc_slew/esc_accel. The stop value and
+// jump (step capture, closed-loop hold) skip the ramp.
+void setEsc(int pwm, bool jump) {
+  commandEsc(pwm, jump || pwm >= escRange.stopPwm, (float)escSlewUsPerS);
+}
+
+// Ramp sweeps: the same command at the sweep's own rate
+void rampEsc(int pwm, int usPerS) {
+  commandEsc(pwm, false, (float)usPerS);
+}
+
+void commandEsc(int pwm, bool jump, float slewUsPerS) {
+  if (safety.tripped()) {
+    pwm = escRange.stopPwm;
+  }
+  escCommandUs = pwm;
+  if (escRange.stopped(pwm)) {
+    safety.disarm();
   } else {
-    lcd.print("  ");
+    safety.arm(micros());  // Deadlines start before the motor does
+    zeroTracker.reset();
+  }
+  escOutput.setLimits({slewUsPerS, (float)escAccelUsPerS2});
+  if (jump || !escOutputRunning) {
+    escOutput.jumpTo(pwm);
+  } else {
+    escOutput.setTarget(pwm);
+  }
+  if (!escOutputRunning) {
+    esc.writeMicroseconds(pwm);
+  }
+  // The command; the output follows the trajectory
+  recorder.add(REC_ESC, pwm, captureUs());
+}
+
+// Until the output stage reaches the command; false on an abort
+bool waitForEsc() {
+  while (escOutputRunning && !escOutput.settled()) {
+    if (!serviceDelay(1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Recorded event time: taken right after the read or write it belongs to,
+// not when the event is queued or printed. Low 32 bits of esp_timer.
+uint32_t captureUs() {
+  return (uint32_t)esp_timer_get_time();
+}
+
+// The slow end and the arming value both leave the prop still. Zero tracking
+// waits for the output to get there, not just the command.
+bool motorStopped() {
+  return escRange.stopped(escCommandUs) && (!escOutputRunning || escRange.stopped(escOutput.output()));
+}
+
+// Feed a no-thrust reading to zero tracking; each accepted update is a drift fit point
+void trackZero(long raw, uint64_t readUs) {
+  if (!zeroTrackEnabled || !motorStopped()) {
+    return;
+  }
+  recorder.add(REC_IDLE_SAMPLE, raw, (uint32_t)readUs);
+  if (zeroTracker.update(loadCell, raw, readUs / 1e6) && temperatureAvailable) {
+    driftFit.add(loadCell.temperature(), loadCell.rawZeroKg());
+  }
+}
+
+// Load cell temperature at 1 Hz; the drift model is refolded into the conversion
+void updateTemperature() {
+#ifdef TEMP_SENSOR_NTC
+  if (millis() - lastTemperatureMs < TEMPERATURE_PERIOD_MS) {
+    return;
+  }
+  lastTemperatureMs = millis();
+  float tempC = ntcTemperatureC(analogRead(StandBoard::TEMP_PIN), StandBoard::ADC_MAX, NTC_SERIES_OHMS, NTC_OHMS_25C, NTC_BETA);
+  temperatureAvailable = !isnan(tempC);
+  if (!temperatureAvailable) {
+    return;
+  }
+  uint32_t readUs = captureUs();
+  loadCell.setTemperature(tempC);
+  recorder.addFloat(REC_TEMPERATURE, tempC, readUs);
+
+  // Console changes take effect here, relative to the temperature now
+  const DriftModel& model = loadCell.driftModel();
+  if (model.zeroKgPerC != driftZeroKgPerC || model.spanPerC != driftSpanPerC) {
+    DriftModel updated = {tempC, driftZeroKgPerC, driftSpanPerC};
+    loadCell.setDriftModel(updated);
+    recorder.addFloat(REC_DRIFT_ZERO, driftZeroKgPerC, readUs);
+    recorder.addFloat(REC_DRIFT_SPAN, driftSpanPerC, readUs);
   }
-  lcd.print("2) Algorithm test");
+#endif
+}
+
+// Load cell upkeep while nothing else reads the HX711 (menu, waits between
+// steps): with the motor armed every conversion goes to the supervisor, so a
+// step delay or settle longer than sample_timeout does not trip it; stopped,
+// conversions feed zero tracking
+void serviceLoadCell() {
+  updateTemperature();
+  bool track = zeroTrackEnabled && motorStopped();
+  if ((track || safety.armed()) && scale.is_ready()) {
+    long raw = scale.read();
+    if (safety.armed()) {
+      safety.sample(raw, loadCell.toKg(raw), micros());
+    }
+    if (track) {
+      trackZero(raw, esp_timer_get_time());
+    }
+  }
+}
+
+// Console input also counts as the host heartbeat
+void pollConsole() {
+  if (console.poll(Serial, CONSOLE_BYTES_PER_TICK) > 0) {
+    safety.heartbeat(HB_HOST, micros());
+  }
+  i2cBus.setClock(i2cClockHz);
+  serviceI2c();
+}
+
+// Long press, console abort or a safety stop
+bool exitRequested() {
+  return checkButtonLongPress() || abortRequested || safety.tripped();
+}
+
+// delay() that keeps the console responsive; false when an abort arrives
+bool serviceDelay(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    pollConsole();
+    safety.heartbeat(HB_LOOP, micros());
+    if (abortRequested || safety.tripped()) {
+      return false;
+    }
+    serviceLoadCell();
+    flushLcd();
+    delay(1);
+  }
+  return true;
+}
+
+// Queue a data row; dropped (and counted) if the UART is too far behind
+void logRow(const LineBuilder& line) {
+  if (!logWriterRunning) {
+    serialOut.print(line.c_str());
+    return;
+  }
+  logQueue.push(line);
+}
+
+// Binary frames take the same queue as the rows, so the host sees them in order
+void sendFrame(const uint8_t* frame, size_t length) {
+  if (!logWriterRunning) {
+    serialOut.write(frame, length);
+    return;
+  }
+  logQueue.push((const char*)frame, length);
+}
+
+void exitToMenu(const char* message) {
+  abortRequested = false;
+  recorder.stop(false, captureUs());
+  serialOut.println(message);
+  if (safety.tripped()) {
+    serialOut.print("SAFETY STOP: ");
+    serialOut.print(safetyFaultName(safety.fault()));
+    serialOut.print(" (");
+    serialOut.print(safety.faultValue(), 3);
+    serialOut.print(", cutoff ");
+    serialOut.print(safety.lastLatencyUs());
+    serialOut.println(" us) - short press or 'safety clear' to acknowledge");
+  }
+  printMemoryReport(consoleOut);
+  setEsc(escRange.stopPwm);  // Stop motor
+  delay(500);
+  currentState = STATE_MENU;
+  displayMenu();
+  serialOut.println("Returned to menu\n");
 }
 
 bool checkButtonPress() {
-  bool buttonPressed = (digitalRead(BUTTON_PIN) == LOW);
+  bool buttonPressed = (digitalRead(StandBoard::BUTTON_PIN) == LOW);
 
   if (buttonPressed && !buttonWasPressed) {
     buttonPressStart = millis();
@@ -111,6 +731,7 @@ bool checkButtonPress() {
     delay(DEBOUNCE_DELAY);
 
     if (pressDuration < LONG_PRESS_TIME) {
+      recorder.add(REC_BUTTON, 1, captureUs());
       return true;  // Short press
     }
   }
@@ -123,6 +744,7 @@ bool checkButtonLongPress() {
     unsigned long pressDuration = millis() - buttonPressStart;
     if (pressDuration >= LONG_PRESS_TIME) {
       buttonWasPressed = false;
+      recorder.add(REC_BUTTON, 2, captureUs());
       delay(DEBOUNCE_DELAY);
       return true;
     }
@@ -131,265 +753,535 @@ bool checkButtonLongPress() {
 }
 
 void setupManualTest() {
-  Serial.println("\n=== Manual Test Mode ===");
+  serialOut.println("\n=== Manual Test Mode ===");
 
-  lcd.clear();
+  clearLcd();
   lcd.setCursor(0, 0);
   lcd.print("Throttle:");
   lcd.setCursor(0, 2);
   lcd.print("Thrust:");
 
-  Serial.println("Throttle % | PWM (us) | Thrust (kg)");
-  Serial.println("========================================");
+  live.configure({liveSampleHz, lcdHz, liveLogHz, liveWindow});
+
+  serialOut.println("Throttle % | PWM (us) | Thrust (kg) | Min (kg) | Peak (kg) | Window | Time (us)");
+  serialOut.println("==================================================================================");
 }
 
+// Acquisition on every pass (pot, ESC, each HX711 conversion as it lands);
+// the log and the LCD show window snapshots at their own rates
 void runManualTest() {
   // Check for long press to exit
-  if (checkButtonLongPress()) {
-    Serial.println("\nExiting manual test...");
-    esc.writeMicroseconds(1360);  // Stop motor
-    delay(500);
-    currentState = STATE_MENU;
-    displayMenu();
-    Serial.println("Returned to menu\n");
+  if (exitRequested()) {
+    exitToMenu("\nExiting manual test...");
     return;
   }
 
-  // Read potentiometer and map to PWM
-  int potValue = analogRead(POT_PIN);
-  int pwmValue = map(potValue, 0, 4095, MIN_PWM, MAX_PWM);
-
-  // Send PWM to motor
-  esc.writeMicroseconds(pwmValue);
-
-  // Calculate throttle percentage
-  int throttlePercent = map(pwmValue, MAX_PWM, MIN_PWM, 0, 100);
+  // Read potentiometer and map to PWM; the output stage limits the slew
+  int potValue = analogRead(StandBoard::POT_PIN);
+  int pwmValue = escRange.pwmFromPot(potValue, StandBoard::ADC_MAX);
+  uint32_t nowUs = micros();
+  safety.heartbeat(HB_LOOP, nowUs);
+  if (pwmValue != escCommandUs) {
+    setEsc(pwmValue);
+  }
 
-  // Read load cell
-  float thrust_kg = 0.0;
   if (scale.is_ready()) {
-    float weight_raw = scale.get_units(10);
-    thrust_kg = weight_raw * CORRECTION_K;
+    long raw = scale.read();
+    uint64_t readUs = esp_timer_get_time();
+    readingUs = (uint32_t)readUs;
+    float thrust_kg = loadCell.toKg(raw);
+    safety.sample(raw, thrust_kg, micros());
+    trackZero(raw, readUs);  // Pot at the slow end
+    if (live.accept(nowUs)) {
+      live.add(thrust_kg, pwmValue, nowUs);
+    }
   }
 
-  // Display data on Serial Monitor
-  Serial.print(throttlePercent);
-  Serial.print("%\t| ");
-  Serial.print(pwmValue);
-  Serial.print("us\t| ");
-  Serial.print(thrust_kg, 3);
-  Serial.println(" kg");
-
-  // Display data on LCD
-  lcd.setCursor(0, 1);
-  lcd.print("   ");
-  lcd.setCursor(0, 1);
-  lcd.print(throttlePercent);
-  lcd.print("%");
-
-  lcd.setCursor(0, 3);
-  lcd.print("         ");
-  lcd.setCursor(0, 3);
-  lcd.print(thrust_kg, 3);
-  lcd.print(" kg");
+  bool logDue = live.logDue(nowUs);
+  bool displayDue = live.displayDue(nowUs);
+  if (!logDue && !displayDue) {
+    delay(1);
+    return;
+  }
+  LiveSnapshot snap = live.snapshot();
+  if (snap.thrust.count == 0) {
+    return;
+  }
+  int throttlePercent = escRange.percentFromPwm(snap.pwm);
+
+  if (logDue) {
+    LineBuilder line;
+    line.integer(throttlePercent).text("%\t| ").integer(snap.pwm).text("us\t| ");
+    line.fixed(snap.thrust.mean, 3).text(" kg\t| ").fixed(snap.thrust.min, 3).text(" kg\t| ");
+    line.fixed(snap.thrust.max, 3).text(" kg\t| ").integer(snap.thrust.count).text(" @ ");
+    line.fixed(snap.thrust.rateHz, 1).text(" Hz\t| ").unsignedInt(readingUs).text("\r\n");
+    logRow(line);
+  }
 
-  delay(100);
+  if (displayDue) {
+    char text[LcdFrame::COLS + 1];
+    snprintf(text, sizeof(text), "%d%%", throttlePercent);
+    lcdFrame.writePadded(0, 1, text, 4);
+    snprintf(text, sizeof(text), "%.3f kg", snap.thrust.mean);
+    lcdFrame.writePadded(0, 3, text, 10);
+    snprintf(text, sizeof(text), "pk %.3f", snap.thrust.max);
+    lcdFrame.writePadded(10, 3, text, 10);
+    flushLcd();
+  }
 }
 
 void setupAlgorithmTest() {
-  Serial.println("\n=== Algorithm Test Mode ===");
+  serialOut.println("\n=== Algorithm Test Mode ===");
 
-  lcd.clear();
+  clearLcd();
   lcd.setCursor(0, 0);
   lcd.print("Algorithm Test");
   lcd.setCursor(0, 1);
   lcd.print("Starting...");
+  flushLcd();
 
   delay(1000);
 
-  // Calculate total steps
-  int stepsDown = (MAX_PWM_ALGO - MIN_PWM_ALGO) / PWM_STEP;
-  int stepsUp = (MAX_PWM_ALGO - MIN_PWM_ALGO) / PWM_STEP;
-  totalAlgorithmSteps = stepsDown + stepsUp;
-  algorithmStep = 0;
-  maxThrustKg = 0.0;
+  // Down to the fast end and back, both ends measured in each direction
+  SweepConfig config = {sweepMaxPwm, sweepMinPwm, sweepStepPwm, true, rampRateUsPerS};
   algorithmTestCompleted = false;
 
-  lcd.clear();
+  clearLcd();
   lcd.setCursor(0, 0);
   lcd.print("Processing...");
 
-  Serial.println("PWM (us) | Throttle % | Thrust (kg) | Progress");
-  Serial.println("=============================================");
+  beginSweep(config);
 }
 
-void runAlgorithmTest() {
-  if (algorithmTestCompleted) {
-    return;  // Test already complete
+// Reset the sweep results and print the table header
+void beginSweep(const SweepConfig& config) {
+  sweep.begin(config);
+  sweepTotals.reset();
+  if (recordEnabled) {
+    startRecord(config);
   }
 
-  bool exitRequested = false;
+  if (powerAvailable) {
+    serialOut.println("PWM (us) | Throttle % | Thrust (kg) | Progress | Voltage | Current | Power | Efficiency | Time (us)");
+    serialOut.println("==================================================================================================");
+  } else {
+    serialOut.println("PWM (us) | Throttle % | Thrust (kg) | Progress | Time (us)");
+    serialOut.println("=========================================================");
+  }
+}
 
-  // Ramp DOWN from MAX to MIN (speeding up)
-  Serial.println("=== Speeding up ===");
-  for (int pwm = MAX_PWM_ALGO; pwm >= MIN_PWM_ALGO; pwm -= PWM_STEP) {
-    // Check for exit request
-    if (checkButtonLongPress()) {
-      exitRequested = true;
-      break;
+// Header with the converter as it is now; zero tracking starts a fresh window
+// so the replay begins from the same state
+void startRecord(const SweepConfig& config) {
+  RecordHeader header;
+  fillRecordHeader(header, loadCell);
+  header.run = recordRuns++;
+  header.startUs = (uint64_t)esp_timer_get_time();
+  header.sweep = config;
+  header.settleSamples = config.rampUsPerS > 0 ? 0 : (uint8_t)settleSamples;  // ramps average every reading
+  header.stoppedPwm = escRange.slowPwm;
+  header.propDiameterM = PROP_DIAMETER_M;
+  header.payload = payloadModel();
+  zeroTracker.reset();
+  recorder.start(header, &calibrationLut);
+}
+
+// One load-cell reading with the power reading beside it, both recorded
+float readSweepSample(PowerReading& reading, long* rawOut) {
+  long raw = scale.read();
+  if (rawOut) {
+    *rawOut = raw;
+  }
+  uint32_t sampleUs = captureUs();
+  readingUs = sampleUs;
+  float thrust_kg = loadCell.toKg(raw);
+  safety.sample(raw, thrust_kg, micros());
+  safety.heartbeat(HB_LOOP, micros());
+
+  // The newest pair off the bus; the read queues the next one
+  reading = {0.0, 0.0, 0.0};
+  if (powerAvailable && !powerSensor.read(reading)) {
+    reading = {0.0, 0.0, 0.0};
+  }
+  if (recorder.active()) {
+    // Power goes first (replay pairs it with the next reading), stamped after its read
+    if (powerAvailable) {
+      uint32_t powerUs = captureUs();
+      recorder.addFloat(REC_VOLTAGE, reading.voltageV, powerUs);
+      recorder.addFloat(REC_CURRENT, reading.currentA, powerUs);
+      recorder.addFloat(REC_POWER, reading.powerW, powerUs);
     }
+    recorder.add(REC_SAMPLE, raw, sampleUs);
+  }
+  return thrust_kg;
+}
 
-    esc.writeMicroseconds(pwm);
+// Sample thrust and electrical power together for one sweep step; the first
+// settleSamples are read (and recorded) but not averaged
+StepPowerResult measureSweepStep() {
+  stepPower.reset();
+
+  int samples = 0;
+  for (int i = 0; i < SAMPLES_PER_STEP && waitForConversion(); i++) {
+    PowerReading reading;
+    float thrust_kg = readSweepSample(reading);
+    if (i >= settleSamples) {
+      stepPower.add(thrust_kg, reading);
+    }
+    samples++;
+  }
+  recorder.add(REC_STEP_END, samples, captureUs());
 
-    // Read thrust
-    float thrust_kg = 0.0;
-    if (scale.is_ready()) {
-      float weight_raw = scale.get_units(10);
-      thrust_kg = weight_raw * CORRECTION_K;
+  return stepPower.result();
+}
+
+// The waits before a step read the pending conversion, so the next one is up
+// to a conversion period away; false when none comes (HX711 unplugged)
+bool waitForConversion() {
+  unsigned long start = millis();
+  while (!scale.is_ready()) {
+    if (millis() - start >= CONVERSION_WAIT_MS) {
+      return false;
     }
+    safety.heartbeat(HB_LOOP, micros());
+    delay(1);
+  }
+  return true;
+}
+
+// Stepped sweep: the output ramps to the point, then the step is measured;
+// false on an abort
+bool recordSweepStep(const SweepPoint& point) {
+  setEsc(point.pwm);
+  if (!waitForEsc()) {
+    return false;
+  }
+  // Power is read over the bus a sample behind: queue a pair at the settled
+  // output for the first one
+  if (powerAvailable) {
+    powerSensor.request();
+  }
+  if (!serviceDelay(2)) {
+    return false;
+  }
 
-    // Track maximum
-    if (thrust_kg > maxThrustKg) {
-      maxThrustKg = thrust_kg;
+  recorder.add(REC_STEP_BEGIN, point.pwm, captureUs());
+  StepPowerResult step = measureSweepStep();
+  recordVibration(point, step.voltageV);
+  reportSweepStep(point, step);
+  return true;
+}
+
+// Ramp sweep: every reading taken while the moving output is within half a
+// step of the point (direction: -1 speeding up, +1 slowing down) until it has
+// passed. atRest (phase ends): SAMPLES_PER_STEP readings once the output has
+// come to rest at the point. false on an abort.
+bool measureRampPoint(const SweepPoint& point, int direction, bool atRest) {
+  float halfStep = sweep.config().stepPwm / 2.0f;
+  stepPower.reset();
+  recorder.add(REC_STEP_BEGIN, point.pwm, captureUs());
+
+  int samples = 0;
+  while (true) {
+    pollConsole();
+    safety.heartbeat(HB_LOOP, micros());
+    if (exitRequested()) {
+      return false;
+    }
+    float along = (float)(escOutput.output() - point.pwm) * direction;
+    if (along > halfStep || (atRest && samples >= SAMPLES_PER_STEP)) {
+      break;
     }
+    bool counts = atRest ? escOutput.settled() : along > -halfStep;
+    if (!counts || !scale.is_ready()) {
+      delay(1);
+      continue;
+    }
+    PowerReading reading;
+    float thrust_kg = readSweepSample(reading);
+    stepPower.add(thrust_kg, reading);
+    samples++;
+  }
+  recorder.add(REC_STEP_END, samples, captureUs());
+  return true;
+}
 
-    int throttlePercent = map(pwm, MAX_PWM_ALGO, MIN_PWM_ALGO, 0, 100);
-    int progressPercent = (algorithmStep * 100) / totalAlgorithmSteps;
+// Totals, the table row and the LCD for one measured point
+void reportSweepStep(const SweepPoint& point, const StepPowerResult& step) {
+  int pwm = point.pwm;
+  float thrust_kg = step.thrustKg;
+  sweepTotals.add(pwm, step);
 
-    // Serial output
-    Serial.print(pwm);
-    Serial.print("us\t| ");
-    Serial.print(throttlePercent);
-    Serial.print("%\t| ");
-    Serial.print(thrust_kg, 3);
-    Serial.print(" kg\t| ");
-    Serial.print(progressPercent);
-    Serial.println("%");
+  int throttlePercent = point.throttlePercent;
+  int progressPercent = point.progressPercent;
 
-    // LCD update
-    lcd.setCursor(0, 1);
-    lcd.print("Progress: ");
-    lcd.print(progressPercent);
-    lcd.print("%   ");
+  // Serial output
+  LineBuilder line;
+  line.integer(pwm).text("us\t| ").integer(throttlePercent).text("%\t| ");
+  line.fixed(thrust_kg, 3).text(" kg\t| ").integer(progressPercent);
+  if (powerAvailable) {
+    line.text("%\t| ").fixed(step.voltageV, 2).text(" V\t| ");
+    line.fixed(step.currentA, 2).text(" A\t| ").fixed(step.powerW, 1).text(" W\t| ");
+    line.fixed(step.efficiencyGPerW, 2).text(" g/W\t| ");
+  } else {
+    line.text("%\t| ");
+  }
+  line.unsignedInt(readingUs).text("\r\n");
+  logRow(line);
+
+  // LCD update
+  char text[LcdFrame::COLS + 1];
+  snprintf(text, sizeof(text), "Progress: %d%%", progressPercent);
+  lcdFrame.writePadded(0, 1, text, LcdFrame::COLS);
+  snprintf(text, sizeof(text), "Thrust: %.3f kg", thrust_kg);
+  lcdFrame.writePadded(0, 2, text, LcdFrame::COLS);
+  if (powerAvailable) {
+    snprintf(text, sizeof(text), "%.0fW %.2fg/W", step.powerW, step.efficiencyGPerW);
+    lcdFrame.writePadded(0, 3, text, LcdFrame::COLS);
+  }
+  flushLcd();
+}
 
-    lcd.setCursor(0, 2);
-    lcd.print("Thrust: ");
-    lcd.print(thrust_kg, 3);
-    lcd.print(" kg   ");
+// Vibration amplitudes: accelerometer in g, load cell in kg
+float vibrationUnit() {
+  return vibSource == 2 ? 1.0f / Mpu6050Accel::LSB_PER_G : loadCell.kgPerCount();
+}
 
-    algorithmStep++;
-    delay(STEP_DELAY);
+// One high-rate window at the current step, then a [VIB] row: the rotor line
+// near the KV estimate (aliased for the load cell) and the largest lines
+void recordVibration(const SweepPoint& point, float voltageV) {
+  if (vibSource == 0 || (vibSource == 2 && !accelAvailable)) {
+    return;
   }
 
-  if (exitRequested) {
-    Serial.println("\nExiting algorithm test...");
-    esc.writeMicroseconds(1360);  // Stop motor
-    delay(500);
-    currentState = STATE_MENU;
-    displayMenu();
-    Serial.println("Returned to menu\n");
+  vibration.reset();
+  unsigned long firstUs = 0;
+  unsigned long lastUs = 0;
+  if (vibSource == 2) {
+    unsigned long nextUs = micros();
+    int16_t value;
+    while (!vibration.full()) {
+      while ((long)(micros() - nextUs) < 0) {
+      }
+      nextUs += VIB_ACCEL_PERIOD_US;
+      if (!accel.read(value)) {
+        break;
+      }
+      lastUs = micros();
+      if (vibration.count() == 0) firstUs = lastUs;
+      vibration.add(value);
+      safety.heartbeat(HB_LOOP, lastUs);
+    }
+  } else {
+    while (vibration.count() < VIB_LOADCELL_SAMPLES) {
+      long raw = scale.read();
+      lastUs = micros();
+      if (vibration.count() == 0) firstUs = lastUs;
+      safety.sample(raw, loadCell.toKg(raw), lastUs);
+      safety.heartbeat(HB_LOOP, lastUs);
+      vibration.add(raw);
+    }
+  }
+  if (vibration.count() < 2 || lastUs == firstUs) {
     return;
   }
 
-  Serial.println("\n[HOLD] At maximum speed for 2 seconds\n");
-  delay(2000);
+  float sampleRateHz = (vibration.count() - 1) * 1000000.0f / (lastUs - firstUs);
+  float rotorHz = expectedRotorHz(MOTOR_KV, voltageV > 0.0f ? voltageV : NOMINAL_BATTERY_V,
+                                  point.throttlePercent / 100.0f);
+  unsigned long startUs = micros();
+  bool ok = vibration.analyze(sampleRateHz, rotorHz, VIB_ROTOR_BAND, lastVibration);
+  vibAnalyzeUs = micros() - startUs;
+  if (!ok) {
+    return;
+  }
 
-  // Ramp UP from MIN to MAX (slowing down)
-  Serial.println("=== Slowing down ===");
-  for (int pwm = MIN_PWM_ALGO; pwm <= MAX_PWM_ALGO; pwm += PWM_STEP) {
-    // Check for exit request
-    if (checkButtonLongPress()) {
-      exitRequested = true;
-      break;
+  float unit = vibrationUnit();
+  const char* unitName = vibSource == 2 ? " g" : " kg";
+  LineBuilder line;
+  line.text("[VIB] ").integer(point.pwm).text("us\t| rotor ").integer(lroundf(rotorHz));
+  line.text(" Hz at ").fixed(lastVibration.rotorSeenHz, 1).text(" Hz ");
+  line.fixed(lastVibration.rotorAmplitude * unit, 4).text(unitName);
+  for (int i = 0; i < lastVibration.peakCount && i < 3; i++) {
+    const VibrationPeak& peak = lastVibration.peaks[i];
+    line.text("\t| ").fixed(peak.frequencyHz, 1).text(" Hz ").fixed(peak.amplitude * unit, 4);
+    if (peak.order > 0.0f) {
+      line.text(" ").fixed(peak.order, 2).text("x");
     }
+  }
+  line.text("\r\n");
+  logRow(line);
+}
 
-    esc.writeMicroseconds(pwm);
+// Measure the remaining sweep steps; false when the operator exits
+bool runSweepSteps(unsigned long delayMs, bool checkpoint) {
+  SweepPoint point;
+  while (sweep.next(point)) {
+    if (point.phaseStart) {
+      if (point.phase == SWEEP_SPEEDING_UP) {
+        // Ramp DOWN from MAX to MIN (speeding up)
+        serialOut.println("=== Speeding up ===");
+      } else {
+        serialOut.println("\n[HOLD] At maximum speed for 2 seconds\n");
+        if (!serviceDelay(2000)) {
+          return false;
+        }
+        // Ramp UP from MIN to MAX (slowing down)
+        serialOut.println("=== Slowing down ===");
+      }
+    }
 
-    // Read thrust
-    float thrust_kg = 0.0;
-    if (scale.is_ready()) {
-      float weight_raw = scale.get_units(10);
-      thrust_kg = weight_raw * CORRECTION_K;
+    // Check for exit request
+    if (exitRequested()) {
+      return false;
     }
 
-    // Track maximum
-    if (thrust_kg > maxThrustKg) {
-      maxThrustKg = thrust_kg;
+    if (!recordSweepStep(point)) {
+      return false;
     }
+    if (checkpoint) {
+      batch.stepDone(sweep.index(), sweepSummary());
+    }
+    if (!serviceDelay(delayMs)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-    int throttlePercent = map(pwm, MAX_PWM_ALGO, MIN_PWM_ALGO, 0, 100);
-    int progressPercent = (algorithmStep * 100) / totalAlgorithmSteps;
+// Continuous ramps at the sweep's rampUsPerS: the first point of each phase is
+// measured at rest, then the output ramps to the phase's end and every point on
+// the way is measured as it passes (no step transients, no vibration windows).
+// Rows lag by rampUsPerS x the motor's spin-up time constant. false when the
+// operator exits.
+bool runRampSweep(bool checkpoint) {
+  const SweepConfig& config = sweep.config();
+  bool ramping = false;
+  SweepPoint point;
+  while (sweep.next(point)) {
+    if (point.phaseStart) {
+      if (point.phase == SWEEP_SPEEDING_UP) {
+        serialOut.println("=== Speeding up (ramp) ===");
+      } else {
+        serialOut.println("\n[HOLD] At maximum speed for 2 seconds\n");
+        if (!serviceDelay(2000)) {
+          return false;
+        }
+        serialOut.println("=== Slowing down (ramp) ===");
+      }
+      ramping = false;
+    }
 
-    // Serial output
-    Serial.print(pwm);
-    Serial.print("us\t| ");
-    Serial.print(throttlePercent);
-    Serial.print("%\t| ");
-    Serial.print(thrust_kg, 3);
-    Serial.print(" kg\t| ");
-    Serial.print(progressPercent);
-    Serial.println("%");
+    int endPwm = point.phase == SWEEP_SPEEDING_UP ? config.fastPwm : config.slowPwm;
+    if (!ramping) {
+      // Phase start, or the point a resumed run picks up at
+      setEsc(point.pwm);
+      if (!waitForEsc()) {
+        return false;
+      }
+    }
+    bool atRest = !ramping || point.pwm == endPwm;
+    if (!measureRampPoint(point, endPwm < point.pwm ? -1 : 1, atRest)) {
+      return false;
+    }
+    if (!ramping) {
+      rampEsc(endPwm, config.rampUsPerS);
+      ramping = true;
+    }
+    reportSweepStep(point, stepPower.result());
+    if (checkpoint) {
+      batch.stepDone(sweep.index(), sweepSummary());
+    }
+  }
+  return true;
+}
 
-    // LCD update
-    lcd.setCursor(0, 1);
-    lcd.print("Progress: ");
-    lcd.print(progressPercent);
-    lcd.print("%   ");
+bool runSweep(unsigned long delayMs, bool checkpoint) {
+  if (sweep.config().rampUsPerS > 0) {
+    return runRampSweep(checkpoint);
+  }
+  return runSweepSteps(delayMs, checkpoint);
+}
 
-    lcd.setCursor(0, 2);
-    lcd.print("Thrust: ");
-    lcd.print(thrust_kg, 3);
-    lcd.print(" kg   ");
+RunSummary sweepSummary() {
+  RunSummary summary = {sweepTotals.maxThrustKg, sweepTotals.bestEfficiencyGPerW,
+                        (int16_t)sweepTotals.bestEfficiencyPwm, sweepTotals.maxPowerW};
+  return summary;
+}
 
-    algorithmStep++;
-    delay(STEP_DELAY);
+void runAlgorithmTest() {
+  if (algorithmTestCompleted) {
+    return;  // Test already complete
   }
 
-  if (exitRequested) {
-    Serial.println("\nExiting algorithm test...");
-    esc.writeMicroseconds(1360);  // Stop motor
-    delay(500);
-    currentState = STATE_MENU;
-    displayMenu();
-    Serial.println("Returned to menu\n");
+  if (!runSweep(stepDelayMs, false)) {
+    exitToMenu("\nExiting algorithm test...");
     return;
   }
 
   // Stop motor
-  esc.writeMicroseconds(MAX_PWM_ALGO);
+  setEsc(sweepMaxPwm);
+  recorder.stop(true, captureUs());
+
+  printPayloadSummary();
+  showSweepResults();
+  algorithmTestCompleted = true;
+}
 
-  // Calculate payload
-  float totalThrust = maxThrustKg * NUM_MOTORS;
-  float maxTotalWeight = totalThrust / THRUST_TO_WEIGHT_RATIO;
-  float payloadCapacity = maxTotalWeight - DRONE_WEIGHT_KG;
+void printPayloadSummary() {
+  float totalThrust = sweepTotals.maxThrustKg * NUM_MOTORS;
+  float payloadCapacity = computePayloadKg(sweepTotals.maxThrustKg);
 
   // Serial output
-  Serial.println("\n========== PAYLOAD CALCULATION ==========");
-  Serial.print("Max single motor thrust: ");
-  Serial.print(maxThrustKg, 3);
-  Serial.println(" kg");
-  Serial.print("Total thrust (4 motors): ");
-  Serial.print(totalThrust, 3);
-  Serial.println(" kg");
-  Serial.print("Drone weight: ");
-  Serial.print(DRONE_WEIGHT_KG, 3);
-  Serial.println(" kg");
-  Serial.print("Thrust-to-weight ratio: ");
-  Serial.print(THRUST_TO_WEIGHT_RATIO, 1);
-  Serial.println(":1");
-  Serial.print("\n>>> PAYLOAD CAPACITY: ");
-  Serial.print(payloadCapacity, 3);
-  Serial.println(" kg <<<\n");
-  Serial.println("=========================================\n");
-
-  // LCD display results
-  lcd.clear();
+  serialOut.println("\n========== PAYLOAD CALCULATION ==========");
+  serialOut.print("Max single motor thrust: ");
+  serialOut.print(sweepTotals.maxThrustKg, 3);
+  serialOut.println(" kg");
+  if (powerAvailable) {
+    serialOut.print("Best efficiency: ");
+    serialOut.print(sweepTotals.bestEfficiencyGPerW, 2);
+    serialOut.print(" g/W at ");
+    serialOut.print(sweepTotals.bestEfficiencyPwm);
+    serialOut.println("us");
+    serialOut.print("Peak electrical power: ");
+    serialOut.print(sweepTotals.maxPowerW, 1);
+    serialOut.println(" W");
+  }
+  serialOut.print("Total thrust (4 motors): ");
+  serialOut.print(totalThrust, 3);
+  serialOut.println(" kg");
+  serialOut.print("Drone weight: ");
+  serialOut.print(droneWeightKg, 3);
+  serialOut.println(" kg");
+  serialOut.print("Thrust-to-weight ratio: ");
+  serialOut.print(thrustToWeightRatio, 1);
+  serialOut.println(":1");
+  serialOut.print("\n>>> PAYLOAD CAPACITY: ");
+  serialOut.print(payloadCapacity, 3);
+  serialOut.println(" kg <<<\n");
+  serialOut.println("=========================================\n");
+}
+
+// Results stay on the LCD until a button press or abort
+void showSweepResults() {
+  float totalThrust = sweepTotals.maxThrustKg * NUM_MOTORS;
+  float payloadCapacity = computePayloadKg(sweepTotals.maxThrustKg);
+
+  clearLcd();
   lcd.setCursor(0, 0);
   lcd.print("Test Complete!");
   lcd.setCursor(0, 1);
-  lcd.print("Max thrust: ");
-  lcd.print(maxThrustKg, 2);
-  lcd.print("kg");
+  if (powerAvailable) {
+    lcd.print("Max:");
+    lcd.print(sweepTotals.maxThrustKg, 2);
+    lcd.print("kg ");
+    lcd.print(sweepTotals.bestEfficiencyGPerW, 1);
+    lcd.print("g/W");
+  } else {
+    lcd.print("Max thrust: ");
+    lcd.print(sweepTotals.maxThrustKg, 2);
+    lcd.print("kg");
+  }
   lcd.setCursor(0, 2);
   lcd.print("UAV thrust: ");
   lcd.print(totalThrust, 2);
@@ -398,90 +1290,1685 @@ void runAlgorithmTest() {
   lcd.print("Payload: ");
   lcd.print(payloadCapacity, 2);
   lcd.print("kg");
-
-  algorithmTestCompleted = true;
 }
 
-void setup() {
-  Serial.begin(9600);
-  delay(1000);
-
-  Serial.println("\n=== UAV Motor Thrust Stand ===\n");
+// Build the plan from the profile list (or the sweep settings) and run it
+void startBatch() {
+  BatchPlan plan;
+  plan.repetitions = (uint16_t)batchRepetitions;
+  plan.autoTare = batchAutoTare != 0;
+  plan.cooldownMs = batchCooldownS * 1000;
+  if (batchProfileCount > 0) {
+    plan.profileCount = (uint8_t)batchProfileCount;
+    for (int i = 0; i < batchProfileCount; i++) {
+      plan.profiles[i] = batchProfiles[i];
+    }
+  } else {
+    plan.profileCount = 1;
+    plan.profiles[0] = {(int16_t)sweepMaxPwm, (int16_t)sweepMinPwm, (int16_t)sweepStepPwm,
+                        (uint16_t)stepDelayMs, (uint16_t)rampRateUsPerS};
+  }
 
-  // Configure pins
-  pinMode(POT_PIN, INPUT);
-  pinMode(BUTTON_PIN, INPUT_PULLUP);
+  for (int i = 0; i < plan.profileCount; i++) {
+    if (!escRange.contains(plan.profiles[i].slowPwm) || !escRange.contains(plan.profiles[i].fastPwm)) {
+      serialOut.println("ERR batch sweep outside the ESC range, see 'esc'");
+      return;
+    }
+  }
+  if (!batch.begin(plan)) {
+    serialOut.println("ERR invalid batch plan");
+    return;
+  }
+  currentState = STATE_BATCH;
+  runBatch();
+}
 
-  // Initialize LCD
-  Wire.begin();
-  lcd.init();
-  lcd.backlight();
+// Runs every remaining sweep of the batch, picking up mid-run after a reset
+void runBatch() {
+  serialOut.println("\n=== Batch Queue ===");
+  bool resuming = batch.resumeStep() > 0;
 
-  // Show welcome screen
-  displayWelcomeScreen();
-  Serial.println("Welcome screen displayed");
-  delay(2000);
+  while (batch.active()) {
+    const BatchProfile& profile = batch.profile();
 
-  // Attach and arm ESC
-  esc.attach(MOTOR_PIN, 1000, 2000);
-  Serial.println("Arming ESC at 1360us (stopped)...");
-  esc.writeMicroseconds(1360);
-  delay(2000);
-  Serial.println("ESC armed!");
+    // Cooldown with the motor stopped; a resumed run continues right away
+    if (batch.run() > 0 && !resuming && !batchCooldown(batch.plan().cooldownMs)) {
+      batch.cancel();
+      exitToMenu("\nBatch aborted");
+      return;
+    }
+    // Zero drifts with temperature; after a reset the boot calibration has tared
+    if (batch.plan().autoTare && !resuming) {
+      scale.tare();
+      loadCell.tare(scale.get_offset());
+    }
 
-  // Initialize and calibrate load cell
-  Serial.println("\nCalibrating load cell...");
-  lcd.clear();
-  lcd.setCursor(0, 1);
-  lcd.print("Calibrating...");
+    serialOut.print("\n[BATCH] Run ");
+    serialOut.print(batch.run() + 1);
+    serialOut.print("/");
+    serialOut.print(batch.totalRuns());
+    serialOut.print(", profile ");
+    serialOut.print(batch.profileIndex() + 1);
+    serialOut.print(": ");
+    serialOut.print(profile.slowPwm);
+    serialOut.print("->");
+    serialOut.print(profile.fastPwm);
+    serialOut.print("us, step ");
+    serialOut.print(profile.stepPwm);
+    serialOut.print("us, ");
+    serialOut.print(profile.stepDelayMs);
+    serialOut.print(" ms");
+    if (profile.rampUsPerS > 0) {
+      serialOut.print(", ramp ");
+      serialOut.print(profile.rampUsPerS);
+      serialOut.print(" us/s");
+    }
+    serialOut.println();
+
+    clearLcd();
+    char text[LcdFrame::COLS + 1];
+    snprintf(text, sizeof(text), "Batch %d/%d P%d", batch.run() + 1, batch.totalRuns(),
+             batch.profileIndex() + 1);
+    lcdFrame.writePadded(0, 0, text, LcdFrame::COLS);
+    flushLcd();
+
+    SweepConfig config = {profile.slowPwm, profile.fastPwm, profile.stepPwm, true, profile.rampUsPerS};
+    beginSweep(config);
+    if (resuming) {
+      // Steps already measured before the reset are not repeated
+      RunSummary partial = batch.partial();
+      sweep.seek(batch.resumeStep());
+      sweepTotals.maxThrustKg = partial.maxThrustKg;
+      sweepTotals.bestEfficiencyGPerW = partial.bestEfficiencyGPerW;
+      sweepTotals.bestEfficiencyPwm = partial.bestEfficiencyPwm;
+      sweepTotals.maxPowerW = partial.maxPowerW;
+      serialOut.print("=== Resumed at step ");
+      serialOut.print(batch.resumeStep() + 1);
+      serialOut.println(" ===");
+      resuming = false;
+    }
 
-  scale.begin(DT, SCK);
-  delay(1000);
-  scale.tare();
+    if (!runSweep(profile.stepDelayMs, true)) {
+      batch.cancel();
+      exitToMenu("\nBatch aborted");
+      return;
+    }
+    setEsc(escRange.stopPwm);  // Stop motor
+    recorder.stop(true, captureUs());
+
+    // Per-run summary, one parseable row
+    LineBuilder line;
+    line.text("[BATCH] run ").integer(batch.run() + 1).text(" | profile ").integer(batch.profileIndex() + 1);
+    line.text(" | max ").fixed(sweepTotals.maxThrustKg, 3).text(" kg | payload ");
+    line.fixed(computePayloadKg(sweepTotals.maxThrustKg), 3).text(" kg");
+    if (powerAvailable) {
+      line.text(" | best ").fixed(sweepTotals.bestEfficiencyGPerW, 2).text(" g/W at ");
+      line.integer(sweepTotals.bestEfficiencyPwm);
+      line.text("us | peak ").fixed(sweepTotals.maxPowerW, 1).text(" W");
+    }
+    line.text("\r\n");
+    logRow(line);
 
-  long raw = scale.read_average(20);
-  float scale_factor = raw / CALIBRATION_WEIGHT_KG;
-  scale.set_scale(scale_factor);
+    batch.runDone(sweepSummary());
+  }
 
-  Serial.println("Load cell calibrated!");
+  printBatchTotals();
+}
 
-  // Move to menu
-  currentState = STATE_MENU;
-  displayMenu();
-  Serial.println("Menu displayed\n");
+// Motor stopped for ms, counting down on the LCD; false when the operator exits
+bool batchCooldown(unsigned long ms) {
+  setEsc(escRange.stopPwm);
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Batch cooldown");
+
+  char text[LcdFrame::COLS + 1];
+  for (unsigned long left = (ms + 999) / 1000; left > 0; left--) {
+    snprintf(text, sizeof(text), "Next run in %lus", left);
+    lcdFrame.writePadded(0, 1, text, LcdFrame::COLS);
+    flushLcd();
+    if (exitRequested() || !serviceDelay(ms < 1000 ? ms : 1000)) {
+      return false;
+    }
+    ms -= ms < 1000 ? ms : 1000;
+  }
+  return true;
 }
 
-void loop() {
-  // Check button inputs
-  bool shortPress = checkButtonPress();
-  bool longPress = checkButtonLongPress();
+// Max thrust spread across repetitions, per profile
+void printBatchTotals() {
+  serialOut.println("\n============ BATCH SUMMARY ============");
+  serialOut.println("Profile | Runs | Max thrust mean | SD | Min | Max (kg)");
 
-  switch (currentState) {
-    case STATE_WELCOME:
-      // Auto-transition handled in setup
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Batch complete!");
+
+  char text[LcdFrame::COLS + 1];
+  for (int p = 0; p < batch.plan().profileCount; p++) {
+    const RunningStats& stats = batch.profileStats(p);
+    serialOut.print(p + 1);
+    serialOut.print("\t| ");
+    serialOut.print(stats.count());
+    serialOut.print("\t| ");
+    serialOut.print(stats.mean(), 3);
+    serialOut.print("\t| ");
+    serialOut.print(stats.stddev(), 3);
+    serialOut.print("\t| ");
+    serialOut.print(stats.min(), 3);
+    serialOut.print("\t| ");
+    serialOut.println(stats.max(), 3);
+
+    if (p < 3) {
+      snprintf(text, sizeof(text), "P%d %.3f sd%.3fkg", p + 1, stats.mean(), stats.stddev());
+      lcdFrame.writePadded(0, p + 1, text, LcdFrame::COLS);
+    }
+  }
+  serialOut.println("=======================================\n");
+  flushLcd();
+}
+
+// A checkpoint at boot means a reset cut the last batch short
+void offerBatchResume() {
+  serialOut.print("\nUnfinished batch: run ");
+  serialOut.print(batch.run() + 1);
+  serialOut.print("/");
+  serialOut.print(batch.totalRuns());
+  serialOut.print(", step ");
+  serialOut.println(batch.resumeStep() + 1);
+  serialOut.println("Resuming - press the button or send 'abort' to cancel");
+
+  currentState = STATE_BATCH;  // so the console abort applies
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Resume batch?");
+  char text[LcdFrame::COLS + 1];
+  snprintf(text, sizeof(text), "Run %d/%d", batch.run() + 1, batch.totalRuns());
+  lcdFrame.writePadded(0, 1, text, LcdFrame::COLS);
+
+  for (int left = BATCH_RESUME_COUNTDOWN_S; left > 0; left--) {
+    snprintf(text, sizeof(text), "Starting in %ds", left);
+    lcdFrame.writePadded(0, 2, text, LcdFrame::COLS);
+    flushLcd();
+    unsigned long start = millis();
+    while (millis() - start < 1000) {
+      if (checkButtonPress() || !serviceDelay(10)) {
+        batch.cancel();
+        exitToMenu("\nBatch resume cancelled");
+        return;
+      }
+    }
+  }
+  runBatch();
+}
+
+void setupThrustHold() {
+  serialOut.println("\n=== Thrust Hold Mode ===");
+
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Hold:");
+  lcd.setCursor(0, 1);
+  lcd.print("Thrust:");
+  lcd.setCursor(0, 2);
+  lcd.print("Throttle:");
+
+  // Start from a stopped motor and an empty filter
+  setEsc(escRange.slowPwm);
+  holdFilter.setAlpha(EmaFilter::alphaFor(HOLD_FILTER_TIME_S, HX711_SAMPLE_PERIOD_S));
+  holdFilter.reset(0.0);
+  holdPid.reset(0.0, 0.0);
+  holdSetpointKg = 0.0;
+  holdStepReported = true;
+  holdLastSampleUs = micros();
+  live.configure({liveSampleHz, lcdHz, liveLogHz, liveWindow});  // LCD rate only
+
+  serialOut.println("Setpoint (kg) | Thrust (kg) | Throttle % | PWM (us) | Time (us)");
+  serialOut.println("===============================================================");
+}
+
+void runThrustHold() {
+  if (exitRequested()) {
+    exitToMenu("\nExiting thrust hold...");
+    return;
+  }
+
+  // Pot selects the setpoint, quantized so ADC noise does not restart the step metrics
+  int potValue = analogRead(StandBoard::POT_PIN);
+  float setpointKg = (potValue / (double)StandBoard::ADC_MAX) * HOLD_MAX_SETPOINT_KG;
+  setpointKg = roundf(setpointKg / HOLD_SETPOINT_STEP_KG) * HOLD_SETPOINT_STEP_KG;
+
+  // The loop runs at the HX711 data rate
+  if (!scale.is_ready()) {
+    return;
+  }
+
+  unsigned long nowUs = micros();
+  float dtS = (nowUs - holdLastSampleUs) / 1000000.0;
+  holdLastSampleUs = nowUs;
+  float timeS = nowUs / 1000000.0;
+
+  long raw = scale.read();
+  readingUs = captureUs();
+  float rawKg = loadCell.toKg(raw);
+  safety.sample(raw, rawKg, micros());
+  safety.heartbeat(HB_LOOP, micros());
+  float thrust_kg = holdFilter.update(rawKg);
+
+  if (fabsf(setpointKg - holdSetpointKg) >= HOLD_SETPOINT_STEP_KG / 2) {
+    holdStep.begin(thrust_kg, setpointKg, timeS);
+    holdSetpointKg = setpointKg;
+    holdStepReported = false;
+  }
+
+  float throttle = holdPid.update(holdSetpointKg, thrust_kg, dtS);
+
+  int pwmValue = escRange.pwmFromThrottle(throttle);
+  setEsc(pwmValue, true);  // The controller limits its own rate; a ramp would add lag
+
+  holdStep.add(timeS, thrust_kg);
+  StepResponseMetrics metrics = holdStep.metrics();
+  if (!holdStepReported && metrics.settled) {
+    LineBuilder report;
+    report.text("[STEP] rise ").fixed(metrics.riseTimeS, 2).text(" s | overshoot ");
+    report.fixed(metrics.overshootPercent, 1).text(" % | settling ");
+    report.fixed(metrics.settlingTimeS, 2).text(" s\r\n");
+    logRow(report);
+    holdStepReported = true;
+  }
+
+  int throttlePercent = (int)lroundf(throttle * 100);
+
+  // Display data on Serial Monitor
+  LineBuilder line;
+  line.fixed(holdSetpointKg, 3).text(" kg\t| ").fixed(thrust_kg, 3).text(" kg\t| ");
+  line.integer(throttlePercent).text("%\t| ").integer(pwmValue).text("us\t| ");
+  line.unsignedInt(readingUs).text("\r\n");
+  logRow(line);
+
+  // Rows at the sample rate (controller trace), the LCD at lcd_hz
+  if (!live.displayDue(nowUs)) {
+    return;
+  }
+  char text[LcdFrame::COLS + 1];
+  snprintf(text, sizeof(text), "%.3f kg", holdSetpointKg);
+  lcdFrame.writePadded(10, 0, text, 10);
+  snprintf(text, sizeof(text), "%.3f kg", thrust_kg);
+  lcdFrame.writePadded(10, 1, text, 10);
+  snprintf(text, sizeof(text), "%d%%", throttlePercent);
+  lcdFrame.writePadded(10, 2, text, 10);
+  lcdFrame.writePadded(0, 3, holdPid.saturated() ? "SATURATED" : "", 9);
+  flushLcd();
+}
+
+// Capture raw samples at the HX711 data rate around one PWM step
+bool captureStep(int fromPwm, int toPwm) {
+  setEsc(fromPwm);
+  if (!waitForEsc() || !serviceDelay(BURST_SETTLE_MS)) {
+    return false;
+  }
+
+  // Drop the stale conversion so the first sample is fresh
+  if (scale.is_ready()) {
+    scale.read();
+  }
+
+  int64_t startUs = esp_timer_get_time();
+  burst.start(startUs);
+  bool stepped = false;
+  int pwm = fromPwm;
+
+  while (true) {
+    int64_t nowUs = esp_timer_get_time();
+    uint32_t elapsedUs = burst.elapsedUs(nowUs);
+    if (elapsedUs >= BURST_WINDOW_US || burst.full()) {
+      break;
+    }
+    if (exitRequested()) {
+      return false;
+    }
+    safety.heartbeat(HB_LOOP, micros());
+
+    if (!stepped && elapsedUs >= BURST_PRE_TRIGGER_US) {
+      // A true step: the output jumps on the next tick, marked when it was written
+      setEsc(toPwm, true);
+      while (escOutputRunning && !escOutput.settled()) {
+      }
+      int64_t stepUs = esp_timer_get_time();
+      if (escOutputRunning) {
+        stepUs += (int32_t)(escOutput.writtenUs() - (uint32_t)stepUs);
+      }
+      burst.markStep(stepUs, fromPwm, toPwm);
+      pwm = toPwm;
+      stepped = true;
+    }
+
+    if (scale.is_ready()) {
+      // Stamp at the data-ready edge, before the 24-bit shift-out
+      int64_t sampleUs = esp_timer_get_time();
+      long raw = scale.read();
+      safety.sample(raw, loadCell.toKg(raw), micros());
+
+      uint16_t currentMa = 0;
+      PowerReading reading;
+      if (powerAvailable && powerSensor.read(reading) && reading.currentA > 0) {
+        currentMa = (uint16_t)constrain(reading.currentA * 1000.0f, 0.0f, 65535.0f);
+      }
+      burst.add(sampleUs, raw, pwm, currentMa);
+    }
+  }
+  return true;
+}
+
+// Send one capture as binary frames (header, samples, analysis)
+void dumpBurst(uint16_t stepIndex, const BurstAnalysis& analysis) {
+  size_t n = encodeBurstHeader(burst, stepIndex, telemetryFrame, sizeof(telemetryFrame));
+  serialOut.write(telemetryFrame, n);
+
+  for (size_t first = 0; first < burst.count(); first += BURST_SAMPLES_PER_FRAME) {
+    n = encodeBurstSamples(burst, stepIndex, first, telemetryFrame, sizeof(telemetryFrame));
+    serialOut.write(telemetryFrame, n);
+  }
+
+  n = encodeBurstResult(analysis, stepIndex, telemetryFrame, sizeof(telemetryFrame));
+  serialOut.write(telemetryFrame, n);
+  serialOut.println();
+}
+
+void runStepCapture() {
+  serialOut.println("\n=== Step Capture Mode ===");
+
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Step Capture");
+
+  if (!burstAvailable) {
+    serialOut.println("Capture buffer not allocated");
+    lcd.setCursor(0, 1);
+    lcd.print("No capture buffer");
+    flushLcd();
+    delay(2000);
+    exitToMenu("Step capture unavailable");
+    return;
+  }
+
+  enduranceWindowHeld = false;  // Same buffer
+
+  serialOut.println("Step (us)   | Samples | Rate (Hz) | Dead (s) | Rise (s) | Tau (s) | Delta (kg)");
+  serialOut.println("===============================================================================");
+
+  float kgPerCount = loadCell.kgPerCount();
+
+  uint16_t stepIndex = 0;
+  for (int fromPwm = sweepMaxPwm; fromPwm - BURST_STEP_PWM >= sweepMinPwm; fromPwm -= BURST_STEP_PWM) {
+    int toPwm = fromPwm - BURST_STEP_PWM;
+
+    lcd.setCursor(0, 1);
+    lcd.print(fromPwm);
+    lcd.print(" -> ");
+    lcd.print(toPwm);
+    lcd.print("us  ");
+
+    if (!captureStep(fromPwm, toPwm)) {
+      exitToMenu("\nExiting step capture...");
+      return;
+    }
+
+    BurstAnalysis analysis = analyzeBurst(burst.samples(), burst.count(), burst.stepUs());
+
+    serialOut.print(fromPwm);
+    serialOut.print("->");
+    serialOut.print(toPwm);
+    serialOut.print("\t| ");
+    serialOut.print(analysis.samples);
+    serialOut.print("\t| ");
+    serialOut.print(analysis.sampleRateHz, 1);
+    serialOut.print("\t| ");
+    serialOut.print(analysis.deadTimeS, 3);
+    serialOut.print("\t| ");
+    serialOut.print(analysis.riseTimeS, 3);
+    serialOut.print("\t| ");
+    serialOut.print(analysis.timeConstantS, 3);
+    serialOut.print("\t| ");
+    serialOut.println((analysis.finalRaw - analysis.baselineRaw) * kgPerCount, 3);
+
+    lcd.setCursor(0, 2);
+    lcd.print("Rise: ");
+    lcd.print(analysis.riseTimeS, 3);
+    lcd.print(" s   ");
+    lcd.setCursor(0, 3);
+    lcd.print("Tau: ");
+    lcd.print(analysis.timeConstantS, 3);
+    lcd.print(" s   ");
+
+    dumpBurst(stepIndex, analysis);
+    stepIndex++;
+  }
+
+  exitToMenu("\nStep capture complete");
+}
+
+// The named ESC's stored endpoints, or the stand ESC's when it has none
+void useEscProfile(const char* name) {
+  strncpy(escName, name, ESC_NAME_MAX - 1);
+  escName[ESC_NAME_MAX - 1] = '\0';
+  escProfileLoaded = loadEscProfile(escName, escProfile);
+  applyEscProfile();
+}
+
+// escRange from the profile in use; the sweep range follows
+void applyEscProfile() {
+  if (escProfileLoaded) {
+    const EscEndpoints& e = escProfile.endpoints;
+    escRange = {e.fastPwm, e.slowPwm, e.stopPwm};
+    sweepMinPwm = e.fastPwm;
+    sweepMaxPwm = e.slowPwm;
+  } else {
+    escRange = StandEsc::range();
+    sweepMinPwm = MIN_PWM_ALGO;
+    sweepMaxPwm = MAX_PWM_ALGO;
+  }
+}
+
+// Runs the endpoint search on the ESC on the stand and stores the result
+// under its name. Until it succeeds any pulse faster than the search's slow
+// end counts as turning (supervisor armed, no zero tracking).
+void runEscDiscovery() {
+  serialOut.println("\n=== ESC Discovery ===");
+  serialOut.print("ESC: ");
+  serialOut.println(escName);
+
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("ESC discovery");
+  flushLcd();
+
+  EscRange previous = escRange;
+  escRange = {escDiscoveryConfig.searchFastPwm, escDiscoveryConfig.searchSlowPwm,
+              escDiscoveryConfig.searchSlowPwm};
+
+  // Resting noise sets the thrust that counts as turning
+  setEsc(escRange.stopPwm);
+  if (!serviceDelay(ESC_DISCOVER_REST_MS)) {
+    escRange = previous;
+    exitToMenu("\nExiting ESC discovery...");
+    return;
+  }
+  RunningStats rest;
+  for (int i = 0; i < ESC_DISCOVER_SAMPLES * 2; i++) {
+    PowerReading reading;
+    rest.add(readSweepSample(reading));
+  }
+  escDiscovery.begin(escDiscoveryConfig, rest.stddev());
+  serialOut.print("Turning above ");
+  serialOut.print(escDiscovery.endpoints().spinKg, 3);
+  serialOut.println(" kg");
+
+  serialOut.println("Phase | PWM (us) | Start | Thrust (kg)");
+  serialOut.println("=====================================");
+  const char* const STARTS[] = {"running", "from rest", "from spin"};
+  EscProbe probe;
+  while (escDiscovery.next(probe)) {
+    char text[LcdFrame::COLS + 1];
+    snprintf(text, sizeof(text), "%s", escDiscoveryPhaseName(escDiscovery.phase()));
+    lcdFrame.writePadded(0, 1, text, LcdFrame::COLS);
+    snprintf(text, sizeof(text), "Probe %d: %dus", escDiscovery.probes() + 1, probe.pwm);
+    lcdFrame.writePadded(0, 2, text, LcdFrame::COLS);
+    flushLcd();
+
+    float thrust_kg = runEscProbe(probe);
+    if (isnan(thrust_kg)) {
+      escRange = previous;
+      exitToMenu("\nExiting ESC discovery...");
+      return;
+    }
+
+    LineBuilder line;
+    line.text(escDiscoveryPhaseName(escDiscovery.phase())).text("\t| ").integer(probe.pwm);
+    line.text("us\t| ").text(STARTS[probe.start]).text("\t| ").fixed(thrust_kg, 3).text(" kg\r\n");
+    logRow(line);
+    snprintf(text, sizeof(text), "Thrust: %.3f kg", thrust_kg);
+    lcdFrame.writePadded(0, 3, text, LcdFrame::COLS);
+
+    escDiscovery.measured(thrust_kg);
+  }
+  setEsc(escRange.stopPwm);
+
+  if (!escDiscovery.ok()) {
+    serialOut.print("ESC discovery failed: ");
+    serialOut.println(escDiscovery.failure());
+    escRange = previous;
+    exitToMenu("Previous ESC range kept");
+    return;
+  }
+
+  const EscEndpoints& e = escDiscovery.endpoints();
+  clearEscProfile(escProfile, escName);
+  escProfile.endpoints = e;
+  bool saved = saveEscProfile(escProfile);
+  escProfileLoaded = true;  // In use even if the save failed
+  applyEscProfile();
+
+  serialOut.print("Spin-up ");
+  serialOut.print(e.startPwm);
+  serialOut.print("us, stall ");
+  serialOut.print(e.stallPwm);
+  serialOut.print("us, saturation ");
+  serialOut.print(e.fastPwm);
+  serialOut.print(e.saturated ? "us" : "us (still climbing at disc_fast)");
+  serialOut.print(", max ");
+  serialOut.print(e.maxThrustKg, 3);
+  serialOut.println(" kg");
+  serialOut.print("Sweep range ");
+  serialOut.print(e.slowPwm);
+  serialOut.print("->");
+  serialOut.print(e.fastPwm);
+  serialOut.print("us, stop ");
+  serialOut.print(e.stopPwm);
+  serialOut.print("us, ");
+  serialOut.print(e.probes);
+  serialOut.println(" probes");
+  serialOut.println(saved ? "Saved" : "ERR not saved, in use until reset");
+
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("ESC discovery done");
+  char text[LcdFrame::COLS + 1];
+  snprintf(text, sizeof(text), "Range %d-%d", e.fastPwm, e.slowPwm);
+  lcdFrame.writePadded(0, 1, text, LcdFrame::COLS);
+  snprintf(text, sizeof(text), "Stop %d Start %d", e.stopPwm, e.startPwm);
+  lcdFrame.writePadded(0, 2, text, LcdFrame::COLS);
+  snprintf(text, sizeof(text), "Max %.3f kg", e.maxThrustKg);
+  lcdFrame.writePadded(0, 3, text, LcdFrame::COLS);
+  flushLcd();
+  delay(3000);
+  exitToMenu("\nESC discovery complete");
+}
+
+// Brings the motor to the probe's pulse the way the search asks, lets it
+// settle and averages the thrust; NAN on an abort
+float runEscProbe(const EscProbe& probe) {
+  if (probe.start != ESC_PROBE_RUNNING) {
+    setEsc(escRange.stopPwm);
+    if (!serviceDelay(ESC_DISCOVER_REST_MS)) {
+      return NAN;
+    }
+  }
+  if (probe.start == ESC_PROBE_FROM_SPIN) {
+    setEsc(probe.spinPwm);
+    if (!waitForEsc() || !holdSampling(ESC_DISCOVER_SPIN_MS)) {
+      return NAN;
+    }
+  }
+  setEsc(probe.pwm);
+  if (!waitForEsc() || !holdSampling(ESC_DISCOVER_SETTLE_MS)) {
+    return NAN;
+  }
+
+  float sum = 0.0f;
+  for (int i = 0; i < ESC_DISCOVER_SAMPLES; i++) {
+    PowerReading reading;
+    sum += readSweepSample(reading);
+  }
+  return sum / ESC_DISCOVER_SAMPLES;
+}
+
+// Wait at a pulse that may turn the motor, every conversion going to the
+// supervisor; false on an abort
+bool holdSampling(unsigned long ms) {
+  unsigned long start = millis();
+  while (millis() - start < ms) {
+    pollConsole();
+    safety.heartbeat(HB_LOOP, micros());
+    if (exitRequested()) {
+      return false;
+    }
+    if (scale.is_ready()) {
+      PowerReading reading;
+      readSweepSample(reading);
+    }
+    flushLcd();
+    delay(1);
+  }
+  return true;
+}
+
+// Thrust change against the run's first minute, 0 before it ends
+float enduranceChangePercent(float thrustKg) {
+  float referenceKg = endurance.record().referenceKg;
+  return referenceKg > 0.0f ? (thrustKg / referenceKg - 1.0f) * 100.0f : 0.0f;
+}
+
+// Holds end_pwm for end_minutes. Every conversion goes into the statistics;
+// rows go out once a second and once a minute, the minute summaries reach
+// NVS every end_save minutes and at the end.
+void setupEndurance() {
+  serialOut.println("\n=== Endurance Mode ===");
+  serialOut.print("Holding ");
+  serialOut.print(endurancePwm);
+  serialOut.print("us for ");
+  serialOut.print(enduranceMinutes);
+  serialOut.println(" min");
+  enduranceStartUs = 0;  // No 'endurance freeze' while settling
+
+  clearLcd();
+  lcd.setCursor(0, 0);
+  lcd.print("Endurance");
+  lcd.setCursor(0, 1);
+  lcd.print("Settling...");
+  flushLcd();
+
+  setEsc(endurancePwm);
+  if (!waitForEsc() || !holdSampling(ENDURANCE_SETTLE_MS)) {
+    exitToMenu("\nExiting endurance...");
+    return;
+  }
+
+  endurance.begin(enduranceTriggers, endurancePwm, enduranceSaveMinutes);
+  enduranceStored = true;
+  enduranceWindowHeld = endurance.window().attached();
+  if (!enduranceWindowHeld) {
+    serialOut.println("Capture buffer not allocated, no raw window");
+  }
+  enduranceStartUs = esp_timer_get_time();
+  clearLcd();
+
+  serialOut.println("Time (s) | Mean (kg) | Min (kg) | Max (kg) | SD (kg) | Current (A) | Min V");
+  serialOut.println("============================================================================");
+}
+
+// One conversion per pass into the statistics, then whatever closed with it
+void runEndurance() {
+  if (exitRequested()) {
+    finishEndurance(false);
+    return;
+  }
+  if (!scale.is_ready()) {
+    return;
+  }
+
+  PowerReading reading;
+  long raw;
+  float thrust_kg = readSweepSample(reading, &raw);
+  uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - enduranceStartUs);
+  uint8_t events = endurance.add(elapsedUs, raw, thrust_kg, reading);
+  bool done = endurance.elapsedSeconds() >= (uint32_t)enduranceMinutes * 60;
+
+  if (events & ENDURANCE_SECOND) {
+    const EnduranceSummary& s = endurance.secondSummary();
+    LineBuilder line;
+    line.integer(s.index).text("\t| ").fixed(s.meanKg, 3).text("\t| ").fixed(s.minKg, 3);
+    line.text("\t| ").fixed(s.maxKg, 3).text("\t| ").fixed(s.stddevKg, 4).text("\t| ");
+    line.fixed(s.meanA, 2).text("\t| ").fixed(s.minV, 2).text("\r\n");
+    logRow(line);
+    showEndurance();
+  }
+  if (events & ENDURANCE_MINUTE) {
+    const EnduranceSummary& m = endurance.minuteSummary();
+    LineBuilder line;
+    line.text("[MINUTE] ").integer(m.index + 1).text(" | mean ").fixed(m.meanKg, 3);
+    line.text(" kg (").fixed(enduranceChangePercent(m.meanKg), 1).text(" %) | min ");
+    line.fixed(m.minKg, 3).text(" | max ").fixed(m.maxKg, 3).text(" | sd ").fixed(m.stddevKg, 4);
+    line.text(" | ").fixed(m.meanA, 2).text(" A | ").fixed(m.minV, 2).text(" V min\r\n");
+    logRow(line);
+  }
+  // The end of the run saves anyway
+  if ((events & ENDURANCE_SAVE_DUE) && !done && !saveEndurance(endurance.record())) {
+    LineBuilder line;
+    line.text("[MINUTE] ERR summaries not saved\r\n");
+    logRow(line);
+  }
+  if (events & ENDURANCE_TRIGGER) {
+    reportEnduranceAnomaly(elapsedUs);
+  }
+  if (events & ENDURANCE_FROZEN) {
+    LineBuilder line;
+    line.text("[ANOMALY] raw window frozen: ").integer(endurance.window().count());
+    line.text(" samples, 'endurance dump' after the run\r\n");
+    logRow(line);
+  }
+
+  if (done) {
+    finishEndurance(true);
+  }
+}
+
+void finishEndurance(bool completed) {
+  setEsc(escRange.stopPwm);
+  EnduranceRecord& record = endurance.record();
+  record.completed = completed;
+  bool saved = saveEndurance(record);
+
+  printEnduranceSummary(consoleOut);
+  if (!saved) {
+    serialOut.println("ERR endurance record not saved");
+  }
+  exitToMenu(completed ? "\nEndurance run complete" : "\nExiting endurance...");
+}
+
+void reportEnduranceAnomaly(uint32_t elapsedUs) {
+  const EnduranceRecord& record = endurance.record();
+  LineBuilder line;
+  line.text("[ANOMALY] ").text(enduranceAnomalyName(endurance.lastAnomaly())).text(" at ");
+  line.fixed(elapsedUs / 1000000.0f, 2).text(" s | thrust ");
+  line.fixed(endurance.secondSummary().meanKg, 3).text(" kg");
+  if (record.triggers > 1) {
+    line.text(" | ").integer(record.triggers).text(" so far, the window keeps the first");
+  } else if (endurance.window().attached()) {
+    line.text(" | raw window recording past it");
+  }
+  line.text("\r\n");
+  logRow(line);
+}
+
+// Time, thrust and change on top; below, the decay chart over three rows
+// (8 pixel levels each), one column per chart bucket
+void showEndurance() {
+  const EnduranceSummary& s = endurance.secondSummary();
+  uint32_t seconds = endurance.elapsedSeconds();
+  char text[LcdFrame::COLS + 1];
+  snprintf(text, sizeof(text), "%02lu:%02lu %.3fkg %+.1f%%", (unsigned long)(seconds / 60),
+           (unsigned long)(seconds % 60), s.meanKg, enduranceChangePercent(s.meanKg));
+  lcdFrame.writePadded(0, 0, text, LcdFrame::COLS);
+
+  uint8_t heights[ENDURANCE_CHART_COLUMNS];
+  float bottomKg, topKg;
+  int columns = endurance.chart().heights(heights, (LcdFrame::ROWS - 1) * 8, ENDURANCE_CHART_SPAN_KG,
+                                          bottomKg, topKg);
+  for (int row = 1; row < LcdFrame::ROWS; row++) {
+    int below = (LcdFrame::ROWS - 1 - row) * 8;  // Levels drawn by the rows under this one
+    for (int col = 0; col < LcdFrame::COLS; col++) {
+      int level = col < columns ? heights[col] - below : 0;
+      lcdFrame.put(col, row, level <= 0 ? ' ' : (char)(LCD_BAR_GLYPH + (level > 8 ? 8 : level) - 1));
+    }
+  }
+  flushLcd();
+}
+
+// Run settings, outcome and the minute summaries kept
+void printEnduranceSummary(ConsoleOutput& out) {
+  const EnduranceRecord& record = endurance.record();
+  int kept = enduranceMinutesKept(record);
+  out.print("pwm=");
+  out.printInt(record.pwm);
+  out.print("\nseconds=");
+  out.printInt(record.seconds);
+  out.print("\ncompleted=");
+  out.printInt(record.completed);
+  out.print("\nreference_kg=");
+  out.printFloat(record.referenceKg, 3);
+  if (kept > 0) {
+    float lastKg = enduranceMinute(record, kept - 1).meanKg;
+    out.print("\nlast_minute_kg=");
+    out.printFloat(lastKg, 3);
+    out.print("\nchange_pct=");
+    out.printFloat(enduranceChangePercent(lastKg), 1);
+  }
+  out.print("\nanomaly=");
+  out.print(enduranceAnomalyName((EnduranceAnomaly)record.anomaly));
+  if (record.anomaly != ANOMALY_NONE) {
+    out.print("\nanomaly_s=");
+    out.printFloat(record.anomalyMs / 1000.0f, 1);
+  }
+  out.print("\ntriggers=");
+  out.printInt(record.triggers);
+  out.print("\nsaves=");
+  out.printInt(record.saves);
+  out.print("\nminutes=");
+  out.printInt(record.minutes);
+  out.print("\n");
+  if (kept == 0) {
+    return;
+  }
+  out.println("minute: mean min max sd (kg) | current (A) | min V");
+  uint32_t first = enduranceFirstMinute(record);
+  for (int i = 0; i < kept; i++) {
+    const EnduranceMinute& m = enduranceMinute(record, i);
+    out.printInt(first + i + 1);
+    out.print(": ");
+    out.printFloat(m.meanKg, 3);
+    out.print(" ");
+    out.printFloat(m.minKg, 3);
+    out.print(" ");
+    out.printFloat(m.maxKg, 3);
+    out.print(" ");
+    out.printFloat(m.stddevKg, 4);
+    out.print(" | ");
+    out.printFloat(m.meanA, 2);
+    out.print(" | ");
+    out.printFloat(m.minV, 2);
+    out.print("\n");
+  }
+}
+
+float computePayloadKg(float singleMotorThrustKg) {
+  return payloadCapacityKg(singleMotorThrustKg, payloadModel());
+}
+
+PayloadModel payloadModel() {
+  PayloadModel model = {droneWeightKg, NUM_MOTORS, thrustToWeightRatio};
+  return model;
+}
+
+void calibrateLoadCell() {
+  scale.tare();
+
+  if (calibrationLut.valid()) {
+    // Stored multi-point calibration: only the zero is taken now
+    loadCell.setLut(&calibrationLut);
+  } else {
+    long raw = scale.read_average(20);
+    float scale_factor = raw / CALIBRATION_WEIGHT_KG;
+    scale.set_scale(scale_factor);
+    loadCell.setLut(nullptr);
+    loadCell.setCalibration(scale.get_offset(), scale.get_scale(), CORRECTION_K);
+  }
+
+  // Calibration sets zero and span at the temperature now
+  DriftModel model = {loadCell.temperature(), driftZeroKgPerC, driftSpanPerC};
+  loadCell.setDriftModel(model);
+  loadCell.tare(scale.get_offset());
+  zeroTracker.reset();
+}
+
+// min_pwm..max_pwm as driven by a sweep or step capture: ordered and inside
+// the endpoints of the ESC in use (after 'esc use', possibly narrower)
+bool sweepRangeUsable() {
+  if (sweepMinPwm >= sweepMaxPwm) {
+    serialOut.println("ERR min_pwm must be below max_pwm");
+    return false;
+  }
+  if (!escRange.contains(sweepMinPwm) || !escRange.contains(sweepMaxPwm)) {
+    serialOut.println("ERR min_pwm/max_pwm outside the ESC range, see 'esc'");
+    return false;
+  }
+  return true;
+}
+
+void startOption(int option) {
+  if (safety.tripped()) {
+    serialOut.println("ERR safety stop active, 'safety clear' first");
+    return;
+  }
+  selectedOption = option;
+  if (option == 1) {
+    currentState = STATE_MANUAL_TEST;
+    setupManualTest();
+  } else if (option == 2) {
+    if (!sweepRangeUsable()) {
+      return;
+    }
+    currentState = STATE_ALGORITHM_TEST;
+    setupAlgorithmTest();
+    runAlgorithmTest();  // Run once
+  } else if (option == 3) {
+    currentState = STATE_THRUST_HOLD;
+    setupThrustHold();
+  } else if (option == 5) {
+    startBatch();  // Runs to completion or abort
+  } else if (option == 6) {
+    if (escDiscoveryConfig.searchFastPwm >= escDiscoveryConfig.searchSlowPwm) {
+      serialOut.println("ERR disc_fast must be below disc_slow");
+      return;
+    }
+    currentState = STATE_ESC_DISCOVERY;
+    runEscDiscovery();  // Run once
+  } else if (option == 7) {
+    if (!escRange.contains(endurancePwm) || escRange.stopped(endurancePwm)) {
+      serialOut.println("ERR end_pwm outside the ESC's turning range, see 'esc'");
+      return;
+    }
+    currentState = STATE_ENDURANCE;
+    setupEndurance();
+  } else {
+    if (!sweepRangeUsable()) {
+      return;
+    }
+    currentState = STATE_STEP_CAPTURE;
+    runStepCapture();  // Run once
+  }
+}
+
+// ---- Serial console commands ----
+
+void consoleStart(const ConsoleArgs& args, ConsoleOutput& out) {
+  if (currentState != STATE_MENU) {
+    out.println("ERR busy, abort first");
+    return;
+  }
+  const char* mode = args.argc > 1 ? args.argv[1] : "sweep";
+  const char* const MODES[NUM_MENU_OPTIONS] = {"manual", "sweep", "hold", "capture", "batch",
+                                                 "discover", "endurance"};
+  for (int i = 0; i < NUM_MENU_OPTIONS; i++) {
+    if (strcmp(mode, MODES[i]) == 0) {
+      pendingOption = i + 1;  // Started from loop(), not from inside the parser
+      out.print("OK starting ");
+      out.println(mode);
+      return;
+    }
+  }
+  out.println("ERR usage: start <manual|sweep|hold|capture|batch|discover|endurance>");
+}
+
+void consoleAbort(const ConsoleArgs&, ConsoleOutput& out) {
+  setEsc(escRange.stopPwm);  // Stop motor right away, the run unwinds after
+  abortRequested = currentState != STATE_MENU;
+  out.println("OK motor stopped");
+}
+
+void consoleTare(const ConsoleArgs&, ConsoleOutput& out) {
+  if (currentState != STATE_MENU) {
+    out.println("ERR busy, abort first");
+    return;
+  }
+  scale.tare();
+  loadCell.tare(scale.get_offset());
+  out.print("OK offset=");
+  out.printInt(scale.get_offset());
+  out.print("\n");
+}
+
+void consoleCalibrate(const ConsoleArgs&, ConsoleOutput& out) {
+  if (currentState != STATE_MENU) {
+    out.println("ERR busy, abort first");
+    return;
+  }
+  calibrateLoadCell();
+  if (loadCell.hasLut()) {
+    out.println("OK zeroed, multi-point calibration kept");
+    return;
+  }
+  out.print("OK scale=");
+  out.printFloat(scale.get_scale(), 1);
+  out.print("\n");
+}
+
+void consoleStats(const ConsoleArgs&, ConsoleOutput& out) {
+  // Live thrust: a fresh conversion when idle, the running mode's latest otherwise
+  if (currentState == STATE_MENU && scale.is_ready()) {
+    long raw = scale.read();
+    safety.sample(raw, loadCell.toKg(raw), micros());
+  }
+  if (safety.lastSampleUs() != 0) {
+    out.print("thrust_kg=");
+    out.printFloat(safety.lastThrustKg(), 3);
+    out.print("\nthrust_age_ms=");
+    out.printInt((micros() - safety.lastSampleUs()) / 1000);
+    out.print("\n");
+  } else {
+    out.println("thrust_kg=none");
+  }
+  out.print("max_thrust_kg=");
+  out.printFloat(sweepTotals.maxThrustKg, 3);
+  out.print("\npayload_kg=");
+  out.printFloat(computePayloadKg(sweepTotals.maxThrustKg), 3);
+  if (powerAvailable) {
+    out.print("\nbest_efficiency_g_per_w=");
+    out.printFloat(sweepTotals.bestEfficiencyGPerW, 2);
+    out.print("\nbest_efficiency_pwm=");
+    out.printInt(sweepTotals.bestEfficiencyPwm);
+    out.print("\nmax_power_w=");
+    out.printFloat(sweepTotals.maxPowerW, 1);
+  }
+  out.print("\nsweep_step=");
+  out.printInt(sweep.index());
+  out.print("/");
+  out.printInt(sweep.totalSteps());
+  if (batch.active()) {
+    out.print("\nbatch_run=");
+    out.printInt(batch.run() + 1);
+    out.print("/");
+    out.printInt(batch.totalRuns());
+  }
+  if (vibSource != 0 && lastVibration.valid) {
+    out.print("\nvib_rotor_hz=");
+    out.printFloat(lastVibration.rotorSeenHz, 1);
+    out.print("\nvib_rotor_amplitude=");
+    out.printFloat(lastVibration.rotorAmplitude * vibrationUnit(), 4);
+    out.print("\nvib_sample_rate_hz=");
+    out.printFloat(lastVibration.sampleRateHz, 1);
+    out.print("\nvib_analyze_us=");
+    out.printInt(vibAnalyzeUs);
+  }
+  out.print("\nesc_command_us=");
+  out.printInt(escCommandUs);
+  out.print("\nesc_output_us=");
+  out.printInt(escOutputRunning ? escOutput.output() : escCommandUs);
+  out.print("\nesc_ticks=");
+  out.printInt(escOutput.ticks());
+  out.print("\nsafety_fault=");
+  out.print(safetyFaultName(safety.fault()));
+  out.print("\nsafety_trips=");
+  out.printInt(safety.trips());
+  out.print("\nsafety_worst_cutoff_us=");
+  out.printInt(safety.worstLatencyUs());
+  out.print("\nzero_updates=");
+  out.printInt(zeroTracker.updates());
+  out.print("\nzero_rejected=");
+  out.printInt(zeroTracker.rejected());
+  out.print("\nzero_correction_kg=");
+  out.printFloat(zeroTracker.correctionKg(), 4);
+  if (temperatureAvailable) {
+    out.print("\ntemperature_c=");
+    out.printFloat(loadCell.temperature(), 1);
+    out.print("\ndrift_shift_kg=");
+    out.printFloat(loadCell.zeroShiftKg(), 4);
+  }
+  out.print("\ncheckpoint_writes=");
+  out.printInt(batch.checkpointWrites());
+  out.print("\nconsole_errors=");
+  out.printInt(console.errors());
+  out.print("\nlog_dropped=");
+  out.printInt(logQueue.linesDropped());
+  out.print("\nlog_high_water=");
+  out.printInt(logQueue.highWater());
+  out.print("\nrecord_events=");
+  out.printInt(recorder.events());
+  out.print("\nrecord_frames=");
+  out.printInt(recorder.frames());
+  out.print("\nsync_replies=");
+  out.printInt(syncReplies);
+  out.print("\n");
+}
+
+// profile add <min> <max> <step> <delay>, profile clear, profile list
+void consoleProfile(const ConsoleArgs& args, ConsoleOutput& out) {
+  const char* action = args.argc > 1 ? args.argv[1] : "list";
+  if (strcmp(action, "add") == 0) {
+    if (args.argc != 6 && args.argc != 7) {
+      out.println("ERR usage: profile add <min_pwm> <max_pwm> <pwm_step> <step_delay> [ramp_rate]");
+      return;
+    }
+    if (batchProfileCount >= BATCH_MAX_PROFILES) {
+      out.println("ERR profile list full");
+      return;
+    }
+    long values[5] = {0, 0, 0, 0, 0};
+    for (int i = 0; i < args.argc - 2; i++) {
+      char* end;
+      values[i] = strtol(args.argv[i + 2], &end, 10);
+      if (*end != '\0') {
+        out.println("ERR not a number");
+        return;
+      }
+    }
+    if (values[0] < 1000 || values[1] > 2000 || values[0] >= values[1] || values[2] < 1 ||
+        values[2] > 200 || values[3] < 100 || values[3] > 60000 || values[4] < 0 || values[4] > 1000) {
+      out.println("ERR out of range");
+      return;
+    }
+    BatchProfile& profile = batchProfiles[batchProfileCount++];
+    profile = {(int16_t)values[1], (int16_t)values[0], (int16_t)values[2], (uint16_t)values[3],
+               (uint16_t)values[4]};
+    out.print("OK profile ");
+    out.printInt(batchProfileCount);
+    out.print("\n");
+  } else if (strcmp(action, "clear") == 0) {
+    batchProfileCount = 0;
+    out.println("OK profiles cleared");
+  } else if (strcmp(action, "list") == 0) {
+    if (batchProfileCount == 0) {
+      out.println("none, batch repeats min_pwm/max_pwm/pwm_step/step_delay/ramp_rate");
+    }
+    for (int i = 0; i < batchProfileCount; i++) {
+      const BatchProfile& profile = batchProfiles[i];
+      out.printInt(i + 1);
+      out.print(": ");
+      out.printInt(profile.fastPwm);
+      out.print(" ");
+      out.printInt(profile.slowPwm);
+      out.print(" ");
+      out.printInt(profile.stepPwm);
+      out.print(" ");
+      out.printInt(profile.stepDelayMs);
+      if (profile.rampUsPerS > 0) {
+        out.print(" ramp ");
+        out.printInt(profile.rampUsPerS);
+      }
+      out.print("\n");
+    }
+  } else {
+    out.println("ERR usage: profile <add|clear|list>");
+  }
+}
+
+// drift show, drift fit (slope from zero-tracking points), drift clear
+void consoleDrift(const ConsoleArgs& args, ConsoleOutput& out) {
+  const char* action = args.argc > 1 ? args.argv[1] : "show";
+  if (strcmp(action, "fit") == 0) {
+    DriftModel model = loadCell.driftModel();
+    if (!temperatureAvailable || !driftFit.fit(model)) {
+      out.println("ERR need 3 zero points over 0.5 C apart (TEMP_SENSOR_NTC)");
+      return;
+    }
+    driftZeroKgPerC = model.zeroKgPerC;
+    out.print("OK drift_zero=");
+    out.printFloat(driftZeroKgPerC, 6);
+    out.print("\n");
+  } else if (strcmp(action, "clear") == 0) {
+    driftFit.reset();
+    out.println("OK fit points cleared");
+  } else if (strcmp(action, "show") == 0) {
+    out.print("points=");
+    out.printInt(driftFit.count());
+    out.print("\ndrift_zero=");
+    out.printFloat(loadCell.driftModel().zeroKgPerC, 6);
+    out.print("\ndrift_span=");
+    out.printFloat(loadCell.driftModel().spanPerC, 6);
+    out.print("\nref_c=");
+    out.printFloat(loadCell.driftModel().refTempC, 1);
+    out.print("\n");
+  } else {
+    out.println("ERR usage: drift <show|fit|clear>");
+  }
+}
+
+void printCalibrationReport(ConsoleOutput& out) {
+  out.println("ref_kg | counts | load | residual_g");
+  for (int i = 0; i < calibration.pointCount; i++) {
+    const CalPoint& point = calibration.points[i];
+    out.printFloat(point.refKg, 3);
+    out.print(" | ");
+    out.printInt(point.netCounts);
+    out.print(point.load == CAL_PULLEY ? " | pulley | " : " | direct | ");
+    out.printFloat(point.residualKg * 1000.0f, 2);
+    out.print("\n");
+  }
+  if (calibration.order != 0) {
+    out.print("order=");
+    out.printInt(calibration.order);
+    out.print(" rms_g=");
+    out.printFloat(calibration.rmsKg * 1000.0f, 2);
+    out.print(" max_g=");
+    out.printFloat(calibration.maxKg * 1000.0f, 2);
+    out.print(" pulley_rms_g=");
+    out.printFloat(calibration.rmsPulleyKg * 1000.0f, 2);
+    out.print("\n");
+  }
+}
+
+// cal add <kg> [pulley], cal fit [1|2], cal report, cal clear (idle only)
+void consoleCal(const ConsoleArgs& args, ConsoleOutput& out) {
+  const char* action = args.argc > 1 ? args.argv[1] : "report";
+  if (strcmp(action, "report") == 0) {
+    printCalibrationReport(out);
+    return;
+  }
+  if (currentState != STATE_MENU) {
+    out.println("ERR busy, abort first");
+    return;
+  }
+
+  if (strcmp(action, "add") == 0) {
+    char* end = nullptr;
+    float refKg = args.argc > 2 ? strtof(args.argv[2], &end) : 0.0f;
+    bool pulley = args.argc > 3 && strcmp(args.argv[3], "pulley") == 0;
+    if (end == nullptr || *end != '\0' || (args.argc > 3 && !pulley)) {
+      out.println("ERR usage: cal add <kg> [pulley]");
+      return;
+    }
+    if (calibration.magic != CAL_RECORD_MAGIC || calibration.order != 0) {
+      clearCalibration(calibration);  // New series; the stored one stays until fit
+    }
+    long net = scale.read_average(CAL_SAMPLES) - loadCell.offset();
+    if (!addCalibrationPoint(calibration, refKg, net, pulley ? CAL_PULLEY : CAL_DIRECT)) {
+      out.println("ERR point list full");
+      return;
+    }
+    out.print("OK point ");
+    out.printInt(calibration.pointCount);
+    out.print(" counts=");
+    out.printInt(net);
+    out.print("\n");
+  } else if (strcmp(action, "fit") == 0) {
+    int order = args.argc > 2 ? atoi(args.argv[2]) : 2;
+    if (!fitCalibration(calibration, order)) {
+      out.println("ERR need order+1 points at different loads");
+      return;
+    }
+    buildCalibrationLut(calibration, calibrationLut);
+    loadCell.setLut(&calibrationLut);
+    bool saved = saveCalibration(calibration);
+    printCalibrationReport(out);
+    out.println(saved ? "OK saved" : "ERR fitted but not saved");
+  } else if (strcmp(action, "clear") == 0) {
+    clearCalibration(calibration);
+    calibrationLut.clear();
+    eraseCalibration();
+    calibrateLoadCell();  // Back to the single-point fallback
+    out.println("OK single-point calibration");
+  } else {
+    out.println("ERR usage: cal <add|fit|report|clear>");
+  }
+}
+
+// safety: status; safety clear: acknowledge a stop (motor stays stopped)
+void consoleSafety(const ConsoleArgs& args, ConsoleOutput& out) {
+  if (args.argc > 1 && strcmp(args.argv[1], "clear") == 0) {
+    if (currentState != STATE_MENU) {
+      out.println("ERR busy, abort first");
+      return;
+    }
+    safety.clear();
+    displayMenu();
+    out.println("OK cleared");
+    return;
+  }
+  out.print(safetyRunning ? "supervisor=running" : "supervisor=off");
+  out.print("\nfault=");
+  out.print(safetyFaultName(safety.fault()));
+  out.print("\nfault_value=");
+  out.printFloat(safety.faultValue(), 3);
+  out.print("\narmed=");
+  out.printInt(safety.armed() ? 1 : 0);
+  out.print("\nlast_cutoff_us=");
+  out.printInt(safety.lastLatencyUs());
+  out.print("\nworst_cutoff_us=");
+  out.printInt(safety.worstLatencyUs());
+  out.print("\n");
+}
+
+// Heap low-water marks, arena use and stack never touched per task; printed
+// at the end of every run so slow leaks show up across a batch night
+void printMemoryReport(ConsoleOutput& out) {
+  HeapStats heap = internalHeapStats();
+  out.print("[MEM] heap free ");
+  out.printInt(heap.freeBytes);
+  out.print(" min ");
+  out.printInt(heap.minFreeBytes);
+  out.print(" largest ");
+  out.printInt(heap.largestBlock);
+  if (memory.hasPsram()) {
+    HeapStats psram = psramHeapStats();
+    out.print(" | psram free ");
+    out.printInt(psram.freeBytes);
+    out.print(" min ");
+    out.printInt(psram.minFreeBytes);
+  }
+  out.print(" | arena sram ");
+  out.printInt(sramArena.used());
+  out.print("/");
+  out.printInt(sramArena.capacity());
+  out.print(" psram ");
+  out.printInt(psramArena.used());
+  out.print("/");
+  out.printInt(psramArena.capacity());
+  out.print(" failed ");
+  out.printInt(sramArena.failures() + psramArena.failures());
+  out.print(" | stack free loop ");
+  out.printInt(taskStackFree(nullptr));
+  out.print(" log_writer ");
+  out.printInt(taskStackFree("log_writer"));
+  out.print(" safety ");
+  out.printInt(taskStackFree("safety"));
+  out.print(" i2c_bus ");
+  out.printInt(taskStackFree("i2c_bus"));
+  out.print("\n");
+}
+
+void consoleMem(const ConsoleArgs&, ConsoleOutput& out) {
+  printMemoryReport(out);
+}
+
+// One line per bus device: queue wait (submit to start) and payload rate
+// while it held the bus
+void consoleI2c(const ConsoleArgs& args, ConsoleOutput& out) {
+  if (args.argc > 1 && strcmp(args.argv[1], "reset") == 0) {
+    i2cBus.resetStats();
+    out.println("OK counters cleared");
+    return;
+  }
+  out.print(i2cBusRunning ? "owner=task" : "owner=loop");
+  out.print(" clock_hz=");
+  out.printInt(i2cBus.clock());
+  out.print(" aged_runs=");
+  out.printInt(i2cBus.agedRuns());
+  out.print("\n");
+  for (size_t i = 0; i < i2cBus.devices(); i++) {
+    const I2cDeviceStats& d = i2cBus.stats(i);
+    out.print(d.name);
+    out.print(" transactions=");
+    out.printInt(d.transactions);
+    out.print(" errors=");
+    out.printInt(d.errors);
+    out.print(" dropped=");
+    out.printInt(d.dropped);
+    out.print(" bytes=");
+    out.printInt(d.bytes);
+    out.print(" wait_avg_us=");
+    out.printInt(d.transactions > 0 ? (long)(d.totalWaitUs / d.transactions) : 0);
+    out.print(" wait_max_us=");
+    out.printInt(d.maxWaitUs);
+    out.print(" bus_us=");
+    out.printInt(d.busUs);
+    out.print(" kb_per_s=");
+    out.printFloat(d.busUs > 0 ? d.bytes * 1000.0f / d.busUs : 0.0f, 1);
+    out.print("\n");
+  }
+}
+
+// esc: the ESC on the stand and the endpoints in use; esc use <name>: switch
+// ESC (its stored profile, or the stand defaults); esc forget: drop its profile
+void consoleEsc(const ConsoleArgs& args, ConsoleOutput& out) {
+  const char* action = args.argc > 1 ? args.argv[1] : "show";
+  if (strcmp(action, "show") != 0) {
+    if (currentState != STATE_MENU) {
+      out.println("ERR busy, abort first");
+      return;
+    }
+    if (strcmp(action, "use") == 0) {
+      if (args.argc < 3 || !escNameValid(args.argv[2])) {
+        out.println("ERR usage: esc use <name> (1-15 of A-Z a-z 0-9 - _)");
+        return;
+      }
+      useEscProfile(args.argv[2]);
+      setEsc(escRange.stopPwm);
+      if (!saveActiveEscName(escName)) {
+        out.println("ERR selected but not saved");
+      }
+    } else if (strcmp(action, "forget") == 0) {
+      eraseEscProfile(escName);
+      useEscProfile(escName);
+      setEsc(escRange.stopPwm);
+    } else {
+      out.println("ERR usage: esc [use <name>|forget]");
+      return;
+    }
+  }
+
+  out.print("esc=");
+  out.print(escName);
+  out.print(escProfileLoaded ? "\nsource=discovered" : "\nsource=stand defaults");
+  out.print("\nfast_pwm=");
+  out.printInt(escRange.fastPwm);
+  out.print("\nslow_pwm=");
+  out.printInt(escRange.slowPwm);
+  out.print("\nstop_pwm=");
+  out.printInt(escRange.stopPwm);
+  if (escProfileLoaded) {
+    const EscEndpoints& e = escProfile.endpoints;
+    out.print("\nstart_pwm=");
+    out.printInt(e.startPwm);
+    out.print("\nstall_pwm=");
+    out.printInt(e.stallPwm);
+    out.print("\nsaturated=");
+    out.printInt(e.saturated);
+    out.print("\nmax_thrust_kg=");
+    out.printFloat(e.maxThrustKg, 3);
+    out.print("\nprobes=");
+    out.printInt(e.probes);
+  }
+  out.print("\n");
+}
+
+void consoleEndurance(const ConsoleArgs& args, ConsoleOutput& out) {
+  const char* action = args.argc > 1 ? args.argv[1] : "show";
+  if (strcmp(action, "freeze") == 0) {
+    // Operator trigger, during the run
+    if (currentState != STATE_ENDURANCE || enduranceStartUs == 0) {
+      out.println("ERR no endurance run");
+      return;
+    }
+    if (!endurance.window().attached()) {
+      out.println("ERR no raw window (capture buffer not allocated)");
+      return;
+    }
+    if (endurance.window().triggered()) {
+      out.println("ERR raw window already holds an anomaly");
+      return;
+    }
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - enduranceStartUs);
+    endurance.freeze(elapsedUs);
+    reportEnduranceAnomaly(elapsedUs);
+    out.println("OK raw window freezes after half a window");
+    return;
+  }
+  if (strcmp(action, "show") != 0 && currentState != STATE_MENU) {
+    out.println("ERR busy, abort first");
+    return;
+  }
+
+  if (strcmp(action, "dump") == 0) {
+    const AnomalyWindow& window = endurance.window();
+    if (!enduranceWindowHeld || window.count() == 0) {
+      out.println("ERR no raw window, run 'start endurance' first");
+      return;
+    }
+    // Times relative to the trigger (to the last sample without one)
+    uint32_t zeroUs = window.triggered() ? window.triggerUs() : window.sample(window.count() - 1).timeUs;
+    out.print("anomaly=");
+    out.print(enduranceAnomalyName((EnduranceAnomaly)endurance.record().anomaly));
+    out.print("\nsamples=");
+    out.printInt(window.count());
+    out.print("\nt_ms raw kg current_ma\n");
+    for (size_t i = 0; i < window.count(); i++) {
+      const BurstSample& sample = window.sample(i);
+      out.printFloat((int32_t)(sample.timeUs - zeroUs) / 1000.0f, 1);
+      out.print(" ");
+      out.printInt(sample.raw);
+      out.print(" ");
+      out.printFloat(loadCell.toKg(sample.raw), 4);
+      out.print(" ");
+      out.printInt(sample.currentMa);
+      out.print("\n");
+      safety.heartbeat(HB_LOOP, micros());  // Long dump at low baud rates
+    }
+    return;
+  }
+  if (strcmp(action, "clear") == 0) {
+    eraseEndurance();
+    enduranceStored = false;
+    enduranceWindowHeld = false;
+    out.println("OK endurance record erased");
+    return;
+  }
+  if (strcmp(action, "show") != 0) {
+    out.println("ERR usage: endurance [dump|freeze|clear]");
+    return;
+  }
+
+  if (!enduranceStored) {
+    out.println("no endurance run stored");
+    return;
+  }
+  printEnduranceSummary(out);
+}
+
+// sync <token>: one clock exchange with the hub. The device time is taken as
+// the line is handled; the reply queues behind the rows like any frame, and
+// the host keeps the exchanges with the shortest round trip.
+void consoleSync(const ConsoleArgs& args, ConsoleOutput& out) {
+  uint64_t nowUs = (uint64_t)esp_timer_get_time();
+  if (args.argc != 2) {
+    out.println("ERR usage: sync <token>");
+    return;
+  }
+  uint8_t payload[12];
+  PayloadWriter writer(payload, sizeof(payload));
+  writer.putU32((uint32_t)strtoul(args.argv[1], nullptr, 10));
+  writer.putU64(nowUs);
+  uint8_t frame[TELEMETRY_HEADER_SIZE + sizeof(payload) + TELEMETRY_CRC_SIZE];
+  size_t n = encodeTelemetryFrame(TELEMETRY_TIME_SYNC, payload, writer.length(), frame, sizeof(frame));
+  sendFrame(frame, n);
+  syncReplies++;
+}
+
+void setup() {
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER);
+  Serial.begin(STAND_SERIAL_BAUD);
+  delay(1000);
+  logWriterRunning = startLogWriter(logQueue, Serial, LOG_WRITER_PRIORITY, LOG_WRITER_CORE);
+  if (logWriterRunning) {
+    serialOut.attachQueue(&logQueue);
+  }
+
+  serialOut.println("\n=== UAV Motor Thrust Stand ===\n");
+
+  // Arenas before anything takes a buffer; the PSRAM block is the one heap allocation
+  sramArena.attach(sramArenaBlock, sizeof(sramArenaBlock));
+#ifdef BOARD_HAS_PSRAM
+  psramArena.attach(allocatePsramBlock(PSRAM_ARENA_BYTES), PSRAM_ARENA_BYTES);
+#endif
+
+  // Configure pins
+  pinMode(StandBoard::POT_PIN, INPUT);
+  pinMode(StandBoard::BUTTON_PIN, INPUT_PULLUP);
+
+  // Initialize LCD, then hand the bus to its owner task
+  Wire.begin();
+  lcdDriver.init();
+  lcdDriver.backlight();
+  // Bar glyphs for the endurance chart: CGRAM k lights the bottom k+1 pixel rows
+  for (uint8_t k = 0; k < 8; k++) {
+    uint8_t glyph[8];
+    for (uint8_t row = 0; row < 8; row++) {
+      glyph[row] = row >= 7 - k ? 0x1F : 0x00;
+    }
+    lcdDriver.createChar(k, glyph);
+  }
+  i2cBus.addDevice("lcd", LCD_ADDRESS);
+  i2cBus.addDevice("ina219", INA219_ADDRESS);
+  i2cBus.addDevice("mpu6050", MPU6050_ADDRESS);
+  i2cBusRunning = startI2cBus(i2cBus, I2C_BUS_PRIORITY, I2C_BUS_CORE);
+  serialOut.println(i2cBusRunning ? "I2C bus task running" : "I2C bus task failed, bus runs from the loop");
+
+  // Show welcome screen
+  displayWelcomeScreen();
+  flushLcd();
+  serialOut.println("Welcome screen displayed");
+  delay(2000);
+
+  // Endpoints of the ESC on the stand, discovered earlier or the stand defaults
+  char activeEsc[ESC_NAME_MAX];
+  useEscProfile(loadActiveEscName(activeEsc, sizeof(activeEsc)) ? activeEsc : ESC_DEFAULT_NAME);
+  serialOut.print("ESC ");
+  serialOut.print(escName);
+  serialOut.println(escProfileLoaded ? ": discovered endpoints" : ": stand defaults");
+
+  // Attach and arm ESC at its arming value; the output stage writes it from
+  // here on, stops go to the ESC's own stop value
+  esc.attach(StandBoard::ESC_PIN, StandEsc::ATTACH_MIN_US, StandEsc::ATTACH_MAX_US);
+  escOutputRunning = startEscOutput(escOutput, ESC_OUTPUT_HZ);
+  serialOut.println(escOutputRunning ? "ESC output stage running" : "ESC output stage failed, commands jump");
+  serialOut.print("Arming ESC at ");
+  serialOut.print(StandEsc::STOP_PWM);
+  serialOut.println("us (stopped)...");
+  setEsc(StandEsc::STOP_PWM);
+  delay(2000);
+  setEsc(escRange.stopPwm);
+  serialOut.println("ESC armed!");
+
+  safetyRunning = startSafetySupervisor(safety, SAFETY_PERIOD_MS, SAFETY_WATCHDOG_MS,
+                                        SAFETY_PRIORITY, SAFETY_CORE);
+  serialOut.println(safetyRunning ? "Safety supervisor running" : "Safety supervisor failed to start");
+
+  // Initialize and calibrate load cell
+  serialOut.println("\nCalibrating load cell...");
+  clearLcd();
+  lcd.setCursor(0, 1);
+  lcd.print("Calibrating...");
+  flushLcd();
+
+  scale.begin(StandBoard::LOADCELL_DT_PIN, StandBoard::LOADCELL_SCK_PIN);
+  delay(1000);
+  if (loadCalibration(calibration)) {
+    buildCalibrationLut(calibration, calibrationLut);
+    serialOut.print("Multi-point calibration: ");
+    serialOut.print(calibration.pointCount);
+    serialOut.print(" points, rms ");
+    serialOut.print(calibration.rmsKg * 1000.0f, 2);
+    serialOut.println(" g");
+  } else {
+    clearCalibration(calibration);
+  }
+#ifdef TEMP_SENSOR_NTC
+  pinMode(StandBoard::TEMP_PIN, INPUT);
+  updateTemperature();
+#endif
+  calibrateLoadCell();
+
+  serialOut.println("Load cell calibrated!");
+
+  // Power monitor is optional, the sweep runs thrust-only without it
+  powerAvailable = powerSensor.begin();
+  if (powerAvailable) {
+    serialOut.println("Power monitor ready");
+  } else {
+    serialOut.println("Power monitor not found, efficiency disabled");
+  }
+
+  // Optional accelerometer for vib_source 2
+  accelAvailable = accel.begin();
+  if (accelAvailable) {
+    serialOut.println("MPU-6050 ready");
+  }
+
+  // Step capture buffer comes from the arenas once and is reused for every step
+  if (memory.hasPsram()) {
+    burstAvailable = burst.allocate(memory, BURST_CAPACITY_PSRAM);
+  }
+  if (!burstAvailable) {
+    burstAvailable = burst.allocate(memory, BURST_CAPACITY);
+  }
+  if (burstAvailable) {
+    serialOut.print("Capture buffer: ");
+    serialOut.print(burst.capacity());
+    serialOut.println(burst.inPsram() ? " samples in PSRAM" : " samples in SRAM");
+    endurance.attachWindow(burst.storage(), burst.capacity());
+  }
+
+  // Last endurance run, for 'endurance' after a reset
+  enduranceStored = loadEndurance(endurance.record());
+
+  // Move to menu
+  currentState = STATE_MENU;
+  displayMenu();
+  serialOut.println("Menu displayed\n");
+
+  if (batch.resume()) {
+    offerBatchResume();
+  }
+}
+
+void loop() {
+  pollConsole();
+  flushLcd();
+  safety.heartbeat(HB_LOOP, micros());
+
+  // Check button inputs
+  bool shortPress = checkButtonPress();
+  bool longPress = checkButtonLongPress();
+
+  switch (currentState) {
+    case STATE_WELCOME:
+      // Auto-transition handled in setup
       break;
 
     case STATE_MENU:
-      if (shortPress) {
-        // Toggle option
-        selectedOption = (selectedOption == 1) ? 2 : 1;
+      serviceLoadCell();
+      if (shortPress && safety.tripped()) {
+        // First press after a safety stop acknowledges it
+        safety.clear();
         displayMenu();
-        Serial.print("Option selected: ");
-        Serial.println(selectedOption);
+        serialOut.println("Safety stop cleared");
+      }
+      else if (shortPress) {
+        // Next option
+        selectedOption = (selectedOption % NUM_MENU_OPTIONS) + 1;
+        displayMenu();
+        serialOut.print("Option selected: ");
+        serialOut.println(selectedOption);
       }
       else if (longPress) {
         // Select option
-        Serial.print("Choosing option: ");
-        Serial.println(selectedOption);
-
-        if (selectedOption == 1) {
-          currentState = STATE_MANUAL_TEST;
-          setupManualTest();
-        } else {
-          currentState = STATE_ALGORITHM_TEST;
-          setupAlgorithmTest();
-          runAlgorithmTest();  // Run once
-        }
+        serialOut.print("Choosing option: ");
+        serialOut.println(selectedOption);
+        startOption(selectedOption);
+      }
+      else if (pendingOption != 0) {
+        int option = pendingOption;
+        pendingOption = 0;
+        startOption(option);
       }
       break;
 
@@ -490,7 +2977,25 @@ void loop() {
       break;
 
     case STATE_ALGORITHM_TEST:
-      // Algorithm test runs once in setup
+    case STATE_BATCH:
+      // Runs once; results stay on the LCD until a button press or abort
+      serviceLoadCell();
+      if (shortPress || longPress || abortRequested) {
+        exitToMenu("\nLeaving results screen...");
+      }
+      break;
+
+    case STATE_THRUST_HOLD:
+      runThrustHold();
+      break;
+
+    case STATE_ENDURANCE:
+      runEndurance();
+      break;
+
+    case STATE_STEP_CAPTURE:
+    case STATE_ESC_DISCOVERY:
+      // Step capture and ESC discovery run once and return to the menu
       break;
   }
 
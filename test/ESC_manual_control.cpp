@@ -1,12 +1,6 @@
 #include <Arduino.h>
 #include <ESP32Servo.h>
-
-#define MOTOR_PIN 19      // PWM pin for motor ESC
-#define POT_PIN 34        // Potentiometer analog input (ADC1_CH6)
-
-// PWM range for ESC (INVERTED: lower PWM = faster)
-#define MIN_PWM 1200   // Maximum speed (fastest)
-#define MAX_PWM 1500   // Minimum spinning speed (slowest)
+#include "StandConfig.h"  // Pins, ESC range (INVERTED: lower PWM = faster)
 
 Servo esc;
 
@@ -17,30 +11,36 @@ void setup() {
   Serial.println("\n=== Motor Manual Control via Potentiometer ===");
 
   // Configure potentiometer pin
-  pinMode(POT_PIN, INPUT);
+  pinMode(StandBoard::POT_PIN, INPUT);
 
   // Attach ESC to pin
-  esc.attach(MOTOR_PIN, 1000, 2000);
+  esc.attach(StandBoard::ESC_PIN, StandEsc::ATTACH_MIN_US, StandEsc::ATTACH_MAX_US);
 
   // Arm ESC without spinning motor
-  Serial.println("Arming ESC at 1500us (stopped)...");
-  esc.writeMicroseconds(1500);
+  Serial.print("Arming ESC at ");
+  Serial.print(StandEsc::STOP_PWM);
+  Serial.println("us (stopped)...");
+  esc.writeMicroseconds(StandEsc::STOP_PWM);
   delay(2000);
 
   Serial.println("ESC armed!");
 
   Serial.println("\nTurn potentiometer to control motor speed");
   Serial.println("Potentiometer range: 0-4095");
-  Serial.println("PWM range: 1200-1500us (inverted ESC)");
+  Serial.print("PWM range: ");
+  Serial.print(StandEsc::FAST_PWM);
+  Serial.print("-");
+  Serial.print(StandEsc::SLOW_PWM);
+  Serial.println("us (inverted ESC)");
   Serial.println("=======================================\n");
 }
 
 void loop() {
   // Read potentiometer value (0-4095 on ESP32)
-  int potValue = analogRead(POT_PIN);
+  int potValue = analogRead(StandBoard::POT_PIN);
 
-  // Map potentiometer to PWM range (1000-2000us)
-  int pwmValue = map(potValue, 0, 4095, MIN_PWM, MAX_PWM);
+  // Pot at 0 is full throttle
+  int pwmValue = StandEsc::pwmFromPot(potValue, StandBoard::ADC_MAX);
 
   // Send PWM to motor
   esc.writeMicroseconds(pwmValue);
@@ -51,7 +51,7 @@ void loop() {
   Serial.print(" | PWM: ");
   Serial.print(pwmValue);
   Serial.print("us (");
-  Serial.print(map(pwmValue, MIN_PWM, MAX_PWM, 0, 100));
+  Serial.print(StandEsc::percentFromPwm(pwmValue));
   Serial.println("%)");
 
   delay(100);  // Update 10 times per second
@@ -1,7 +1,6 @@
 #include <Arduino.h>
 #include <ESP32Servo.h>
-
-#define MOTOR_PIN 19  // PWM pin for motor ESC
+#include "StandConfig.h"
 
 Servo esc;
 
@@ -13,7 +12,7 @@ void setup() {
   Serial.println("Waiting 15 seconds before starting...");
 
   // Attach ESC to pin
-  esc.attach(MOTOR_PIN, 1000, 2000);
+  esc.attach(StandBoard::ESC_PIN, StandEsc::ATTACH_MIN_US, StandEsc::ATTACH_MAX_US);
 
   // ESC Calibration
   Serial.println("Calibrating ESC - MAX throttle");
@@ -1,8 +1,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
-
-#define BUTTON_PIN 4  // Button on GPIO 4
+#include "StandConfig.h"
 
 LiquidCrystal_I2C lcd(0x27, 20, 4);
 
@@ -75,7 +74,7 @@ void displayAlgorithmTest() {
 }
 
 ButtonState checkButton() {
-  bool buttonPressed = (digitalRead(BUTTON_PIN) == LOW);  // Assuming active LOW
+  bool buttonPressed = (digitalRead(StandBoard::BUTTON_PIN) == LOW);  // Assuming active LOW
 
   if (buttonPressed && !buttonWasPressed) {
     // Button just pressed
@@ -118,7 +117,7 @@ void setup() {
   Serial.println("\n=== UI Test ===");
 
   // Configure button pin
-  pinMode(BUTTON_PIN, INPUT_PULLUP);  // Using internal pull-up
+  pinMode(StandBoard::BUTTON_PIN, INPUT_PULLUP);  // Using internal pull-up
 
   // Initialize LCD
   Wire.begin();
@@ -0,0 +1,469 @@
+// Native micro-benchmarks for the per-sample hot paths - runs on the host
+// Build and run: make bench (results in bench_output.txt)
+//
+// Usage: program [baseline_file] [output_file] [--update-baseline]
+// Each benchmark reports the median ns/op over BENCH_REPEATS runs. With a
+// baseline file, any benchmark slower than
+//   baseline * (1 + BENCH_TOLERANCE) + BENCH_SLACK_NS
+// is a regression and the program exits non-zero. The absolute slack keeps
+// single-nanosecond operations from flagging on timer noise.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "BurstCapture.h"
+#include "CommandConsole.h"
+#include "LcdFrame.h"
+#include "LoadCell.h"
+#include "PowerMonitor.h"
+#include "SampleStats.h"
+#include "SignalFilter.h"
+#include "StandSim.h"
+#include "Sweep.h"
+#include "Telemetry.h"
+#include "TextLogger.h"
+#include "ThrustControl.h"
+#include "Vibration.h"
+
+const int BENCH_REPEATS = 9;
+const int MAX_BENCHMARKS = 32;
+const float BENCH_TOLERANCE = 0.25f;  // host timing noise; tighten on a quiet machine
+const double BENCH_SLACK_NS = 2.0;
+
+// Keeps results alive so the optimizer cannot drop the measured work
+template <typename T>
+static inline void keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct BenchResult {
+  char name[48];
+  double nsPerOp;
+  long iterations;
+};
+
+static BenchResult results[MAX_BENCHMARKS];
+static int resultCount = 0;
+
+// Runs fn(iterations) BENCH_REPEATS times and records the median ns per op
+template <typename Fn>
+static void bench(const char* name, long iterations, Fn fn) {
+  double samples[BENCH_REPEATS];
+  fn(iterations / 10);  // warm-up
+  for (int r = 0; r < BENCH_REPEATS; r++) {
+    auto start = std::chrono::steady_clock::now();
+    fn(iterations);
+    auto end = std::chrono::steady_clock::now();
+    samples[r] = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  }
+  std::sort(samples, samples + BENCH_REPEATS);
+
+  BenchResult& result = results[resultCount++];
+  snprintf(result.name, sizeof(result.name), "%s", name);
+  result.nsPerOp = samples[BENCH_REPEATS / 2];
+  result.iterations = iterations;
+  printf("%-28s %10.2f ns/op\n", name, result.nsPerOp);
+}
+
+// ---- Benchmarks ----
+
+static void benchLoadCell() {
+  LoadCellConverter converter;
+  converter.setCalibration(84213, 451234.0f, 3.265f);
+  long raws[256];
+  for (int i = 0; i < 256; i++) {
+    raws[i] = 84213 + i * 977;
+  }
+  bench("loadcell_convert", 5000000, [&](long n) {
+    float sum = 0.0f;
+    for (long i = 0; i < n; i++) {
+      sum += converter.toKg(raws[i & 255]);
+    }
+    keep(sum);
+  });
+
+  // Multi-point calibration: table lookup instead of one multiply
+  CalibrationLut lut;
+  lut.build(1.0f / 400000.0f, 1.2e-13f, 800000);
+  LoadCellConverter tabled;
+  tabled.setLut(&lut);
+  tabled.setOffset(84213);
+  bench("loadcell_convert_lut", 5000000, [&](long n) {
+    float sum = 0.0f;
+    for (long i = 0; i < n; i++) {
+      sum += tabled.toKg(raws[i & 255]);
+    }
+    keep(sum);
+  });
+}
+
+static void benchFilterAndStats() {
+  EmaFilter filter(EmaFilter::alphaFor(0.15f, 0.1f));
+  bench("ema_filter", 5000000, [&](long n) {
+    float value = 0.0f;
+    for (long i = 0; i < n; i++) {
+      value = filter.update((float)(i & 1023) * 0.001f);
+    }
+    keep(value);
+  });
+
+  RunningStats stats;
+  bench("running_stats_add", 5000000, [&](long n) {
+    stats.reset();
+    for (long i = 0; i < n; i++) {
+      stats.add((float)(i & 1023) * 0.001f);
+    }
+    keep(stats);
+  });
+
+  StepPowerAccumulator power(0.127f);
+  PowerReading reading = {16.4f, 8.2f, 134.5f};
+  bench("power_step_accumulate", 2000000, [&](long n) {
+    power.reset();
+    for (long i = 0; i < n; i++) {
+      power.add(0.3f + (i & 15) * 0.001f, reading);
+    }
+    StepPowerResult r = power.result();
+    keep(r);
+  });
+}
+
+static void benchControl() {
+  ThrustPid pid(defaultThrustPidConfig());
+  pid.reset(0.0f, 0.0f);
+  bench("pid_update", 5000000, [&](long n) {
+    float out = 0.0f;
+    for (long i = 0; i < n; i++) {
+      out = pid.update(0.35f, 0.30f + (i & 63) * 0.001f, 0.1f);
+    }
+    keep(out);
+  });
+}
+
+static void benchTelemetry() {
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.002f);
+  static uint8_t block[BURST_SAMPLES_PER_FRAME * 6 * sizeof(BurstSample)];
+  MemoryArena sram("sram");
+  MemoryArena psram("psram");
+  sram.attach(block, sizeof(block));
+  TieredArena memory(sram, psram);
+  BurstCapture capture;
+  capture.allocate(memory, BURST_SAMPLES_PER_FRAME * 6);
+  capture.start(0);
+  capture.markStep(200000, 1300, 1240);
+  motor.setPwm(1240);
+  for (int i = 0; i < (int)capture.capacity(); i++) {
+    motor.update(0.0125f);
+    capture.add(i * 12500, cell.readRaw(), 1240, 8000);
+  }
+
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  size_t frameSize = 0;
+  bench("telemetry_encode_samples", 500000, [&](long n) {
+    for (long i = 0; i < n; i++) {
+      frameSize = encodeBurstSamples(capture, 1, 0, frame, sizeof(frame));
+    }
+    keep(frameSize);
+  });
+
+  TelemetryDecoder decoder;
+  bench("telemetry_decode_frame", 200000, [&](long n) {
+    int frames = 0;
+    for (long i = 0; i < n; i++) {
+      for (size_t b = 0; b < frameSize; b++) {
+        frames += decoder.feed(frame[b]);
+      }
+    }
+    keep(frames);
+  });
+
+  bench("burst_analyze_120", 200000, [&](long n) {
+    BurstAnalysis a = {};
+    for (long i = 0; i < n; i++) {
+      a = analyzeBurst(capture.samples(), capture.count(), capture.stepUs());
+    }
+    keep(a);
+  });
+}
+
+static void benchVibration() {
+  // One sweep-step window: 512 accelerometer samples, window + Q15 FFT + peaks
+  VibrationAnalyzer analyzer;
+  SimNoise noise(5);
+  for (int i = 0; i < VIB_FFT_MAX; i++) {
+    analyzer.add(4096 + (int32_t)(900.0f * sinf(0.7458f * i) + noise.next(40.0f)));
+  }
+  VibrationSpectrum spectrum;
+  bench("vibration_fft_512", 20000, [&](long n) {
+    for (long i = 0; i < n; i++) {
+      analyzer.analyze(1000.0f, 120.0f, 0.3f, spectrum);
+    }
+    keep(spectrum);
+  });
+}
+
+static void benchLcd() {
+  // One live-screen update: two formatted fields, diff, flush runs
+  LcdFrame frame;
+  char text[LcdFrame::COLS + 1];
+  bench("lcd_diff_render", 1000000, [&](long n) {
+    int runs = 0;
+    for (long i = 0; i < n; i++) {
+      snprintf(text, sizeof(text), "%ld%%", i % 100);
+      frame.writePadded(0, 1, text, 4);
+      snprintf(text, sizeof(text), "%.3f kg", (i % 500) * 0.001f);
+      frame.writePadded(0, 3, text, 10);
+      LcdRun run;
+      while (frame.nextRun(run)) {
+        runs += run.length;
+      }
+    }
+    keep(runs);
+  });
+}
+
+static void benchSweep() {
+  SweepConfig config = {1340, 1210, 10, true, 0};
+  SweepStepper sweep;
+  bench("sweep_step", 5000000, [&](long n) {
+    SweepPoint point = {};
+    int sum = 0;
+    sweep.begin(config);
+    for (long i = 0; i < n; i++) {
+      if (!sweep.next(point)) {
+        sweep.begin(config);
+        sweep.next(point);
+      }
+      sum += point.pwm + point.progressPercent;
+    }
+    keep(sum);
+  });
+}
+
+struct NullOutput : public ConsoleOutput {
+  size_t bytes = 0;
+  void write(const char* text) override { bytes += strlen(text); }
+};
+
+static void benchConsole() {
+  int minPwm = 1210;
+  float droneWeight = 0.5f;
+  const ConsoleParam params[] = {
+    {"min_pwm", PARAM_INT, &minPwm, 1000, 2000},
+    {"drone_weight", PARAM_FLOAT, &droneWeight, 0.0f, 25.0f},
+  };
+  NullOutput out;
+  CommandConsole console(nullptr, 0, params, 2, out);
+  const char* line = "set drone_weight 0.750\n";
+  bench("console_set_line", 500000, [&](long n) {
+    for (long i = 0; i < n; i++) {
+      for (const char* c = line; *c != '\0'; c++) {
+        if (console.feed(*c)) {
+          console.execute();
+        }
+      }
+    }
+    keep(droneWeight);
+  });
+}
+
+// The current approach: Arduino Print::print(float, digits), one virtual write per char
+struct PrintLike {
+  char text[LOG_LINE_SIZE];
+  size_t length = 0;
+
+  virtual ~PrintLike() {}
+  virtual size_t write(uint8_t c) {
+    if (length < sizeof(text) - 1) text[length++] = (char)c;
+    return 1;
+  }
+  void print(const char* s) {
+    while (*s != '\0') write((uint8_t)*s++);
+  }
+  void print(long n) {
+    char buf[12];
+    char* str = &buf[sizeof(buf) - 1];
+    *str = '\0';
+    unsigned long m = n < 0 ? 0ul - (unsigned long)n : (unsigned long)n;
+    do {
+      *--str = (char)('0' + m % 10);
+      m /= 10;
+    } while (m != 0);
+    if (n < 0) write('-');
+    print(str);
+  }
+  void print(double number, uint8_t digits) {
+    if (number < 0.0) {
+      write('-');
+      number = -number;
+    }
+    double rounding = 0.5;
+    for (uint8_t i = 0; i < digits; ++i) rounding /= 10.0;
+    number += rounding;
+    unsigned long intPart = (unsigned long)number;
+    double remainder = number - (double)intPart;
+    print((long)intPart);
+    if (digits > 0) write('.');
+    while (digits-- > 0) {
+      remainder *= 10.0;
+      unsigned int toPrint = (unsigned int)remainder;
+      write((uint8_t)('0' + toPrint));
+      remainder -= toPrint;
+    }
+  }
+};
+
+static void benchLogger() {
+  const int pwm = 1250;
+  const int throttle = 64;
+  const float values[4] = {0.3125f, 15.87f, 7.42f, 117.6f};
+
+  bench("log_row_print_float", 500000, [&](long n) {
+    size_t total = 0;
+    for (long i = 0; i < n; i++) {
+      PrintLike p;
+      float jitter = (i & 7) * 0.001f;
+      p.print((long)pwm); p.print("us\t| "); p.print((long)throttle); p.print("%\t| ");
+      p.print(values[0] + jitter, 3); p.print(" kg\t| "); p.print(values[1] + jitter, 2);
+      p.print(" V\t| "); p.print(values[2] + jitter, 2); p.print(" A\t| ");
+      p.print(values[3] + jitter, 1); p.print(" W\r\n");
+      total += p.length;
+    }
+    keep(total);
+  });
+
+  bench("log_row_snprintf", 500000, [&](long n) {
+    size_t total = 0;
+    char text[LOG_LINE_SIZE];
+    for (long i = 0; i < n; i++) {
+      float jitter = (i & 7) * 0.001f;
+      total += snprintf(text, sizeof(text), "%dus\t| %d%%\t| %.3f kg\t| %.2f V\t| %.2f A\t| %.1f W\r\n",
+                        pwm, throttle, values[0] + jitter, values[1] + jitter,
+                        values[2] + jitter, values[3] + jitter);
+      keep(text);
+    }
+    keep(total);
+  });
+
+  bench("log_row_fixed", 500000, [&](long n) {
+    size_t total = 0;
+    for (long i = 0; i < n; i++) {
+      LineBuilder line;
+      float jitter = (i & 7) * 0.001f;
+      line.integer(pwm).text("us\t| ").integer(throttle).text("%\t| ");
+      line.fixed(values[0] + jitter, 3).text(" kg\t| ").fixed(values[1] + jitter, 2);
+      line.text(" V\t| ").fixed(values[2] + jitter, 2).text(" A\t| ");
+      line.fixed(values[3] + jitter, 1).text(" W\r\n");
+      total += line.length();
+      keep(line);
+    }
+    keep(total);
+  });
+
+  struct UnboundedUart {
+    size_t bytes = 0;
+    int availableForWrite() { return 1 << 20; }
+    size_t write(const uint8_t*, size_t n) { bytes += n; return n; }
+  };
+  static uint8_t storage[4096];
+  LogQueue queue(storage, sizeof(storage));
+  UnboundedUart uart;
+  const char* row = "1250us\t| 64%\t| 0.313 kg\t| 15.87 V\t| 7.42 A\t| 117.6 W\r\n";
+  size_t rowLength = strlen(row);
+  bench("log_queue_push_drain", 1000000, [&](long n) {
+    for (long i = 0; i < n; i++) {
+      queue.push(row, rowLength);
+      if ((i & 15) == 15) {
+        queue.drain(uart);
+      }
+    }
+    queue.drain(uart);
+    keep(uart.bytes);
+  });
+}
+
+// ---- Baseline comparison ----
+
+static bool loadBaseline(const char* path, const char* name, double& nsPerOp) {
+  FILE* f = fopen(path, "r");
+  if (f == nullptr) {
+    return false;
+  }
+  char line[128];
+  bool found = false;
+  while (fgets(line, sizeof(line), f) != nullptr) {
+    char entry[48];
+    double value;
+    if (line[0] != '#' && sscanf(line, "%47s %lf", entry, &value) == 2 && strcmp(entry, name) == 0) {
+      nsPerOp = value;
+      found = true;
+      break;
+    }
+  }
+  fclose(f);
+  return found;
+}
+
+int main(int argc, char** argv) {
+  const char* baselinePath = argc > 1 ? argv[1] : "test/bench_baseline.txt";
+  const char* outputPath = argc > 2 ? argv[2] : "bench_output.txt";
+  bool updateBaseline = argc > 3 && strcmp(argv[3], "--update-baseline") == 0;
+
+  printf("=== Native Hot-Path Benchmarks ===\n\n");
+
+  benchLoadCell();
+  benchFilterAndStats();
+  benchControl();
+  benchTelemetry();
+  benchVibration();
+  benchLcd();
+  benchSweep();
+  benchConsole();
+  benchLogger();
+
+  FILE* out = fopen(updateBaseline ? baselinePath : outputPath, "w");
+  if (out == nullptr) {
+    printf("Cannot write %s\n", updateBaseline ? baselinePath : outputPath);
+    return 2;
+  }
+
+  if (updateBaseline) {
+    fprintf(out, "# name ns_per_op (make bench-baseline)\n");
+    for (int i = 0; i < resultCount; i++) {
+      fprintf(out, "%s %.2f\n", results[i].name, results[i].nsPerOp);
+    }
+    fclose(out);
+    printf("\nBaseline written to %s\n", baselinePath);
+    return 0;
+  }
+
+  int regressions = 0;
+  printf("\n%-28s %10s %10s %7s\n", "benchmark", "ns/op", "baseline", "ratio");
+  fprintf(out, "# name ns_per_op baseline_ns_per_op ratio status\n");
+  for (int i = 0; i < resultCount; i++) {
+    const BenchResult& r = results[i];
+    double baseline = 0.0;
+    const char* status = "NEW";
+    double ratio = 0.0;
+    if (loadBaseline(baselinePath, r.name, baseline) && baseline > 0.0) {
+      ratio = r.nsPerOp / baseline;
+      bool regressed = r.nsPerOp > baseline * (1.0 + BENCH_TOLERANCE) + BENCH_SLACK_NS;
+      status = regressed ? "REGRESSION" : "OK";
+      if (regressed) {
+        regressions++;
+      }
+    }
+    printf("%-28s %10.2f %10.2f %7.2f %s\n", r.name, r.nsPerOp, baseline, ratio, status);
+    fprintf(out, "%s %.2f %.2f %.3f %s\n", r.name, r.nsPerOp, baseline, ratio, status);
+  }
+  fclose(out);
+
+  printf("\n%d regression%s (tolerance %.0f %%), results in %s\n",
+         regressions, regressions == 1 ? "" : "s", BENCH_TOLERANCE * 100, outputPath);
+  return regressions == 0 ? 0 : 1;
+}
@@ -1,7 +1,6 @@
 #include <Arduino.h>
 #include <ESP32Servo.h>
-
-#define MOTOR_PIN 19  // PWM pin for motor ESC
+#include "StandConfig.h"
 
 Servo esc;
 int currentThrottle = 1000;
@@ -20,12 +19,12 @@ void setup() {
 
   Serial.println("\n\n=== Motor PWM Diagnostic Test ===");
   Serial.print("Motor Pin: ");
-  Serial.println(MOTOR_PIN);
+  Serial.println(StandBoard::ESC_PIN);
   Serial.println("Waiting 3 seconds for battery connection...");
   delay(3000);
 
   Serial.println("\n[INIT] Attaching ESC to pin...");
-  if (esc.attach(MOTOR_PIN, 1000, 2000)) {
+  if (esc.attach(StandBoard::ESC_PIN, StandEsc::ATTACH_MIN_US, StandEsc::ATTACH_MAX_US)) {
     Serial.println("ESC attached to pin");
   } else {
     Serial.println("Failed to attach ESC!");
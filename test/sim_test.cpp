@@ -0,0 +1,2066 @@
+// Native simulator checks - runs on the host, no hardware required
+// Build and run: make test-sim
+
+#include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+#include "BatchQueue.h"
+#include "BurstCapture.h"
+#include "Calibration.h"
+#include "CommandConsole.h"
+#include "Endurance.h"
+#include "EscDiscovery.h"
+#include "EscTrajectory.h"
+#include "I2cBus.h"
+#include "LcdFrame.h"
+#include "LiveView.h"
+#include "LoadCell.h"
+#include "MemoryArena.h"
+#include "PowerMonitor.h"
+#include "RawRecord.h"
+#include "Safety.h"
+#include "SampleStats.h"
+#include "SignalFilter.h"
+#include "StandConfig.h"
+#include "StandSim.h"
+#include "Sweep.h"
+#include "Telemetry.h"
+#include "TextLogger.h"
+#include "ThrustControl.h"
+#include "Vibration.h"
+
+static int failures = 0;
+
+// Allocation counter for the steady-state check: operator new always, and
+// malloc/calloc/realloc as well on glibc
+static bool countAllocations = false;
+static long allocationCount = 0;
+
+#ifdef __GLIBC__
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* block, size_t size);
+
+extern "C" void* malloc(size_t size) noexcept {
+  if (countAllocations) allocationCount++;
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+  if (countAllocations) allocationCount++;
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* block, size_t size) noexcept {
+  if (countAllocations) allocationCount++;
+  return __libc_realloc(block, size);
+}
+#endif
+
+// Out of line, so the compiler does not pair our free() with its own new
+__attribute__((noinline)) void* operator new(size_t size) {
+  if (countAllocations) allocationCount++;
+  void* block = malloc(size);
+  if (block == nullptr) throw std::bad_alloc();
+  return block;
+}
+
+__attribute__((noinline)) void operator delete(void* block) noexcept {
+  free(block);
+}
+
+__attribute__((noinline)) void operator delete(void* block, size_t) noexcept {
+  free(block);
+}
+
+static void check(bool condition, const char* what) {
+  printf("[%s] %s\n", condition ? "PASS" : "FAIL", what);
+  if (!condition) {
+    failures++;
+  }
+}
+
+static void testRunningStats() {
+  RunningStats stats;
+  const float values[] = {2.0f, 4.0f, 4.0f, 4.0f, 5.0f, 5.0f, 7.0f, 9.0f};
+  for (float v : values) {
+    stats.add(v);
+  }
+  check(stats.count() == 8, "stats: count");
+  check(fabsf(stats.mean() - 5.0f) < 1e-5f, "stats: mean");
+  check(stats.min() == 2.0f && stats.max() == 9.0f, "stats: min/max");
+  check(fabsf(stats.stddev() - 2.13809f) < 1e-4f, "stats: sample stddev");
+}
+
+static void testPowerSweep() {
+  const float PROP_DIAMETER_M = 0.127f;
+  MotorModel motor(defaultMotorModelConfig());
+  SimPowerSensor sensor(motor, 0.05f);
+  StepPowerAccumulator accumulator(PROP_DIAMETER_M);
+
+  printf("\nPWM (us) | Thrust (kg) | V     | A     | W      | g/W   | Pmech (W)\n");
+  bool plausible = true;
+  bool mechBelowElectrical = true;
+  float peakEfficiency = 0.0f;
+  float lastEfficiency = 0.0f;
+
+  for (int pwm = 1330; pwm >= 1210; pwm -= 10) {
+    motor.setPwm(pwm);
+    for (int i = 0; i < 200; i++) {
+      motor.update(0.01f);  // settle
+    }
+
+    accumulator.reset();
+    for (int i = 0; i < 10; i++) {
+      motor.update(0.1f);   // 10 SPS HX711
+      PowerReading reading;
+      sensor.read(reading);
+      accumulator.add(motor.thrustKg(), reading);
+    }
+
+    StepPowerResult r = accumulator.result();
+    printf("%d     | %.3f       | %.2f | %.2f | %6.2f | %5.2f | %.2f\n",
+           pwm, r.thrustKg, r.voltageV, r.currentA, r.powerW,
+           r.efficiencyGPerW, r.mechanicalPowerW);
+
+    // Idle current dominates below ~50 g, only judge real thrust steps
+    if (r.thrustKg > 0.05f && (r.efficiencyGPerW < 1.0f || r.efficiencyGPerW > 30.0f)) {
+      plausible = false;
+    }
+    if (r.mechanicalPowerW >= r.powerW) mechBelowElectrical = false;
+    if (r.efficiencyGPerW > peakEfficiency) peakEfficiency = r.efficiencyGPerW;
+    lastEfficiency = r.efficiencyGPerW;
+  }
+
+  check(plausible, "power: efficiency within plausible g/W range");
+  check(mechBelowElectrical, "power: ideal mechanical power below electrical power");
+  check(lastEfficiency < peakEfficiency, "power: efficiency peaks below full throttle");
+  check(efficiencyGramsPerWatt(0.5f, 0.0f) == 0.0f, "power: zero power gives zero efficiency");
+}
+
+static void testThrustHold() {
+  const float DT_S = 0.1f;  // HX711 at 10 SPS
+  MotorModelConfig config = defaultMotorModelConfig();
+  MotorModel motor(config);
+  SimLoadCell loadCell(motor, 0, 1.0f, 0.004f);
+  EmaFilter filter(EmaFilter::alphaFor(0.15f, DT_S));
+  ThrustPid pid(defaultThrustPidConfig());
+  StepResponseAnalyzer analyzer(0.05f, 2.0f);
+
+  const float setpoints[] = {0.35f, 0.20f};
+  float t = 0.0f;
+  pid.reset(0.0f, 0.0f);
+  bool allSettled = true;
+  bool overshootOk = true;
+  bool rateLimited = true;
+  float lastThrottle = 0.0f;
+  float finalErrorKg = 0.0f;
+
+  for (float setpoint : setpoints) {
+    analyzer.begin(filter.value(), setpoint, t);
+    for (int i = 0; i < 150; i++) {
+      float measured = filter.update(loadCell.readKg());
+      float throttle = pid.update(setpoint, measured, DT_S);
+      if (fabsf(throttle - lastThrottle) > pid.config().outputRatePerS * DT_S + 1e-5f) {
+        rateLimited = false;
+      }
+      lastThrottle = throttle;
+
+      // Inverted ESC: throttle 1.0 -> fullPwm
+      int pwm = config.stopPwm - (int)lroundf(throttle * (config.stopPwm - config.fullPwm));
+      motor.setPwm(pwm);
+      for (int k = 0; k < 10; k++) {
+        motor.update(DT_S / 10);
+      }
+      t += DT_S;
+      analyzer.add(t, measured);
+      finalErrorKg = fabsf(measured - setpoint);
+    }
+
+    StepResponseMetrics m = analyzer.metrics();
+    printf("\nHold %.2f kg: rise %.2f s, overshoot %.1f %%, settling %.2f s\n",
+           setpoint, m.riseTimeS, m.overshootPercent, m.settlingTimeS);
+    if (!m.settled || m.settlingTimeS > 8.0f) allSettled = false;
+    if (m.overshootPercent > 15.0f) overshootOk = false;
+  }
+
+  check(allSettled, "hold: settles within 8 s for up and down steps");
+  check(overshootOk, "hold: overshoot below 15 %");
+  check(rateLimited, "hold: throttle slew respects output rate limit");
+  check(finalErrorKg < 0.015f, "hold: steady-state error below 15 g");
+
+  // Anti-windup: unreachable setpoint must not wind the integrator past the limit
+  ThrustPid windup(defaultThrustPidConfig());
+  windup.reset(0.0f, 0.0f);
+  for (int i = 0; i < 200; i++) {
+    windup.update(5.0f, 0.3f, DT_S);
+  }
+  check(windup.integral() <= windup.config().outputMax, "hold: integrator clamped when saturated");
+  float recovered = windup.output();
+  for (int i = 0; i < 5; i++) {
+    recovered = windup.update(0.1f, 0.3f, DT_S);
+  }
+  check(recovered < windup.config().outputMax, "hold: output recovers immediately after saturation");
+}
+
+static void testBurstCapture() {
+  const int64_t SAMPLE_US = 12500;  // HX711 at 80 SPS
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell loadCell(motor, 84000, 400000.0f, 0.002f);
+  static uint8_t block[256 * sizeof(BurstSample)];
+  MemoryArena sram("sram");
+  MemoryArena psram("psram");
+  sram.attach(block, sizeof(block));
+  TieredArena memory(sram, psram);
+  BurstCapture capture;
+  check(capture.allocate(memory, 256) && !capture.inPsram(), "burst: buffer allocated once");
+
+  motor.setPwm(1300);
+  for (int i = 0; i < 100; i++) {
+    motor.update(0.02f);
+  }
+
+  int64_t now = 1000000;
+  capture.start(now);
+  for (int i = 0; i < 120; i++) {
+    if (i == 16) {  // 200 ms pre-trigger
+      capture.markStep(now, 1300, 1240);
+      motor.setPwm(1240);
+    }
+    capture.add(now, loadCell.readRaw(), (uint16_t)motor.pwm(), 0);
+    for (int k = 0; k < 5; k++) {
+      motor.update(SAMPLE_US / 5 / 1e6f);
+    }
+    now += SAMPLE_US;
+  }
+
+  BurstAnalysis a = analyzeBurst(capture.samples(), capture.count(), capture.stepUs());
+  float tau = motor.config().timeConstantS;
+  printf("\nBurst: %.1f Hz, dead %.3f s, rise %.3f s, tau %.3f s (model %.3f s)\n",
+         a.sampleRateHz, a.deadTimeS, a.riseTimeS, a.timeConstantS, tau);
+  check(a.valid, "burst: step response found");
+  check(fabsf(a.sampleRateHz - 80.0f) < 0.5f, "burst: sample rate from timestamps");
+  check(fabsf(a.timeConstantS - tau) < 0.02f, "burst: time constant matches model");
+  check(fabsf(a.riseTimeS - 2.197f * tau) < 0.03f, "burst: rise time matches first-order 2.2 tau");
+
+  // Dump through the binary link with text interleaved, then decode
+  uint8_t stream[4096];
+  size_t used = 0;
+  const char* text = "1300us\t| 43%\t| 0.042 kg\n";
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  size_t n = encodeBurstHeader(capture, 3, frame, sizeof(frame));
+  memcpy(stream + used, frame, n);
+  used += n;
+  for (size_t first = 0; first < capture.count(); first += BURST_SAMPLES_PER_FRAME) {
+    memcpy(stream + used, text, strlen(text));
+    used += strlen(text);
+    n = encodeBurstSamples(capture, 3, first, frame, sizeof(frame));
+    memcpy(stream + used, frame, n);
+    used += n;
+  }
+  n = encodeBurstResult(a, 3, frame, sizeof(frame));
+  memcpy(stream + used, frame, n);
+  used += n;
+
+  TelemetryDecoder decoder;
+  size_t decodedSamples = 0;
+  uint64_t headerStartUs = 0;
+  bool samplesMatch = true;
+  int results = 0;
+  for (size_t i = 0; i < used; i++) {
+    if (!decoder.feed(stream[i])) {
+      continue;
+    }
+    PayloadReader r(decoder.payload(), decoder.length());
+    if (decoder.type() == TELEMETRY_BURST_HEADER) {
+      r.getU16();
+      r.getU16();
+      r.getU16();
+      r.getU32();
+      r.getU32();
+      headerStartUs = r.getU64();
+    } else if (decoder.type() == TELEMETRY_BURST_SAMPLES) {
+      r.getU16();
+      uint32_t first = r.getU32();
+      uint8_t count = r.getU8();
+      for (uint8_t k = 0; k < count; k++) {
+        uint32_t t = r.getU32();
+        int32_t raw = r.getI32();
+        const BurstSample& s = capture.samples()[first + k];
+        if (t != s.timeUs || raw != s.raw) samplesMatch = false;
+        r.getU32();
+      }
+      decodedSamples += count;
+    } else if (decoder.type() == TELEMETRY_BURST_RESULT) {
+      results++;
+    }
+  }
+  check(decodedSamples == capture.count() && samplesMatch, "telemetry: all burst samples decoded intact");
+  check(headerStartUs == 1000000, "telemetry: header carries the capture start in device time");
+  check(results == 1 && decoder.crcErrors() == 0, "telemetry: result frame decoded, no CRC errors");
+
+  stream[7] ^= 0x40;  // corrupt the header payload
+  TelemetryDecoder corrupted;
+  int frames = 0;
+  for (size_t i = 0; i < used; i++) {
+    if (corrupted.feed(stream[i])) frames++;
+  }
+  check(corrupted.crcErrors() == 1, "telemetry: corrupted frame rejected by CRC");
+  check(frames == 7, "telemetry: decoder resyncs on the next frame");
+}
+
+static void testSweepAndLcd() {
+  SweepConfig config = {1340, 1210, 10, true, 0};
+  SweepStepper sweep;
+  sweep.begin(config);
+  SweepPoint point;
+  int count = 0;
+  int phaseStarts = 0;
+  int first = 0;
+  int turn = 0;
+  int last = 0;
+  int lastProgress = 0;
+  while (sweep.next(point)) {
+    if (count == 0) first = point.pwm;
+    if (count == 13) turn = point.pwm;
+    if (point.phaseStart) phaseStarts++;
+    last = point.pwm;
+    lastProgress = point.progressPercent;
+    count++;
+  }
+  check(count == 28 && sweep.totalSteps() == 28, "sweep: 14 points each way");
+  check(first == 1340 && turn == 1210 && last == 1340, "sweep: down to 1210 and back");
+  check(phaseStarts == 2 && lastProgress == 100, "sweep: two phases, progress ends at 100 %");
+
+  LcdFrame frame;
+  frame.write(0, 0, "Thrust:");
+  frame.writePadded(0, 3, "0.234 kg", 10);
+  LcdRun run;
+  int runs = 0;
+  while (frame.nextRun(run)) runs++;
+  check(runs == 2 && !frame.dirty(), "lcd: first flush sends both fields");
+
+  frame.writePadded(0, 3, "0.236 kg", 10);
+  bool single = frame.nextRun(run) && run.row == 3 && run.col == 4 && run.length == 1;
+  check(single && !frame.nextRun(run), "lcd: one changed digit sends one character");
+}
+
+// Scripted serial input for the console
+struct ScriptInput {
+  const char* text;
+  size_t pos;
+  int available() const { return text[pos] != '\0' ? 1 : 0; }
+  int read() { return text[pos] != '\0' ? (unsigned char)text[pos++] : -1; }
+};
+
+struct BufferOutput : public ConsoleOutput {
+  char text[1024];
+  size_t length = 0;
+  void write(const char* s) override {
+    while (*s != '\0' && length < sizeof(text) - 1) text[length++] = *s++;
+    text[length] = '\0';
+  }
+  void clear() { length = 0; text[0] = '\0'; }
+};
+
+static int consoleStarts = 0;
+
+static void commandStart(const ConsoleArgs& args, ConsoleOutput& out) {
+  consoleStarts++;
+  out.println(args.argc > 1 ? args.argv[1] : "sweep");
+}
+
+// Keeps the tokens of the last `profile` line; argv points into the console's
+// line buffer, which the next line reuses
+static int profileArgc = 0;
+static char profileArgs[CONSOLE_MAX_ARGS][12];
+
+static void commandProfile(const ConsoleArgs& args, ConsoleOutput& out) {
+  profileArgc = args.argc;
+  for (int i = 0; i < args.argc; i++) {
+    snprintf(profileArgs[i], sizeof(profileArgs[i]), "%s", args.argv[i]);
+  }
+  out.println("OK profile");
+}
+
+static void testCommandConsole() {
+  int minPwm = 1210;
+  unsigned long stepDelay = 2000;
+  float droneWeight = 0.5f;
+  const ConsoleParam params[] = {
+    {"min_pwm", PARAM_INT, &minPwm, 1000, 2000},
+    {"step_delay", PARAM_ULONG, &stepDelay, 100, 60000},
+    {"drone_weight", PARAM_FLOAT, &droneWeight, 0.0f, 20.0f},
+  };
+  const ConsoleCommand commands[] = {
+    {"start", "start [sweep|hold]", commandStart},
+    {"profile", "profile add MIN MAX STEP DELAY [RAMP]", commandProfile},
+  };
+  BufferOutput out;
+  CommandConsole console(commands, 2, params, 3, out);
+
+  ScriptInput in = {"set min_pwm 1220\r\nset drone_weight 0.75\nset step_delay 1500.5\n"
+                    "get min_pwm\nbogus\nstart hold\n", 0};
+  int polls = 0;
+  while (in.available() && polls < 100) {
+    console.poll(in, 8);  // bounded per tick
+    polls++;
+  }
+  check(minPwm == 1220 && droneWeight == 0.75f, "console: set int and float parameters");
+  check(stepDelay == 2000, "console: non-integer value rejected for integer parameter");
+  check(strstr(out.text, "min_pwm=1220") != nullptr, "console: get reports the value");
+  check(strstr(out.text, "ERR unknown command: bogus") != nullptr, "console: unknown command reported");
+  check(consoleStarts == 1 && strstr(out.text, "hold") != nullptr, "console: command handler gets arguments");
+  check(polls > 10, "console: input consumed in bounded chunks");
+
+  // The longest documented form: profile add with a ramp rate, 7 tokens
+  ScriptInput ramp = {"profile add 1210 1340 10 2000 200\n", 0};
+  while (ramp.available()) console.poll(ramp, 16);
+  check(profileArgc == 7 && strcmp(profileArgs[1], "add") == 0 && strcmp(profileArgs[5], "2000") == 0 &&
+            strcmp(profileArgs[6], "200") == 0,
+        "console: profile add with a ramp rate reaches the handler as 7 tokens");
+
+  out.clear();
+  profileArgc = 0;
+  ScriptInput extra = {"profile add 1210 1340 10 2000 200 5 9\n", 0};
+  while (extra.available()) console.poll(extra, 16);
+  check(profileArgc == 0 && strstr(out.text, "ERR too many arguments") != nullptr,
+        "console: extra words rejected, not merged into the last argument");
+
+  out.clear();
+  char longLine[CONSOLE_LINE_SIZE * 2 + 2];
+  memset(longLine, 'x', sizeof(longLine) - 2);
+  longLine[sizeof(longLine) - 2] = '\n';
+  longLine[sizeof(longLine) - 1] = '\0';
+  ScriptInput overflow = {longLine, 0};
+  while (overflow.available()) console.poll(overflow, 16);
+  ScriptInput after = {"set min_pwm 5000\nget min_pwm\n", 0};
+  while (after.available()) console.poll(after, 64);
+  check(console.overflows() == 1 && strstr(out.text, "ERR line too long") != nullptr,
+        "console: overlong line dropped without corrupting the next one");
+  check(minPwm == 1220 && strstr(out.text, "ERR min_pwm range") != nullptr,
+        "console: out-of-range value rejected");
+}
+
+// Stand-in UART with a small TX FIFO
+struct SlowUart {
+  char text[512];
+  size_t length;
+  int room;
+
+  int availableForWrite() { return room; }
+  size_t write(const uint8_t* data, size_t n) {
+    memcpy(text + length, data, n);
+    length += n;
+    text[length] = '\0';
+    room -= (int)n;
+    return n;
+  }
+};
+
+static void testTextLogger() {
+  char buf[24];
+  formatFixed(buf, sizeof(buf), 0.1234f, 3);
+  check(strcmp(buf, "0.123") == 0, "logger: fixed rounds to 3 places");
+  formatFixed(buf, sizeof(buf), -1.9996f, 3);
+  check(strcmp(buf, "-2.000") == 0, "logger: fixed carries into the integer part");
+  formatFixed(buf, sizeof(buf), -0.0004f, 3);
+  check(strcmp(buf, "0.000") == 0, "logger: no negative zero");
+  formatFixed(buf, sizeof(buf), 12.05f, 1);
+  check(strcmp(buf, "12.1") == 0 || strcmp(buf, "12.0") == 0, "logger: one decimal");
+  formatFixed(buf, sizeof(buf), 5e9f, 2);
+  check(strcmp(buf, "ovf") == 0, "logger: out of range prints ovf");
+  check(formatFixed(buf, 4, 123.456f, 2) == 0, "logger: too small buffer rejected");
+
+  bool allMatch = true;
+  for (int i = -20000; i <= 20000; i += 7) {
+    float value = i * 0.00137f;
+    char expected[24];
+    snprintf(expected, sizeof(expected), "%.3f", value);
+    if (strcmp(expected, "-0.000") == 0) {
+      strcpy(expected, "0.000");
+    }
+    formatFixed(buf, sizeof(buf), value, 3);
+    // Float scaling may round a near-half the other way, as Print::print does
+    if (strcmp(buf, expected) != 0 && fabsf(strtof(buf, nullptr) - value) > 0.0006f) {
+      allMatch = false;
+    }
+  }
+  check(allMatch, "logger: fixed agrees with printf(\"%.3f\")");
+
+  LineBuilder line;
+  line.integer(1240).text("us\t| ").integer(-7).text("%\t| ").fixed(0.2505f, 3).text(" kg\r\n");
+  check(strcmp(line.c_str(), "1240us\t| -7%\t| 0.251 kg\r\n") == 0 ||
+        strcmp(line.c_str(), "1240us\t| -7%\t| 0.250 kg\r\n") == 0, "logger: row built in place");
+  line.clear();
+  line.unsignedInt(4000000000u).text("\t| ").unsignedInt(0);
+  check(strcmp(line.c_str(), "4000000000\t| 0") == 0, "logger: device times past 2^31 print unsigned");
+
+  uint8_t storage[80];
+  LogQueue queue(storage, sizeof(storage));
+  int pushed = 0;
+  for (int i = 0; i < 10; i++) {
+    LineBuilder row;
+    row.text("row ").integer(i).text("\n");
+    pushed += queue.push(row) ? 1 : 0;
+  }
+  check(pushed == 10 && queue.linesDropped() == 0, "logger: queue accepts rows while there is room");
+  for (int i = 10; i < 14; i++) {
+    LineBuilder row;
+    row.text("row ").integer(i).text("\n");
+    queue.push(row);
+  }
+  check(queue.linesDropped() > 0 && queue.used() <= queue.capacity(), "logger: full queue drops and counts rows");
+
+  SlowUart uart = {{0}, 0, 14};
+  queue.drain(uart);
+  check(strcmp(uart.text, "row 0\nrow 1\n") == 0, "logger: drain writes whole lines that fit");
+  uart.room = 1000;
+  queue.drain(uart);
+  check(queue.empty() && strstr(uart.text, "row 9\n") != nullptr, "logger: drain empties the queue in order");
+
+  // Wrap around the ring
+  for (int i = 0; i < 30; i++) {
+    LineBuilder row;
+    row.text("wrap ").integer(i).text("\n");
+    queue.push(row);
+    uart.length = 0;
+    queue.drain(uart);
+  }
+  check(strcmp(uart.text, "wrap 29\n") == 0, "logger: lines survive wrapping the ring");
+}
+
+// Checkpoint "flash" that survives a simulated reset
+struct RamCheckpointStore : public CheckpointStore {
+  BatchCheckpoint data;
+  bool stored = false;
+  bool load(BatchCheckpoint& out) override {
+    if (stored) out = data;
+    return stored;
+  }
+  bool save(const BatchCheckpoint& checkpoint) override {
+    data = checkpoint;
+    stored = true;
+    return true;
+  }
+  void clear() override { stored = false; }
+};
+
+// Runs the batch on the motor model; stops (brownout) after stopAfter steps in total
+static int runBatchSim(BatchQueue& queue, int stopAfter) {
+  MotorModel motor(defaultMotorModelConfig());
+  int steps = 0;
+  while (queue.active()) {
+    const BatchProfile& profile = queue.profile();
+    SweepStepper sweep;
+    sweep.begin({profile.slowPwm, profile.fastPwm, profile.stepPwm, true, profile.rampUsPerS});
+    sweep.seek(queue.resumeStep());
+    RunSummary summary = queue.partial();
+    SweepPoint point;
+    while (sweep.next(point)) {
+      if (steps++ == stopAfter) return steps;
+      motor.setPwm(point.pwm);
+      // Repetitions differ slightly, as real runs do
+      float thrust = motor.steadyThrustKg() * (1.0f + 0.01f * queue.repetition());
+      if (thrust > summary.maxThrustKg) summary.maxThrustKg = thrust;
+      queue.stepDone(sweep.index(), summary);
+    }
+    queue.runDone(summary);
+  }
+  return steps;
+}
+
+static void testZeroTracking() {
+  MotorModel motor(defaultMotorModelConfig());
+  motor.setPwm(1360);
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.001f);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 400000.0f, 1.0f);
+
+  // 20 g of creep over 10 minutes with the motor stopped, 10 SPS
+  ZeroTrackConfig config = defaultZeroTrackConfig();
+  ZeroTracker tracker(config);
+  long lastOffset = converter.offset();
+  float maxStepKg = 0.0f;
+  bool movedWhileSettling = false;
+  for (int i = 0; i <= 6000; i++) {
+    float timeS = i * 0.1f;
+    cell.setDriftKg(0.020f * timeS / 600.0f);
+    tracker.update(converter, cell.readRaw(), timeS);
+    if (timeS < config.settleS && converter.offset() != lastOffset) movedWhileSettling = true;
+    float stepKg = fabsf((converter.offset() - lastOffset) * converter.kgPerCount());
+    if (stepKg > maxStepKg) maxStepKg = stepKg;
+    lastOffset = converter.offset();
+  }
+  float errorKg = 0.0f;
+  for (int i = 0; i < 50; i++) errorKg += converter.toKg(cell.readRaw()) / 50;
+  check(!movedWhileSettling, "zero: no update while the prop spins down");
+  check(fabsf(errorKg) < 0.002f && tracker.updates() > 0, "zero: 20 g of creep tracked out");
+  check(maxStepKg <= config.maxRateKgPerS * 1.0f + 0.0001f, "zero: offset moves at the limited rate");
+
+  // A real load on the cell is not drift
+  long before = converter.offset();
+  uint32_t rejected = tracker.rejected();
+  cell.setDriftKg(0.020f + 0.200f);
+  for (int i = 0; i < 100; i++) tracker.update(converter, cell.readRaw(), 600.0f + i * 0.1f);
+  check(converter.offset() == before && tracker.rejected() > rejected, "zero: load outside the band ignored");
+
+  // Drift model: zero moves 0.5 g/C; compensated readings stay at zero
+  LoadCellConverter plain;
+  plain.setCalibration(84000, 400000.0f, 1.0f);
+  LoadCellConverter compensated;
+  compensated.setCalibration(84000, 400000.0f, 1.0f);
+  compensated.setTemperature(25.0f);
+  DriftModel model = {25.0f, 0.0005f, 0.0f};
+  compensated.setDriftModel(model);
+  float worstKg = 0.0f;
+  float worstRawKg = 0.0f;
+  for (float tempC = 25.0f; tempC <= 45.0f; tempC += 5.0f) {
+    cell.setDriftKg(0.0005f * (tempC - 25.0f));
+    compensated.setTemperature(tempC);
+    float kg = 0.0f;
+    float rawKg = 0.0f;
+    for (int i = 0; i < 50; i++) {
+      long raw = cell.readRaw();
+      kg += compensated.toKg(raw) / 50;
+      rawKg += plain.toKg(raw) / 50;
+    }
+    if (fabsf(kg) > worstKg) worstKg = fabsf(kg);
+    if (fabsf(rawKg) > worstRawKg) worstRawKg = fabsf(rawKg);
+  }
+  check(worstKg < 0.001f && worstRawKg > 0.009f, "drift: 10 g of thermal zero shift compensated");
+
+  // Fit from tracked zeros at several temperatures (as during a batch)
+  LoadCellConverter fitted;
+  fitted.setCalibration(84000, 400000.0f, 1.0f);
+  ZeroTracker fitTracker(config);
+  DriftFit fit;
+  float timeS = 0.0f;
+  for (float tempC = 25.0f; tempC <= 40.0f; tempC += 3.0f) {
+    cell.setDriftKg(0.0005f * (tempC - 25.0f));
+    fitted.setTemperature(tempC);
+    for (int i = 0; i < 600; i++, timeS += 0.1f) fitTracker.update(fitted, cell.readRaw(), timeS);
+    fit.add(tempC, fitted.rawZeroKg());
+  }
+  DriftModel result = noDrift();
+  check(fit.fit(result) && fabsf(result.zeroKgPerC - 0.0005f) < 0.00005f, "drift: slope fitted from tracked zeros");
+  DriftFit flat;
+  for (int i = 0; i < 5; i++) flat.add(25.0f, 0.001f * i);
+  check(!flat.fit(result), "drift: no fit without temperature spread");
+
+  check(fabsf(ntcTemperatureC(2048, 4095, 10000.0f, 10000.0f, 3950.0f) - 25.0f) < 0.1f &&
+        isnan(ntcTemperatureC(0, 4095, 10000.0f, 10000.0f, 3950.0f)), "drift: NTC conversion");
+}
+
+// Slightly nonlinear cell: 400k counts/kg with 2 %/kg stiffening
+static long nonlinearCounts(float kg) {
+  return lroundf(400000.0f * kg * (1.0f - 0.02f * kg));
+}
+
+static void testCalibration() {
+  CalibrationRecord record;
+  clearCalibration(record);
+  const float loads[] = {0.0f, 0.2f, 0.5f, 0.8f, 1.0f};
+  for (float kg : loads) addCalibrationPoint(record, kg, nonlinearCounts(kg), CAL_DIRECT);
+
+  check(fitCalibration(record, 1), "cal: linear fit");
+  float linearRms = record.rmsKg;
+  check(fitCalibration(record, 2) && record.rmsKg < 0.0002f && record.rmsKg < linearRms / 5,
+        "cal: quadratic fit follows a curved cell");
+
+  // Pulley friction costs 0.5 % of the load in the thrust direction
+  CalibrationRecord withPulley = record;
+  addCalibrationPoint(withPulley, 0.3f, nonlinearCounts(0.3f * 0.995f), CAL_PULLEY);
+  addCalibrationPoint(withPulley, 0.6f, nonlinearCounts(0.6f * 0.995f), CAL_PULLEY);
+  check(fitCalibration(withPulley, 2) && withPulley.rmsPulleyKg > withPulley.rmsKg,
+        "cal: residuals single out the pulley points");
+
+  CalibrationLut lut;
+  buildCalibrationLut(record, lut);
+  float worstKg = 0.0f;
+  for (long n = -900000; n <= 900000; n += 1234) {
+    float exact = record.c1 * n + record.c2 * (float)n * (float)n;
+    float error = fabsf(lut.toKg(n) - exact);
+    if (error > worstKg) worstKg = error;
+  }
+  check(lut.valid() && worstKg < 0.0002f, "cal: table matches the polynomial within 0.2 g");
+  float beyond = lut.toKg(3000000);
+  check(beyond > lut.toKg(1500000) && beyond < 10.0f, "cal: extrapolates past the table");
+
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 1.0f, 1.0f);
+  converter.setLut(&lut);
+  converter.tare(84000);
+  check(fabsf(converter.toKg(84000 + nonlinearCounts(0.8f)) - 0.8f) < 0.002f, "cal: converter reads through the table");
+  check(fabsf(converter.kgPerCount() * 400000.0f - 1.0f) < 0.01f, "cal: local gain for zero tracking");
+
+  record.crc = calibrationCrc(record);
+  check(calibrationValid(record), "cal: record checks out");
+  record.c1 *= 1.001f;
+  check(!calibrationValid(record), "cal: modified record rejected");
+
+  CalibrationRecord few;
+  clearCalibration(few);
+  addCalibrationPoint(few, 0.5f, 200000, CAL_DIRECT);
+  check(!fitCalibration(few, 2), "cal: quadratic needs three points");
+}
+
+static void testBatchQueue() {
+  BatchPlan plan;
+  plan.repetitions = 3;
+  plan.profileCount = 2;
+  plan.autoTare = true;
+  plan.cooldownMs = 0;
+  plan.profiles[0] = {1340, 1210, 10, 2000, 0};
+  plan.profiles[1] = {1340, 1270, 10, 2000, 0};
+
+  // Uninterrupted reference
+  RamCheckpointStore reference;
+  BatchQueue full(reference);
+  check(full.begin(plan) && full.totalRuns() == 6, "batch: plan accepted, 3 x 2 runs");
+  int totalSteps = runBatchSim(full, -1);
+  check(!full.active() && !reference.stored, "batch: checkpoint cleared on completion");
+  check(full.profileStats(0).count() == 3 && full.profileStats(1).count() == 3, "batch: runs interleave profiles");
+  check(full.profileStats(0).mean() > full.profileStats(1).mean() && full.profileStats(0).stddev() > 0.0f,
+        "batch: per-profile max thrust totals");
+
+  // Brownout in the middle of run 2, after the fast end of the sweep
+  RamCheckpointStore flash;
+  BatchQueue first(flash);
+  first.begin(plan);
+  int before = runBatchSim(first, 28 + 12);
+  float partialMax = first.partial().maxThrustKg;
+
+  BatchQueue resumed(flash);
+  check(resumed.resume() && resumed.run() == 1 && resumed.resumeStep() == 12,
+        "batch: resume at the next step of the interrupted run");
+  check(resumed.partial().maxThrustKg == partialMax && partialMax > 0.0f, "batch: partial results survive the reset");
+  int after = runBatchSim(resumed, -1);
+  check(before - 1 + after == totalSteps, "batch: no step measured twice");
+  bool same = true;
+  for (int p = 0; p < 2; p++) {
+    same = same && resumed.profileStats(p).count() == full.profileStats(p).count() &&
+           resumed.profileStats(p).mean() == full.profileStats(p).mean();
+  }
+  check(same, "batch: resumed totals match an uninterrupted batch");
+
+  // Torn or stale checkpoints are ignored
+  BatchQueue corrupt(flash);
+  corrupt.begin(plan);
+  flash.data.plan.repetitions = 40;
+  check(!BatchQueue(flash).resume(), "batch: checkpoint with a bad CRC rejected");
+  corrupt.cancel();
+  check(!flash.stored && !BatchQueue(flash).resume(), "batch: cancel forgets the checkpoint");
+
+  plan.profiles[1].fastPwm = 1400;
+  check(!BatchQueue(flash).begin(plan), "batch: profile with fast end above slow end rejected");
+}
+
+static void testVibration() {
+  const double TWO_PI = 6.283185307179586;
+  SimNoise noise(7);
+
+  // Q15 FFT against a double-precision DFT of the same input
+  const int N = 256;
+  static int16_t re[N];
+  static int16_t im[N];
+  static double input[N];
+  for (int i = 0; i < N; i++) {
+    input[i] = 9000.0 * sin(TWO_PI * 19.3 * i / N) + 4000.0 * cos(TWO_PI * 77 * i / N) + noise.next(2000.0f);
+    re[i] = (int16_t)lround(input[i]);
+    im[i] = 0;
+  }
+  fftQ15(re, im, 8);
+  double worstError = 0.0;
+  for (int k = 0; k < N; k++) {
+    double refRe = 0.0;
+    double refIm = 0.0;
+    for (int i = 0; i < N; i++) {
+      refRe += round(input[i]) * cos(TWO_PI * k * i / N);
+      refIm -= round(input[i]) * sin(TWO_PI * k * i / N);
+    }
+    double error = hypot(re[k] - refRe / N, im[k] - refIm / N);
+    if (error > worstError) worstError = error;
+  }
+  printf("\nFFT 256 points: worst bin error %.2f LSB (DFT / n)\n", worstError);
+  check(worstError < 4.0, "vibration: Q15 FFT matches the reference DFT");
+
+  // Accelerometer at 1 kHz: imbalance at the rotor frequency plus a 2x line
+  VibrationAnalyzer analyzer;
+  float fs = 1000.0f;
+  for (int i = 0; i < VIB_FFT_MAX; i++) {
+    double t = i / fs;
+    double v = 900.0 * sin(TWO_PI * 118.7 * t) + 300.0 * sin(TWO_PI * 237.4 * t + 1.0) + noise.next(40.0f);
+    analyzer.add((int32_t)lround(v) + 4096);  // 1 g on the axis
+  }
+  check(!analyzer.add(0), "vibration: window is bounded");
+  VibrationSpectrum spectrum;
+  bool ok = analyzer.analyze(fs, 120.0f, 0.2f, spectrum);
+  printf("Vibration: %.2f Hz %.0f, %.2f Hz %.0f (%.2fx)\n", spectrum.peaks[0].frequencyHz,
+         spectrum.peaks[0].amplitude, spectrum.peaks[1].frequencyHz, spectrum.peaks[1].amplitude,
+         spectrum.peaks[1].order);
+  check(ok && spectrum.points == 512 && spectrum.peakCount == VIB_MAX_PEAKS, "vibration: 512-point spectrum");
+  check(fabsf(spectrum.peaks[0].frequencyHz - 118.7f) < spectrum.binHz * 0.25f &&
+        fabsf(spectrum.peaks[0].amplitude - 900.0f) < 45.0f, "vibration: dominant line frequency and amplitude");
+  check(fabsf(spectrum.peaks[1].frequencyHz - 237.4f) < spectrum.binHz * 0.25f &&
+        fabsf(spectrum.peaks[1].amplitude - 300.0f) < 15.0f, "vibration: second line");
+  check(fabsf(spectrum.peaks[0].order - 0.989f) < 0.01f && fabsf(spectrum.peaks[1].order - 1.978f) < 0.01f,
+        "vibration: orders relative to the rotor");
+  check(fabsf(spectrum.rotorSeenHz - 118.7f) < spectrum.binHz && fabsf(spectrum.rotorAmplitude - 900.0f) < 45.0f,
+        "vibration: rotor line found near the estimate");
+  check(fabsf(spectrum.rmsAmplitude - sqrtf((900.0f * 900.0f + 300.0f * 300.0f) / 2)) < 30.0f,
+        "vibration: window RMS");
+
+  // Load cell at 80 SPS: a 263 Hz rotor line folds to 23 Hz
+  analyzer.reset();
+  fs = 80.0f;
+  for (int i = 0; i < 64; i++) {
+    double v = 84000.0 + 2000.0 * sin(TWO_PI * 263.0 * i / fs) + noise.next(100.0f);
+    analyzer.add((int32_t)lround(v));
+  }
+  ok = analyzer.analyze(fs, 263.0f, 0.05f, spectrum);
+  check(ok && spectrum.points == 64 && fabsf(aliasedHz(263.0f, fs) - 23.0f) < 1e-3f, "vibration: alias folding");
+  check(fabsf(spectrum.rotorSeenHz - 23.0f) < spectrum.binHz && fabsf(spectrum.rotorAmplitude - 2000.0f) < 200.0f &&
+        spectrum.peaks[0].order == 0.0f, "vibration: aliased rotor line in load cell samples");
+
+  analyzer.reset();
+  for (int i = 0; i < VIB_FFT_MIN - 1; i++) analyzer.add(i);
+  check(!analyzer.analyze(fs, 0.0f, 0.1f, spectrum) && !spectrum.valid, "vibration: short window rejected");
+  check(fabsf(expectedRotorHz(1750.0f, 16.8f, 0.5f) - 245.0f) < 0.01f, "vibration: rotor estimate from KV");
+}
+
+// Supervisor stop callback: the test motor stands in for the ESC
+static MotorModel* safetyMotor = nullptr;
+static int safetyStops = 0;
+
+static void safetyStopMotor() {
+  safetyStops++;
+  if (safetyMotor != nullptr) safetyMotor->setPwm(1360);
+}
+
+static void testSafety() {
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.001f);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 400000.0f, 1.0f);
+  safetyMotor = &motor;
+
+  SafetyLimits limits = defaultSafetyLimits();
+  SafetySupervisor safety(limits, safetyStopMotor);
+  uint32_t nowUs = 1000;
+
+  // 1 ms ticks: supervisor checks every 5 ms, 80 SPS samples, loop heartbeat every tick
+  auto run = [&](int ms, bool loopAlive, bool cellAlive) {
+    for (int i = 0; i < ms && !safety.tripped(); i++) {
+      nowUs += 1000;
+      motor.update(0.001f);
+      if (loopAlive) safety.heartbeat(HB_LOOP, nowUs);
+      if (cellAlive && nowUs % 12000 < 1000) {
+        long raw = cell.readRaw();
+        safety.sample(raw, converter.toKg(raw), nowUs);
+      }
+      if (nowUs % 5000 < 1000) safety.check(nowUs);
+    }
+  };
+  auto start = [&](int pwm) {
+    safety.clear();
+    safety.arm(nowUs);
+    motor.setPwm(pwm);
+  };
+
+  // Full-throttle run with spin-up and spin-down: no false trips
+  start(1210);
+  run(3000, true, true);
+  motor.setPwm(1360);
+  run(1000, true, true);
+  safety.disarm();
+  check(!safety.tripped() && safetyStops == 0, "safety: normal run does not trip");
+
+  // Disarmed (motor stopped): nothing has to report
+  run(10000, false, false);
+  check(!safety.tripped(), "safety: no deadlines while disarmed");
+
+  // Over-thrust sample stops the motor from the sample call itself
+  start(1250);
+  run(1000, true, true);
+  safety.sample(84000 + 360000, 0.9f, nowUs);
+  check(safety.fault() == FAULT_THRUST_LIMIT && safetyStops == 1 && motor.pwm() == 1360 &&
+        safety.lastLatencyUs() == 0, "safety: thrust limit stops immediately");
+  check(!safety.armed(), "safety: trip disarms");
+
+  // A jump no spin-up can produce
+  start(1250);
+  run(1000, true, true);
+  long raw = cell.readRaw() + 120000;
+  safety.sample(raw, converter.toKg(raw), nowUs + 12000);
+  check(safety.fault() == FAULT_THRUST_RATE && motor.pwm() == 1360, "safety: thrust rate stops immediately");
+
+  // Control loop hangs with the motor running; the sampler keeps going
+  start(1250);
+  run(500, true, true);
+  uint32_t stallUs = nowUs;
+  run(5000, false, true);
+  uint32_t deadlineUs = stallUs + limits.loopTimeoutMs * 1000;
+  check(safety.fault() == FAULT_LOOP_STALL && motor.pwm() == 1360, "safety: loop stall stops the motor");
+  check(nowUs >= deadlineUs && nowUs - deadlineUs <= 5000 && safety.lastLatencyUs() <= 5000,
+        "safety: stall cutoff within one check period of the deadline");
+
+  // Load cell goes quiet while the loop is fine
+  start(1250);
+  run(500, true, true);
+  uint32_t quietUs = nowUs;
+  run(5000, true, false);
+  check(safety.fault() == FAULT_SAMPLE_TIMEOUT && motor.pwm() == 1360 &&
+        nowUs - quietUs <= limits.sampleTimeoutMs * 1000 + 5000, "safety: sample timeout stops the motor");
+
+  // HX711 stuck on one value, or clipped
+  start(1250);
+  for (int i = 0; i <= limits.stuckSamples; i++) safety.sample(90000, 0.015f, nowUs += 12000);
+  check(safety.fault() == FAULT_LOADCELL, "safety: stuck load cell trips");
+  start(1250);
+  safety.sample(0x7FFFFF, 0.0f, nowUs);
+  check(safety.fault() == FAULT_LOADCELL, "safety: saturated load cell trips");
+
+  // Host heartbeat only when a timeout is set
+  limits.hostTimeoutMs = 2000;
+  start(1250);
+  run(5000, true, true);
+  check(safety.fault() == FAULT_HOST_LOST, "safety: host timeout applies from the live limits");
+  limits.hostTimeoutMs = 0;
+
+  check(safety.trips() == 7 && safetyStops == 7, "safety: every trip calls the stop");
+  check(safety.worstLatencyUs() <= 5000, "safety: worst cutoff within one check period");
+  safety.clear();
+  check(!safety.tripped() && safety.fault() == FAULT_NONE, "safety: clear acknowledges the stop");
+  safetyMotor = nullptr;
+}
+
+// Default firmware sweep under the default limits, the way main.cpp runs it:
+// 1340 -> 1210 us in 10 us steps and back, 2 s between steps, a 2 s hold at
+// the fast end, 10 readings per step from a 10 SPS HX711. waitsSample is the
+// serviceDelay() policy: feed ready conversions to the supervisor while armed.
+// Counts the steps that found a conversion pending and the fewest readings
+// any step got.
+struct SweepRun {
+  SafetyFault fault;
+  int steps;
+  int readyAtStep;
+  int fewestSamples;
+};
+
+static SweepRun runDefaultSweep(bool waitsSample) {
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.001f);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 400000.0f, 1.0f);
+  safetyMotor = &motor;
+
+  SafetyLimits limits = defaultSafetyLimits();
+  SafetySupervisor safety(limits, safetyStopMotor);
+  uint32_t nowUs = 1000;
+  uint32_t conversionUs = 100000;
+  uint32_t lastConversion = 0;
+
+  auto tick = [&]() {
+    nowUs += 1000;
+    motor.update(0.001f);
+    if (nowUs % 5000 < 1000) safety.check(nowUs);
+  };
+  auto ready = [&]() { return nowUs / conversionUs > lastConversion; };
+  auto read = [&]() {
+    lastConversion = nowUs / conversionUs;
+    long raw = cell.readRaw();
+    safety.sample(raw, converter.toKg(raw), nowUs);
+  };
+  auto wait = [&](int ms) {
+    for (int i = 0; i < ms && !safety.tripped(); i++) {
+      tick();
+      safety.heartbeat(HB_LOOP, nowUs);
+      if (waitsSample && safety.armed() && ready()) read();
+    }
+  };
+  auto setEsc = [&](int pwm) {
+    if (StandEsc::stopped(pwm)) safety.disarm();
+    else safety.arm(nowUs);
+    motor.setPwm(pwm);
+  };
+
+  SweepRun run = {FAULT_NONE, 0, 0, 10};
+  SweepStepper sweep;
+  sweep.begin({1340, 1210, 10, true, 0});
+  SweepPoint point;
+  while (!safety.tripped() && sweep.next(point)) {
+    if (point.phaseStart && point.phase == SWEEP_SLOWING_DOWN) wait(2000);
+    setEsc(point.pwm);
+    wait(2);
+    // measureSweepStep(): waitForConversion() before every reading, bounded
+    // and beating the loop heartbeat
+    run.steps++;
+    if (ready()) run.readyAtStep++;
+    int samples = 0;
+    for (int n = 0; n < 10 && !safety.tripped(); n++) {
+      for (int waitedMs = 0; !ready() && waitedMs < 500; waitedMs++) {
+        tick();
+        safety.heartbeat(HB_LOOP, nowUs);
+      }
+      if (!ready()) break;
+      read();
+      samples++;
+    }
+    if (samples < run.fewestSamples) run.fewestSamples = samples;
+    wait(2000);
+  }
+  setEsc(StandEsc::STOP_PWM);
+  safetyMotor = nullptr;
+  run.fault = safety.fault();
+  return run;
+}
+
+static void testSafetySweep() {
+  SweepRun run = runDefaultSweep(true);
+  check(run.fault == FAULT_NONE, "safety sweep: default sweep runs without a trip");
+  // The waits take the pending conversion: a step gated on is_ready() would
+  // measure nothing, the wait for the next one gets all of them
+  check(run.readyAtStep * 4 < run.steps, "safety sweep: steps start with no conversion pending");
+  check(run.fewestSamples == 10, "safety sweep: every step gets all its readings");
+  check(runDefaultSweep(false).fault == FAULT_SAMPLE_TIMEOUT,
+        "safety sweep: waits that skip the load cell would trip the sample timeout");
+}
+
+// ESC output stage writes go to the simulated motor
+static MotorModel* escMotor = nullptr;
+static int escWrites = 0;
+
+static void escWriteMotor(int pwm) {
+  escWrites++;
+  if (escMotor != nullptr) escMotor->setPwm(pwm);
+}
+
+static void testEscTrajectory() {
+  const float DT_S = 0.004f;  // 250 Hz tick
+  TrajectoryLimits limits = {500.0f, 5000.0f};
+  const float MAX_CHANGE = limits.accelUsPerS2 * DT_S + 0.01f;
+
+  // Pot slammed from the slow end to full: bounded slew and slew change, no overshoot
+  EscTrajectory trajectory;
+  trajectory.setLimits(limits);
+  trajectory.reset(1340);
+  trajectory.setTarget(1200);
+  bool withinSlew = true;
+  bool withinAccel = true;
+  bool overshoot = false;
+  float lastVelocity = 0.0f;
+  int ticks = 0;
+  while (!trajectory.settled() && ticks < 1000) {
+    float output = trajectory.step(DT_S);
+    ticks++;
+    if (fabsf(trajectory.velocity()) > limits.slewUsPerS + 0.01f) withinSlew = false;
+    if (!trajectory.settled() && fabsf(trajectory.velocity() - lastVelocity) > MAX_CHANGE) {
+      withinAccel = false;
+    }
+    if (output < 1200.0f) overshoot = true;
+    lastVelocity = trajectory.velocity();
+  }
+  float rampS = ticks * DT_S;
+  check(withinSlew && withinAccel, "esc: slew and slew change within the limits");
+  check(!overshoot && trajectory.output() == 1200.0f, "esc: lands on the target without overshoot");
+  // 140 us at 500 us/s plus 0.1 s to reach and leave full slew
+  check(rampS > 0.35f && rampS < 0.45f, "esc: full-range ramp takes the profile time");
+
+  // Reversal halfway: braking stays within the limit, ends at the new target
+  trajectory.reset(1340);
+  trajectory.setTarget(1200);
+  for (int i = 0; i < 40; i++) trajectory.step(DT_S);
+  float turnedAt = trajectory.output();
+  trajectory.setTarget(1300);
+  withinAccel = true;
+  lastVelocity = trajectory.velocity();
+  for (int i = 0; i < 1000 && !trajectory.settled(); i++) {
+    trajectory.step(DT_S);
+    if (!trajectory.settled() && fabsf(trajectory.velocity() - lastVelocity) > MAX_CHANGE) {
+      withinAccel = false;
+    }
+    lastVelocity = trajectory.velocity();
+  }
+  check(turnedAt < 1300.0f && withinAccel && trajectory.output() == 1300.0f,
+        "esc: target behind a moving output brakes and returns");
+
+  trajectory.setLimits({0.0f, 0.0f});
+  trajectory.setTarget(1250);
+  check(trajectory.step(DT_S) == 1250.0f && trajectory.settled(), "esc: zero slew jumps");
+
+  // Output stage: writes only on change, settled() follows the latest target
+  MotorModel motor(defaultMotorModelConfig());
+  escMotor = &motor;
+  escWrites = 0;
+  EscOutputStage stage(escWriteMotor, 1360);
+  stage.setLimits(limits);
+  uint32_t nowUs = 0xFFFFF000u;  // wraps during the run
+  stage.tick(nowUs);
+  check(escWrites == 1 && motor.pwm() == 1360 && stage.settled(), "esc: first tick writes the initial value");
+  stage.setTarget(1340);
+  stage.tick(nowUs += 4000);  // stop value to the slow end: 20 us
+  stage.setTarget(1210);
+  bool settledEarly = stage.settled();
+  int writesBefore = escWrites;
+  while (!stage.settled()) stage.tick(nowUs += 4000);
+  check(!settledEarly && motor.pwm() == 1210 && stage.output() == 1210, "esc: stage reaches a new target");
+  check(escWrites - writesBefore <= 130 && stage.writtenUs() < 0x10000000u,
+        "esc: one write per changed microsecond, wrap-safe tick clock");
+  stage.jumpTo(1360);
+  check(!stage.settled(), "esc: jump pending until the next tick");
+  stage.tick(nowUs += 4000);
+  check(motor.pwm() == 1360 && stage.settled(), "esc: jump written on the next tick");
+
+  // Ramp sweep vs stepped sweep on the motor model: the phase ends are read at
+  // rest, every reading within half a step of an inner point is averaged; the
+  // stepped sweep reads right after each jump
+  const int STEP = 10;
+  const int RAMP_US_PER_S = 10;
+  stage.setTarget(1340);
+  while (!stage.settled()) stage.tick(nowUs += 4000);
+  for (int i = 0; i < 3000; i++) motor.update(0.001f);
+  float rampError = 0.0f;
+  float stepError = 0.0f;
+  int minSamples = 1000;
+  int elapsedUs = 0;
+  for (int pwm = 1340; pwm >= 1210; pwm -= STEP) {
+    if (pwm < 1340 && stage.target() != 1210) {
+      stage.setLimits({(float)RAMP_US_PER_S, 5000.0f});
+      stage.setTarget(1210);
+    }
+    bool atRest = pwm == 1340 || pwm == 1210;
+    float sum = 0.0f;
+    int samples = 0;
+    while (true) {
+      float along = (float)(pwm - stage.output());  // speeding up: output falls
+      if (along > STEP / 2.0f || samples >= (atRest ? 10 : 1000)) break;
+      motor.update(0.001f);  // 1 ms steps, readings at about 80 SPS
+      elapsedUs += 1000;
+      if (elapsedUs % 4000 == 0) stage.tick(nowUs += 4000);
+      bool counts = atRest ? stage.settled() : along > -STEP / 2.0f;
+      if (elapsedUs % 12000 == 0 && counts) {
+        sum += motor.thrustKg();
+        samples++;
+      }
+    }
+    MotorModel steady(defaultMotorModelConfig());
+    steady.setPwm(pwm);
+    float reference = steady.steadyThrustKg();
+    rampError = fmaxf(rampError, fabsf(sum / samples - reference));
+    if (samples < minSamples) minSamples = samples;
+
+    // Stepped: 10 readings at 80 SPS starting at the jump
+    MotorModel stepped(defaultMotorModelConfig());
+    stepped.setPwm(pwm + STEP);
+    for (int i = 0; i < 300; i++) stepped.update(0.01f);
+    stepped.setPwm(pwm);
+    float stepSum = 0.0f;
+    for (int i = 0; i < 10; i++) {
+      stepped.update(0.0125f);
+      stepSum += stepped.thrustKg();
+    }
+    stepError = fmaxf(stepError, fabsf(stepSum / 10 - reference));
+  }
+  escMotor = nullptr;
+  printf("\nRamp %d us/s: worst point error %.4f kg (%d+ readings), stepped without settling %.4f kg\n",
+         RAMP_US_PER_S, rampError, minSamples, stepError);
+  check(minSamples >= 10, "esc: ramp points get enough readings");
+  check(rampError < stepError / 2 && rampError < 0.01f, "esc: ramp points closer to steady state than jumps");
+}
+
+static void testLiveView() {
+  // Window statistics against a brute-force pass over the latest N values
+  WindowStats window;
+  window.setLength(7);
+  float values[30];
+  SimNoise noise(7);
+  for (int i = 0; i < 30; i++) {
+    values[i] = noise.next(1.0f);
+    window.add(values[i], 1000u + i * 12500u);
+  }
+  WindowSummary w = window.summary();
+  float sum = 0.0f, lo = values[23], hi = values[23];
+  for (int i = 23; i < 30; i++) {
+    sum += values[i];
+    lo = fminf(lo, values[i]);
+    hi = fmaxf(hi, values[i]);
+  }
+  check(w.count == 7 && window.total() == 30, "live: window keeps the latest N of all samples");
+  check(fabsf(w.mean - sum / 7) < 1e-5f && w.min == lo && w.max == hi && w.last == values[29],
+        "live: windowed mean, min and peak hold");
+  check(fabsf(w.rateHz - 80.0f) < 0.01f, "live: sample rate from the window times");
+  window.setLength(1000);
+  check(window.length() == WINDOW_STATS_MAX && window.count() == 0, "live: window length clamped, restarted");
+
+  // Late caller: missed periods are skipped, not fired in a burst
+  RateGate gate(4.0f);
+  uint32_t t = 0xFFF00000u;  // wraps below
+  bool first = gate.due(t);
+  bool early = gate.due(t + 200000);
+  bool onTime = gate.due(t + 250000);
+  bool late = gate.due(t + 2000000);
+  bool burst = gate.due(t + 2000001);
+  check(first && !early && onTime && late && !burst, "live: rate gate keeps cadence, skips missed periods");
+
+  // Ten seconds of manual mode: 1 ms loop, 80 SPS HX711, thrust step at 5 s.
+  // Every conversion sampled, LCD at 4 Hz, log at 10 Hz
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.002f);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 400000.0f, 1.0f);
+  LiveAggregator aggregator;
+  aggregator.configure({0.0f, 4.0f, 10.0f, 32});
+  motor.setPwm(1300);
+  float lowKg = motor.steadyThrustKg();
+  uint32_t nowUs = 0xFFFF0000u;
+  int conversions = 0;
+  bool peakHeld = false;
+  bool minHeld = false;
+  for (int ms = 0; ms < 10000; ms++) {
+    nowUs += 1000;
+    motor.update(0.001f);
+    if (ms == 5000) motor.setPwm(1230);
+    if (ms % 25 == 0 || ms % 25 == 12) {  // 80 SPS
+      conversions++;
+      long raw = cell.readRaw();
+      if (aggregator.accept(nowUs)) aggregator.add(converter.toKg(raw), motor.pwm(), nowUs);
+    }
+    aggregator.logDue(nowUs);
+    if (aggregator.displayDue(nowUs)) {
+      LiveSnapshot snap = aggregator.snapshot();
+      // 0.4 s window just after the step: old level as min, new level as peak
+      if (ms >= 5200 && ms < 5300) {
+        peakHeld = snap.thrust.max > motor.steadyThrustKg() * 0.9f;
+        minHeld = snap.thrust.min < lowKg + 0.01f;
+      }
+    }
+  }
+  LiveSnapshot snap = aggregator.snapshot();
+  uint32_t displayed = aggregator.displayed();
+  uint32_t logged = aggregator.logged();
+  check(snap.samples == (uint32_t)conversions && fabsf(snap.thrust.rateHz - 80.0f) < 1.0f,
+        "live: every conversion in the window at full rate");
+  check(displayed >= 39 && displayed <= 41, "live: LCD refreshed at 4 Hz");
+  check(logged >= 99 && logged <= 101, "live: log rows at their own 10 Hz");
+  check(peakHeld && minHeld, "live: peak and min span a thrust step");
+  check(snap.pwm == 1230 && fabsf(snap.thrust.mean - motor.steadyThrustKg()) < 0.01f,
+        "live: snapshot follows the newest samples");
+
+  // Decimated to 20 Hz: the window covers 4x the time, rates unchanged
+  aggregator.configure({20.0f, 4.0f, 10.0f, 16});
+  for (int ms = 0; ms < 10000; ms++) {
+    nowUs += 1000;
+    if ((ms % 25 == 0 || ms % 25 == 12) && aggregator.accept(nowUs)) {
+      aggregator.add(0.1f, 1300, nowUs);
+    }
+    aggregator.logDue(nowUs);
+    aggregator.displayDue(nowUs);
+  }
+  snap = aggregator.snapshot();
+  printf("\nLive view: %d conversions at 80 SPS, %u LCD frames, %u log rows in 10 s; "
+         "decimated to %u samples at %.1f Hz\n",
+         conversions, (unsigned)displayed, (unsigned)logged, (unsigned)snap.samples, snap.thrust.rateHz);
+  check(snap.samples >= 199 && snap.samples <= 201 && fabsf(snap.thrust.rateHz - 20.0f) < 1.0f,
+        "live: sample rate set independently");
+}
+
+// Runs the bus until both queues are empty
+static void drainBus(I2cScheduler& bus) {
+  while (bus.runOnce()) {
+  }
+}
+
+static void testI2cBus() {
+  FakeI2cPort port;
+  port.addLcd(0x27);
+  port.addRegisterDevice(0x40, 2);
+  // 12 mV across 10 mOhm = 1.2 A; 12.0 V bus (4 mV per LSB, shifted by 3)
+  port.setRegister(0x40, 0x01, 1200);
+  port.setRegister(0x40, 0x02, 3000 << 3);
+  I2cScheduler bus(port, 400000, 20000);
+  int lcdDevice = bus.addDevice("lcd", 0x27);
+  int inaDevice = bus.addDevice("ina219", 0x40);
+  int ghostDevice = bus.addDevice("ghost", 0x50);
+  Ina219PowerSensor power(bus, inaDevice, 0.01f);
+  LcdFrame frame;
+  I2cLcd lcd(bus, lcdDevice);
+
+  // Blocking call with no owner task: the caller runs the bus itself
+  check(power.begin() && port.registerValue(0x40, 0x00) == 0x399F, "i2c: INA219 configured");
+  check(port.clockHz() == 400000, "i2c: bus clock applied");
+
+  // LCD text through the nibble encoder, decoded by the fake backpack
+  frame.write(0, 0, "Thrust: 1.234 kg");
+  frame.write(0, 3, "PWM: 1250");
+  size_t queued = lcd.flush(frame);
+  drainBus(bus);
+  char row0[21], row3[21];
+  port.lcdRow(0, row0);
+  port.lcdRow(3, row3);
+  check(strcmp(row0, "Thrust: 1.234 kg    ") == 0 && strcmp(row3, "PWM: 1250           ") == 0,
+        "i2c: LCD runs land at their cells");
+  check(queued == 6 && !frame.dirty(), "i2c: five characters per transaction");
+
+  // Full redraw queued, then a sensor request: it runs after at most the
+  // LCD transaction already on the wire
+  frame.invalidate();
+  size_t redraw = lcd.flush(frame);
+  check(redraw == 20 && !frame.dirty(), "i2c: full redraw fits the display queue");
+  bus.runOnce();
+  bus.runOnce();
+  port.clearLog();
+  uint32_t requestUs = port.nowUs();
+  power.request();
+  drainBus(bus);
+  bool sensorFirst = port.transfers() > 2 && port.transferAt(0).address == 0x40 &&
+                     port.transferAt(1).address == 0x40;
+  uint32_t sensorWaitUs = port.transferAt(0).startUs - requestUs;
+  check(sensorFirst && sensorWaitUs == 0, "i2c: sensor read preempts queued LCD updates");
+  PowerReading reading;
+  check(power.read(reading) && fabsf(reading.voltageV - 12.0f) < 1e-4f &&
+        fabsf(reading.currentA - 1.2f) < 1e-4f && fabsf(reading.powerW - 14.4f) < 1e-3f,
+        "i2c: INA219 pair decoded off the callbacks");
+  check(power.completed() == 1, "i2c: read() queued the next pair");
+  drainBus(bus);
+
+  // One LCD chunk against a sensor that never lets up: it ages past
+  // maxWaitUs and goes next. Strict priority starves it.
+  for (int strict = 0; strict < 2; strict++) {
+    bus.setMaxWaitUs(strict ? 0 : 20000);
+    frame.write(0, 1, "A");
+    lcd.flush(frame);
+    port.clearLog();
+    uint32_t queuedUs = port.nowUs();
+    uint32_t lcdStartUs = 0;
+    bool lcdRan = false;
+    for (int i = 0; i < 400 && !lcdRan; i++) {
+      power.request();
+      bus.runOnce();
+      for (size_t k = 0; k < port.transfers(); k++) {
+        if (port.transferAt(k).address == 0x27) {
+          lcdRan = true;
+          lcdStartUs = port.transferAt(k).startUs;
+        }
+      }
+    }
+    if (strict) {
+      check(!lcdRan, "i2c: strict priority lets a busy sensor starve the LCD");
+    } else {
+      check(lcdRan && lcdStartUs - queuedUs < 20000 + 200 && bus.agedRuns() == 1,
+            "i2c: waiting LCD update runs within max wait under sensor load");
+    }
+    drainBus(bus);
+  }
+  bus.setMaxWaitUs(20000);
+
+  // Counters: errors for a missing device, bytes and throughput per device
+  bus.resetStats();
+  I2cTransaction probe;
+  memset(&probe, 0, sizeof(probe));
+  probe.device = (uint8_t)ghostDevice;
+  probe.writeLength = 1;
+  I2cResult result;
+  bool ghostOk = bus.transact(I2C_PRIORITY_SENSOR, probe, result);
+  for (int i = 0; i < 10; i++) {
+    power.request();
+    drainBus(bus);
+  }
+  const I2cDeviceStats& ina = bus.stats(inaDevice);
+  const I2cDeviceStats& ghost = bus.stats(ghostDevice);
+  check(!ghostOk && ghost.errors == 1 && ghost.transactions == 1, "i2c: NACK counted as an error");
+  check(ina.transactions == 20 && ina.bytes == 60 && ina.errors == 0, "i2c: per-device transactions and bytes");
+
+  // Same LCD chunk at 100 and 400 kHz
+  uint32_t chunkUs[2];
+  uint32_t clocks[2] = {100000, 400000};
+  for (int i = 0; i < 2; i++) {
+    bus.setClock(clocks[i]);
+    bus.resetStats();
+    frame.write(0, 2, "12345");
+    lcd.flush(frame);
+    drainBus(bus);
+    chunkUs[i] = bus.stats(lcdDevice).busUs;
+    frame.write(0, 2, "     ");
+    lcd.flush(frame);
+    drainBus(bus);
+  }
+  check(chunkUs[0] >= 4 * chunkUs[1] - 4 && chunkUs[0] <= 4 * chunkUs[1] + 4,
+        "i2c: transfer time scales with the bus clock");
+
+  // Queue full: submit refuses and counts, flush leaves the rest dirty
+  bus.resetStats();
+  probe.device = (uint8_t)lcdDevice;
+  probe.done = nullptr;
+  size_t accepted = 0;
+  for (size_t i = 0; i < I2C_QUEUE_DEPTH + 3; i++) {
+    if (bus.submit(I2C_PRIORITY_DISPLAY, probe)) accepted++;
+  }
+  frame.write(0, 1, "queue full");
+  size_t whileFull = lcd.flush(frame);
+  check(accepted == I2C_QUEUE_DEPTH && bus.stats(lcdDevice).dropped == 3, "i2c: full queue drops are counted");
+  check(whileFull == 0 && frame.dirty(), "i2c: LCD waits for room instead of dropping");
+  drainBus(bus);
+  lcd.flush(frame);
+  drainBus(bus);
+  char row1[21];
+  port.lcdRow(1, row1);
+  check(strncmp(row1, "queue full", 10) == 0, "i2c: LCD catches up once the queue drains");
+
+  float kbPerS = bus.stats(lcdDevice).bytes * 1000.0f / bus.stats(lcdDevice).busUs;
+  printf("\nI2C: full LCD redraw %u transactions, chunk %u us at 100 kHz / %u us at 400 kHz; "
+         "LCD payload %.1f kB/s\n",
+         (unsigned)redraw, (unsigned)chunkUs[0], (unsigned)chunkUs[1], kbPerS);
+}
+
+// Arduino map(), as the conversions replaced by the ESC traits used it
+static long arduinoMap(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// Forward-polarity ESC, to check the traits in both directions
+struct ForwardTestEsc {
+  static constexpr int FAST_PWM = 1940;
+  static constexpr int SLOW_PWM = 1100;
+  static constexpr int STOP_PWM = 1000;
+  static constexpr int ATTACH_MIN_US = 1000;
+  static constexpr int ATTACH_MAX_US = 2000;
+};
+typedef EscTraits<ForwardTestEsc> ForwardEsc;
+static_assert(!ForwardEsc::INVERTED && ForwardEsc::SPAN == 840, "forward ESC polarity");
+static_assert(StandEsc::INVERTED && StandEsc::SPAN == 140, "stand ESC polarity");
+// Both pin maps pass their chip's checks on the host too
+static_assert(BoardTraits<DevKitBoard>::POT_PIN == 34 && BoardTraits<S3DevKitBoard>::POT_PIN == 4,
+              "board traits instantiate");
+static_assert(gpioAdc1(CHIP_ESP32, 34) && !gpioAdc1(CHIP_ESP32S3, 34) && gpioAdc1(CHIP_ESP32S3, 4) &&
+                  !gpioInputOnly(CHIP_ESP32S3, 35) && gpioReserved(CHIP_ESP32S3, 33),
+              "S3 pins are not checked against the classic map");
+
+static void testStandConfig() {
+  // Same pulse widths as the map()/lroundf() expressions they replace
+  bool potSame = true;
+  for (int raw = 0; raw <= StandBoard::ADC_MAX; raw++) {
+    long old = arduinoMap(raw, 0, 4095, 1200, 1340);
+    if (StandEsc::pwmFromPot(raw, StandBoard::ADC_MAX) != old) potSame = false;
+  }
+  check(potSame, "config: pot -> PWM matches map() over the whole ADC range");
+  bool percentSame = true;
+  for (int pwm = StandEsc::FAST_PWM; pwm <= StandEsc::SLOW_PWM; pwm++) {
+    if (StandEsc::percentFromPwm(pwm) != arduinoMap(pwm, 1340, 1200, 0, 100)) percentSame = false;
+  }
+  check(percentSame, "config: throttle percent matches map()");
+  bool throttleSame = true;
+  for (int i = 0; i <= 1000; i++) {
+    float throttle = i / 1000.0f;
+    int old = 1340 - (int)lroundf(throttle * (1340 - 1200));
+    if (StandEsc::pwmFromThrottle(throttle) != old) throttleSame = false;
+  }
+  check(throttleSame, "config: hold throttle -> PWM matches the lroundf() form");
+
+  // Forward ESC: full throttle is the long pulse, stop below the slow end
+  check(ForwardEsc::pwmFromThrottle(1.0f) == 1940 && ForwardEsc::pwmFromThrottle(0.25f) == 1310 &&
+            ForwardEsc::percentFromPwm(1520) == 50 && ForwardEsc::pwmFromPot(0, 4095) == 1940,
+        "config: conversions follow the forward polarity");
+  check(ForwardEsc::stopped(1000) && ForwardEsc::stopped(1100) && !ForwardEsc::stopped(1101) &&
+            StandEsc::stopped(1360) && StandEsc::stopped(1340) && !StandEsc::stopped(1339),
+        "config: stopped on the slow side for either polarity");
+  check(fabsf(ForwardEsc::throttleFromPwm(1520) - 0.5f) < 1e-6f &&
+            fabsf(StandEsc::throttleFromPwm(1270) - 0.5f) < 1e-6f,
+        "config: throttle from PWM");
+
+  MotorModelConfig motor = defaultMotorModelConfig();
+  check(motor.stopPwm == StandEsc::SLOW_PWM && motor.fullPwm == StandEsc::FAST_PWM,
+        "config: simulated motor uses the stand's ESC endpoints");
+}
+
+// Runs one discovery probe on the simulated motor: rest, spin-up and settle
+// times as the firmware's, then the mean of ten readings
+static float runSimEscProbe(MotorModel& motor, SimLoadCell& cell, const EscProbe& probe,
+                            int stopPwm, int& fastestPwm) {
+  const float DT = 0.01f;
+  if (probe.start != ESC_PROBE_RUNNING) {
+    motor.setPwm(stopPwm);
+    for (int i = 0; i < 200; i++) motor.update(DT);
+  }
+  if (probe.start == ESC_PROBE_FROM_SPIN) {
+    motor.setPwm(probe.spinPwm);
+    for (int i = 0; i < 100; i++) motor.update(DT);
+  }
+  motor.setPwm(probe.pwm);
+  for (int i = 0; i < 100; i++) motor.update(DT);
+  if (probe.pwm < fastestPwm) fastestPwm = probe.pwm;
+  float sum = 0.0f;
+  for (int i = 0; i < 10; i++) {
+    motor.update(0.1f);
+    sum += cell.readKg();
+  }
+  return sum / 10;
+}
+
+static void testEscDiscovery() {
+  // An ESC that needs 1330 us to start but keeps turning (at idle) up to
+  // 1346 us once running, and stops adding thrust at 1215 us
+  MotorModelConfig config = defaultMotorModelConfig();
+  config.stopPwm = 1346;
+  config.startPwm = 1330;
+  config.idleThrottle = 0.2f;
+  config.fullPwm = 1215;
+  config.timeConstantS = 0.05f;
+  MotorModel motor(config);
+  SimLoadCell cell(motor, 0, 100000.0f, 0.002f, 11);
+
+  EscDiscoveryConfig search = defaultEscDiscoveryConfig();
+  EscDiscovery discovery;
+  discovery.begin(search, 0.002f / 1.7320508f);  // uniform noise: a / sqrt(3)
+  int fastestPwm = search.searchSlowPwm;
+  bool fromRestFirst = false;
+  EscProbe probe;
+  while (discovery.next(probe)) {
+    if (discovery.probes() == 0) fromRestFirst = probe.start == ESC_PROBE_FROM_REST;
+    discovery.measured(runSimEscProbe(motor, cell, probe, search.searchSlowPwm, fastestPwm));
+  }
+  EscEndpoints e = discovery.endpoints();
+  printf("\n       start %d us, stall %d us, saturation %d us, slow %d, stop %d, %d probes\n",
+         e.startPwm, e.stallPwm, e.fastPwm, e.slowPwm, e.stopPwm, e.probes);
+  check(discovery.ok() && fromRestFirst, "esc discovery: search completes on the simulated ESC");
+  check(e.startPwm >= 1330 - 1 - search.resolutionPwm && e.startPwm <= 1329,
+        "esc discovery: spin-up threshold within the resolution");
+  check(e.stallPwm >= 1345 - search.resolutionPwm && e.stallPwm <= 1345,
+        "esc discovery: turning motor's stall point found past the spin-up threshold");
+  check(e.slowPwm >= 1346 && e.slowPwm <= 1346 + search.resolutionPwm &&
+            e.stopPwm == e.slowPwm + search.stopMarginPwm,
+        "esc discovery: slow end still from either side, stop past it");
+  check(e.saturated && abs(e.fastPwm - 1216) <= 3, "esc discovery: saturation point found");
+  check(fastestPwm >= config.fullPwm - (search.flatSteps + 1) * search.coarseStepPwm,
+        "esc discovery: climb ends once thrust goes flat");
+  check(e.probes < 40, "esc discovery: coarse-to-fine keeps the probe count low");
+
+  // Endpoints become a sweep the stand can run
+  EscRange range = {e.fastPwm, e.slowPwm, e.stopPwm};
+  check(range.inverted() && range.stopped(e.stopPwm) && range.contains(1300) &&
+            range.percentFromPwm(e.fastPwm) == 100,
+        "esc discovery: endpoints usable as the ESC range");
+
+  // A motor turning at the search's slow end is refused, not tuned around
+  MotorModelConfig runaway = config;
+  runaway.stopPwm = 1450;
+  runaway.startPwm = 0;
+  MotorModel fast(runaway);
+  SimLoadCell fastCell(fast, 0, 100000.0f, 0.002f, 12);
+  discovery.begin(search, 0.001f);
+  while (discovery.next(probe)) {
+    discovery.measured(runSimEscProbe(fast, fastCell, probe, search.searchSlowPwm, fastestPwm));
+  }
+  check(!discovery.ok() && discovery.probes() == 1, "esc discovery: turning at the slow end fails");
+
+  // Stored per ESC name, checked on load
+  check(escNameValid("t-motor_40a") && !escNameValid("") && !escNameValid("has space") &&
+            !escNameValid("sixteen-chars-xx"),
+        "esc discovery: ESC names fit an NVS key");
+  EscProfileRecord record;
+  clearEscProfile(record, "t-motor_40a");
+  record.endpoints = e;
+  record.crc = escProfileCrc(record);
+  bool valid = escProfileValid(record);
+  record.endpoints.stopPwm++;
+  check(valid && !escProfileValid(record), "esc discovery: stored profile checked by CRC");
+}
+
+static void testEndurance() {
+  // 80 SPS for 6 minutes: slow decay, a 0.05 kg step down at 250 s (past the
+  // 10 % drop trigger) and a single 0.3 kg spike at 300 s
+  BurstSample storage[256];
+  EnduranceRun run;
+  run.attachWindow(storage, 256);
+  EnduranceTriggers triggers = defaultEnduranceTriggers();
+  triggers.spikeKg = 0.1f;
+  run.begin(triggers, 1270, 5);
+
+  const uint32_t periodUs = 12500;
+  int seconds = 0, minutes = 0, saves = 0, triggered = 0, frozen = 0;
+  bool countsOk = true, secondOk = true;
+  RunningStats second42;
+  double minute2Sum = 0.0;
+  uint32_t minute2Count = 0;
+  EnduranceSummary minute2 = {};
+  uint32_t stepUs = 250000000UL;
+  for (uint32_t i = 0; i < 360 * 80; i++) {
+    uint32_t t = i * periodUs;
+    float kg = 0.5f - 0.0001f * (t / 1e6f) + (i % 2 ? 0.01f : -0.01f);
+    if (t >= stepUs) kg -= 0.05f;
+    if (t == 300000000UL) kg += 0.3f;
+    PowerReading power = {16.0f - 0.001f * (t / 1e6f), 10.0f, 0.0f};
+    if (t / 1000000 == 42) second42.add(kg);
+    if (t / 60000000 == 2) {
+      minute2Sum += kg;
+      minute2Count++;
+    }
+    uint8_t events = run.add(t, (int32_t)(kg * 100000.0f), kg, power);
+    if (events & ENDURANCE_SECOND) {
+      seconds++;
+      countsOk = countsOk && run.secondSummary().count == 80;
+      if (run.secondSummary().index == 42) {
+        const EnduranceSummary& s = run.secondSummary();
+        secondOk = fabsf(s.meanKg - second42.mean()) < 1e-5f && s.minKg == second42.min() &&
+                   s.maxKg == second42.max() && fabsf(s.stddevKg - second42.stddev()) < 1e-5f &&
+                   fabsf(s.meanA - 10.0f) < 1e-4f && fabsf(s.minV - (16.0f - 0.001f * 42.9875f)) < 1e-4f;
+      }
+    }
+    if (events & ENDURANCE_MINUTE) {
+      minutes++;
+      if (run.minuteSummary().index == 2) minute2 = run.minuteSummary();
+    }
+    if (events & ENDURANCE_SAVE_DUE) saves++;
+    if (events & ENDURANCE_TRIGGER) triggered++;
+    if (events & ENDURANCE_FROZEN) frozen++;
+  }
+  const EnduranceRecord& record = run.record();
+  const AnomalyWindow& window = run.window();
+  check(seconds == 359 && countsOk && secondOk,
+        "endurance: per-second mean/min/max/stddev match the readings");
+  check(minutes == 5 && minute2.count == minute2Count &&
+            fabsf(minute2.meanKg - (float)(minute2Sum / minute2Count)) < 1e-5f,
+        "endurance: minute summaries roll up a full minute of readings");
+  check(record.minutes == 5 && fabsf(record.referenceKg - enduranceMinute(record, 0).meanKg) < 1e-6f &&
+            record.referenceKg > 0.49f && record.referenceKg < 0.5f,
+        "endurance: first minute is the drop reference");
+
+  size_t before = 0;
+  for (size_t i = 0; i < window.count(); i++) {
+    if (window.sample(i).timeUs < window.triggerUs()) before++;
+  }
+  bool ordered = true;
+  for (size_t i = 1; i < window.count(); i++) {
+    ordered = ordered && window.sample(i).timeUs - window.sample(i - 1).timeUs == periodUs;
+  }
+  printf("\n       drop at %.2f s, window %u samples (%u before), triggers %u\n",
+         record.anomalyMs / 1000.0f, (unsigned)window.count(), (unsigned)before, record.triggers);
+  check(record.anomaly == ANOMALY_DROP && record.anomalyMs >= 251000 && record.anomalyMs < 251100,
+        "endurance: drop below the reference triggers once the second closes");
+  check(frozen == 1 && window.frozen() && window.count() == 256 && before == 128 && ordered,
+        "endurance: raw window frozen with the trigger in the middle");
+  check(triggered == 2 && record.triggers == 2 && run.lastAnomaly() == ANOMALY_SPIKE &&
+            window.triggerUs() / 1000 == record.anomalyMs,
+        "endurance: later spike counted, window keeps the first anomaly");
+  check(saves == 1, "endurance: NVS save due once per save interval");
+
+  const DecayChart& chart = run.chart();
+  uint8_t heights[ENDURANCE_CHART_COLUMNS];
+  float bottomKg, topKg;
+  int columns = chart.heights(heights, 24, 0.02f, bottomKg, topKg);
+  bool falling = true;
+  for (int i = 1; i < columns; i++) {
+    falling = falling && heights[i] <= heights[i - 1];
+  }
+  check(chart.bucketSeconds() == 20 && columns == 18 && heights[0] == 24 &&
+            heights[columns - 1] <= 3 && falling,
+        "endurance: decay chart merged to fit and falls with the thrust");
+
+  // An hour past the ring: 65 minutes at 2 readings a second, thrust marking the minute
+  run.begin(defaultEnduranceTriggers(), 1270, 5);
+  saves = 0;
+  for (uint32_t t = 0; t < 65u * 60u * 1000000u; t += 500000) {
+    float kg = 1.0f + 0.001f * (t / 60000000);
+    PowerReading power = {0.0f, 0.0f, 0.0f};
+    if (run.add(t, 0, kg, power) & ENDURANCE_SAVE_DUE) saves++;
+  }
+  if (run.add(65u * 60u * 1000000u, 0, 1.0f, {0.0f, 0.0f, 0.0f}) & ENDURANCE_SAVE_DUE) {
+    saves++;  // This reading closes minute 65
+  }
+  EnduranceRecord copy = run.record();
+  check(copy.minutes == 65 && enduranceMinutesKept(copy) == ENDURANCE_MAX_MINUTES &&
+            enduranceFirstMinute(copy) == 5 && fabsf(enduranceMinute(copy, 0).meanKg - 1.005f) < 1e-5f &&
+            fabsf(enduranceMinute(copy, 59).meanKg - 1.064f) < 1e-5f && enduranceMinute(copy, 0).minV == 0.0f,
+        "endurance: minute ring keeps the latest hour in order");
+  check(saves == 13 && run.chart().columns() <= ENDURANCE_CHART_COLUMNS && run.chart().bucketSeconds() == 320,
+        "endurance: writes and chart stay bounded over a long run");
+  printf("\n       record %u bytes, run state %u bytes, raw window borrowed\n",
+         (unsigned)sizeof(EnduranceRecord), (unsigned)sizeof(EnduranceRun));
+
+  copy.crc = enduranceCrc(copy);
+  bool valid = enduranceValid(copy);
+  copy.minute[3].meanKg += 0.001f;
+  check(valid && !enduranceValid(copy), "endurance: stored record checked by CRC");
+}
+
+static void testMemory() {
+  // Arenas: aligned bump allocation, failures counted, PSRAM first for large buffers
+  alignas(8) static uint8_t sramBlock[256];
+  alignas(8) static uint8_t psramBlock[128];
+  MemoryArena sram("sram");
+  MemoryArena psram("psram");
+  TieredArena memory(sram, psram);
+  MemoryTier tier;
+  check(memory.allocate(16, false, tier) == nullptr && sram.failures() == 1, "memory: unattached arena fails");
+  sram.attach(sramBlock, sizeof(sramBlock));
+  uint8_t* a = sram.allocateArray<uint8_t>(3);
+  uint32_t* b = sram.allocateArray<uint32_t>(4);
+  check(a == sramBlock && (uintptr_t)b % alignof(uint32_t) == 0 && sram.used() == 20, "memory: aligned bump allocation");
+  check(sram.allocate(sram.remaining() + 1) == nullptr && sram.failures() == 2 && sram.used() == 20,
+        "memory: request that does not fit fails without growing");
+  check(memory.allocate(64, true, tier) != nullptr && tier == TIER_SRAM, "memory: large buffer in SRAM without PSRAM");
+  psram.attach(psramBlock, sizeof(psramBlock));
+  check(memory.allocate(100, true, tier) != nullptr && tier == TIER_PSRAM, "memory: large buffer in PSRAM");
+  check(memory.allocate(100, true, tier) != nullptr && tier == TIER_SRAM, "memory: falls back to SRAM when PSRAM is full");
+  check(memory.allocate(16, false, tier) != nullptr && tier == TIER_SRAM && psram.used() == 100,
+        "memory: small buffers stay in SRAM");
+
+  countAllocations = true;
+  int* probe = new int(3);
+  countAllocations = false;
+  delete probe;
+  check(allocationCount > 0, "memory: allocation counter sees new");
+  allocationCount = 0;
+
+  // Everything a run touches, set up as at boot
+  MotorModel motor(defaultMotorModelConfig());
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.002f);
+  SimPowerSensor power(motor, 0.05f);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 400000.0f, 1.0f);
+  ZeroTracker tracker(defaultZeroTrackConfig());
+  StepPowerAccumulator stepPower(0.127f);
+  SafetyLimits limits = defaultSafetyLimits();
+  SafetySupervisor safety(limits, nullptr);
+  ThrustPid pid(defaultThrustPidConfig());
+  alignas(8) static uint8_t captureBlock[512 * sizeof(BurstSample)];
+  MemoryArena captureArena("sram");
+  MemoryArena noPsram("psram");
+  captureArena.attach(captureBlock, sizeof(captureBlock));
+  TieredArena captureMemory(captureArena, noPsram);
+  BurstCapture burst;
+  burst.allocate(captureMemory, 512);
+  static VibrationAnalyzer vibration;
+  VibrationSpectrum spectrum;
+  uint8_t logStorage[512];
+  LogQueue queue(logStorage, sizeof(logStorage));
+  char drained[LOG_LINE_SIZE];
+  LcdFrame lcd;
+  uint8_t frame[TELEMETRY_MAX_FRAME];
+  RamCheckpointStore flash;
+  BatchQueue batch(flash);
+  BatchPlan plan = {};
+  plan.repetitions = 3;
+  plan.profileCount = 1;
+  plan.profiles[0] = {1340, 1210, 10, 2000, 0};
+  batch.begin(plan);
+  unsigned long stepDelay = 2000;
+  const ConsoleParam params[] = {{"step_delay", PARAM_ULONG, &stepDelay, 100, 60000}};
+  BufferOutput out;
+  CommandConsole console(nullptr, 0, params, 1, out);
+
+  // Three batch runs: sweep, sampling, analysis, logging, LCD, telemetry, console, checkpoints
+  countAllocations = true;
+  uint32_t nowUs = 0;
+  float timeS = 0.0f;
+  while (batch.active()) {
+    SweepStepper sweep;
+    sweep.begin({batch.profile().slowPwm, batch.profile().fastPwm, batch.profile().stepPwm, true,
+                 batch.profile().rampUsPerS});
+    RunSummary summary = batch.partial();
+    SweepPoint point;
+    while (sweep.next(point)) {
+      motor.setPwm(point.pwm);
+      safety.arm(nowUs);
+      stepPower.reset();
+      vibration.reset();
+      for (int i = 0; i < 64; i++) {
+        motor.update(0.0125f);
+        nowUs += 12500;
+        long raw = cell.readRaw();
+        float kg = converter.toKg(raw);
+        safety.sample(raw, kg, nowUs);
+        safety.heartbeat(HB_LOOP, nowUs);
+        safety.check(nowUs);
+        PowerReading reading;
+        power.read(reading);
+        stepPower.add(kg, reading);
+        vibration.add(raw);
+        pid.update(0.3f, kg, 0.0125f);
+      }
+      StepPowerResult step = stepPower.result();
+      vibration.analyze(80.0f, 200.0f, 0.3f, spectrum);
+      if (step.thrustKg > summary.maxThrustKg) summary.maxThrustKg = step.thrustKg;
+
+      LineBuilder line;
+      line.integer(point.pwm).text("us\t| ").fixed(step.thrustKg, 3).text(" kg\t| ");
+      line.fixed(step.powerW, 1).text(" W\r\n");
+      queue.push(line);
+      while (queue.peek(drained, sizeof(drained)) > 0) queue.pop();
+
+      char text[LcdFrame::COLS + 1];
+      formatFixed(text, sizeof(text), step.thrustKg, 3);
+      lcd.writePadded(0, 2, text, LcdFrame::COLS);
+      LcdRun run;
+      while (lcd.nextRun(run)) {
+      }
+
+      uint8_t payload[8] = {0};
+      encodeTelemetryFrame(TELEMETRY_BURST_RESULT, payload, sizeof(payload), frame, sizeof(frame));
+      ScriptInput in = {"set step_delay 1500\n", 0};
+      while (in.available()) console.poll(in, 16);
+      out.clear();
+
+      batch.stepDone(sweep.index(), summary);
+    }
+    batch.runDone(summary);
+
+    // Stopped between runs: zero tracking and a step capture
+    motor.setPwm(1360);
+    safety.disarm();
+    for (int i = 0; i < 100; i++) {
+      motor.update(0.1f);
+      timeS += 0.1f;
+      tracker.update(converter, cell.readRaw(), timeS);
+    }
+    burst.start(nowUs);
+    for (int i = 0; i < 120; i++) {
+      if (i == 16) burst.markStep(nowUs, 1360, 1300);
+      nowUs += 12500;
+      burst.add(nowUs, (int32_t)cell.readRaw(), 1300, 0);
+    }
+    analyzeBurst(burst.samples(), burst.count(), burst.stepUs());
+  }
+  countAllocations = false;
+  check(!batch.active() && stepDelay == 1500, "memory: steady-state run completed");
+  printf("       steady state: %ld allocations over 3 runs\n", allocationCount);
+  check(allocationCount == 0, "memory: no dynamic allocation in steady state");
+}
+
+// Serial capture of the record frames, with text rows in between as on the port
+static uint8_t recordLog[32768];
+static size_t recordLogLength = 0;
+static int recordFramesSeen = 0;
+static int recordDropFrame = -1;
+
+static void appendRecordLog(const uint8_t* data, size_t length) {
+  if (recordLogLength + length <= sizeof(recordLog)) {
+    memcpy(recordLog + recordLogLength, data, length);
+    recordLogLength += length;
+  }
+}
+
+static void recordSink(const uint8_t* frame, size_t length) {
+  if (recordFramesSeen++ != recordDropFrame) {
+    appendRecordLog(frame, length);
+  }
+}
+
+class ReplayCapture : public ReplayListener {
+ public:
+  ReplayCapture() : steps(0), ended(false) {}
+
+  void stepDone(int pwm, const StepPowerResult& step) override {
+    if (steps < 32) {
+      pwms[steps] = pwm;
+      results[steps] = step;
+    }
+    steps++;
+  }
+
+  void runEnded(const ReplayRun& r) override {
+    run = r;
+    ended = true;
+  }
+
+  int steps;
+  int pwms[32];
+  StepPowerResult results[32];
+  ReplayRun run;
+  bool ended;
+};
+
+static void replayLog(const ReplayOptions& options, ReplayCapture& capture, uint32_t& lostFrames) {
+  TelemetryDecoder decoder;
+  ReplayEngine engine(options, capture);
+  for (size_t i = 0; i < recordLogLength; i++) {
+    if (decoder.feed(recordLog[i])) {
+      engine.feed(decoder.type(), decoder.payload(), decoder.length());
+    }
+  }
+  lostFrames = engine.lostFrames();
+}
+
+static void testRecordReplay() {
+  const float PROP_DIAMETER_M = 0.127f;
+  const int STOPPED_PWM = 1340;
+  const int SAMPLES = 10;
+  const int SETTLE = 1;
+
+  // The firmware's processing, recording as it goes (see measureSweepStep)
+  MotorModel motor(defaultMotorModelConfig());
+  motor.setPwm(1360);
+  SimLoadCell cell(motor, 84000, 400000.0f, 0.001f, 7);
+  SimPowerSensor sensor(motor, 0.05f, 8);
+  CalibrationLut lut;
+  lut.build(1.0f / 400000.0f, -2.0e-14f, 800000);
+  LoadCellConverter converter;
+  converter.setCalibration(84000, 1.0f, 1.0f);
+  converter.setLut(&lut);
+  converter.setTemperature(24.0f);
+  DriftModel drift = {24.0f, 0.0004f, 0.0001f};
+  converter.setDriftModel(drift);
+  ZeroTracker tracker(defaultZeroTrackConfig());
+  StepPowerAccumulator power(PROP_DIAMETER_M);
+  SweepTotals totals;
+  totals.reset();
+  RawRecorder recorder(recordSink);
+
+  SweepConfig config = {1340, 1240, 20, true, 0};
+  RecordHeader header;
+  fillRecordHeader(header, converter);
+  header.run = 3;
+  header.sweep = config;
+  header.settleSamples = SETTLE;
+  header.stoppedPwm = STOPPED_PWM;
+  header.propDiameterM = PROP_DIAMETER_M;
+  header.payload = {0.5f, 4, 2.0f};
+  // 15 s before the 32-bit event times wrap, so the run crosses it
+  const uint64_t START_US = (1ull << 32) - 15000000;
+  header.startUs = START_US;
+  recorder.start(header, &lut);
+
+  const char* text = "PWM (us) | Throttle % | Thrust (kg) | Progress\r\n";
+  appendRecordLog((const uint8_t*)text, strlen(text));
+
+  // Stopped with 10 g of creep: zero tracking moves the offset
+  uint64_t nowUs = START_US;
+  cell.setDriftKg(0.010f);
+  for (int i = 0; i < 100; i++, nowUs += 100000) {
+    long raw = cell.readRaw();
+    recorder.add(REC_IDLE_SAMPLE, raw, (uint32_t)nowUs);
+    tracker.update(converter, raw, nowUs / 1e6);
+  }
+  bool tracked = converter.offset() != 84000;
+
+  SweepStepper sweep;
+  sweep.begin(config);
+  SweepPoint point;
+  int deviceSteps = 0;
+  StepPowerResult deviceResults[32];
+  while (sweep.next(point)) {
+    motor.setPwm(point.pwm);
+    recorder.add(REC_ESC, point.pwm, (uint32_t)nowUs);
+    if (point.pwm < STOPPED_PWM) tracker.reset();
+    recorder.add(REC_STEP_BEGIN, point.pwm, (uint32_t)nowUs);
+    if (point.index == 4) {
+      converter.setTemperature(27.5f);
+      recorder.addFloat(REC_TEMPERATURE, 27.5f, (uint32_t)nowUs);
+    }
+    power.reset();
+    for (int i = 0; i < SAMPLES; i++) {
+      motor.update(0.1f);
+      nowUs += 100000;
+      long raw = cell.readRaw();
+      float kg = converter.toKg(raw);
+      PowerReading reading;
+      sensor.read(reading);
+      // Power is read after the load cell, as on the stand
+      recorder.addFloat(REC_VOLTAGE, reading.voltageV, (uint32_t)nowUs + 400);
+      recorder.addFloat(REC_CURRENT, reading.currentA, (uint32_t)nowUs + 400);
+      recorder.addFloat(REC_POWER, reading.powerW, (uint32_t)nowUs + 400);
+      recorder.add(REC_SAMPLE, raw, (uint32_t)nowUs);
+      if (i >= SETTLE) power.add(kg, reading);
+    }
+    recorder.add(REC_STEP_END, SAMPLES, (uint32_t)nowUs);
+    StepPowerResult step = power.result();
+    totals.add(point.pwm, step);
+    if (deviceSteps < 32) deviceResults[deviceSteps] = step;
+    deviceSteps++;
+  }
+  motor.setPwm(1360);
+  recorder.add(REC_ESC, 1360, (uint32_t)nowUs);
+  recorder.stop(true, (uint32_t)nowUs);
+  float devicePayload = payloadCapacityKg(totals.maxThrustKg, header.payload);
+  appendRecordLog((const uint8_t*)text, strlen(text));
+
+  check(tracked && recorder.frames() > 3 && recordLogLength < sizeof(recordLog),
+        "record: run recorded with zero tracking active");
+
+  // As recorded: every step and the totals bit for bit
+  ReplayCapture replayed;
+  uint32_t lost = 0;
+  replayLog(recordedReplayOptions(), replayed, lost);
+  bool same = replayed.ended && replayed.steps == deviceSteps && lost == 0;
+  for (int i = 0; same && i < deviceSteps; i++) {
+    same = memcmp(&replayed.results[i], &deviceResults[i], sizeof(StepPowerResult)) == 0;
+  }
+  check(same, "replay: every step bit-exact");
+  check(memcmp(&replayed.run.totals, &totals, sizeof(totals)) == 0 &&
+        memcmp(&replayed.run.payloadKg, &devicePayload, sizeof(float)) == 0 && replayed.run.completed,
+        "replay: totals and payload bit-exact");
+  check(replayed.run.header.run == 3 && replayed.run.header.sweep.stepPwm == 20 &&
+        replayed.run.firstUs == START_US && replayed.run.durationUs == nowUs - START_US + 400,
+        "replay: header and timing across the 32-bit wrap");
+  const ReplayRun& timing = replayed.run;
+  check(timing.sampleIntervalUs.count() == (uint32_t)(deviceSteps * (SAMPLES - 1)) &&
+        timing.sampleIntervalUs.mean() == 100000.0f && timing.escToSampleUs.count() == (uint32_t)deviceSteps &&
+        timing.escToSampleUs.mean() == 100000.0f, "replay: sample interval and ESC-to-sample lag");
+
+  // A/B: the same data processed differently
+  ReplayOptions noZero = recordedReplayOptions();
+  noZero.zeroTracking = false;
+  ReplayCapture withoutZero;
+  replayLog(noZero, withoutZero, lost);
+  float shiftG = (withoutZero.run.totals.maxThrustKg - totals.maxThrustKg) * 1000.0f;
+  check(withoutZero.steps == deviceSteps && shiftG > 5.0f && shiftG < 15.0f,
+        "replay: zero tracking off keeps the creep in the thrust");
+
+  ReplayOptions settle = recordedReplayOptions();
+  settle.settleSamples = 5;
+  ReplayCapture settled;
+  replayLog(settle, settled, lost);
+  bool trimmed = settled.steps == deviceSteps;
+  bool differs = false;
+  for (int i = 0; i < deviceSteps && i < settled.steps; i++) {
+    if (settled.results[i].samples != (uint32_t)(SAMPLES - 5)) trimmed = false;
+    if (settled.results[i].thrustKg != deviceResults[i].thrustKg) differs = true;
+  }
+  check(trimmed && differs, "replay: settle option changes the averages");
+
+  // A frame lost on the way is reported, not silently replayed
+  recordLogLength = 0;
+  recordFramesSeen = 0;
+  recordDropFrame = 6;
+  RawRecorder again(recordSink);
+  again.start(header, &lut);
+  for (int i = 0; i < 200; i++) again.add(REC_IDLE_SAMPLE, 84000, i);
+  again.stop(false, 200);
+  ReplayCapture gap;
+  replayLog(recordedReplayOptions(), gap, lost);
+  check(lost == 1 && gap.run.lostFrames == 1 && gap.ended && !gap.run.completed,
+        "replay: dropped frame counted");
+}
+
+int main() {
+  printf("=== Native Simulator Checks ===\n\n");
+
+  testRunningStats();
+  testPowerSweep();
+  testThrustHold();
+  testBurstCapture();
+  testSweepAndLcd();
+  testCommandConsole();
+  testTextLogger();
+  testBatchQueue();
+  testZeroTracking();
+  testCalibration();
+  testSafety();
+  testSafetySweep();
+  testEscTrajectory();
+  testLiveView();
+  testI2cBus();
+  testStandConfig();
+  testEscDiscovery();
+  testEndurance();
+  testVibration();
+  testMemory();
+  testRecordReplay();
+
+  printf("\n%s (%d failure%s)\n", failures == 0 ? "ALL PASSED" : "FAILED",
+         failures, failures == 1 ? "" : "s");
+  return failures == 0 ? 0 : 1;
+}
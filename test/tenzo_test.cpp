@@ -1,36 +1,45 @@
 #include <Arduino.h>
 #include "HX711.h"
-
-#define DT 22
-#define SCK 23
+#include "Calibration.h"
+#include "StandConfig.h"
 
 HX711 scale;
-
-const float CALIBRATION_WEIGHT_KG = 0.800; 
-const float CORRECTION_K = 3.265;
+LoadCellConverter loadCell;
+CalibrationRecord calibration;
+CalibrationLut calibrationLut;
 
 void setup() {
   Serial.begin(9600);
-  scale.begin(DT, SCK);
+  scale.begin(StandBoard::LOADCELL_DT_PIN, StandBoard::LOADCELL_SCK_PIN);
 
   Serial.println("=== HX711 CALIBRATION ===");
   delay(2000);
   scale.tare();
 
+  // Multi-point calibration saved by the main program ('cal fit'), if any
+  if (loadCalibration(calibration)) {
+    buildCalibrationLut(calibration, calibrationLut);
+    loadCell.setLut(&calibrationLut);
+    loadCell.setOffset(scale.get_offset());
+    Serial.print("Multi-point calibration, points: ");
+    Serial.print(calibration.pointCount);
+    Serial.print(", rms (g): ");
+    Serial.println(calibration.rmsKg * 1000.0f, 2);
+    return;
+  }
+
   long raw = scale.read_average(20); 
   float scale_factor = raw / CALIBRATION_WEIGHT_KG;
 
   scale.set_scale(scale_factor);
+  loadCell.setCalibration(scale.get_offset(), scale.get_scale(), CORRECTION_K);
 }
 void loop() {
   if (scale.is_ready()) {
-    float weight_raw = scale.get_units(10);   
-    float weight_kg  = weight_raw * CORRECTION_K;
+    float weight_kg = loadCell.toKg(scale.read_average(10));
 
     Serial.print("Вага (кг): ");
     Serial.println(weight_kg, 3);
   }
   delay(500);
 }
-
-
@@ -3,25 +3,23 @@
 #include <Wire.h>
 #include <LiquidCrystal_I2C.h>
 #include "HX711.h"
+#include "LoadCell.h"  // CALIBRATION_WEIGHT_KG, CORRECTION_K
+#include "StandConfig.h"  // Pins and ESC endpoints
 
-#define MOTOR_PIN 19  // PWM pin for motor ESC
-
-// Load cell pins
-#define DT 18
-#define SCK 23
-
-// PWM range for ESC (INVERTED: lower PWM = faster)
+// Ramp range (INVERTED ESC: lower PWM = faster)
 #define MIN_PWM 1210   // Maximum speed (fastest)
-#define MAX_PWM 1340   // Minimum speed (slowest)
+#define MAX_PWM StandEsc::SLOW_PWM   // Minimum speed (slowest)
+static_assert(StandEsc::contains(MIN_PWM) && MIN_PWM < MAX_PWM, "ramp range outside the ESC's range");
+// Throttle % runs over the ramp (0 at 1340us, 100 at 1210us) as it always
+// has here, not over the ESC's full 1200-1340us span
+constexpr EscRange RAMP_RANGE = {MIN_PWM, MAX_PWM, StandEsc::STOP_PWM};
+static_assert(RAMP_RANGE.percentFromPwm(MIN_PWM) == 100 && RAMP_RANGE.percentFromPwm(MAX_PWM) == 0,
+              "ramp throttle endpoints");
 
 // Ramp settings
 #define PWM_STEP 10      // PWM change per step
 #define STEP_DELAY 2000  // Delay between steps (ms)
 
-// Load cell calibration
-const float CALIBRATION_WEIGHT_KG = 0.800;
-const float CORRECTION_K = 3.265;
-
 // Drone payload calculation
 const float DRONE_WEIGHT_KG = 0.500;          // Average drone weight (hardcoded)
 const int NUM_MOTORS = 4;                      // Quadcopter
@@ -52,9 +50,11 @@ void setup() {
   lcd.print("Initializing...");
 
   // Attach and arm ESC
-  esc.attach(MOTOR_PIN, 1000, 2000);
-  Serial.println("Arming ESC at 1340us (stopped)...");
-  esc.writeMicroseconds(MAX_PWM);
+  esc.attach(StandBoard::ESC_PIN, StandEsc::ATTACH_MIN_US, StandEsc::ATTACH_MAX_US);
+  Serial.print("Arming ESC at ");
+  Serial.print(StandEsc::STOP_PWM);
+  Serial.println("us (stopped)...");
+  esc.writeMicroseconds(StandEsc::STOP_PWM);
   delay(2000);
   Serial.println("ESC armed!");
 
@@ -63,7 +63,7 @@ void setup() {
   lcd.setCursor(0, 1);
   lcd.print("Calibrating...");
 
-  scale.begin(DT, SCK);
+  scale.begin(StandBoard::LOADCELL_DT_PIN, StandBoard::LOADCELL_SCK_PIN);
   delay(1000);
   scale.tare();
 
@@ -112,7 +112,7 @@ void loop() {
       maxThrustKg = thrust_kg;
     }
 
-    int throttlePercent = map(pwm, MAX_PWM, MIN_PWM, 0, 100);
+    int throttlePercent = RAMP_RANGE.percentFromPwm(pwm);
     int progressPercent = (currentStep * 100) / totalSteps;
 
     Serial.print(pwm);
@@ -159,7 +159,7 @@ void loop() {
       maxThrustKg = thrust_kg;
     }
 
-    int throttlePercent = map(pwm, MAX_PWM, MIN_PWM, 0, 100);
+    int throttlePercent = RAMP_RANGE.percentFromPwm(pwm);
     int progressPercent = (currentStep * 100) / totalSteps;
 
     Serial.print(pwm);
@@ -189,7 +189,7 @@ void loop() {
   Serial.println("\n[TEST COMPLETE] Motor stopped.\n");
 
   // Stop motor
-  esc.writeMicroseconds(MAX_PWM);
+  esc.writeMicroseconds(StandEsc::STOP_PWM);
 
   // Calculate payload capacity
   float totalThrust = maxThrustKg * NUM_MOTORS;  // Total thrust from 4 motors